@@ -1,3 +1,6 @@
 @PACKAGE_INIT@
 
+include(CMakeFindDependencyMacro)
+find_dependency(Threads)
+
 include(${CMAKE_CURRENT_LIST_DIR}/SndFile2KTargets.cmake)
@@ -32,6 +32,7 @@ if(VORBISENC_FOUND AND FLAC_FOUND)
   set(HAVE_EXTERNAL_XIPH_LIBS 1)
 endif()
 find_package(Speex)
+find_package(Threads REQUIRED)
 find_package(Doxygen 1.8)
 if(NOT CMAKE_VERSION VERSION_LESS 3.9)
   set(CMAKE_DOXYGEN_SUPPORTS_TARGETS 1)
@@ -54,6 +55,7 @@ if(BUILD_TESTING)
     check_include_file(sys/wait.h   HAVE_SYS_WAIT_H)
   endif()
 endif()
+check_include_file(sys/mman.h       HAVE_SYS_MMAN_H)
 check_include_file(sys/time.h       HAVE_SYS_TIME_H)
 check_include_file(sys/types.h      HAVE_SYS_TYPES_H)
 check_include_file(unistd.h         HAVE_UNISTD_H)
@@ -100,6 +102,12 @@ check_function_exists(fstat         HAVE_FSTAT)
 check_function_exists(fstat64       HAVE_FSTAT64)
 check_function_exists(fsync         HAVE_FSYNC)
 check_function_exists(gettimeofday  HAVE_GETTIMEOFDAY)
+if(HAVE_SYS_MMAN_H)
+  check_function_exists(mmap        HAVE_MMAP)
+  check_function_exists(madvise     HAVE_MADVISE)
+endif()
+check_function_exists(pread         HAVE_PREAD)
+check_function_exists(pwrite        HAVE_PWRITE)
 check_function_exists(gmtime_r      HAVE_GMTIME_R)
 if(NOT HAVE_GMTIME_R)
   check_function_exists(gmtime      HAVE_GMTIME)
@@ -509,6 +509,23 @@ typedef enum SF_COMMAND
      */
     SFC_GET_MAX_ALL_CHANNELS = 0x1045,
 
+    /** Calculates the normalised peak, RMS level, DC offset, clip count and
+     * zero crossing rate of each channel
+     *
+     * @param[in] sndfile a valid ::SNDFILE* pointer
+     * @param[out] data a pointer to an ::SF_SIGNAL_STATS array
+     * @param[in] datasize @c sizeof(SF_SIGNAL_STATS) * number of channels
+     *
+     * All statistics are calculated in a single pass over the file. Files
+     * opened with sf_open() are split into parts which are read by
+     * independent handles (see sf_clone()) in several threads, unless their
+     * codec can only seek by decoding (G72x, NMS ADPCM, DWVW, VOX ADPCM and
+     * XI DPCM). The read position and settings of @p sndfile are not changed.
+     *
+     * @return #SF_ERR_NO_ERROR on succes, negative error code otherwise.
+     */
+    SFC_CALC_SIGNAL_STATS = 0x1046,
+
     /** Switches the code for adding the PEAK chunk to WAV and AIFF files on or
      * off
      *
@@ -814,6 +831,152 @@ typedef enum SF_COMMAND
      */
     SFC_SET_COMPRESSION_LEVEL = 0x1301,
 
+    /** Sets the size of the blocks used for file I/O
+     *
+     * @param[in] sndfile a valid ::SNDFILE* pointer
+     * @param[in] data A pointer to a variable of ::sf_count_t type
+     * @param[in] datasize sizeof(sf_count_t)
+     *
+     * PCM, A-law, u-law and floating point data is converted through an
+     * internal buffer and read or written one buffer at a time. The default
+     * buffer is 8192 bytes. Larger blocks (1 MB and up) can be much faster on
+     * network file systems. The size is rounded down to a multiple of 8 and
+     * must be between 1 KB and 64 MB. The buffer is allocated by this
+     * command. If that fails, the previous size is kept.
+     *
+     * @return ::SF_ERR_NO_ERROR on succes, negative error code otherwise.
+     */
+    SFC_SET_IO_BLOCK_SIZE = 0x1310,
+    /** Gets the size of the blocks used for file I/O
+     *
+     * @param[in] sndfile a valid ::SNDFILE* pointer
+     * @param[out] data A pointer to a variable of ::sf_count_t type
+     * @param[in] datasize sizeof(sf_count_t)
+     *
+     * @return ::SF_ERR_NO_ERROR on succes, negative error code otherwise.
+     */
+    SFC_GET_IO_BLOCK_SIZE = 0x1311,
+
+    /** Builds an index of the pages of an Ogg/Vorbis file
+     *
+     * @param[in] sndfile a valid ::SNDFILE* pointer opened for reading
+     * @param data NULL
+     * @param datasize 0
+     *
+     * Scans the whole file once. Later seeks look the page to start decoding
+     * from up in the index instead of searching the file for it.
+     *
+     * @return ::SF_TRUE on success, ::SF_FALSE otherwise.
+     */
+    SFC_OGG_BUILD_PAGE_INDEX = 0x1320,
+    /** Exports the Ogg page index as a byte blob
+     *
+     * @param[in] sndfile a valid ::SNDFILE* pointer
+     * @param[out] data A buffer for the blob or NULL
+     * @param[in] datasize Size of the buffer in bytes
+     *
+     * The blob can be stored alongside the file and passed to
+     * ::SFC_OGG_SET_PAGE_INDEX when the file is opened again. Nothing is
+     * written if the buffer is too small.
+     *
+     * @return Size of the blob in bytes, 0 if there is no index.
+     */
+    SFC_OGG_GET_PAGE_INDEX = 0x1321,
+    /** Loads an Ogg page index exported with ::SFC_OGG_GET_PAGE_INDEX
+     *
+     * @param[in] sndfile a valid ::SNDFILE* pointer opened for reading
+     * @param[in] data A pointer to the blob
+     * @param[in] datasize Size of the blob in bytes
+     *
+     * The blob is rejected if it is malformed or was exported for a file with
+     * a different length or stream serial number.
+     *
+     * @return ::SF_TRUE on success, ::SF_FALSE otherwise.
+     */
+    SFC_OGG_SET_PAGE_INDEX = 0x1322,
+
+    /** Sets the spacing of the seek table written to a FLAC file
+     *
+     * @param[in] sndfile a valid ::SNDFILE* pointer opened for writing
+     * @param[in] data A pointer to a double holding the spacing in seconds
+     * @param[in] datasize sizeof(double)
+     *
+     * The default is a seek point every 10 seconds, 0 writes no seek table.
+     * The table has room for a fixed number of points, on long files the
+     * spacing is doubled as often as needed to fit it. Must be sent before
+     * any data is written.
+     *
+     * @return ::SF_TRUE on success, ::SF_FALSE otherwise.
+     */
+    SFC_SET_SEEKTABLE_SPACING = 0x1330,
+    /** Gets information about the seek table of a file
+     *
+     * @param[in] sndfile a valid ::SNDFILE* pointer
+     * @param[out] data A pointer to a ::SF_SEEKTABLE_INFO struct
+     * @param[in] datasize sizeof(::SF_SEEKTABLE_INFO)
+     *
+     * @return ::SF_TRUE if the file has a seek table, ::SF_FALSE otherwise.
+     */
+    SFC_GET_SEEKTABLE_INFO = 0x1331,
+
+    /** Sets the number of threads used to encode a file
+     *
+     * @param[in] sndfile a valid ::SNDFILE* pointer opened for writing
+     * @param[in] data A pointer to an int holding the number of threads
+     * @param[in] datasize sizeof(int)
+     *
+     * 0 or 1 encodes on the calling thread, which is the default. With more
+     * threads the written audio is buffered and encoded in parallel, so it
+     * reaches the file in batches. Counts above 64 are clamped. Must be sent
+     * before any data is written. Supported by FLAC and ALAC files.
+     *
+     * @return ::SF_TRUE on success, ::SF_FALSE otherwise.
+     */
+    SFC_SET_ENCODER_THREADS = 0x1340,
+
+    /** Builds the seek index of a file whose codec seeks by decoding
+     *
+     * @param[in] sndfile a valid ::SNDFILE* pointer opened for reading
+     * @param[in] data NULL, or a pointer to an ::sf_count_t holding the
+     * spacing of the index in frames
+     * @param[in] datasize 0 or sizeof(::sf_count_t)
+     *
+     * G72x, NMS ADPCM, DWVW and VOX ADPCM decoders carry state from one sample
+     * to the next, so they seek by going back to a saved decoder state and
+     * decoding forward from it. These checkpoints are saved as the file is
+     * decoded, one every 16384 frames by default. This command decodes the
+     * whole file once so every seek is served by a nearby checkpoint, the read
+     * position is kept. A new spacing drops all but the first checkpoint.
+     *
+     * @return ::SF_TRUE on success, ::SF_FALSE otherwise.
+     */
+    SFC_BUILD_SEEK_INDEX = 0x1350,
+    /** Exports the seek index of a file as a byte blob
+     *
+     * @param[in] sndfile a valid ::SNDFILE* pointer
+     * @param[out] data A buffer for the blob or NULL
+     * @param[in] datasize Size of the buffer in bytes
+     *
+     * The blob can be stored alongside the file and passed to
+     * ::SFC_SET_SEEK_INDEX when the file is opened again. Nothing is written
+     * if the buffer is too small.
+     *
+     * @return Size of the blob in bytes, 0 if the codec has no seek index.
+     */
+    SFC_GET_SEEK_INDEX = 0x1351,
+    /** Loads a seek index exported with ::SFC_GET_SEEK_INDEX
+     *
+     * @param[in] sndfile a valid ::SNDFILE* pointer opened for reading
+     * @param[in] data A pointer to the blob
+     * @param[in] datasize Size of the blob in bytes
+     *
+     * The blob is rejected if it is malformed or was exported for a file with
+     * a different format or length.
+     *
+     * @return ::SF_TRUE on success, ::SF_FALSE otherwise.
+     */
+    SFC_SET_SEEK_INDEX = 0x1352,
+
     /** Internal, do not use
      */
     SFC_TEST_IEEE_FLOAT_REPLACE = 0x6001,
@@ -898,6 +1061,8 @@ typedef enum SF_FILEMODE
     SFM_WRITE = 0x20,
     //! Read/write mode
     SFM_RDWR = 0x30,
+    //! Flag for sf_open() in read mode: memory map the file
+    SFM_MMAP = 0x100,
 } SF_FILEMODE;
 
 /** Defines Ambisonics format constants
@@ -1065,6 +1230,38 @@ typedef struct SF_DITHER_INFO
     const char *name;
 } SF_DITHER_INFO;
 
+/** Contains signal statistics of one channel
+ *
+ * Sample values are normalised to the range [-1.0, 1.0].
+ *
+ * @sa ::SFC_CALC_SIGNAL_STATS
+ */
+typedef struct SF_SIGNAL_STATS
+{
+    //! Largest absolute sample value
+    double peak;
+    //! Root mean square level
+    double rms;
+    //! Mean sample value
+    double dc_offset;
+    //! Number of samples at or beyond full scale
+    sf_count_t clip_count;
+    //! Fraction of consecutive sample pairs with opposite signs
+    double zero_crossing_rate;
+} SF_SIGNAL_STATS;
+
+/** Describes the seek table of a file
+ *
+ * @sa ::SFC_GET_SEEKTABLE_INFO
+ */
+typedef struct SF_SEEKTABLE_INFO
+{
+    //! Number of seek points
+    int points;
+    //! Average distance between seek points in seconds
+    double spacing;
+} SF_SEEKTABLE_INFO;
+
 /** Contains CUE marker information
  */
 typedef struct SF_CUE_POINT
@@ -1323,6 +1520,14 @@ typedef struct SF_STREAM
  * When opening a file for write, the caller must fill in structure members 
  * SF_INFO::samplerate, SF_INFO::channels, and SF_INFO::format.
  *
+ * Regular, non-empty files opened with <tt>SFM_READ | SFM_MMAP</tt> are
+ * memory mapped, which saves a system call and a copy for every read. The
+ * mapping covers the file as it was when it was opened, data appended later
+ * is not seen. If the file is truncated while it is open, reading the part
+ * that was cut off raises @c SIGBUS, so only map files no other process will
+ * change. Other files, and all files on Windows, are read with ordinary
+ * reads.
+ *
  * All calls to sf_open() should be matched with a call to sf_close().
  *
  * @return A valid pointer to a #SNDFILE object on success, @c NULL
@@ -1333,6 +1538,31 @@ typedef struct SF_STREAM
  */
 SNDFILE2K_EXPORT int sf_open(const char *path, SF_FILEMODE mode, SF_INFO *sfinfo, SNDFILE **sndfile);
 
+/** Opens another read handle on the same sound file
+ *
+ * @param[in] sndfile Pointer to a sound file state
+ * @param[out] clone Receives the new handle
+ *
+ * The clone has its own read position and codec state, so it can be used from
+ * another thread at the same time as @p sndfile. It reads through the same
+ * memory mapping or file descriptor instead of opening the file again. Read
+ * settings (normalisation, scaling, clipping, dithering) are copied.
+ *
+ * The clone parses the header again, nothing is shared with @p sndfile but the
+ * file data. Seek indexes are not copied either: Ogg page indexes and the
+ * decoder checkpoints of G72x, NMS ADPCM, DWVW and VOX ADPCM files have to be
+ * built again or loaded with the matching ::SFC_OGG_SET_PAGE_INDEX or
+ * ::SFC_SET_SEEK_INDEX command. Until then, seeking a clone of such a file
+ * decodes or searches from the start.
+ *
+ * Only files opened with sf_open() in ::SFM_READ mode can be cloned. The
+ * clone must be closed with sf_close() like any other handle. Errors are only
+ * returned, the error state of @p sndfile is not changed.
+ *
+ * @return ::SF_ERR_NO_ERROR on success, non-zero error code otherwise.
+ */
+SNDFILE2K_EXPORT int sf_clone(SNDFILE *sndfile, SNDFILE **clone);
+
 /** @defgroup file-virt Virtual I/O
  *
  * SndFile2K calls the callbacks provided by the ::SF_VIRTUAL_IO structure when
@@ -1375,6 +1605,30 @@ SNDFILE2K_EXPORT int sf_open(const char *path, SF_FILEMODE mode, SF_INFO *sfinfo
  */
 SNDFILE2K_EXPORT int sf_open_stream(SF_STREAM *stream, SF_FILEMODE mode, SF_INFO *sfinfo, SNDFILE **sndfile);
 
+/** Wraps a stream in a read-ahead buffer
+ *
+ * @param[in] stream Seekable stream to wrap
+ * @param[in] buffer_size Size of the read-ahead window in bytes, @c 0 selects
+ * the default of 64 KB
+ * @param[out] buffered Buffered stream
+ *
+ * Opening a file issues many small reads and seeks while the header is parsed.
+ * The buffered stream serves them from one larger read of @p stream and keeps
+ * track of the file position itself, which helps a lot when every call on
+ * @p stream is expensive (network file systems, object stores). Pass
+ * @p buffered to sf_open_stream(). Files opened with sf_open() are buffered
+ * already.
+ *
+ * The buffered stream holds a reference to @p stream. Call @c unref on
+ * @p buffered when it is no longer needed. Don't use @p stream directly while
+ * @p buffered is in use, the buffered stream would not notice.
+ *
+ * @return ::SF_ERR_NO_ERROR on success, error code otherwise.
+ *
+ * @sa sf_open_stream()
+ */
+SNDFILE2K_EXPORT int sf_create_buffered_stream(SF_STREAM *stream, size_t buffer_size, SF_STREAM **buffered);
+
 /** @}*/
 
 /** @}*/
@@ -1723,6 +1977,158 @@ SNDFILE2K_EXPORT sf_count_t sf_readf_double(SNDFILE *sndfile, double *ptr, sf_co
 SNDFILE2K_EXPORT sf_count_t sf_writef_double(SNDFILE *sndfile, const double *ptr,
                                              sf_count_t frames);
 
+/** Borrows frames without copying them
+ *
+ * @param[in] sndfile Pointer to a sound file state
+ * @param[out] ptr Receives pointer to the borrowed frames.
+ * @param[in] frames Count of frames to borrow
+ *
+ * Frames are returned in the native sample type of the file: @c short for
+ * ::SF_FORMAT_PCM_16, @c int for ::SF_FORMAT_PCM_32, @c float for
+ * ::SF_FORMAT_FLOAT and @c double for ::SF_FORMAT_DOUBLE. Other subformats
+ * are not supported.
+ *
+ * When the file is memory mapped, see ::SFM_MMAP, and stored in host layout,
+ * @p ptr points directly into the mapping, otherwise frames are read into an
+ * internal buffer and fewer frames than requested may be returned.
+ *
+ * The read position is advanced by the number of returned frames. The pointer
+ * stays valid until sf_release_frames() is called or the file is closed, only
+ * one borrow may be outstanding at a time.
+ *
+ * @return Number of frames actually borrowed.
+ */
+SNDFILE2K_EXPORT sf_count_t sf_borrow_frames(SNDFILE *sndfile, const void **ptr, sf_count_t frames);
+/** Releases frames returned by sf_borrow_frames()
+ *
+ * @param[in] sndfile Pointer to a sound file state
+ * @param[in] ptr Pointer returned by sf_borrow_frames()
+ *
+ * @return ::SF_ERR_NO_ERROR on success, non-zero error code otherwise.
+ */
+SNDFILE2K_EXPORT int sf_release_frames(SNDFILE *sndfile, const void *ptr);
+
+/** Reads short (16-bit) frames from file into one buffer per channel
+ *
+ * @param[in] sndfile Pointer to a sound file state
+ * @param[out] ptr Array of pointers to an allocated block of memory for each
+ * channel.
+ * @param[in] frames Count of frames to read
+ *
+ * Reads like sf_readf_short(), but the samples of each channel are stored one
+ * after another in the channel's own buffer. FLAC and ALAC files are decoded
+ * straight into the channel buffers, other formats go through a small
+ * interleaved buffer.
+ *
+ * @return Number of frames actually read.
+ */
+SNDFILE2K_EXPORT sf_count_t sf_readf_short_planar(SNDFILE *sndfile, short *const *ptr, sf_count_t frames);
+/** Writes short (16-bit) frames to file from one buffer per channel
+ *
+ * @param[in] sndfile Pointer to a sound file state
+ * @param[in] ptr Array of pointers to a block of memory for each channel.
+ * @param[in] frames Count of frames to write
+ *
+ * Writes like sf_writef_short(), but the samples of each channel are taken
+ * one after another from the channel's own buffer.
+ *
+ * @return Number of frames actually written.
+ */
+SNDFILE2K_EXPORT sf_count_t sf_writef_short_planar(SNDFILE *sndfile, const short *const *ptr, sf_count_t frames);
+
+/** Reads integer (32-bit) frames from file into one buffer per channel
+ *
+ * @sa sf_readf_short_planar()
+ *
+ * @return Number of frames actually read.
+ */
+SNDFILE2K_EXPORT sf_count_t sf_readf_int_planar(SNDFILE *sndfile, int *const *ptr, sf_count_t frames);
+/** Writes integer (32-bit) frames to file from one buffer per channel
+ *
+ * @sa sf_writef_short_planar()
+ *
+ * @return Number of frames actually written.
+ */
+SNDFILE2K_EXPORT sf_count_t sf_writef_int_planar(SNDFILE *sndfile, const int *const *ptr, sf_count_t frames);
+
+/** Reads float (32-bit) frames from file into one buffer per channel
+ *
+ * @sa sf_readf_short_planar()
+ *
+ * @return Number of frames actually read.
+ */
+SNDFILE2K_EXPORT sf_count_t sf_readf_float_planar(SNDFILE *sndfile, float *const *ptr, sf_count_t frames);
+/** Writes float (32-bit) frames to file from one buffer per channel
+ *
+ * @sa sf_writef_short_planar()
+ *
+ * @return Number of frames actually written.
+ */
+SNDFILE2K_EXPORT sf_count_t sf_writef_float_planar(SNDFILE *sndfile, const float *const *ptr, sf_count_t frames);
+
+/** Reads double (64-bit) frames from file into one buffer per channel
+ *
+ * @sa sf_readf_short_planar()
+ *
+ * @return Number of frames actually read.
+ */
+SNDFILE2K_EXPORT sf_count_t sf_readf_double_planar(SNDFILE *sndfile, double *const *ptr, sf_count_t frames);
+/** Writes double (64-bit) frames to file from one buffer per channel
+ *
+ * @sa sf_writef_short_planar()
+ *
+ * @return Number of frames actually written.
+ */
+SNDFILE2K_EXPORT sf_count_t sf_writef_double_planar(SNDFILE *sndfile, const double *const *ptr,
+                                                    sf_count_t frames);
+
+/** Reads short (16-bit) frames from file using several threads
+ *
+ * @param[in] sndfile Pointer to a sound file state
+ * @param[out] ptr Pointer to an allocated block of memory.
+ * @param[in] frames Count of frames to read
+ * @param[in] threads Number of threads, 0 for one per processor core
+ *
+ * Reads like sf_readf_short() from the current read position. The frames are
+ * split into contiguous parts, each read in its own thread by a clone of
+ * @p sndfile (see sf_clone()) that first seeks to the start of its part.
+ * Files that can't be cloned or seeked, files whose codec can only seek by
+ * decoding (G72x, NMS ADPCM, DWVW, VOX ADPCM and XI DPCM) and reads too short
+ * to be worth splitting are read on the calling thread.
+ *
+ * The frames read end at the first part that came up short, so the data is
+ * always contiguous. The read position is advanced by the number of frames
+ * read.
+ *
+ * @return Number of frames actually read.
+ */
+SNDFILE2K_EXPORT sf_count_t sf_readf_short_parallel(SNDFILE *sndfile, short *ptr, sf_count_t frames,
+                                                    int threads);
+/** Reads integer (32-bit) frames from file using several threads
+ *
+ * @sa sf_readf_short_parallel()
+ *
+ * @return Number of frames actually read.
+ */
+SNDFILE2K_EXPORT sf_count_t sf_readf_int_parallel(SNDFILE *sndfile, int *ptr, sf_count_t frames,
+                                                  int threads);
+/** Reads float (32-bit) frames from file using several threads
+ *
+ * @sa sf_readf_short_parallel()
+ *
+ * @return Number of frames actually read.
+ */
+SNDFILE2K_EXPORT sf_count_t sf_readf_float_parallel(SNDFILE *sndfile, float *ptr, sf_count_t frames,
+                                                    int threads);
+/** Reads double (64-bit) frames from file using several threads
+ *
+ * @sa sf_readf_short_parallel()
+ *
+ * @return Number of frames actually read.
+ */
+SNDFILE2K_EXPORT sf_count_t sf_readf_double_parallel(SNDFILE *sndfile, double *ptr, sf_count_t frames,
+                                                     int threads);
+
 /** @}*/
 
 /** @defgroup read-write-items Read/Write items
@@ -109,6 +109,24 @@ struct ISndFile: public SF_OBJECT
 	 */
 	virtual int command(int cmd, void *data, int datasize) = 0;
 
+	/** Opens another read handle on the same file
+	 *
+	 * @param[out] clone Receives the new handle
+	 *
+	 * The clone has its own read position and codec state, so it can be used
+	 * from another thread at the same time as this handle. It reads through
+	 * the same memory mapping or file descriptor instead of opening the file
+	 * again. Read settings (normalisation, scaling, clipping, dithering) are
+	 * copied. The clone parses the header again and does not get the seek
+	 * indexes of this handle, see sf_clone().
+	 *
+	 * Only files opened with sf_open() in ::SFM_READ mode can be cloned.
+	 * Errors are only returned, the error state of this handle is not changed.
+	 *
+	 * @return ::SF_ERR_NO_ERROR on success, non-zero error code otherwise.
+	 */
+	virtual int clone(ISndFile **clone) = 0;
+
 	/** Changes position of sound file
 	 *
 	 * @param[in] frames Count of frames
@@ -316,6 +334,110 @@ struct ISndFile: public SF_OBJECT
 	 */
 	virtual sf_count_t writeDoubleFrames(const double *ptr, sf_count_t frames) = 0;
 
+	/** Borrows frames without copying them
+	 *
+	 * @param[out] ptr Receives pointer to the borrowed frames.
+	 * @param[in] frames Count of frames to borrow
+	 *
+	 * Frames are returned in the native sample type of the file: @c short
+	 * for ::SF_FORMAT_PCM_16, @c int for ::SF_FORMAT_PCM_32, @c float for
+	 * ::SF_FORMAT_FLOAT and @c double for ::SF_FORMAT_DOUBLE. Other
+	 * subformats are not supported.
+	 *
+	 * When the file is memory mapped, see ::SFM_MMAP, and stored in host
+	 * layout, @p ptr points directly into the mapping, otherwise frames are
+	 * read into an internal buffer and fewer frames than requested may be
+	 * returned.
+	 *
+	 * The read position is advanced by the number of returned frames. The
+	 * pointer stays valid until releaseFrames() is called or the file is
+	 * closed, only one borrow may be outstanding at a time.
+	 *
+	 * @return Number of frames actually borrowed.
+	 */
+	virtual sf_count_t borrowFrames(const void **ptr, sf_count_t frames) = 0;
+
+	/** Releases frames returned by borrowFrames()
+	 *
+	 * @param[in] ptr Pointer returned by borrowFrames()
+	 *
+	 * @return ::SF_ERR_NO_ERROR on success, non-zero error code otherwise.
+	 */
+	virtual int releaseFrames(const void *ptr) = 0;
+
+	/** Reads short (16-bit) frames from file into one buffer per channel
+	 *
+	 * @param[out] ptr Array of pointers to an allocated block of memory for
+	 * each channel.
+	 * @param[in] frames Count of frames to read
+	 *
+	 * Reads like readShortFrames(), but the samples of each channel are stored
+	 * one after another in the channel's own buffer.
+	 *
+	 * @return Number of frames actually read.
+	 */
+	virtual sf_count_t readShortPlanar(short *const *ptr, sf_count_t frames) = 0;
+
+	/** Reads integer (32-bit) frames from file into one buffer per channel
+	 *
+	 * @sa readShortPlanar()
+	 *
+	 * @return Number of frames actually read.
+	 */
+	virtual sf_count_t readIntPlanar(int *const *ptr, sf_count_t frames) = 0;
+
+	/** Reads float (32-bit) frames from file into one buffer per channel
+	 *
+	 * @sa readShortPlanar()
+	 *
+	 * @return Number of frames actually read.
+	 */
+	virtual sf_count_t readFloatPlanar(float *const *ptr, sf_count_t frames) = 0;
+
+	/** Reads double (64-bit) frames from file into one buffer per channel
+	 *
+	 * @sa readShortPlanar()
+	 *
+	 * @return Number of frames actually read.
+	 */
+	virtual sf_count_t readDoublePlanar(double *const *ptr, sf_count_t frames) = 0;
+
+	/** Writes short (16-bit) frames to file from one buffer per channel
+	 *
+	 * @param[in] ptr Array of pointers to a block of memory for each channel.
+	 * @param[in] frames Count of frames to write
+	 *
+	 * Writes like writeShortFrames(), but the samples of each channel are
+	 * taken one after another from the channel's own buffer.
+	 *
+	 * @return Number of frames actually written.
+	 */
+	virtual sf_count_t writeShortPlanar(const short *const *ptr, sf_count_t frames) = 0;
+
+	/** Writes integer (32-bit) frames to file from one buffer per channel
+	 *
+	 * @sa writeShortPlanar()
+	 *
+	 * @return Number of frames actually written.
+	 */
+	virtual sf_count_t writeIntPlanar(const int *const *ptr, sf_count_t frames) = 0;
+
+	/** Writes float (32-bit) frames to file from one buffer per channel
+	 *
+	 * @sa writeShortPlanar()
+	 *
+	 * @return Number of frames actually written.
+	 */
+	virtual sf_count_t writeFloatPlanar(const float *const *ptr, sf_count_t frames) = 0;
+
+	/** Writes double (64-bit) frames to file from one buffer per channel
+	 *
+	 * @sa writeShortPlanar()
+	 *
+	 * @return Number of frames actually written.
+	 */
+	virtual sf_count_t writeDoublePlanar(const double *const *ptr, sf_count_t frames) = 0;
+
     virtual int getCurrentByterate() const = 0;
 
 	/** Read raw bytes from sound file
@@ -35,6 +35,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <cctype>
+#include <cmath>
 #include <cstdint>
 
 using namespace std;
@@ -43,39 +44,131 @@ using namespace std;
 
 #include "common.h"
 
-#define BUFFER_LEN (4096)
+#define BUFFER_LEN (1 << 16)
 
 #define MIN(x, y) ((x) < (y) ? (x) : (y))
 
+static sf_count_t copy_data_fp(SNDFILE *outfile, SNDFILE *infile, double *data, sf_count_t frames, int channels,
+                               double scale, double *peak)
+{
+    sf_count_t readcount, total = 0, k;
+    double max = 0.0, temp;
+
+    while ((readcount = sf_readf_double(infile, data, frames)) > 0)
+    {
+        for (k = 0; k < readcount * channels; k++)
+        {
+            data[k] *= scale;
+            temp = fabs(data[k]);
+            max = temp > max ? temp : max;
+        };
+        sf_writef_double(outfile, data, readcount);
+        total += readcount;
+    };
+
+    *peak = max;
+    return total;
+}
+
+/*
+** Whether outfile can be rewound and written over once infile has been read
+** to the end. Codecs keep state from block to block, or can't seek at all
+** while writing, so only plain sample formats can be written over. Float and
+** double files get a PEAK chunk, which only ever grows and would keep the
+** peak of the first copy. Neither file has been read or written yet, so
+** seeking them to the start is harmless.
+*/
+static int can_copy_again(SNDFILE *outfile, SNDFILE *infile)
+{
+    SF_INFO sfinfo;
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    if (sf_command(outfile, SFC_GET_CURRENT_SF_INFO, &sfinfo, sizeof(sfinfo)) != 0)
+        return SF_FALSE;
+
+    switch (sfinfo.format & SF_FORMAT_TYPEMASK)
+    {
+    /* These pack or encode PCM subformats. */
+    case SF_FORMAT_FLAC:
+    case SF_FORMAT_OGG:
+    case SF_FORMAT_PAF:
+    case SF_FORMAT_SDS:
+        return SF_FALSE;
+
+    default:
+        break;
+    };
+
+    switch (sfinfo.format & SF_FORMAT_SUBMASK)
+    {
+    case SF_FORMAT_PCM_S8:
+    case SF_FORMAT_PCM_U8:
+    case SF_FORMAT_PCM_16:
+    case SF_FORMAT_PCM_24:
+    case SF_FORMAT_PCM_32:
+    case SF_FORMAT_ULAW:
+    case SF_FORMAT_ALAW:
+        break;
+
+    default:
+        return SF_FALSE;
+    };
+
+    /* Pipes fail here. */
+    return sf_seek(infile, 0, SEEK_SET) == 0 && sf_seek(outfile, 0, SEEK_SET) == 0;
+}
+
 void sfe_copy_data_fp(SNDFILE *outfile, SNDFILE *infile, int channels, int normalize)
 {
-    static double data[BUFFER_LEN], max;
-    sf_count_t frames, readcount, k;
+    static double data[BUFFER_LEN];
+    double max = 0.0, peak;
+    sf_count_t frames;
+    int have_max;
 
     frames = BUFFER_LEN / channels;
-    readcount = frames;
 
-    sf_command(infile, SFC_CALC_SIGNAL_MAX, &max, sizeof(max));
+    /* Use the PEAK chunk if the file has one, it saves a pass over the data. */
+    have_max = sf_command(infile, SFC_GET_SIGNAL_MAX, &max, sizeof(max)) == SF_TRUE;
 
-    if (!normalize && max < 1.0)
+    if (normalize)
     {
-        while (readcount > 0)
-        {
-            readcount = sf_readf_double(infile, data, frames);
-            sf_writef_double(outfile, data, readcount);
-        };
-    }
-    else
+        /* The peak is needed before anything is written, so this does take two passes. */
+        if (!have_max)
+            sf_command(infile, SFC_CALC_NORM_SIGNAL_MAX, &max, sizeof(max));
+
+        copy_data_fp(outfile, infile, data, frames, channels, max > 0.0 ? 1.0 / max : 1.0, &peak);
+        return;
+    };
+
+    /*
+    ** Without the peak, the data is copied as it is and copied again, scaled
+    ** down, if it turns out to go past full scale. If that can't be done, find
+    ** the peak first.
+    */
+    if (!have_max && !can_copy_again(outfile, infile))
     {
-        sf_command(infile, SFC_SET_NORM_DOUBLE, NULL, SF_FALSE);
+        max = 0.0;
+        have_max = sf_command(infile, SFC_CALC_NORM_SIGNAL_MAX, &max, sizeof(max)) == 0 && sf_error(infile) == 0;
+    };
+
+    if (have_max)
+    {
+        /* Only scale down data which would clip. */
+        copy_data_fp(outfile, infile, data, frames, channels, max > 1.0 ? 1.0 / max : 1.0, &peak);
+        return;
+    };
 
-        while (readcount > 0)
+    copy_data_fp(outfile, infile, data, frames, channels, 1.0, &peak);
+
+    if (peak > 1.0)
+    {
+        if (sf_seek(infile, 0, SEEK_SET) != 0 || sf_seek(outfile, 0, SEEK_SET) != 0)
         {
-            readcount = sf_readf_double(infile, data, frames);
-            for (k = 0; k < readcount * channels; k++)
-                data[k] /= max;
-            sf_writef_double(outfile, data, readcount);
+            printf("Warning : Peak of %f is past full scale and the output can't be rewritten.\n", peak);
+            return;
         };
+
+        copy_data_fp(outfile, infile, data, frames, channels, 1.0 / peak, &peak);
     };
 
     return;
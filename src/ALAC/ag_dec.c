@@ -30,6 +30,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 #include "shift.h"
 
@@ -77,6 +80,21 @@ void set_ag_params(AGParamRecPtr params, uint32_t m, uint32_t p, uint32_t k, uin
 #endif
 
 // note: implementing this with some kind of "count leading zeros" assembly is a big performance win
+#if defined(__GNUC__)
+static inline int32_t ALWAYS_INLINE lead(int32_t m)
+{
+    return (m == 0) ? 32 : __builtin_clz((uint32_t)m);
+}
+#elif defined(_MSC_VER)
+static inline int32_t ALWAYS_INLINE lead(int32_t m)
+{
+    unsigned long index;
+
+    if (_BitScanReverse(&index, (unsigned long)m) == 0)
+        return 32;
+    return 31 - (int32_t)index;
+}
+#else
 static inline int32_t lead(int32_t m)
 {
     long j;
@@ -90,6 +108,7 @@ static inline int32_t lead(int32_t m)
     }
     return j;
 }
+#endif
 
 #define arithmin(a, b) ((a) < (b) ? (a) : (b))
 
@@ -260,7 +279,7 @@ int32_t dyn_decomp(AGParamRecPtr params, BitBuffer *bitstream, int32_t *pc, int3
     uint8_t *in;
     int32_t *outPtr = pc;
     uint32_t bitPos, startPos, maxPos;
-    uint32_t j, m, k, n, c, mz;
+    uint32_t m, k, n, c, mz;
     int32_t del, zmode;
     uint32_t mb;
     uint32_t pb_local = params->pb;
@@ -327,11 +346,9 @@ int32_t dyn_decomp(AGParamRecPtr params, BitBuffer *bitstream, int32_t *pc, int3
 
             RequireAction(c + n <= (uint32_t)numSamples, status = kALAC_ParamError; goto Exit;);
 
-            for (j = 0; j < n; j++)
-            {
-                *outPtr++ = 0;
-                ++c;
-            }
+            memset(outPtr, 0, n * sizeof(*outPtr));
+            outPtr += n;
+            c += n;
 
             if (n >= 65535)
                 zmode = 0;
@@ -41,13 +41,77 @@ static inline int32_t ALWAYS_INLINE sign_of_int(int32_t i)
     return negishift | (i >> 31);
 }
 
+// adaptive predictor for any order, used for the orders without a hand unrolled loop
+// - the coefficients are kept in a local copy so they can live in registers when numactive is constant
+static inline void ALWAYS_INLINE unpc_block_order(const int32_t *pc1, int32_t *out, int32_t num,
+                                                  int16_t *coefs, int32_t numactive, uint32_t chanshift,
+                                                  uint32_t denshift, int32_t denhalf)
+{
+    int16_t a[32];
+    int32_t j, k, lim;
+    int32_t sum1, sg, sgn, top, dd;
+    int32_t *pout;
+    int32_t del, del0;
+
+    for (k = 0; k < numactive; k++)
+        a[k] = coefs[k];
+
+    lim = numactive + 1;
+
+    for (j = lim; j < num; j++)
+    {
+        LOOP_ALIGN
+
+        sum1 = 0;
+        pout = out + j - 1;
+        top = out[j - lim];
+
+        for (k = 0; k < numactive; k++)
+            sum1 += a[k] * (pout[-k] - top);
+
+        del = pc1[j];
+        del0 = del;
+        sg = sign_of_int(del);
+        del += top + ((sum1 + denhalf) >> denshift);
+        out[j] = (del << chanshift) >> chanshift;
+
+        if (sg > 0)
+        {
+            for (k = (numactive - 1); k >= 0; k--)
+            {
+                dd = top - pout[-k];
+                sgn = sign_of_int(dd);
+                a[k] -= sgn;
+                del0 -= (numactive - k) * ((sgn * dd) >> denshift);
+                if (del0 <= 0)
+                    break;
+            }
+        }
+        else if (sg < 0)
+        {
+            for (k = (numactive - 1); k >= 0; k--)
+            {
+                dd = top - pout[-k];
+                sgn = sign_of_int(dd);
+                a[k] += sgn;
+                del0 -= (numactive - k) * ((-sgn * dd) >> denshift);
+                if (del0 >= 0)
+                    break;
+            }
+        }
+    }
+
+    for (k = 0; k < numactive; k++)
+        coefs[k] = a[k];
+}
+
 void unpc_block(const int32_t *pc1, int32_t *out, int32_t num, int16_t *coefs, int32_t numactive,
                 uint32_t chanbits, uint32_t denshift)
 {
     register int16_t a0, a1, a2, a3;
     register int32_t b0, b1, b2, b3;
-    int32_t j, k, lim;
-    int32_t sum1, sg, sgn, top, dd;
+    int32_t j, lim;
+    int32_t sum1, sg, sgn, top;
     int32_t *pout;
     int32_t del, del0;
     uint32_t chanshift = 32 - chanbits;
@@ -325,48 +389,22 @@ void unpc_block(const int32_t *pc1, int32_t *out, int32_t num, int16_t *coefs, i
     }
     else
     {
-        // general case
-        for (j = lim; j < num; j++)
+        // general case, the orders FFmpeg and other encoders commonly choose are expanded with a
+        // constant order so the compiler can unroll them
+        switch (numactive)
         {
-            LOOP_ALIGN
-
-            sum1 = 0;
-            pout = out + j - 1;
-            top = out[j - lim];
-
-            for (k = 0; k < numactive; k++)
-                sum1 += coefs[k] * (pout[-k] - top);
-
-            del = pc1[j];
-            del0 = del;
-            sg = sign_of_int(del);
-            del += top + ((sum1 + denhalf) >> denshift);
-            out[j] = (del << chanshift) >> chanshift;
-
-            if (sg > 0)
-            {
-                for (k = (numactive - 1); k >= 0; k--)
-                {
-                    dd = top - pout[-k];
-                    sgn = sign_of_int(dd);
-                    coefs[k] -= sgn;
-                    del0 -= (numactive - k) * ((sgn * dd) >> denshift);
-                    if (del0 <= 0)
-                        break;
-                }
-            }
-            else if (sg < 0)
-            {
-                for (k = (numactive - 1); k >= 0; k--)
-                {
-                    dd = top - pout[-k];
-                    sgn = sign_of_int(dd);
-                    coefs[k] += sgn;
-                    del0 -= (numactive - k) * ((-sgn * dd) >> denshift);
-                    if (del0 >= 0)
-                        break;
-                }
-            }
+        case 5:
+            unpc_block_order(pc1, out, num, coefs, 5, chanshift, denshift, denhalf);
+            break;
+        case 6:
+            unpc_block_order(pc1, out, num, coefs, 6, chanshift, denshift, denhalf);
+            break;
+        case 7:
+            unpc_block_order(pc1, out, num, coefs, 7, chanshift, denshift, denhalf);
+            break;
+        default:
+            unpc_block_order(pc1, out, num, coefs, numactive, chanshift, denshift, denhalf);
+            break;
         }
     }
 }
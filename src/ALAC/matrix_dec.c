@@ -64,6 +64,9 @@ void unmix16(const int32_t *u, int32_t *v, int32_t *out, uint32_t stride, int32_
 {
     int32_t j;
 
+    // the vectorised kernels do the tail of the block, the loops below the rest
+    numSamples = unmix_simd(u, v, out, stride, numSamples, mixbits, mixres, NULL, 0, 16);
+
     if (mixres != 0)
     {
         /* matrixed stereo */
@@ -99,6 +102,8 @@ void unmix20(const int32_t *u, int32_t *v, int32_t *out, uint32_t stride, int32_
 {
     int32_t j;
 
+    numSamples = unmix_simd(u, v, out, stride, numSamples, mixbits, mixres, NULL, 0, 12);
+
     if (mixres != 0)
     {
         /* matrixed stereo */
@@ -136,6 +141,9 @@ void unmix24(const int32_t *u, int32_t *v, int32_t *out, uint32_t stride, int32_
     int32_t l, r;
     int32_t j, k;
 
+    numSamples = unmix_simd(u, v, out, stride, numSamples, mixbits, mixres,
+                            (bytesShifted != 0) ? shiftUV : NULL, bytesShifted, 8);
+
     if (mixres != 0)
     {
         /* matrixed stereo */
@@ -209,6 +217,10 @@ void unmix32(const int32_t *u, int32_t *v, int32_t *out, uint32_t stride, int32_
     int32_t l, r;
     int32_t j, k;
 
+    // the matrixed loop below uses the shift buffer even when nothing was shifted off
+    numSamples = unmix_simd(u, v, out, stride, numSamples, mixbits, mixres,
+                            (mixres != 0 || bytesShifted != 0) ? shiftUV : NULL, bytesShifted, 0);
+
     if (mixres != 0)
     {
         //Assert (bytesShifted != 0) ;
@@ -64,6 +64,12 @@ void mix32(const int32_t *in, uint32_t stride, int32_t *u, int32_t *v, int32_t n
 void unmix32(const int32_t *u, int32_t *v, int32_t *out, uint32_t stride, int32_t numSamples,
              int32_t mixbits, int32_t mixres, uint16_t *shiftUV, int32_t bytesShifted);
 
+// vectorised unmix of the tail of a stereo pair, defined in simd.cpp
+// - unmixes and interleaves as the routines above do when stride is 2, shiftUV is only used if not NULL
+// - returns the number of samples at the start which are left for the scalar loops
+int32_t unmix_simd(const int32_t *u, const int32_t *v, int32_t *out, uint32_t stride, int32_t numSamples,
+                   int32_t mixbits, int32_t mixres, const uint16_t *shiftUV, int32_t bytesShifted, int32_t outShift);
+
 // 20/24/32-bit <-> 32-bit helper routines (not really matrixing but convenient to put here)
 void copy20ToPredictor(const int32_t *in, uint32_t stride, int32_t *out, int32_t numSamples);
 void copy24ToPredictor(const int32_t *in, uint32_t stride, int32_t *out, int32_t numSamples);
@@ -30,6 +30,7 @@
  * Common routines for G.721 and G.723 conversions.
  */
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -268,6 +269,86 @@ int g72x_encode_block(G72x_STATE *pstate, short *samples, unsigned char *block)
     return count;
 } /* g72x_encode_block */
 
+void g72x_save_state(const G72x_STATE *pstate, int32_t *state)
+{
+    int k;
+
+    state[0] = pstate->yl;
+    state[1] = pstate->yu;
+    state[2] = pstate->dms;
+    state[3] = pstate->dml;
+    state[4] = pstate->ap;
+    for (k = 0; k < 2; k++)
+    {
+        state[5 + k] = pstate->a[k];
+        state[7 + k] = pstate->pk[k];
+        state[9 + k] = pstate->sr[k];
+    }
+    for (k = 0; k < 6; k++)
+    {
+        state[11 + k] = pstate->b[k];
+        state[17 + k] = pstate->dq[k];
+    }
+    state[23] = pstate->td;
+} /* g72x_save_state */
+
+void g72x_restore_state(G72x_STATE *pstate, const int32_t *state)
+{
+    int k;
+
+    pstate->yl = state[0];
+    pstate->yu = state[1];
+    pstate->dms = state[2];
+    pstate->dml = state[3];
+    pstate->ap = state[4];
+    for (k = 0; k < 2; k++)
+    {
+        pstate->a[k] = state[5 + k];
+        pstate->pk[k] = state[7 + k];
+        pstate->sr[k] = state[9 + k];
+    }
+    for (k = 0; k < 6; k++)
+    {
+        pstate->b[k] = state[11 + k];
+        pstate->dq[k] = state[17 + k];
+    }
+    pstate->td = state[23];
+} /* g72x_restore_state */
+
+int g72x_check_state(const int32_t *state)
+{
+    int k;
+
+    /* update () keeps yu in [544, 5120] and yl between 64 times those. */
+    if (state[0] < 34816 || state[0] > 327680 || state[1] < 544 || state[1] > 5120)
+        return 0;
+    /* Smoothed from fi, which is at most 0xE00. */
+    if (state[2] < 0 || state[2] > 0xE00 || state[3] < 0 || state[3] > 0xE00 << 2)
+        return 0;
+    if (state[4] < 0 || state[4] > 0x200 || (state[23] != 0 && state[23] != 1))
+        return 0;
+    /* LIMC and LIMD. */
+    if (state[6] < -12288 || state[6] > 12288 || abs(state[5]) > 15360 - state[6])
+        return 0;
+    for (k = 0; k < 2; k++)
+    {
+        if (state[7 + k] != 0 && state[7 + k] != 1)
+            return 0;
+        /* Sign, 4 bit exponent and 6 bit mantissa. */
+        if (state[9 + k] < -0x400 || state[9 + k] >= 0x400)
+            return 0;
+    }
+    for (k = 0; k < 6; k++)
+    {
+        if (state[11 + k] < SHRT_MIN || state[11 + k] > SHRT_MAX)
+            return 0;
+        if (state[17 + k] < -0x400 || state[17 + k] >= 0x400)
+            return 0;
+    }
+
+    return 1;
+} /* g72x_check_state */
+
 /*
  * predictor_zero ()
  *
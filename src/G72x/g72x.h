@@ -24,6 +24,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 /*
 ** Number of samples per block to process.
 ** Must be a common multiple of possible bits per sample : 2, 3, 4, 5 and 8.
@@ -89,3 +91,17 @@ int g72x_encode_block(struct g72x_state *pstate, short *samples, unsigned char *
 **	(up to G72x_BLOCK_SIZE) samples before calling the function.
 **	When it returns, the caller can read out bytes encoded bytes.
 */
+
+/*
+**	Number of int32_t values g72x_save_state () stores, enough to carry on
+**	decoding from the same point after g72x_restore_state ().
+*/
+#define G72x_STATE_LEN (24)
+
+void g72x_save_state(const struct g72x_state *pstate, int32_t *state);
+void g72x_restore_state(struct g72x_state *pstate, const int32_t *state);
+int g72x_check_state(const int32_t *state);
+/*
+**	Return 1 if every value of a saved state is one the coder can reach,
+**	0 otherwise.
+*/
@@ -37,6 +37,10 @@ void gsm_init(gsm);
 
 void gsm_destroy(gsm);
 
+/* Added for sndfile2k, used to decode a stream in parallel runs. */
+void gsm_copy(gsm dest, gsm src);
+int gsm_decoder_state_equal(gsm a, gsm b);
+
 int gsm_print(FILE *, gsm, gsm_byte *);
 int gsm_option(gsm, int, int *);
 
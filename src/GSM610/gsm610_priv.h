@@ -8,6 +8,8 @@
 
 #include <stdint.h>
 
+#include "gsm610_simd.h"
+
 /* Added by Erik de Castro Lopo */
 #define USE_FLOAT_MUL
 #define FAST
@@ -0,0 +1,57 @@
+/*
+** Copyright (C) 2026 agent <agent@local>
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation; either version 2.1 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *  Vectorised versions of some of the loops, defined in simd.cpp. Each
+ *  returns 0 when there is no kernel for the running CPU and the caller
+ *  has to run its own loop. The results are bit exact with the loops.
+ */
+
+/* lpc.c, Autocorrelation () sums, before the doubling. */
+int gsm_simd_autocorrelation(const float *s, /* [0..159]    IN  */
+                             int32_t *L_ACF); /* [0..8]      OUT */
+
+/* long_term.c, cross correlations for lags 40..120. */
+int gsm_simd_ltp_correlation(const float *wt, /* [0..39]     IN  */
+                             const float *dp, /* [-120..-1]  IN  */
+                             float *L_corr); /* [0..80]     OUT */
+
+/* rpe.c, Weighting_filter (). */
+int gsm_simd_weighting_filter(const int16_t *e, /* [-5..-1][0..39][40..44] IN  */
+                              int16_t *x); /* [0..39]                 OUT */
+
+/* rpe.c, energy of each RPE grid, before the doubling. */
+int gsm_simd_grid_energy(const int16_t *x, /* [0..39]     IN  */
+                         int32_t *L_energy); /* [0..3]      OUT */
+
+/* long_term.c, reconstruction of drp [0..39] in the long term synthesis. */
+int gsm_simd_ltp_synthesis(int16_t brp, const int16_t *lagged, /* drp - Nr [0..39]  IN  */
+                           const int16_t *erp, /* [0..39]           IN  */
+                           int16_t *drp); /* [0..39]           OUT */
+
+#ifdef __cplusplus
+}
+#endif
@@ -33,3 +33,24 @@ void gsm_init(gsm state)
     memset(state, 0, sizeof(struct gsm_state));
     state->nrp = 40;
 }
+
+/* Added for sndfile2k. */
+void gsm_copy(gsm dest, gsm src)
+{
+    memcpy(dest, src, sizeof(struct gsm_state));
+}
+
+/*
+ * Added for sndfile2k. Two decoders in equal states decode the rest of a
+ * stream to the same samples. Only what gsm_decode () reads back from the
+ * state counts: the lag history dp0 [0..119], the synthesis filter v [0..7],
+ * the deemphasis memory, the last valid lag, the previous frame's LARs and
+ * the WAV49 frame parity.
+ */
+int gsm_decoder_state_equal(gsm a, gsm b)
+{
+    return memcmp(a->dp0, b->dp0, 120 * sizeof(a->dp0[0])) == 0 &&
+           memcmp(a->v, b->v, 8 * sizeof(a->v[0])) == 0 && a->msr == b->msr && a->nrp == b->nrp &&
+           memcmp(a->LARpp[!a->j], b->LARpp[!b->j], sizeof(a->LARpp[0])) == 0 && a->wav_fmt == b->wav_fmt &&
+           (!a->wav_fmt || a->frame_index == b->frame_index);
+}
@@ -604,6 +604,7 @@ static void Calculation_of_the_LTP_parameters(register int16_t *din, /* [0..39]
 
     float wt_float[40];
     float dp_float_base[120], *dp_float = dp_float_base + 120;
+    float L_corr[81];
 
     int32_t L_max, L_power;
     int16_t R, S, dmax, scal;
@@ -649,16 +650,26 @@ static void Calculation_of_the_LTP_parameters(register int16_t *din, /* [0..39]
     L_max = 0;
     Nc = 40; /* index for the maximum cross-correlation */
 
-    for (lambda = 40; lambda <= 120; lambda += 9)
+    if (gsm_simd_ltp_correlation(wt_float, dp_float, L_corr))
     {
-        /*  Calculate L_result for l = lambda .. lambda + 9. */
-        register float *lp = dp_float - lambda;
+        for (lambda = 40; lambda <= 120; lambda++)
+            if (L_corr[lambda - 40] > L_max)
+            {
+                L_max = (int32_t)L_corr[lambda - 40];
+                Nc = lambda;
+            }
+    }
+    else
+        for (lambda = 40; lambda <= 120; lambda += 9)
+        {
+            /*  Calculate L_result for l = lambda .. lambda + 9. */
+            register float *lp = dp_float - lambda;
 
-        register float W;
-        register float a = lp[-8], b = lp[-7], c = lp[-6], d = lp[-5], e = lp[-4], f = lp[-3],
-                       g = lp[-2], h = lp[-1];
-        register float E;
-        register float S0 = 0, S1 = 0, S2 = 0, S3 = 0, S4 = 0, S5 = 0, S6 = 0, S7 = 0, S8 = 0;
+            register float W;
+            register float a = lp[-8], b = lp[-7], c = lp[-6], d = lp[-5], e = lp[-4], f = lp[-3],
+                           g = lp[-2], h = lp[-1];
+            register float E;
+            register float S0 = 0, S1 = 0, S2 = 0, S3 = 0, S4 = 0, S5 = 0, S6 = 0, S7 = 0, S8 = 0;
 
 #undef STEP
 #define STEP(K, a, b, c, d, e, f, g, h) \
@@ -692,50 +703,50 @@ static void Calculation_of_the_LTP_parameters(register int16_t *din, /* [0..39]
 #define STEP_G(K) STEP(K, g, h, a, b, c, d, e, f)
 #define STEP_H(K) STEP(K, h, a, b, c, d, e, f, g)
 
-        STEP_A(0);
-        STEP_B(1);
-        STEP_C(2);
-        STEP_D(3);
-        STEP_E(4);
-        STEP_F(5);
-        STEP_G(6);
-        STEP_H(7);
-
-        STEP_A(8);
-        STEP_B(9);
-        STEP_C(10);
-        STEP_D(11);
-        STEP_E(12);
-        STEP_F(13);
-        STEP_G(14);
-        STEP_H(15);
-
-        STEP_A(16);
-        STEP_B(17);
-        STEP_C(18);
-        STEP_D(19);
-        STEP_E(20);
-        STEP_F(21);
-        STEP_G(22);
-        STEP_H(23);
-
-        STEP_A(24);
-        STEP_B(25);
-        STEP_C(26);
-        STEP_D(27);
-        STEP_E(28);
-        STEP_F(29);
-        STEP_G(30);
-        STEP_H(31);
-
-        STEP_A(32);
-        STEP_B(33);
-        STEP_C(34);
-        STEP_D(35);
-        STEP_E(36);
-        STEP_F(37);
-        STEP_G(38);
-        STEP_H(39);
+            STEP_A(0);
+            STEP_B(1);
+            STEP_C(2);
+            STEP_D(3);
+            STEP_E(4);
+            STEP_F(5);
+            STEP_G(6);
+            STEP_H(7);
+
+            STEP_A(8);
+            STEP_B(9);
+            STEP_C(10);
+            STEP_D(11);
+            STEP_E(12);
+            STEP_F(13);
+            STEP_G(14);
+            STEP_H(15);
+
+            STEP_A(16);
+            STEP_B(17);
+            STEP_C(18);
+            STEP_D(19);
+            STEP_E(20);
+            STEP_F(21);
+            STEP_G(22);
+            STEP_H(23);
+
+            STEP_A(24);
+            STEP_B(25);
+            STEP_C(26);
+            STEP_D(27);
+            STEP_E(28);
+            STEP_F(29);
+            STEP_G(30);
+            STEP_H(31);
+
+            STEP_A(32);
+            STEP_B(33);
+            STEP_C(34);
+            STEP_D(35);
+            STEP_E(36);
+            STEP_F(37);
+            STEP_G(38);
+            STEP_H(39);
 
 #undef STEP_A
 #undef STEP_B
@@ -746,52 +757,52 @@ static void Calculation_of_the_LTP_parameters(register int16_t *din, /* [0..39]
 #undef STEP_G
 #undef STEP_H
 
-        if (S0 > L_max)
-        {
-            L_max = (int32_t)S0;
-            Nc = lambda;
-        }
-        if (S1 > L_max)
-        {
-            L_max = (int32_t)S1;
-            Nc = lambda + 1;
-        }
-        if (S2 > L_max)
-        {
-            L_max = (int32_t)S2;
-            Nc = lambda + 2;
-        }
-        if (S3 > L_max)
-        {
-            L_max = (int32_t)S3;
-            Nc = lambda + 3;
-        }
-        if (S4 > L_max)
-        {
-            L_max = (int32_t)S4;
-            Nc = lambda + 4;
-        }
-        if (S5 > L_max)
-        {
-            L_max = (int32_t)S5;
-            Nc = lambda + 5;
-        }
-        if (S6 > L_max)
-        {
-            L_max = (int32_t)S6;
-            Nc = lambda + 6;
-        }
-        if (S7 > L_max)
-        {
-            L_max = (int32_t)S7;
-            Nc = lambda + 7;
-        }
-        if (S8 > L_max)
-        {
-            L_max = (int32_t)S8;
-            Nc = lambda + 8;
+            if (S0 > L_max)
+            {
+                L_max = (int32_t)S0;
+                Nc = lambda;
+            }
+            if (S1 > L_max)
+            {
+                L_max = (int32_t)S1;
+                Nc = lambda + 1;
+            }
+            if (S2 > L_max)
+            {
+                L_max = (int32_t)S2;
+                Nc = lambda + 2;
+            }
+            if (S3 > L_max)
+            {
+                L_max = (int32_t)S3;
+                Nc = lambda + 3;
+            }
+            if (S4 > L_max)
+            {
+                L_max = (int32_t)S4;
+                Nc = lambda + 4;
+            }
+            if (S5 > L_max)
+            {
+                L_max = (int32_t)S5;
+                Nc = lambda + 5;
+            }
+            if (S6 > L_max)
+            {
+                L_max = (int32_t)S6;
+                Nc = lambda + 6;
+            }
+            if (S7 > L_max)
+            {
+                L_max = (int32_t)S7;
+                Nc = lambda + 7;
+            }
+            if (S8 > L_max)
+            {
+                L_max = (int32_t)S8;
+                Nc = lambda + 8;
+            }
         }
-    }
     *Nc_out = Nc;
 
     L_max <<= 1;
@@ -1241,11 +1252,12 @@ void Gsm_Long_Term_Synthesis_Filtering(struct gsm_state *S,
 	 */
     assert(brp != MIN_WORD);
 
-    for (k = 0; k <= 39; k++)
-    {
-        drpp = GSM_MULT_R(brp, drp[k - Nr]);
-        drp[k] = GSM_ADD(erp[k], drpp);
-    }
+    if (!gsm_simd_ltp_synthesis(brp, drp - Nr, erp, drp))
+        for (k = 0; k <= 39; k++)
+        {
+            drpp = GSM_MULT_R(brp, drp[k - Nr]);
+            drp[k] = GSM_ADD(erp[k], drpp);
+        }
 
     /*
 	 *  Update of the reconstructed short term residual signal
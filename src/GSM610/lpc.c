@@ -89,6 +89,9 @@ static void Autocorrelation(int16_t *s, /* [0..159] IN/OUT  */
 
     /*  Compute the L_ACF [..].
 	 */
+#ifdef USE_FLOAT_MUL
+    if (!gsm_simd_autocorrelation(float_s, L_ACF))
+#endif
     {
 #ifdef USE_FLOAT_MUL
         register float *sp = float_s;
@@ -165,10 +168,11 @@ static void Autocorrelation(int16_t *s, /* [0..159] IN/OUT  */
             STEP(7);
             STEP(8);
         }
-
-        for (k = 9; k--;)
-            L_ACF[k] = SASL_L(L_ACF[k], 1);
     }
+
+    for (k = 9; k--;)
+        L_ACF[k] = SASL_L(L_ACF[k], 1);
+
     /*   Rescaling of the array s [0..159]
 	 */
     if (scalauto > 0)
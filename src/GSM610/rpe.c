@@ -41,6 +41,9 @@ static void Weighting_filter(register int16_t *e, /* signal [-5..0.39.44] IN  */
 	 *  (e[-5..-1] and e[40..44] are allocated by the caller,
 	 *  are initially zero and are not written anywhere.)
 	 */
+    if (gsm_simd_weighting_filter(e, x))
+        return;
+
     e -= 5;
 
     /*  Compute the signal x[0..39]
@@ -117,6 +120,7 @@ static void RPE_grid_selection(int16_t *x, /* [0..39]  IN  */
     int16_t Mc;
 
     int32_t L_common_0_3;
+    int32_t L_energy[4];
 
     EM = 0;
     Mc = 0;
@@ -142,89 +146,102 @@ static void RPE_grid_selection(int16_t *x, /* [0..39]  IN  */
 	 * }
 	 */
 
+    if (gsm_simd_grid_energy(x, L_energy))
+    {
+        EM = L_energy[0] << 1;
+        for (i = 1; i <= 3; i++)
+            if ((L_energy[i] << 1) > EM)
+            {
+                Mc = i;
+                EM = L_energy[i] << 1;
+            }
+    }
+    else
+    {
 #undef STEP
 #define STEP(m, i)                    \
     L_temp = SASR_W(x[m + 3 * i], 2); \
     L_result += L_temp * L_temp;
 
-    /* common part of 0 and 3 */
-
-    L_result = 0;
-    STEP(0, 1);
-    STEP(0, 2);
-    STEP(0, 3);
-    STEP(0, 4);
-    STEP(0, 5);
-    STEP(0, 6);
-    STEP(0, 7);
-    STEP(0, 8);
-    STEP(0, 9);
-    STEP(0, 10);
-    STEP(0, 11);
-    STEP(0, 12);
-    L_common_0_3 = L_result;
-
-    /* i = 0 */
-
-    STEP(0, 0);
-    L_result <<= 1; /* implicit in L_MULT */
-    EM = L_result;
-
-    /* i = 1 */
-
-    L_result = 0;
-    STEP(1, 0);
-    STEP(1, 1);
-    STEP(1, 2);
-    STEP(1, 3);
-    STEP(1, 4);
-    STEP(1, 5);
-    STEP(1, 6);
-    STEP(1, 7);
-    STEP(1, 8);
-    STEP(1, 9);
-    STEP(1, 10);
-    STEP(1, 11);
-    STEP(1, 12);
-    L_result <<= 1;
-    if (L_result > EM)
-    {
-        Mc = 1;
+        /* common part of 0 and 3 */
+
+        L_result = 0;
+        STEP(0, 1);
+        STEP(0, 2);
+        STEP(0, 3);
+        STEP(0, 4);
+        STEP(0, 5);
+        STEP(0, 6);
+        STEP(0, 7);
+        STEP(0, 8);
+        STEP(0, 9);
+        STEP(0, 10);
+        STEP(0, 11);
+        STEP(0, 12);
+        L_common_0_3 = L_result;
+
+        /* i = 0 */
+
+        STEP(0, 0);
+        L_result <<= 1; /* implicit in L_MULT */
         EM = L_result;
-    }
 
-    /* i = 2 */
-
-    L_result = 0;
-    STEP(2, 0);
-    STEP(2, 1);
-    STEP(2, 2);
-    STEP(2, 3);
-    STEP(2, 4);
-    STEP(2, 5);
-    STEP(2, 6);
-    STEP(2, 7);
-    STEP(2, 8);
-    STEP(2, 9);
-    STEP(2, 10);
-    STEP(2, 11);
-    STEP(2, 12);
-    L_result <<= 1;
-    if (L_result > EM)
-    {
-        Mc = 2;
-        EM = L_result;
-    }
+        /* i = 1 */
+
+        L_result = 0;
+        STEP(1, 0);
+        STEP(1, 1);
+        STEP(1, 2);
+        STEP(1, 3);
+        STEP(1, 4);
+        STEP(1, 5);
+        STEP(1, 6);
+        STEP(1, 7);
+        STEP(1, 8);
+        STEP(1, 9);
+        STEP(1, 10);
+        STEP(1, 11);
+        STEP(1, 12);
+        L_result <<= 1;
+        if (L_result > EM)
+        {
+            Mc = 1;
+            EM = L_result;
+        }
 
-    /* i = 3 */
+        /* i = 2 */
+
+        L_result = 0;
+        STEP(2, 0);
+        STEP(2, 1);
+        STEP(2, 2);
+        STEP(2, 3);
+        STEP(2, 4);
+        STEP(2, 5);
+        STEP(2, 6);
+        STEP(2, 7);
+        STEP(2, 8);
+        STEP(2, 9);
+        STEP(2, 10);
+        STEP(2, 11);
+        STEP(2, 12);
+        L_result <<= 1;
+        if (L_result > EM)
+        {
+            Mc = 2;
+            EM = L_result;
+        }
 
-    L_result = L_common_0_3;
-    STEP(3, 12);
-    L_result <<= 1;
-    if (L_result > EM)
-    {
-        Mc = 3;
-        EM = L_result;
+        /* i = 3 */
+
+        L_result = L_common_0_3;
+        STEP(3, 12);
+        L_result <<= 1;
+        if (L_result > EM)
+        {
+            Mc = 3;
+            EM = L_result;
+        }
     }
 
     /*  Down-sampling by a factor 3 to get the selected xM [0..12]
@@ -38,10 +38,46 @@ extern "C" {
 }
 #endif
 
+#include <algorithm>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+
 #define ALAC_MAX_FRAME_SIZE (8192)
 #define ALAC_BYTE_BUFFER_SIZE (0x20000)
 #define ALAC_MAX_CHANNEL_COUNT (8) // Same as kALACMaxChannels in /ALACAudioTypes.h
 
+/*
+** Pooled encoding, see SFC_SET_ENCODER_THREADS.
+**
+** ALAC packets decode independently of each other, so full packets are
+** collected into a batch of ALAC_POOL_PACKETS per thread and each thread
+** encodes a run of them with its own copy of the encoder. The packets are
+** written in order once all threads are done. The encoder adapts its
+** predictor from packet to packet, so the output is not byte for byte the
+** same as a serial encode, but it decodes to the same samples.
+*/
+#define ALAC_MAX_ENCODER_THREADS (64)
+#define ALAC_POOL_PACKETS (16)
+
+struct ALAC_WORKER
+{
+    ALAC_ENCODER encoder;
+    /* Encoded packets of the run back to back. */
+    std::vector<uint8_t> output;
+};
+
+struct ALAC_POOL
+{
+    std::vector<ALAC_WORKER> workers;
+    /* Input of each packet, frames_per_block frames apart. */
+    std::vector<int32_t> input;
+    /* Frames in and encoded size of each packet. */
+    std::vector<uint32_t> frames, bytes;
+    uint32_t capacity, filled;
+};
+
 typedef struct
 {
     uint32_t current, count, allocated;
@@ -69,8 +105,7 @@ typedef struct
         ALAC_ENCODER encoder;
     };
 
-    char enctmpname[512];
-    FILE *enctmp;
+    ALAC_POOL *pool;
 
     uint8_t byte_buffer[ALAC_MAX_CHANNEL_COUNT * ALAC_BYTE_BUFFER_SIZE];
 
@@ -88,6 +123,11 @@ static size_t alac_read_i(SndFile *psf, int *ptr, size_t len);
 static size_t alac_read_f(SndFile *psf, float *ptr, size_t len);
 static size_t alac_read_d(SndFile *psf, double *ptr, size_t len);
 
+static size_t alac_read_s_planar(SndFile *psf, short *const *ptr, size_t frames);
+static size_t alac_read_i_planar(SndFile *psf, int *const *ptr, size_t frames);
+static size_t alac_read_f_planar(SndFile *psf, float *const *ptr, size_t frames);
+static size_t alac_read_d_planar(SndFile *psf, double *const *ptr, size_t frames);
+
 static size_t alac_write_s(SndFile *psf, const short *ptr, size_t len);
 static size_t alac_write_i(SndFile *psf, const int *ptr, size_t len);
 static size_t alac_write_f(SndFile *psf, const float *ptr, size_t len);
@@ -99,7 +139,7 @@ static int alac_close(SndFile *psf);
 static int alac_byterate(SndFile *psf);
 
 static int alac_decode_block(SndFile *psf, ALAC_PRIVATE *plac);
-static int alac_encode_block(ALAC_PRIVATE *plac);
+static int alac_encode_block(SndFile *psf, ALAC_PRIVATE *plac);
 
 static uint32_t alac_kuki_read(SndFile *psf, uint32_t kuki_offset, uint8_t *kuki,
                                size_t kuki_maxlen);
@@ -108,6 +148,8 @@ static PAKT_INFO *alac_pakt_alloc(uint32_t initial_count);
 static PAKT_INFO *alac_pakt_read_decode(SndFile *psf, uint32_t pakt_offset);
 static PAKT_INFO *alac_pakt_append(PAKT_INFO *info, uint32_t value);
 static uint8_t *alac_pakt_encode(const SndFile *psf, uint32_t *pakt_size);
+static void alac_kuki_save(SndFile *psf, ALAC_PRIVATE *plac);
+static int alac_pool_run(SndFile *psf, ALAC_PRIVATE *plac);
 static sf_count_t alac_pakt_block_offset(const PAKT_INFO *info, uint32_t block);
 
 static const char *alac_error_string(int error);
@@ -176,16 +218,12 @@ void alac_get_desc_chunk_items(int subformat, uint32_t *fmt_flags, uint32_t *fra
 static int alac_close(SndFile *psf)
 {
     ALAC_PRIVATE *plac;
-    BUF_UNION ubuf;
 
     plac = (ALAC_PRIVATE *)psf->m_codec_data;
 
     if (psf->m_mode == SFM_WRITE)
     {
-        ALAC_ENCODER *penc = &plac->encoder;
-        SF_CHUNK_INFO chunk_info;
-        size_t readcount;
-        uint8_t kuki_data[1024];
+        uint8_t *pakt_data;
         uint32_t pakt_size = 0, saved_partial_block_frames;
 
         plac->final_write_block = 1;
@@ -196,37 +234,44 @@ static int alac_close(SndFile *psf)
          * block.
          */
         if (plac->partial_block_frames && plac->partial_block_frames < plac->frames_per_block)
-            alac_encode_block(plac);
+            alac_encode_block(psf, plac);
 
         plac->partial_block_frames = saved_partial_block_frames;
 
-        alac_get_magic_cookie(penc, kuki_data, &plac->kuki_size);
-
-        memset(&chunk_info, 0, sizeof(chunk_info));
-        chunk_info.id_size = snprintf(chunk_info.id, sizeof(chunk_info.id), "kuki");
-        chunk_info.data = kuki_data;
-        chunk_info.datalen = plac->kuki_size;
-        psf_save_write_chunk(&psf->m_wchunks, &chunk_info);
+        if (plac->pool != NULL)
+        {
+            alac_pool_run(psf, plac);
+            delete plac->pool;
+            plac->pool = NULL;
+        };
 
-        memset(&chunk_info, 0, sizeof(chunk_info));
-        chunk_info.id_size = snprintf(chunk_info.id, sizeof(chunk_info.id), "pakt");
-        chunk_info.data = alac_pakt_encode(psf, &pakt_size);
-        chunk_info.datalen = pakt_size;
-        psf_save_write_chunk(&psf->m_wchunks, &chunk_info);
+        /* The cookie has the same size as the one in the header, only its contents change. */
+        alac_kuki_save(psf, plac);
 
-        free(chunk_info.data);
-        chunk_info.data = NULL;
+        /*
+         * The packets went straight to the file, so the 'pakt' chunk goes after
+         * the data. The container writes its tailer after it and fixes the
+         * header sizes.
+         */
+        if (!psf->m_have_written && psf->write_header != NULL)
+            psf->write_header(psf, SF_FALSE);
 
-        psf->write_header(psf, 1);
+        psf->m_dataend = psf->ftell();
 
-        if (plac->enctmp != NULL)
+        if ((pakt_data = alac_pakt_encode(psf, &pakt_size)) == NULL)
+        {
+            psf->log_printf("%s : alac_pakt_encode() failed.\n", __func__);
+            psf->m_error = SFE_INTERNAL;
+        }
+        else
         {
-            fseek(plac->enctmp, 0, SEEK_SET);
+            psf->m_header.ptr[0] = 0;
+            psf->m_header.indx = 0;
+            psf->binheader_writef("Em8", BHWm(MAKE_MARKER('p', 'a', 'k', 't')), BHW8((sf_count_t)pakt_size));
+            psf->fwrite(psf->m_header.ptr, psf->m_header.indx, 1);
+            psf->fwrite(pakt_data, pakt_size, 1);
 
-            while ((readcount = fread(ubuf.ucbuf, 1, sizeof(ubuf.ucbuf), plac->enctmp)) > 0)
-                psf->fwrite(ubuf.ucbuf, 1, readcount);
-            fclose(plac->enctmp);
-            remove(plac->enctmpname);
+            free(pakt_data);
         };
     };
 
@@ -317,6 +362,11 @@ static int alac_reader_init(SndFile *psf, const struct ALAC_DECODER_INFO *info)
         psf->read_int = alac_read_i;
         psf->read_float = alac_read_f;
         psf->read_double = alac_read_d;
+
+        psf->read_short_planar = alac_read_s_planar;
+        psf->read_int_planar = alac_read_i_planar;
+        psf->read_float_planar = alac_read_f_planar;
+        psf->read_double_planar = alac_read_d_planar;
         break;
 
     default:
@@ -380,21 +430,48 @@ static int alac_writer_init(SndFile *psf)
 
     plac->frames_per_block = ALAC_FRAME_LENGTH;
 
-    plac->pakt_info = alac_pakt_alloc(2000);
-
-    if ((plac->enctmp = psf_open_tmpfile(plac->enctmpname, sizeof(plac->enctmpname))) == NULL)
-    {
-        psf->log_printf("Error : Failed to open temp file '%s' : \n", plac->enctmpname,
-                       strerror(errno));
-        return SFE_ALAC_FAIL_TMPFILE;
-    };
+    if ((plac->pakt_info = alac_pakt_alloc(2000)) == NULL)
+        return SFE_MALLOC_FAILED;
 
     alac_encoder_init(&plac->encoder, psf->sf.samplerate, psf->sf.channels, alac_format_flags,
                       ALAC_FRAME_LENGTH);
 
+    /*
+     * Packets are written straight after the header, so the 'kuki' chunk has
+     * to be in it before the first write. It is updated on close.
+     */
+    alac_kuki_save(psf, plac);
+
     return 0;
 }
 
+static void alac_kuki_save(SndFile *psf, ALAC_PRIVATE *plac)
+{
+    SF_CHUNK_INFO chunk_info;
+    uint8_t kuki_data[1024];
+    uint32_t k;
+
+    plac->kuki_size = sizeof(kuki_data);
+    alac_get_magic_cookie(&plac->encoder, kuki_data, &plac->kuki_size);
+
+    for (k = 0; k < psf->m_wchunks.used; k++)
+    {
+        struct WRITE_CHUNK *chunk = &psf->m_wchunks.chunks[k];
+
+        if (chunk->mark32 == MAKE_MARKER('k', 'u', 'k', 'i') && chunk->len >= plac->kuki_size)
+        {
+            memcpy(chunk->data, kuki_data, plac->kuki_size);
+            return;
+        };
+    };
+
+    memset(&chunk_info, 0, sizeof(chunk_info));
+    chunk_info.id_size = snprintf(chunk_info.id, sizeof(chunk_info.id), "kuki");
+    chunk_info.data = kuki_data;
+    chunk_info.datalen = plac->kuki_size;
+    psf_save_write_chunk(&psf->m_wchunks, &chunk_info);
+}
+
 /*
  * ALAC block decoder and encoder.
  */
@@ -471,14 +548,180 @@ static int alac_decode_block(SndFile *psf, ALAC_PRIVATE *plac)
     return 1;
 }
 
-static int alac_encode_block(ALAC_PRIVATE *plac)
+/* Runs on a worker thread, encodes packets first to last - 1 of the batch. */
+static void alac_pool_encode(ALAC_POOL *pool, ALAC_WORKER *worker, uint32_t first, uint32_t last,
+                             size_t stride)
+{
+    size_t offset = 0;
+
+    for (uint32_t k = first; k < last; k++)
+    {
+        uint32_t num_bytes = 0;
+
+        alac_encode(&worker->encoder, pool->frames[k], pool->input.data() + k * stride,
+                    worker->output.data() + offset, &num_bytes);
+        pool->bytes[k] = num_bytes;
+        offset += num_bytes;
+    };
+}
+
+/* Encodes the packets of the batch and writes them out in order. */
+static int alac_pool_run(SndFile *psf, ALAC_PRIVATE *plac)
+{
+    ALAC_POOL *pool = plac->pool;
+    ALAC_ENCODER *penc = &plac->encoder;
+    const size_t stride = (size_t)plac->frames_per_block * plac->channels;
+    const uint32_t count = pool->filled;
+    const uint32_t n = std::min((uint32_t)pool->workers.size(), count);
+    std::vector<std::thread> threads;
+    uint32_t k, w;
+
+    if (count == 0)
+        return 1;
+
+    pool->filled = 0;
+
+    for (w = 1; w < n; w++)
+    {
+        try
+        {
+            threads.emplace_back(alac_pool_encode, pool, &pool->workers[w], count * w / n,
+                                 count * (w + 1) / n, stride);
+        }
+        catch (const std::system_error &)
+        {
+            alac_pool_encode(pool, &pool->workers[w], count * w / n, count * (w + 1) / n, stride);
+        };
+    };
+
+    alac_pool_encode(pool, &pool->workers[0], 0, count / n, stride);
+
+    for (auto &thread : threads)
+        thread.join();
+
+    for (w = 0; w < n; w++)
+    {
+        const uint8_t *output = pool->workers[w].output.data();
+
+        for (k = count * w / n; k < count * (w + 1) / n; k++)
+        {
+            if (psf->fwrite(output, 1, pool->bytes[k]) != (sf_count_t)pool->bytes[k])
+                return 0;
+            if ((plac->pakt_info = alac_pakt_append(plac->pakt_info, pool->bytes[k])) == NULL)
+                return 0;
+
+            output += pool->bytes[k];
+
+            /* The workers kept their own statistics, the cookie is made from these. */
+            penc->mTotalBytesGenerated += pool->bytes[k];
+            penc->mMaxFrameBytes = std::max(penc->mMaxFrameBytes, pool->bytes[k]);
+        };
+    };
+
+    return 1;
+}
+
+static int alac_pool_init(SndFile *psf, ALAC_PRIVATE *plac, int threads)
+{
+    ALAC_POOL *pool;
+
+    try
+    {
+        pool = new ALAC_POOL;
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SFE_MALLOC_FAILED;
+    };
+
+    pool->capacity = threads * ALAC_POOL_PACKETS;
+    pool->filled = 0;
+
+    try
+    {
+        pool->workers.resize(threads);
+        for (auto &worker : pool->workers)
+        {
+            /* Nothing has been encoded yet, so this is a freshly initialised encoder. */
+            worker.encoder = plac->encoder;
+            worker.output.resize((size_t)ALAC_POOL_PACKETS * plac->encoder.mMaxOutputBytes);
+        };
+        pool->input.resize((size_t)pool->capacity * plac->frames_per_block * plac->channels);
+        pool->frames.resize(pool->capacity);
+        pool->bytes.resize(pool->capacity);
+    }
+    catch (const std::bad_alloc &)
+    {
+        delete pool;
+        return SFE_MALLOC_FAILED;
+    };
+
+    delete plac->pool;
+    plac->pool = pool;
+
+    psf->log_printf("ALAC : encoding on %d threads.\n", threads);
+
+    return 0;
+}
+
+size_t alac_command(SndFile *psf, int command, void *data, size_t datasize)
+{
+    ALAC_PRIVATE *plac = (ALAC_PRIVATE *)psf->m_codec_data;
+    int threads;
+
+    switch (command)
+    {
+    case SFC_SET_ENCODER_THREADS:
+        if (plac == NULL || data == NULL || datasize != sizeof(int))
+            return SF_FALSE;
+
+        if (psf->m_mode != SFM_WRITE || psf->m_have_written)
+            return SF_FALSE;
+
+        if ((threads = *((int *)data)) < 0)
+            return SF_FALSE;
+
+        threads = std::min(threads, ALAC_MAX_ENCODER_THREADS);
+
+        if (threads < 2)
+        {
+            delete plac->pool;
+            plac->pool = NULL;
+            return SF_TRUE;
+        };
+
+        return alac_pool_init(psf, plac, threads) == 0 ? SF_TRUE : SF_FALSE;
+
+    default:
+        break;
+    };
+
+    return SF_FALSE;
+}
+
+static int alac_encode_block(SndFile *psf, ALAC_PRIVATE *plac)
 {
     ALAC_ENCODER *penc = &plac->encoder;
     uint32_t num_bytes = 0;
 
+    if (plac->pool != NULL)
+    {
+        ALAC_POOL *pool = plac->pool;
+
+        memcpy(pool->input.data() + (size_t)pool->filled * plac->frames_per_block * plac->channels,
+               plac->buffer, (size_t)plac->partial_block_frames * plac->channels * sizeof(int32_t));
+        pool->frames[pool->filled++] = plac->partial_block_frames;
+        plac->partial_block_frames = 0;
+
+        if (pool->filled == pool->capacity)
+            return alac_pool_run(psf, plac);
+
+        return 1;
+    };
+
     alac_encode(penc, plac->partial_block_frames, plac->buffer, plac->byte_buffer, &num_bytes);
 
-    if (fwrite(plac->byte_buffer, 1, num_bytes, plac->enctmp) != num_bytes)
+    if (psf->fwrite(plac->byte_buffer, 1, num_bytes) != (sf_count_t)num_bytes)
         return 0;
     if ((plac->pakt_info = alac_pakt_append(plac->pakt_info, num_bytes)) == NULL)
         return 0;
@@ -626,6 +869,87 @@ static size_t alac_read_d(SndFile *psf, double *ptr, size_t len)
     return total;
 }
 
+/*
+** Planar reads convert each channel of the decoded packet straight into its
+** buffer. The decoder itself interleaves as it unmixes stereo pairs, so the
+** samples are converted from its packet buffer in one pass, as the
+** interleaved reads do.
+*/
+static void alac_deinterleave(short *dest, const int *src, size_t frames, int channels, double)
+{
+    for (size_t k = 0; k < frames; k++)
+        dest[k] = src[k * channels] >> 16;
+}
+
+static void alac_deinterleave(int *dest, const int *src, size_t frames, int channels, double)
+{
+    for (size_t k = 0; k < frames; k++)
+        dest[k] = src[k * channels];
+}
+
+static void alac_deinterleave(float *dest, const int *src, size_t frames, int channels, double normfact)
+{
+    for (size_t k = 0; k < frames; k++)
+        dest[k] = (float)normfact * src[k * channels];
+}
+
+static void alac_deinterleave(double *dest, const int *src, size_t frames, int channels, double normfact)
+{
+    for (size_t k = 0; k < frames; k++)
+        dest[k] = normfact * src[k * channels];
+}
+
+template <typename T>
+static size_t alac_read_planar(SndFile *psf, T *const *ptr, size_t frames, double normfact)
+{
+    ALAC_PRIVATE *plac;
+    size_t readcount;
+    size_t total = 0;
+
+    if ((plac = (ALAC_PRIVATE *)psf->m_codec_data) == NULL)
+        return 0;
+
+    while (frames > 0)
+    {
+        if (plac->partial_block_frames >= plac->frames_this_block &&
+            alac_decode_block(psf, plac) == 0)
+            break;
+
+        readcount = plac->frames_this_block - plac->partial_block_frames;
+        readcount = readcount > frames ? frames : readcount;
+
+        for (int k = 0; k < plac->channels; k++)
+            alac_deinterleave(ptr[k] + total, plac->buffer + plac->partial_block_frames * plac->channels + k,
+                              readcount, plac->channels, normfact);
+
+        plac->partial_block_frames += readcount;
+        total += readcount;
+        frames -= readcount;
+    };
+
+    return total;
+}
+
+static size_t alac_read_s_planar(SndFile *psf, short *const *ptr, size_t frames)
+{
+    return alac_read_planar(psf, ptr, frames, 0.0);
+}
+
+static size_t alac_read_i_planar(SndFile *psf, int *const *ptr, size_t frames)
+{
+    return alac_read_planar(psf, ptr, frames, 0.0);
+}
+
+static size_t alac_read_f_planar(SndFile *psf, float *const *ptr, size_t frames)
+{
+    return alac_read_planar(psf, ptr, frames, (psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x80000000) : 1.0);
+}
+
+static size_t alac_read_d_planar(SndFile *psf, double *const *ptr, size_t frames)
+{
+    return alac_read_planar(psf, ptr, frames, (psf->m_norm_double == SF_TRUE) ? 1.0 / ((float)0x80000000) : 1.0);
+}
+
 static sf_count_t alac_seek(SndFile *psf, int mode, sf_count_t offset)
 {
     ALAC_PRIVATE *plac;
@@ -708,7 +1032,7 @@ static size_t alac_write_s(SndFile *psf, const short *ptr, size_t len)
         ptr += writecount;
 
         if (plac->partial_block_frames >= plac->frames_per_block)
-            alac_encode_block(plac);
+            alac_encode_block(psf, plac);
     };
 
     return total;
@@ -740,7 +1064,7 @@ static size_t alac_write_i(SndFile *psf, const int *ptr, size_t len)
         ptr += writecount;
 
         if (plac->partial_block_frames >= plac->frames_per_block)
-            alac_encode_block(plac);
+            alac_encode_block(psf, plac);
     };
 
     return total;
@@ -774,7 +1098,7 @@ static size_t alac_write_f(SndFile *psf, const float *ptr, size_t len)
         ptr += writecount;
 
         if (plac->partial_block_frames >= plac->frames_per_block)
-            alac_encode_block(plac);
+            alac_encode_block(psf, plac);
     };
 
     return total;
@@ -808,7 +1132,7 @@ static size_t alac_write_d(SndFile *psf, const double *ptr, size_t len)
         ptr += writecount;
 
         if (plac->partial_block_frames >= plac->frames_per_block)
-            alac_encode_block(plac);
+            alac_encode_block(psf, plac);
     };
 
     return total;
@@ -939,7 +1263,8 @@ static uint8_t *alac_pakt_encode(const SndFile *psf, uint32_t *pakt_size_out)
     plac = (const ALAC_PRIVATE *)psf->m_codec_data;
     info = plac->pakt_info;
 
-    allocated = 100 + 2 * info->count;
+    /* Packet sizes take up to 4 bytes each. */
+    allocated = 100 + 4 * info->count;
     if ((data = (uint8_t *)calloc(1, allocated)) == NULL)
         return NULL;
 
@@ -322,11 +322,11 @@ static inline void d2alaw_array(const double *ptr, size_t count, unsigned char *
 
 static size_t alaw_read_alaw2s(SndFile *psf, short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -345,11 +345,11 @@ static size_t alaw_read_alaw2s(SndFile *psf, short *ptr, size_t len)
 
 static size_t alaw_read_alaw2i(SndFile *psf, int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -368,14 +368,14 @@ static size_t alaw_read_alaw2i(SndFile *psf, int *ptr, size_t len)
 
 static size_t alaw_read_alaw2f(SndFile *psf, float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
     float normfact;
 
     normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x8000) : 1.0);
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -394,13 +394,13 @@ static size_t alaw_read_alaw2f(SndFile *psf, float *ptr, size_t len)
 
 static size_t alaw_read_alaw2d(SndFile *psf, double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
     double normfact;
 
     normfact = (psf->m_norm_double) ? 1.0 / ((double)0x8000) : 1.0;
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -419,11 +419,11 @@ static size_t alaw_read_alaw2d(SndFile *psf, double *ptr, size_t len)
 
 static size_t alaw_write_s2alaw(SndFile *psf, const short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -442,11 +442,11 @@ static size_t alaw_write_s2alaw(SndFile *psf, const short *ptr, size_t len)
 
 static size_t alaw_write_i2alaw(SndFile *psf, const int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -465,14 +465,14 @@ static size_t alaw_write_i2alaw(SndFile *psf, const int *ptr, size_t len)
 
 static size_t alaw_write_f2alaw(SndFile *psf, const float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
     float normfact;
 
     normfact = (float)((psf->m_norm_float == SF_TRUE) ? (1.0 * 0x7FFF) / 16.0 : 1.0 / 16);
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -491,14 +491,14 @@ static size_t alaw_write_f2alaw(SndFile *psf, const float *ptr, size_t len)
 
 static size_t alaw_write_d2alaw(SndFile *psf, const double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
     double normfact;
 
     normfact = (psf->m_norm_double) ? (1.0 * 0x7FFF) / 16.0 : 1.0 / 16.0;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
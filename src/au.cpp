@@ -196,17 +196,14 @@ int au_open(SndFile *psf)
 
     case SF_FORMAT_G721_32:
         error = g72x_init(psf);
-        psf->sf.seekable = SF_FALSE;
         break;
 
     case SF_FORMAT_G723_24:
         error = g72x_init(psf);
-        psf->sf.seekable = SF_FALSE;
         break;
 
     case SF_FORMAT_G723_40:
         error = g72x_init(psf);
-        psf->sf.seekable = SF_FALSE;
         break;
 
     default:
@@ -0,0 +1,257 @@
+/*
+** Copyright (C) 2026 agent <agent@local>
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation; either version 2.1 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+/*
+** Read-ahead buffering for any SF_STREAM.
+**
+** Header parsing reads a few bytes at a time and seeks back and forth within
+** the first few kilobytes of the file. The buffered stream serves those reads
+** from a single larger read of the underlying stream and keeps the file
+** position itself, so small reads, seeks and tell() cost no system calls.
+**
+** Writes go straight through to the underlying stream, dropping the cached
+** window if they overlap it. Reads at least as large as the window bypass it.
+*/
+
+#include "config.h"
+
+#include "common.h"
+#include "ref_ptr.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+class SF_BUFFERED_STREAM final: public SF_STREAM
+{
+    unsigned long m_ref = 0;
+    sf::ref_ptr<SF_STREAM> m_stream;
+
+    std::vector<unsigned char> m_buffer;
+    /* File offset of the first byte in m_buffer and number of valid bytes. */
+    sf_count_t m_start = 0;
+    sf_count_t m_len = 0;
+
+    /* Logical position and position of the underlying stream. */
+    sf_count_t m_pos = 0;
+    sf_count_t m_stream_pos = 0;
+
+    bool sync()
+    {
+        if (m_stream_pos == m_pos)
+            return true;
+
+        if (m_stream->seek(m_pos, SEEK_SET) != m_pos)
+            return false;
+
+        m_stream_pos = m_pos;
+        return true;
+    }
+
+public:
+    SF_BUFFERED_STREAM(SF_STREAM *stream, size_t buffer_size, sf_count_t position)
+        : m_buffer(buffer_size), m_pos(position), m_stream_pos(position)
+    {
+        m_stream.copy(stream);
+    }
+
+    SF_STREAM *source() const
+    {
+        return m_stream.get();
+    }
+
+    // Inherited via SF_STREAM
+    unsigned long ref() override
+    {
+        return ++m_ref;
+    }
+
+    void unref() override
+    {
+        m_ref--;
+        if (m_ref == 0)
+            delete this;
+    }
+
+    sf_count_t get_filelen() override
+    {
+        return m_stream->get_filelen();
+    }
+
+    sf_count_t seek(sf_count_t offset, int whence) override
+    {
+        sf_count_t new_pos;
+
+        switch (whence)
+        {
+        case SEEK_SET:
+            new_pos = offset;
+            break;
+
+        case SEEK_CUR:
+            new_pos = m_pos + offset;
+            break;
+
+        case SEEK_END:
+            /* Only the underlying stream knows where the end is. */
+            new_pos = m_stream->seek(offset, SEEK_END);
+            if (new_pos < 0)
+                return new_pos;
+            m_stream_pos = new_pos;
+            break;
+
+        default:
+            return -1;
+        }
+
+        if (new_pos < 0)
+            return -1;
+
+        /* The underlying stream is moved on the next read or write. */
+        m_pos = new_pos;
+
+        return m_pos;
+    }
+
+    sf_count_t read(void *ptr, sf_count_t count) override
+    {
+        unsigned char *dest = static_cast<unsigned char *>(ptr);
+        sf_count_t total = 0;
+        sf_count_t buffer_size = (sf_count_t)m_buffer.size();
+
+        while (count > 0)
+        {
+            if (m_pos >= m_start && m_pos < m_start + m_len)
+            {
+                sf_count_t n = (std::min)(count, m_start + m_len - m_pos);
+
+                memcpy(dest + total, m_buffer.data() + (m_pos - m_start), (size_t)n);
+                m_pos += n;
+                total += n;
+                count -= n;
+
+                /* A short window means the end of the file was reached. */
+                if (m_len < buffer_size && m_pos == m_start + m_len)
+                    break;
+                continue;
+            }
+
+            if (!sync())
+                break;
+
+            if (count >= buffer_size)
+            {
+                sf_count_t n = m_stream->read(dest + total, count);
+                if (n > 0)
+                {
+                    m_pos += n;
+                    m_stream_pos += n;
+                    total += n;
+                }
+                break;
+            }
+
+            sf_count_t n = m_stream->read(m_buffer.data(), buffer_size);
+            if (n <= 0)
+            {
+                m_len = 0;
+                break;
+            }
+
+            m_start = m_pos;
+            m_len = n;
+            m_stream_pos += n;
+        }
+
+        return total;
+    }
+
+    sf_count_t write(const void *ptr, sf_count_t count) override
+    {
+        if (!sync())
+            return 0;
+
+        sf_count_t n = m_stream->write(ptr, count);
+        if (n > 0)
+        {
+            /* Also drop it when appending to it, it may be a short window at EOF. */
+            if (m_pos <= m_start + m_len && m_pos + n >= m_start)
+                m_len = 0;
+            m_pos += n;
+            m_stream_pos += n;
+        }
+
+        return n;
+    }
+
+    sf_count_t tell() override
+    {
+        return m_pos;
+    }
+
+    void flush() override
+    {
+        m_stream->flush();
+    }
+
+    int set_filelen(sf_count_t len) override
+    {
+        m_len = 0;
+        return m_stream->set_filelen(len);
+    }
+};
+
+SF_STREAM *psf_buffered_stream_source(SF_STREAM *stream)
+{
+    SF_BUFFERED_STREAM *bs = dynamic_cast<SF_BUFFERED_STREAM *>(stream);
+
+    return bs ? bs->source() : nullptr;
+}
+
+int psf_open_buffered_stream(SF_STREAM *stream, size_t buffer_size, SF_STREAM **buffered)
+{
+    if (!stream || !buffered)
+        return SFE_BAD_VIRTUAL_IO;
+
+    *buffered = nullptr;
+
+    if (buffer_size == 0)
+        buffer_size = SF_STREAM_BUFFER_LEN;
+
+    /* The window is addressed by file offset, so the stream must be seekable. */
+    sf_count_t position = stream->tell();
+    if (position < 0)
+        return SFE_NOT_SEEKABLE;
+
+    SF_BUFFERED_STREAM *s = nullptr;
+    try
+    {
+        s = new SF_BUFFERED_STREAM(stream, buffer_size, position);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SFE_MALLOC_FAILED;
+    }
+
+    *buffered = static_cast<SF_STREAM *>(s);
+    s->ref();
+
+    return SFE_NO_ERROR;
+}
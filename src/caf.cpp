@@ -227,7 +227,7 @@ static int caf_close(SndFile *psf)
     return 0;
 }
 
-static size_t caf_command(SndFile *psf, int command, void *UNUSED(data), size_t UNUSED(datasize))
+static size_t caf_command(SndFile *psf, int command, void *data, size_t datasize)
 {
 	struct CAF_PRIVATE *pcaf;
 
@@ -240,6 +240,20 @@ static size_t caf_command(SndFile *psf, int command, void *UNUSED(data), size_t
         pcaf->chanmap_tag = aiff_caf_find_channel_layout_tag(psf->m_channel_map.data(), psf->sf.channels);
         return (pcaf->chanmap_tag != 0);
 
+    case SFC_SET_ENCODER_THREADS:
+        switch (SF_CODEC(psf->sf.format))
+        {
+        case SF_FORMAT_ALAC_16:
+        case SF_FORMAT_ALAC_20:
+        case SF_FORMAT_ALAC_24:
+        case SF_FORMAT_ALAC_32:
+            return alac_command(psf, command, data, datasize);
+
+        default:
+            break;
+        };
+        break;
+
     default:
         break;
     };
@@ -818,13 +832,28 @@ static int caf_write_tailer(SndFile *psf)
         psf->m_dataend = psf->m_dataoffset + psf->m_datalength;
     };
 
-    if (psf->m_dataend > 0)
-        psf->fseek(psf->m_dataend, SEEK_SET);
-    else
-        psf->m_dataend = psf->fseek(0, SEEK_END);
+    switch (SF_CODEC(psf->sf.format))
+    {
+    case SF_FORMAT_ALAC_16:
+    case SF_FORMAT_ALAC_20:
+    case SF_FORMAT_ALAC_24:
+    case SF_FORMAT_ALAC_32:
+        /* The codec has set the end of the data and written the 'pakt' chunk after it. */
+        if (psf->m_dataend <= 0)
+            psf->m_dataend = psf->ftell();
+        psf->fseek(0, SEEK_END);
+        break;
 
-    if (psf->m_dataend & 1)
-        psf->binheader_writef("z", BHWz(1));
+    default:
+        if (psf->m_dataend > 0)
+            psf->fseek(psf->m_dataend, SEEK_SET);
+        else
+            psf->m_dataend = psf->fseek(0, SEEK_END);
+
+        if (psf->m_dataend & 1)
+            psf->binheader_writef("z", BHWz(1));
+        break;
+    };
 
     if (psf->m_strings.flags & SF_STR_LOCATE_END)
         caf_write_strings(psf, SF_STR_LOCATE_END);
@@ -0,0 +1,330 @@
+/*
+** Copyright (C) 2026 agent <agent@local>
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation; either version 2.1 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+/*
+** Decoder state checkpoints for codecs which can only seek by decoding.
+**
+** G72x, NMS ADPCM, DWVW and VOX ADPCM predict every sample from the ones
+** before it, so the decoder state at a given frame is only known after
+** decoding everything up to it. The codecs save their state every so many
+** frames as they decode, and a seek restores the last checkpoint before the
+** goal and decodes forward at most one interval.
+*/
+
+#include "config.h"
+
+#include "common.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+struct SF_CHECKPOINTS
+{
+    int state_len = 0;
+    sf_count_t interval = SF_CHECKPOINT_INTERVAL;
+    bool (*check)(SndFile *psf, sf_count_t frame, sf_count_t offset, const int32_t *state) = nullptr;
+
+    /* Ordered by frame, states holds state_len values per checkpoint. */
+    std::vector<sf_count_t> frames;
+    std::vector<sf_count_t> offsets;
+    std::vector<int32_t> states;
+};
+
+SF_CHECKPOINTS *psf_checkpoints_new(int state_len,
+                                    bool (*check)(SndFile *psf, sf_count_t frame, sf_count_t offset,
+                                                  const int32_t *state))
+{
+    SF_CHECKPOINTS *cp = new (std::nothrow) SF_CHECKPOINTS;
+
+    if (cp == nullptr)
+        return nullptr;
+
+    cp->state_len = state_len;
+    cp->check = check;
+
+    return cp;
+}
+
+void psf_checkpoints_free(SF_CHECKPOINTS *cp)
+{
+    delete cp;
+}
+
+sf_count_t psf_checkpoints_next(const SF_CHECKPOINTS *cp)
+{
+    if (cp == nullptr)
+        return SF_COUNT_MAX;
+
+    return cp->frames.empty() ? 0 : cp->frames.back() + cp->interval;
+}
+
+void psf_checkpoints_add(SF_CHECKPOINTS *cp, sf_count_t frame, sf_count_t offset, const int32_t *state)
+{
+    if (frame < psf_checkpoints_next(cp))
+        return;
+
+    /* Running out of memory only costs speed. */
+    try
+    {
+        cp->states.insert(cp->states.end(), state, state + cp->state_len);
+        cp->frames.push_back(frame);
+        cp->offsets.push_back(offset);
+    }
+    catch (const std::bad_alloc &)
+    {
+        cp->states.resize(cp->frames.size() * cp->state_len);
+        cp->offsets.resize(cp->frames.size());
+    };
+}
+
+bool psf_checkpoints_find(const SF_CHECKPOINTS *cp, sf_count_t frame, sf_count_t *cp_frame, sf_count_t *offset,
+                          int32_t *state)
+{
+    if (cp == nullptr)
+        return false;
+
+    /* Index of the first checkpoint past frame. */
+    size_t k = std::upper_bound(cp->frames.begin(), cp->frames.end(), frame) - cp->frames.begin();
+    if (k == 0)
+        return false;
+    k--;
+
+    *cp_frame = cp->frames[k];
+    *offset = cp->offsets[k];
+    memcpy(state, cp->states.data() + k * cp->state_len, cp->state_len * sizeof(int32_t));
+
+    return true;
+}
+
+bool psf_seeks_by_decoding(const SndFile *psf)
+{
+    switch (SF_CODEC(psf->sf.format))
+    {
+    case SF_FORMAT_DPCM_8:
+    case SF_FORMAT_DPCM_16:
+        return true;
+
+    default:
+        break;
+    };
+
+    return psf->m_checkpoints != nullptr;
+}
+
+/* Keeps the checkpoint at frame 0, the codecs can't seek without it. */
+static void psf_checkpoints_set_interval(SF_CHECKPOINTS *cp, sf_count_t interval)
+{
+    cp->interval = interval;
+
+    if (cp->frames.size() > 1)
+    {
+        cp->frames.resize(1);
+        cp->offsets.resize(1);
+        cp->states.resize(cp->state_len);
+    };
+}
+
+/* Leading bytes of an exported seek index, the last one is the version. */
+static const unsigned char checkpoint_magic[] = {'S', 'f', 'C', 'p', 1};
+
+static uint64_t zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint64_t value)
+{
+    return (int32_t)((uint32_t)(value >> 1) ^ (0 - (uint32_t)(value & 1)));
+}
+
+/*
+** The blob is the magic followed by LEB128 varints: the format, the channel
+** count, the file length, the state length and the checkpoint count, and then
+** for each checkpoint the increase of the frame and of the file offset over
+** the previous one and the zigzag encoded state values. Nothing is written
+** unless the whole blob fits, the return value is its size either way.
+*/
+static size_t psf_checkpoints_export(SndFile *psf, const SF_CHECKPOINTS *cp, void *data, size_t datasize)
+{
+    unsigned char *bytes = (unsigned char *)data;
+    size_t size = 0;
+
+    /* The first pass measures, the second one writes. */
+    for (int pass = 0; pass < 2; pass++)
+    {
+        size_t pos = sizeof(checkpoint_magic);
+
+        if (pass == 1)
+        {
+            if (data == nullptr || datasize < size)
+                break;
+            memcpy(bytes, checkpoint_magic, sizeof(checkpoint_magic));
+        };
+
+        unsigned char *out = pass == 1 ? bytes : nullptr;
+
+        pos = psf_varint_put(out, pos, size, (uint32_t)psf->sf.format);
+        pos = psf_varint_put(out, pos, size, (uint32_t)psf->sf.channels);
+        pos = psf_varint_put(out, pos, size, psf->get_filelen());
+        pos = psf_varint_put(out, pos, size, cp->state_len);
+        pos = psf_varint_put(out, pos, size, cp->frames.size());
+
+        sf_count_t frame = 0, offset = 0;
+        for (size_t k = 0; k < cp->frames.size(); k++)
+        {
+            pos = psf_varint_put(out, pos, size, cp->frames[k] - frame);
+            pos = psf_varint_put(out, pos, size, cp->offsets[k] - offset);
+            for (int n = 0; n < cp->state_len; n++)
+                pos = psf_varint_put(out, pos, size, zigzag(cp->states[k * cp->state_len + n]));
+            frame = cp->frames[k];
+            offset = cp->offsets[k];
+        };
+
+        size = pos;
+    };
+
+    return size;
+}
+
+/*
+** Only blobs exported for a file with the same format and length are accepted.
+** Every checkpoint has to lie in the data and pass the codec's check, the
+** first one must be at frame 0.
+*/
+static int psf_checkpoints_import(SndFile *psf, SF_CHECKPOINTS *cp, const void *data, size_t datasize)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    uint64_t format, channels, filelen, state_len, count, value;
+    size_t pos = sizeof(checkpoint_magic);
+
+    if (data == nullptr || datasize < sizeof(checkpoint_magic) ||
+        memcmp(bytes, checkpoint_magic, sizeof(checkpoint_magic)) != 0)
+        return SFE_BAD_COMMAND_PARAM;
+
+    if (!psf_varint_get(bytes, &pos, datasize, &format) || !psf_varint_get(bytes, &pos, datasize, &channels) ||
+        !psf_varint_get(bytes, &pos, datasize, &filelen) || !psf_varint_get(bytes, &pos, datasize, &state_len) ||
+        !psf_varint_get(bytes, &pos, datasize, &count))
+        return SFE_BAD_COMMAND_PARAM;
+
+    if (format != (uint32_t)psf->sf.format || channels != (uint32_t)psf->sf.channels ||
+        filelen != (uint64_t)psf->get_filelen() || state_len != (uint64_t)cp->state_len)
+        return SFE_BAD_COMMAND_PARAM;
+
+    /* Each checkpoint takes at least a byte per value. */
+    if (count == 0 || count > (datasize - pos) / (2 + state_len))
+        return SFE_BAD_COMMAND_PARAM;
+
+    SF_CHECKPOINTS loaded;
+    std::vector<int32_t> state(cp->state_len);
+    sf_count_t frame = 0, offset = 0;
+
+    try
+    {
+        loaded.frames.reserve(count);
+        loaded.offsets.reserve(count);
+        loaded.states.reserve(count * cp->state_len);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SFE_MALLOC_FAILED;
+    };
+
+    for (uint64_t k = 0; k < count; k++)
+    {
+        uint64_t frame_delta, offset_delta;
+
+        if (!psf_varint_get(bytes, &pos, datasize, &frame_delta) ||
+            !psf_varint_get(bytes, &pos, datasize, &offset_delta))
+            return SFE_BAD_COMMAND_PARAM;
+
+        /* Frames go up, from frame 0 on, and offsets stay within the data. */
+        if ((k == 0) != (frame_delta == 0) || frame_delta > (uint64_t)(psf->sf.frames - frame) ||
+            offset_delta > (uint64_t)(psf->m_dataoffset + psf->m_datalength - offset))
+            return SFE_BAD_COMMAND_PARAM;
+
+        frame += frame_delta;
+        offset += offset_delta;
+        if (offset < psf->m_dataoffset)
+            return SFE_BAD_COMMAND_PARAM;
+
+        for (int n = 0; n < cp->state_len; n++)
+        {
+            if (!psf_varint_get(bytes, &pos, datasize, &value) || value > UINT32_MAX)
+                return SFE_BAD_COMMAND_PARAM;
+            state[n] = unzigzag(value);
+        };
+
+        if (cp->check && !cp->check(psf, frame, offset, state.data()))
+            return SFE_BAD_COMMAND_PARAM;
+
+        loaded.frames.push_back(frame);
+        loaded.offsets.push_back(offset);
+        loaded.states.insert(loaded.states.end(), state.begin(), state.end());
+    };
+
+    cp->frames.swap(loaded.frames);
+    cp->offsets.swap(loaded.offsets);
+    cp->states.swap(loaded.states);
+
+    return 0;
+}
+
+size_t psf_checkpoints_command(SndFile *psf, int command, void *data, size_t datasize)
+{
+    SF_CHECKPOINTS *cp = psf->m_checkpoints;
+
+    if (cp == nullptr || psf->m_mode != SFM_READ)
+        return command == SFC_GET_SEEK_INDEX ? 0 : SF_FALSE;
+
+    switch (command)
+    {
+    case SFC_BUILD_SEEK_INDEX:
+    {
+        if (data != nullptr)
+        {
+            if (datasize != sizeof(sf_count_t) || *((sf_count_t *)data) <= 0)
+                return SF_FALSE;
+            if (*((sf_count_t *)data) != cp->interval)
+                psf_checkpoints_set_interval(cp, *((sf_count_t *)data));
+        };
+
+        /* Seeking to the end decodes and checkpoints everything on the way. */
+        sf_count_t current = psf->m_read_current;
+        if (psf->seek_from_start(psf, SFM_READ, psf->sf.frames) == PSF_SEEK_ERROR ||
+            psf->seek_from_start(psf, SFM_READ, current) == PSF_SEEK_ERROR)
+            return SF_FALSE;
+
+        psf->log_printf("Seek index : %d checkpoints\n", (int)cp->frames.size());
+        return SF_TRUE;
+    }
+
+    case SFC_GET_SEEK_INDEX:
+        return psf_checkpoints_export(psf, cp, data, datasize);
+
+    case SFC_SET_SEEK_INDEX:
+        return psf_checkpoints_import(psf, cp, data, datasize) == 0 ? SF_TRUE : SF_FALSE;
+
+    default:
+        break;
+    };
+
+    return SF_FALSE;
+}
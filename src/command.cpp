@@ -24,8 +24,13 @@
 
 #include "sndfile2k/sndfile2k.h"
 #include "common.h"
+#include "simd.h"
 
 #include <algorithm>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 static SF_FORMAT_INFO const simple_formats[] = {
     {SF_FORMAT_AIFF | SF_FORMAT_PCM_16, "AIFF (Apple/SGI 16 bit PCM)", "aiff"},
@@ -324,17 +329,17 @@ int psf_calc_max_all_channels(SndFile *psf, double *peaks, int normalize)
 
     data = ubuf.dbuf;
 
-    chan = 0;
-    readcount = len;
-    while (readcount > 0)
+    while ((readcount = (int)sf_readf_double((SNDFILE *)psf, data, len / psf->sf.channels)) > 0)
     {
-        readcount = sf_read_double((SNDFILE *)psf, data, len);
-        for (k = 0; k < readcount; k++)
+        for (k = 0; k < readcount; k++, data += psf->sf.channels)
         {
-            temp = fabs(data[k]);
-            peaks[chan] = temp > peaks[chan] ? temp : peaks[chan];
-            chan = (chan + 1) % psf->sf.channels;
+            for (chan = 0; chan < psf->sf.channels; chan++)
+            {
+                temp = fabs(data[chan]);
+                peaks[chan] = temp > peaks[chan] ? temp : peaks[chan];
+            };
         };
+        data = ubuf.dbuf;
     };
 
     sf_seek((SNDFILE *)psf, position, SEEK_SET); /* Return to original position. */
@@ -344,6 +349,239 @@ int psf_calc_max_all_channels(SndFile *psf, double *peaks, int normalize)
     return 0;
 }
 
+/*
+** Signal statistics. The file is split into parts which are read by clones of
+** the file in their own threads. Each part keeps its first and last frames so
+** that zero crossings at the part boundaries are counted when the parts are
+** merged.
+*/
+
+#define SIGNAL_STATS_MAX_THREADS (8)
+/* Parts shorter than this are not worth a thread of their own. */
+#define SIGNAL_STATS_MIN_FRAMES (1 << 16)
+#define SIGNAL_STATS_BUFFER_FRAMES (4096)
+
+struct SIGNAL_STATS_PART
+{
+    SNDFILE *file = nullptr;
+    sf_count_t start = 0;
+    /* Frames to read, the number of frames actually read on return. */
+    sf_count_t frames = 0;
+    int error = SFE_NO_ERROR;
+
+    std::vector<SIMD_SIGNAL_STATS> stats;
+    std::vector<double> first;
+    std::vector<double> last;
+    std::vector<double> buffer;
+};
+
+static void calc_signal_stats_part(SIGNAL_STATS_PART *part, int channels)
+{
+    const SIMD_KERNELS *kernels = psf_simd_kernels();
+    double *data = part->buffer.data();
+    sf_count_t remaining = part->frames, total = 0;
+
+    part->frames = 0;
+
+    if (sf_seek(part->file, part->start, SEEK_SET) != part->start)
+    {
+        part->error = SFE_BAD_SEEK;
+        return;
+    };
+
+    while (remaining > 0)
+    {
+        sf_count_t want = std::min(remaining, (sf_count_t)SIGNAL_STATS_BUFFER_FRAMES);
+        sf_count_t readcount = sf_readf_double(part->file, data, want);
+
+        if (readcount <= 0)
+            break;
+
+        if (total == 0)
+            std::copy(data, data + channels, part->first.begin());
+
+        /* The kernel takes the tail, the first frame is compared with the last block here. */
+        size_t head = kernels->stats(data, (size_t)readcount, channels, part->stats.data());
+
+        for (size_t k = 0; k < head; k++)
+        {
+            const double *frame = data + k * channels;
+            const double *before = k > 0 ? frame - channels : (total > 0 ? part->last.data() : NULL);
+
+            for (int chan = 0; chan < channels; chan++)
+            {
+                SIMD_SIGNAL_STATS &s = part->stats[chan];
+                double temp = fabs(frame[chan]);
+
+                s.peak = temp > s.peak ? temp : s.peak;
+                s.sum += frame[chan];
+                s.sum_sq += frame[chan] * frame[chan];
+                if (temp >= 1.0)
+                    s.clips++;
+                if (before && (frame[chan] < 0.0) != (before[chan] < 0.0))
+                    s.crossings++;
+            };
+        };
+
+        std::copy(data + (readcount - 1) * channels, data + readcount * channels, part->last.begin());
+
+        total += readcount;
+        remaining -= readcount;
+
+        if (readcount < want)
+            break;
+    };
+
+    part->frames = total;
+    part->error = sf_error(part->file);
+}
+
+int psf_calc_signal_stats(SndFile *psf, SF_SIGNAL_STATS *stats)
+{
+    // If the file is not seekable, there is nothing we can do.
+    if (!psf->sf.seekable)
+        return (psf->m_error = SFE_NOT_SEEKABLE);
+
+    if (!psf->read_double)
+        return (psf->m_error = SFE_UNIMPLEMENTED);
+
+    const int channels = psf->sf.channels;
+
+    int count = (int)std::min(psf->sf.frames / SIGNAL_STATS_MIN_FRAMES, (sf_count_t)SIGNAL_STATS_MAX_THREADS);
+    count = std::min(count, (int)std::thread::hardware_concurrency());
+    count = std::max(count, 1);
+
+    std::vector<SIGNAL_STATS_PART> parts;
+    std::vector<std::thread> threads;
+    try
+    {
+        parts.resize(count);
+        for (auto &part : parts)
+        {
+            part.stats.resize(channels);
+            part.first.resize(channels);
+            part.last.resize(channels);
+            part.buffer.resize(SIGNAL_STATS_BUFFER_FRAMES * channels);
+        };
+        threads.reserve(count);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return (psf->m_error = SFE_MALLOC_FAILED);
+    };
+
+    if (psf_seeks_by_decoding(psf))
+        count = 1;
+
+    if (count > 1)
+    {
+        for (int k = 0; k < count; k++)
+        {
+            if (sf_clone((SNDFILE *)psf, &parts[k].file) != SFE_NO_ERROR)
+            {
+                /* Not opened with sf_open(), read it all through this handle instead. */
+                for (int j = 0; j < k; j++)
+                    sf_close(parts[j].file);
+                count = 1;
+                break;
+            };
+
+            sf_command(parts[k].file, SFC_SET_NORM_DOUBLE, NULL, SF_TRUE);
+            parts[k].start = psf->sf.frames * k / count;
+            parts[k].frames = psf->sf.frames * (k + 1) / count - parts[k].start;
+        };
+    };
+
+    sf_count_t position = 0;
+    int save_state = 0;
+
+    if (count == 1)
+    {
+        parts.resize(1);
+        parts[0].file = (SNDFILE *)psf;
+        parts[0].frames = SF_COUNT_MAX;
+
+        position = sf_seek((SNDFILE *)psf, 0, SEEK_CUR);
+        save_state = sf_command((SNDFILE *)psf, SFC_GET_NORM_DOUBLE, NULL, 0);
+        sf_command((SNDFILE *)psf, SFC_SET_NORM_DOUBLE, NULL, SF_TRUE);
+    };
+
+    for (int k = 1; k < count; k++)
+    {
+        try
+        {
+            threads.emplace_back(calc_signal_stats_part, &parts[k], channels);
+        }
+        catch (const std::system_error &)
+        {
+            calc_signal_stats_part(&parts[k], channels);
+        };
+    };
+
+    calc_signal_stats_part(&parts[0], channels);
+
+    for (auto &thread : threads)
+        thread.join();
+
+    if (count > 1)
+    {
+        for (auto &part : parts)
+            sf_close(part.file);
+    }
+    else
+    {
+        sf_seek((SNDFILE *)psf, position, SEEK_SET);
+        sf_command((SNDFILE *)psf, SFC_SET_NORM_DOUBLE, NULL, save_state);
+    };
+
+    for (auto &part : parts)
+    {
+        if (part.error != SFE_NO_ERROR)
+            return (psf->m_error = part.error);
+    };
+
+    /* Merge the parts into the first one. */
+    SIGNAL_STATS_PART &total = parts[0];
+    const SIGNAL_STATS_PART *previous = &parts[0];
+
+    for (int k = 1; k < count; k++)
+    {
+        const SIGNAL_STATS_PART &part = parts[k];
+
+        if (part.frames == 0)
+            continue;
+
+        for (int chan = 0; chan < channels; chan++)
+        {
+            SIMD_SIGNAL_STATS &s = total.stats[chan];
+
+            s.peak = std::max(s.peak, part.stats[chan].peak);
+            s.sum += part.stats[chan].sum;
+            s.sum_sq += part.stats[chan].sum_sq;
+            s.clips += part.stats[chan].clips;
+            s.crossings += part.stats[chan].crossings;
+            if (previous->frames > 0 && (previous->last[chan] < 0.0) != (part.first[chan] < 0.0))
+                s.crossings++;
+        };
+
+        total.frames += part.frames;
+        previous = &part;
+    };
+
+    for (int chan = 0; chan < channels; chan++)
+    {
+        const SIMD_SIGNAL_STATS &s = total.stats[chan];
+
+        stats[chan].peak = s.peak;
+        stats[chan].rms = total.frames > 0 ? sqrt(s.sum_sq / total.frames) : 0.0;
+        stats[chan].dc_offset = total.frames > 0 ? s.sum / total.frames : 0.0;
+        stats[chan].clip_count = s.clips;
+        stats[chan].zero_crossing_rate = total.frames > 1 ? (double)s.crossings / (total.frames - 1) : 0.0;
+    };
+
+    return 0;
+}
+
 int psf_get_signal_max(SndFile *psf, double *peak)
 {
     int k;
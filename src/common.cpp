@@ -33,12 +33,15 @@
 #include "sfendian.h"
 #include "common.h"
 #include "sndfile_error.h"
+#include "shift.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 
 #include <cassert>
 #include <algorithm>
+#include <system_error>
+#include <thread>
 
 using namespace std;
 
@@ -59,7 +62,7 @@ int SndFile::open(const char *filename, SF_FILEMODE mode, SF_INFO *sfinfo)
     sf::ref_ptr<SF_STREAM> stream;
     m_error = psf_open_file_stream(filename, mode, stream.get_address_of());
     if (m_error == SFE_NO_ERROR)
-        m_error = open(stream, mode, sfinfo);
+        m_error = open(stream, (SF_FILEMODE)(mode & ~SFM_MMAP), sfinfo);
 
     return m_error;
 }
@@ -160,6 +163,10 @@ void SndFile::close()
     free(m_instrument);
     m_cues.clear();
     m_channel_map.clear();
+    m_borrowed = nullptr;
+    m_borrow_buffer.clear();
+    m_planar_buffer.clear();
+    m_io_buffer.clear();
     free(m_format_desc);
     free(m_strings.storage);
 
@@ -169,6 +176,8 @@ void SndFile::close()
     free(m_rchunks.chunks);
     free(m_wchunks.chunks);
     free(m_iterator);
+    psf_checkpoints_free(m_checkpoints);
+    m_checkpoints = nullptr;
     m_is_open = false;
 }
 
@@ -1461,6 +1470,136 @@ void psf_get_date_str(char *str, int maxlen)
     return;
 }
 
+/* Upper limit on the threads of psf_parallel_for(), as for sf_readf_*_parallel(). */
+#define PARALLEL_FOR_MAX_THREADS (64)
+
+void psf_parallel_for(void (*func)(void *data, int first, int last), void *data, int count, int grain)
+{
+    std::vector<std::thread> threads;
+    int parts;
+
+    parts = std::min(count / std::max(grain, 1), (int)std::thread::hardware_concurrency());
+    parts = std::min(parts, PARALLEL_FOR_MAX_THREADS);
+
+    if (parts < 2)
+    {
+        func(data, 0, count);
+        return;
+    };
+
+    for (int k = 1; k < parts; k++)
+    {
+        int first = (int)((int64_t)count * k / parts);
+        int last = (int)((int64_t)count * (k + 1) / parts);
+
+        try
+        {
+            threads.emplace_back(func, data, first, last);
+        }
+        catch (const std::system_error &)
+        {
+            func(data, first, last);
+        };
+    };
+
+    func(data, 0, count / parts);
+
+    for (auto &thread : threads)
+        thread.join();
+}
+
+bool psf_read_batch(SndFile *psf, unsigned char **batch, sf_count_t len)
+{
+    sf_count_t k;
+
+    if (*batch == NULL && (*batch = (unsigned char *)malloc(PSF_BATCH_LEN)) == NULL)
+        return false;
+
+    if ((k = psf->fread(*batch, 1, len)) != len)
+    {
+        if (k > 0)
+            psf->fseek(-k, SEEK_CUR);
+        return false;
+    };
+
+    return true;
+}
+
+size_t psf_read_widened(SndFile *psf, int *ptr, size_t len, size_t (*read_s)(SndFile *psf, short *ptr, size_t len))
+{
+    short *sptr = (short *)ptr;
+    size_t k, total;
+
+    total = read_s(psf, sptr, len);
+    for (k = total; k-- > 0;)
+        ptr[k] = arith_shift_left(sptr[k], 16);
+
+    return total;
+}
+
+size_t psf_read_widened(SndFile *psf, float *ptr, size_t len, size_t (*read_s)(SndFile *psf, short *ptr, size_t len))
+{
+    short *sptr = (short *)ptr;
+    size_t k, total;
+    float normfact;
+
+    normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x8000) : 1.0);
+
+    total = read_s(psf, sptr, len);
+    for (k = total; k-- > 0;)
+        ptr[k] = normfact * (float)(sptr[k]);
+
+    return total;
+}
+
+size_t psf_read_widened(SndFile *psf, double *ptr, size_t len, size_t (*read_s)(SndFile *psf, short *ptr, size_t len))
+{
+    short *sptr = (short *)ptr;
+    size_t k, total;
+    double normfact;
+
+    normfact = (psf->m_norm_double == SF_TRUE) ? 1.0 / ((double)0x8000) : 1.0;
+
+    total = read_s(psf, sptr, len);
+    for (k = total; k-- > 0;)
+        ptr[k] = normfact * (double)(sptr[k]);
+
+    return total;
+}
+
+size_t psf_varint_put(unsigned char *data, size_t pos, size_t datasize, uint64_t value)
+{
+    do
+    {
+        unsigned char byte = value & 0x7f;
+
+        value >>= 7;
+        if (value)
+            byte |= 0x80;
+        if (data && pos < datasize)
+            data[pos] = byte;
+        pos++;
+    } while (value);
+
+    return pos;
+}
+
+bool psf_varint_get(const unsigned char *data, size_t *pos, size_t datasize, uint64_t *value)
+{
+    *value = 0;
+
+    for (int shift = 0; shift < 64 && *pos < datasize; shift += 7)
+    {
+        unsigned char byte = data[(*pos)++];
+
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    };
+
+    return false;
+}
+
 int subformat_to_bytewidth(int format)
 {
     switch (format)
@@ -1933,6 +2072,21 @@ size_t SndFile::fwrite(const void *ptr, size_t bytes, size_t items)
         return 0;
 }
 
+/*
+** Points ubuf at the codec I/O buffer and returns its size in bytes. The
+** buffer belongs to the file, so it must not be held across calls that may
+** change the block size. Only the small default sized buffer is allocated
+** here, larger ones are allocated by SFC_SET_IO_BLOCK_SIZE.
+*/
+size_t SndFile::get_io_buffer(IO_BUFFER *ubuf)
+{
+    if (m_io_buffer.empty())
+        m_io_buffer.resize(m_io_block_size / sizeof(double));
+
+    ubuf->vbuf = m_io_buffer.data();
+    return m_io_block_size;
+}
+
 sf_count_t SndFile::ftell()
 {
     assert(m_stream);
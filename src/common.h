@@ -55,6 +55,8 @@
 
 #define SNDFILE_MAGICK (0x1234C0DE)
 #define SF_BUFFER_LEN (8192)
+#define SF_MIN_IO_BLOCK_SIZE (1024)
+#define SF_MAX_IO_BLOCK_SIZE (64 * 1024 * 1024)
 #define SF_FILENAME_LEN (1024)
 #define SF_SYSERR_LEN (256)
 #define SF_MAX_STRINGS (32)
@@ -306,8 +308,24 @@ typedef union
     unsigned char ucbuf[SF_BUFFER_LEN / sizeof(signed char)];
 } BUF_UNION;
 
+/*
+** Heap allocated counterpart of BUF_UNION, filled in by SndFile::get_io_buffer().
+** Its size is set per file with SFC_SET_IO_BLOCK_SIZE.
+*/
+typedef union
+{
+    void *vbuf;
+    double *dbuf;
+    float *fbuf;
+    int *ibuf;
+    short *sbuf;
+    signed char *scbuf;
+    unsigned char *ucbuf;
+} IO_BUFFER;
+
 struct DITHER_DATA;
 struct INTERLEAVE_DATA;
+struct SF_CHECKPOINTS;
 
 class SndFile: public ISndFile
 {
@@ -328,6 +346,8 @@ public:
 
 	int command(int cmd, void *data, int datasize) override;
 
+    int clone(ISndFile **clone) override;
+
 	sf_count_t seek(sf_count_t frames, int whence) override;
 
 	void writeSync(void) override;
@@ -352,6 +372,18 @@ public:
 	sf_count_t writeFloatFrames(const float *ptr, sf_count_t frames) override;
 	sf_count_t writeDoubleFrames(const double *ptr, sf_count_t frames) override;
 
+    sf_count_t borrowFrames(const void **ptr, sf_count_t frames) override;
+    int releaseFrames(const void *ptr) override;
+
+    sf_count_t readShortPlanar(short *const *ptr, sf_count_t frames) override;
+    sf_count_t readIntPlanar(int *const *ptr, sf_count_t frames) override;
+    sf_count_t readFloatPlanar(float *const *ptr, sf_count_t frames) override;
+    sf_count_t readDoublePlanar(double *const *ptr, sf_count_t frames) override;
+    sf_count_t writeShortPlanar(const short *const *ptr, sf_count_t frames) override;
+    sf_count_t writeIntPlanar(const int *const *ptr, sf_count_t frames) override;
+    sf_count_t writeFloatPlanar(const float *const *ptr, sf_count_t frames) override;
+    sf_count_t writeDoublePlanar(const double *const *ptr, sf_count_t frames) override;
+
     int getCurrentByterate() const override;
 
 	sf_count_t readRaw(void *ptr, sf_count_t bytes) override;
@@ -458,6 +490,21 @@ public:
     sf_count_t m_read_current = 0;
     sf_count_t m_write_current = 0;
 
+    /* Frames handed out by borrowFrames(), NULL if none are outstanding. */
+    const void *m_borrowed = nullptr;
+    /* Staging buffer for borrowFrames() when the data can't be used in place. */
+    std::vector<double> m_borrow_buffer;
+
+    /* Interleaved staging buffer for planar reads and writes, see read_planar(). */
+    std::vector<double> m_planar_buffer;
+
+    /*
+    ** Codec I/O buffer, see get_io_buffer(). Allocated on first use at the
+    ** default size, by SFC_SET_IO_BLOCK_SIZE otherwise.
+    */
+    size_t m_io_block_size = SF_BUFFER_LEN;
+    std::vector<double> m_io_buffer;
+
     /* This is a pointer to dynamically allocated file
 	** container format specific data.
 	*/
@@ -489,6 +536,15 @@ public:
     size_t (*write_float)(SndFile *, const float *ptr, size_t len) = nullptr;
     size_t (*write_double)(SndFile *, const double *ptr, size_t len) = nullptr;
 
+    /*
+    ** Optional readers for codecs which decode the channels apart anyway. They
+    ** store up to frames frames, ptr holds one pointer per channel.
+    */
+    size_t (*read_short_planar)(SndFile *, short *const *ptr, size_t frames) = nullptr;
+    size_t (*read_int_planar)(SndFile *, int *const *ptr, size_t frames) = nullptr;
+    size_t (*read_float_planar)(SndFile *, float *const *ptr, size_t frames) = nullptr;
+    size_t (*read_double_planar)(SndFile *, double *const *ptr, size_t frames) = nullptr;
+
     sf_count_t (*seek_from_start)(SndFile *, int mode, sf_count_t samples_from_start) = nullptr;
     int (*write_header)(SndFile *, int calc_length) = nullptr;
     size_t (*on_command)(SndFile *, int command, void *data, size_t datasize) = nullptr;
@@ -506,6 +562,9 @@ public:
     /* Chunk get/set. */
     SF_CHUNK_ITERATOR *m_iterator = nullptr;
 
+    /* Decoder checkpoints of codecs which seek by decoding, see psf_checkpoints_new(). */
+    SF_CHECKPOINTS *m_checkpoints = nullptr;
+
     READ_CHUNKS m_rchunks = {};
 	WRITE_CHUNKS m_wchunks = {};
 
@@ -551,6 +610,7 @@ public:
     sf_count_t fseek(sf_count_t offset, int whence);
     size_t fread(void *ptr, size_t bytes, size_t count);
     size_t fwrite(const void *ptr, size_t bytes, size_t count);
+    size_t get_io_buffer(IO_BUFFER *ubuf);
     sf_count_t ftell();
     sf_count_t get_filelen();
 
@@ -763,6 +823,10 @@ enum
 
     SFE_ALREADY_INITIALIZED,
 
+    SFE_FRAMES_BORROWED,
+    SFE_BAD_RELEASE,
+    SFE_NOT_CLONEABLE,
+
     SFE_MAX_ERROR /* This must be last in list. */
 };
 
@@ -813,6 +877,7 @@ void psf_generate_format_desc(SndFile *psf);
 
 double psf_calc_signal_max(SndFile *psf, int normalize);
 int psf_calc_max_all_channels(SndFile *psf, double *peaks, int normalize);
+int psf_calc_signal_stats(SndFile *psf, SF_SIGNAL_STATS *stats);
 
 int psf_get_signal_max(SndFile *psf, double *peak);
 int psf_get_max_all_channels(SndFile *psf, double *peaks);
@@ -831,10 +896,30 @@ int macos_guess_file_type(SndFile *psf, const char *filename);
 
 static void psf_log_syserr(SndFile *psf, int error);
 
+/* Files opened in SFM_READ | SFM_MMAP mode are memory mapped when possible. */
 int psf_open_file_stream(const char *filename, SF_FILEMODE mode, SF_STREAM **stream);
 #ifdef _WIN32
 int psf_open_file_stream(const wchar_t *filename, SF_FILEMODE mode, SF_STREAM **stream);
 #endif
+/* Returns the read only mapping of the whole stream or NULL if stream is not mapped. */
+const void *psf_stream_mapping(SF_STREAM *stream, sf_count_t *length);
+
+/* Default read-ahead window of psf_open_buffered_stream(). */
+#define SF_STREAM_BUFFER_LEN (64 * 1024)
+
+/*
+** Wraps a seekable stream in a read-ahead buffer, see buffered_stream.cpp.
+** A buffer_size of zero selects SF_STREAM_BUFFER_LEN.
+*/
+int psf_open_buffered_stream(SF_STREAM *stream, size_t buffer_size, SF_STREAM **buffered);
+/* Returns the stream wrapped by a buffered stream or NULL if stream isn't one. */
+SF_STREAM *psf_buffered_stream_source(SF_STREAM *stream);
+
+/*
+** Opens a second read stream on the file behind stream, with its own position.
+** Only memory mapped and pread() based file streams support this.
+*/
+int psf_open_stream_view(SF_STREAM *stream, SF_STREAM **view);
 
 /*
 void psf_fclearerr (SndFile *psf) ;
@@ -1007,6 +1092,73 @@ void psf_sanitize_string(char *cptr, int len);
 /* Generate the current date as a string. */
 void psf_get_date_str(char *str, int maxlen);
 
+/*
+** Calls func(data, first, last) on contiguous runs of count independent items
+** and returns once all of them are done. The runs get a thread each when there
+** are at least 2 * grain items, otherwise, or if no thread can be started, they
+** run on the calling thread.
+*/
+void psf_parallel_for(void (*func)(void *data, int first, int last), void *data, int count, int grain);
+
+/*
+** Block codecs read up to PSF_BATCH_LEN bytes of whole blocks at once and
+** decode them, spread over psf_parallel_for(), straight into the caller's
+** buffer. psf_read_batch() reads len bytes into *batch, allocated on first
+** use. On a short read it leaves the file where it was and returns false, the
+** codec then reads a block at a time, which logs the short read.
+*/
+#define PSF_BATCH_LEN (1 << 20)
+
+bool psf_read_batch(SndFile *psf, unsigned char **batch, sf_count_t len);
+
+/*
+** Reads len samples as shorts with read_s into the front of ptr and widens
+** them in place, last first, so int, float and double reads of 16 bit codecs
+** get the same large batched reads as short ones.
+*/
+size_t psf_read_widened(SndFile *psf, int *ptr, size_t len, size_t (*read_s)(SndFile *psf, short *ptr, size_t len));
+size_t psf_read_widened(SndFile *psf, float *ptr, size_t len, size_t (*read_s)(SndFile *psf, short *ptr, size_t len));
+size_t psf_read_widened(SndFile *psf, double *ptr, size_t len, size_t (*read_s)(SndFile *psf, short *ptr, size_t len));
+
+/*
+** LEB128 varints for exported seek indexes. psf_varint_put() stores value at
+** data[pos] if it fits in datasize, data may be NULL to only measure, and
+** returns the position after it. psf_varint_get() fails on a truncated value.
+*/
+size_t psf_varint_put(unsigned char *data, size_t pos, size_t datasize, uint64_t value);
+bool psf_varint_get(const unsigned char *data, size_t *pos, size_t datasize, uint64_t *value);
+
+/*
+** Codec state checkpoints, see checkpoint.cpp. A checkpoint holds the decoder
+** state in front of a frame as state_len int32_t values, with the file offset
+** to go on decoding from. Codecs whose state depends on all the data before it
+** record them as they decode, at most one per interval frames and in frame
+** order, and seek by restoring the last one before the goal and decoding on.
+** The first checkpoint must be at frame 0. check() vets imported checkpoints.
+*/
+#define SF_CHECKPOINT_INTERVAL (16384)
+
+SF_CHECKPOINTS *psf_checkpoints_new(int state_len,
+                                    bool (*check)(SndFile *psf, sf_count_t frame, sf_count_t offset,
+                                                  const int32_t *state));
+void psf_checkpoints_free(SF_CHECKPOINTS *cp);
+/* First frame at which psf_checkpoints_add() records one, SF_COUNT_MAX if cp is NULL. */
+sf_count_t psf_checkpoints_next(const SF_CHECKPOINTS *cp);
+/* Records a checkpoint if frame is at or after psf_checkpoints_next(), cp may be NULL. */
+void psf_checkpoints_add(SF_CHECKPOINTS *cp, sf_count_t frame, sf_count_t offset, const int32_t *state);
+/* Finds the last checkpoint at or before frame, returns false if there is none. */
+bool psf_checkpoints_find(const SF_CHECKPOINTS *cp, sf_count_t frame, sf_count_t *cp_frame, sf_count_t *offset,
+                          int32_t *state);
+/* Handles SFC_BUILD_SEEK_INDEX, SFC_GET_SEEK_INDEX and SFC_SET_SEEK_INDEX. */
+size_t psf_checkpoints_command(SndFile *psf, int command, void *data, size_t datasize);
+/*
+** Whether seeking decodes everything before the frame sought, or since the
+** last checkpoint. Clones parse the file again and have no checkpoint past
+** frame 0, so splitting a read between clones would decode the same data
+** over and over.
+*/
+bool psf_seeks_by_decoding(const SndFile *psf);
+
 struct AUDIO_DETECT
 {
     int channels;
@@ -1017,6 +1169,7 @@ int audio_detect(SndFile *psf, struct AUDIO_DETECT *ad, const unsigned char *dat
 int id3_skip(SndFile *psf);
 
 void alac_get_desc_chunk_items(int subformat, uint32_t *fmt_flags, uint32_t *frames_per_packet);
+size_t alac_command(SndFile *psf, int command, void *data, size_t datasize);
 
 FILE *psf_open_tmpfile(char *fname, size_t fnamelen);
 
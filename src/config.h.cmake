@@ -70,6 +70,18 @@
 /* Define if you have C99's lrintf function. */
 #cmakedefine HAVE_LRINTF
 
+/* Define if you have the `madvise' function. */
+#cmakedefine HAVE_MADVISE
+
+/* Define if you have the `mmap' function. */
+#cmakedefine HAVE_MMAP
+
+/* Define if you have the `pread' function. */
+#cmakedefine HAVE_PREAD
+
+/* Define if you have the `pwrite' function. */
+#cmakedefine HAVE_PWRITE
+
 /* Define if you have the `setlocale' function. */
 #cmakedefine HAVE_SETLOCALE
 
@@ -82,6 +94,9 @@
 /* Define if the system has the type `ssize_t'. */
 #cmakedefine HAVE_SSIZE_T
 
+/* Define if you have the <sys/mman.h> header file. */
+#cmakedefine HAVE_SYS_MMAN_H
+
 /* Define if you have the <sys/time.h> header file. */
 #cmakedefine HAVE_SYS_TIME_H
 
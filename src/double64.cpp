@@ -583,14 +583,14 @@ static inline void f2d_array(const float *src, double *dest, size_t count)
 
 static size_t host_read_d2s(SndFile *psf, short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const double *, size_t, short *, double);
     size_t bufferlen, readcount;
     size_t total = 0;
     double scale;
 
     convert = (psf->m_add_clipping) ? d2s_clip_array : d2s_array;
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
     scale = (psf->m_float_int_mult == 0) ? 1.0 : 0x7FFF / psf->m_float_max;
 
     while (len > 0)
@@ -614,14 +614,14 @@ static size_t host_read_d2s(SndFile *psf, short *ptr, size_t len)
 
 static size_t host_read_d2i(SndFile *psf, int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const double *, size_t, int *, double);
     size_t bufferlen, readcount;
     size_t total = 0;
     double scale;
 
     convert = (psf->m_add_clipping) ? d2i_clip_array : d2i_array;
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
     scale = (psf->m_float_int_mult == 0) ? 1.0 : 0x7FFFFFFF / psf->m_float_max;
 
     while (len > 0)
@@ -645,11 +645,11 @@ static size_t host_read_d2i(SndFile *psf, int *ptr, size_t len)
 
 static size_t host_read_d2f(SndFile *psf, float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
 
     while (len > 0)
     {
@@ -704,13 +704,13 @@ static size_t host_read_d(SndFile *psf, double *ptr, size_t len)
 
 static size_t host_write_s2d(SndFile *psf, const short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
     double scale;
 
     scale = (psf->m_scale_int_float == 0) ? 1.0 : 1.0 / 0x8000;
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
 
     while (len > 0)
     {
@@ -737,13 +737,13 @@ static size_t host_write_s2d(SndFile *psf, const short *ptr, size_t len)
 
 static size_t host_write_i2d(SndFile *psf, const int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
     double scale;
 
     scale = (psf->m_scale_int_float == 0) ? 1.0 : 1.0 / (8.0 * 0x10000000);
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
 
     while (len > 0)
     {
@@ -769,11 +769,11 @@ static size_t host_write_i2d(SndFile *psf, const int *ptr, size_t len)
 
 static size_t host_write_f2d(SndFile *psf, const float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
 
     while (len > 0)
     {
@@ -799,7 +799,7 @@ static size_t host_write_f2d(SndFile *psf, const float *ptr, size_t len)
 
 static size_t host_write_d(SndFile *psf, const double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
@@ -809,7 +809,7 @@ static size_t host_write_d(SndFile *psf, const double *ptr, size_t len)
     if (psf->m_data_endswap != SF_TRUE)
         return psf->fwrite(ptr, sizeof(double), len);
 
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
 
     while (len > 0)
     {
@@ -830,12 +830,12 @@ static size_t host_write_d(SndFile *psf, const double *ptr, size_t len)
 
 static size_t replace_read_d2s(SndFile *psf, short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
     double scale;
 
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
     scale = (psf->m_float_int_mult == 0) ? 1.0 : 0x7FFF / psf->m_float_max;
 
     while (len > 0)
@@ -861,12 +861,12 @@ static size_t replace_read_d2s(SndFile *psf, short *ptr, size_t len)
 
 static size_t replace_read_d2i(SndFile *psf, int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
     double scale;
 
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
     scale = (psf->m_float_int_mult == 0) ? 1.0 : 0x7FFFFFFF / psf->m_float_max;
 
     while (len > 0)
@@ -892,11 +892,11 @@ static size_t replace_read_d2i(SndFile *psf, int *ptr, size_t len)
 
 static size_t replace_read_d2f(SndFile *psf, float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
 
     while (len > 0)
     {
@@ -922,12 +922,12 @@ static size_t replace_read_d2f(SndFile *psf, float *ptr, size_t len)
 
 static size_t replace_read_d(SndFile *psf, double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
 
     /* FIXME : This is probably nowhere near optimal. */
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
 
     while (len > 0)
     {
@@ -953,13 +953,13 @@ static size_t replace_read_d(SndFile *psf, double *ptr, size_t len)
 
 static size_t replace_write_s2d(SndFile *psf, const short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
     double scale;
 
     scale = (psf->m_scale_int_float == 0) ? 1.0 : 1.0 / 0x8000;
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
 
     while (len > 0)
     {
@@ -987,13 +987,13 @@ static size_t replace_write_s2d(SndFile *psf, const short *ptr, size_t len)
 
 static size_t replace_write_i2d(SndFile *psf, const int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
     double scale;
 
     scale = (psf->m_scale_int_float == 0) ? 1.0 : 1.0 / (8.0 * 0x10000000);
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
 
     while (len > 0)
     {
@@ -1021,11 +1021,11 @@ static size_t replace_write_i2d(SndFile *psf, const int *ptr, size_t len)
 
 static size_t replace_write_f2d(SndFile *psf, const float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
 
     while (len > 0)
     {
@@ -1050,7 +1050,7 @@ static size_t replace_write_f2d(SndFile *psf, const float *ptr, size_t len)
 
 static size_t replace_write_d(SndFile *psf, const double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
@@ -1058,7 +1058,7 @@ static size_t replace_write_d(SndFile *psf, const double *ptr, size_t len)
     if (psf->m_peak_info)
         double64_peak_update(psf, ptr, len, 0);
 
-    bufferlen = ARRAY_LEN(ubuf.dbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(double);
 
     while (len > 0)
     {
@@ -41,7 +41,9 @@
 typedef struct
 {
     int bit_width, dwm_maxsize, max_delta, span;
-    int samplecount;
+    sf_count_t samplecount;
+    /* Sample count at which dwvw_decode_data() next tries to add a checkpoint. */
+    sf_count_t next_checkpoint;
     int bit_count, bits, last_delta_width, last_sample;
     struct
     {
@@ -71,6 +73,13 @@ static size_t dwvw_encode_data(SndFile *psf, DWVW_PRIVATE *pdwvw, const int *ptr
 static void dwvw_encode_store_bits(SndFile *psf, DWVW_PRIVATE *pdwvw, int data, int new_bits);
 static void dwvw_read_reset(DWVW_PRIVATE *pdwvw);
 
+/* The bit reservoir, last_delta_width and last_sample. */
+#define DWVW_STATE_LEN (4)
+
+static void dwvw_add_checkpoint(SndFile *psf, DWVW_PRIVATE *pdwvw, sf_count_t samplecount, int delta_width,
+                                int sample);
+static bool dwvw_check_checkpoint(SndFile *psf, sf_count_t frame, sf_count_t offset, const int32_t *state);
+
 /*
  * DWVW initialisation function.
  */
@@ -120,6 +129,11 @@ int dwvw_init(SndFile *psf, int bitwidth)
 
     if (psf->m_mode == SFM_READ)
     {
+        /* Counting the frames decodes the file, checkpoints come for free. */
+        psf->m_checkpoints = psf_checkpoints_new(DWVW_STATE_LEN, dwvw_check_checkpoint);
+        if (psf->m_checkpoints == NULL)
+            return SFE_MALLOC_FAILED;
+
         psf->sf.frames = psf_decode_frame_count(psf);
         dwvw_read_reset(pdwvw);
     };
@@ -152,9 +166,17 @@ static int dwvw_close(SndFile *psf)
     return 0;
 }
 
-static sf_count_t dwvw_seek(SndFile *psf, int UNUSED(mode), sf_count_t offset)
+/*
+** Reads restore the last checkpoint before offset and decode forward from
+** there. Anything else can only go back to the start.
+*/
+static sf_count_t dwvw_seek(SndFile *psf, int mode, sf_count_t offset)
 {
     DWVW_PRIVATE *pdwvw;
+    BUF_UNION ubuf;
+    int32_t state[DWVW_STATE_LEN];
+    sf_count_t cp_frame, cp_offset, skip;
+    size_t readcount, count;
 
     if (!psf->m_codec_data)
     {
@@ -164,6 +186,35 @@ static sf_count_t dwvw_seek(SndFile *psf, int UNUSED(mode), sf_count_t offset)
 
     pdwvw = (DWVW_PRIVATE *)psf->m_codec_data;
 
+    if (mode == SFM_READ && psf_checkpoints_find(psf->m_checkpoints, offset, &cp_frame, &cp_offset, state))
+    {
+        if (psf->fseek(cp_offset, SEEK_SET) == PSF_SEEK_ERROR)
+            return PSF_SEEK_ERROR;
+
+        dwvw_read_reset(pdwvw);
+        pdwvw->bits = state[0];
+        pdwvw->bit_count = state[1];
+        pdwvw->last_delta_width = state[2];
+        pdwvw->last_sample = state[3];
+        pdwvw->samplecount = cp_frame * psf->sf.channels;
+
+        /* dwvw_decode_data() takes an empty buffer for the end of the data. */
+        pdwvw->b.end = psf->fread(pdwvw->b.buffer, 1, sizeof(pdwvw->b.buffer));
+
+        skip = (offset - cp_frame) * psf->sf.channels;
+        while (skip > 0)
+        {
+            readcount = (skip > (sf_count_t)ARRAY_LEN(ubuf.ibuf)) ? ARRAY_LEN(ubuf.ibuf) : (size_t)skip;
+            count = dwvw_decode_data(psf, pdwvw, ubuf.ibuf, readcount);
+            skip -= count;
+            if (count != readcount)
+                break;
+        };
+
+        /* Frame counts of long files are a guess, the data may end early. */
+        return offset - skip / psf->sf.channels;
+    };
+
     if (offset == 0)
     {
         psf->fseek(psf->m_dataoffset, SEEK_SET);
@@ -316,6 +367,9 @@ static size_t dwvw_decode_data(SndFile *psf, DWVW_PRIVATE *pdwvw, int *ptr, size
 
     for (count = 0; count < len; count++)
     {
+        if (pdwvw->samplecount + (sf_count_t)count >= pdwvw->next_checkpoint)
+            dwvw_add_checkpoint(psf, pdwvw, pdwvw->samplecount + count, delta_width, sample);
+
         /* If bit_count parameter is zero get the delta_width_modifier. */
         delta_width_modifier = dwvw_decode_load_bits(psf, pdwvw, -1);
 
@@ -364,6 +418,40 @@ static size_t dwvw_decode_data(SndFile *psf, DWVW_PRIVATE *pdwvw, int *ptr, size
     return count;
 }
 
+/* Called with the decoder state in front of sample number samplecount. */
+static void dwvw_add_checkpoint(SndFile *psf, DWVW_PRIVATE *pdwvw, sf_count_t samplecount, int delta_width,
+                                int sample)
+{
+    int32_t state[DWVW_STATE_LEN];
+    sf_count_t next;
+
+    if (samplecount % psf->sf.channels == 0 &&
+        samplecount / psf->sf.channels >= psf_checkpoints_next(psf->m_checkpoints))
+    {
+        state[0] = pdwvw->bits;
+        state[1] = pdwvw->bit_count;
+        state[2] = delta_width;
+        state[3] = sample;
+        psf_checkpoints_add(psf->m_checkpoints, samplecount / psf->sf.channels,
+                            psf->ftell() - (sf_count_t)(pdwvw->b.end - pdwvw->b.index), state);
+    };
+
+    next = psf_checkpoints_next(psf->m_checkpoints);
+    if (next > samplecount / psf->sf.channels)
+        pdwvw->next_checkpoint = next < SF_COUNT_MAX / psf->sf.channels ? next * psf->sf.channels : SF_COUNT_MAX;
+    else
+        pdwvw->next_checkpoint = samplecount + 1;
+}
+
+static bool dwvw_check_checkpoint(SndFile *psf, sf_count_t UNUSED(frame), sf_count_t UNUSED(offset),
+                                  const int32_t *state)
+{
+    DWVW_PRIVATE *pdwvw = (DWVW_PRIVATE *)psf->m_codec_data;
+
+    return state[1] >= 0 && state[1] < 32 && state[2] >= 0 && state[2] < pdwvw->bit_width &&
+           state[3] >= -pdwvw->max_delta && state[3] < pdwvw->max_delta;
+}
+
 static int dwvw_decode_load_bits(SndFile *psf, DWVW_PRIVATE *pdwvw, int bit_count)
 {
     int output = 0, get_dwm = SF_FALSE;
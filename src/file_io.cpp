@@ -31,16 +31,36 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include <sf_unistd.h>
+#include <atomic>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 using namespace std;
 
 static sf_count_t psf_get_filelen_fd(int fd);
 
-class SF_FILE_STREAM: public SF_STREAM
+#if (defined(HAVE_PREAD) && defined(HAVE_PWRITE))
+#define USE_POSITIONAL_IO 1
+#else
+#define USE_POSITIONAL_IO 0
+#endif
+
+class SF_FILE_STREAM final: public SF_STREAM
 {
     unsigned long m_ref = 0;
     int m_filedes = -1;
 
+    /*
+    ** Regular files are accessed with pread() and pwrite() and the file offset
+    ** is kept here, so seek() and tell() don't need a system call and the
+    ** descriptor's own offset is never touched.
+    */
+    bool m_positional = false;
+    sf_count_t m_pos = 0;
+
+    SF_FILE_STREAM() = default;
+
     void close()
     {
         if (m_filedes >= 0)
@@ -92,6 +112,14 @@ public:
             close();
             throw;
         }
+
+#if USE_POSITIONAL_IO
+        struct stat statbuf;
+
+        /* Pipes and devices have no file offset to speak of. */
+        if (fstat(m_filedes, &statbuf) == 0 && S_ISREG(statbuf.st_mode))
+            m_positional = true;
+#endif
     }
 
 #ifdef _WIN32
@@ -147,6 +175,26 @@ public:
         close();
     }
 
+    /*
+    ** Returns a new stream on a duplicate of the descriptor with its own file
+    ** offset, or NULL if the file is not accessed with pread().
+    */
+    SF_FILE_STREAM *view()
+    {
+        if (!m_positional)
+            return nullptr;
+
+        int filedes = dup(m_filedes);
+        if (filedes == -1)
+            return nullptr;
+
+        SF_FILE_STREAM *s = new SF_FILE_STREAM();
+        s->m_filedes = filedes;
+        s->m_positional = true;
+
+        return s;
+    }
+
     // Inherited via SF_STREAM
     unsigned long ref() override
     {
@@ -185,6 +233,40 @@ public:
 
     sf_count_t seek(sf_count_t offset, int whence) override
     {
+#if USE_POSITIONAL_IO
+        if (m_positional)
+        {
+            sf_count_t new_pos;
+
+            switch (whence)
+            {
+            case SEEK_SET:
+                new_pos = offset;
+                break;
+
+            case SEEK_CUR:
+                new_pos = m_pos + offset;
+                break;
+
+            case SEEK_END:
+                new_pos = get_filelen();
+                if (new_pos < 0)
+                    return -1;
+                new_pos += offset;
+                break;
+
+            default:
+                return -1;
+            }
+
+            if (new_pos < 0)
+                return -1;
+
+            m_pos = new_pos;
+            return m_pos;
+        }
+#endif
+
 #ifdef _WIN32
         return _lseeki64(m_filedes, offset, whence);
 #else
@@ -194,16 +276,39 @@ public:
 
     sf_count_t read(void * ptr, sf_count_t count) override
     {
+#if USE_POSITIONAL_IO
+        if (m_positional)
+        {
+            sf_count_t n = pread(m_filedes, ptr, (size_t)count, (off_t)m_pos);
+            if (n > 0)
+                m_pos += n;
+            return n;
+        }
+#endif
+
         return ::read(m_filedes, ptr, count);
     }
 
     sf_count_t write(const void * ptr, sf_count_t count) override
     {
+#if USE_POSITIONAL_IO
+        if (m_positional)
+        {
+            sf_count_t n = pwrite(m_filedes, ptr, (size_t)count, (off_t)m_pos);
+            if (n > 0)
+                m_pos += n;
+            return n;
+        }
+#endif
+
         return ::write(m_filedes, ptr, count);
     }
 
     sf_count_t tell() override
     {
+        if (m_positional)
+            return m_pos;
+
 #if _WIN32
         return _lseeki64(m_filedes, 0, SEEK_CUR);
 #else
@@ -238,6 +343,254 @@ public:
     }
 };
 
+#if (defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP))
+
+/*
+** Read only stream backed by a memory mapping of the whole file. Reads are
+** served with memcpy from the mapping, so there is no syscall per read.
+**
+** Only regular, non-empty files opened with SFM_READ | SFM_MMAP are mapped.
+** The mapping keeps the length the file had when it was opened, and if the
+** file is truncated under it, touching the pages past the new end raises
+** SIGBUS. That is why mapping has to be asked for.
+*/
+
+/* Seeks further than this switch the mapping to random access mode. */
+#define MMAP_RANDOM_SEEK_DISTANCE (1024 * 1024)
+/* Sequential reads longer than this switch it back to sequential mode. */
+#define MMAP_SEQUENTIAL_RUN (4 * 1024 * 1024)
+
+class SF_MMAP_STREAM final: public SF_STREAM
+{
+    /* Views on the mapping may be released from other threads. */
+    std::atomic<unsigned long> m_ref{0};
+    /* Stream that owns the mapping if this is a view, see view(). */
+    sf::ref_ptr<SF_STREAM> m_owner;
+    unsigned char *m_data = nullptr;
+    sf_count_t m_size = 0;
+    sf_count_t m_pos = 0;
+
+    bool m_random = false;
+    sf_count_t m_run = 0;
+
+    void advise(bool random)
+    {
+#ifdef HAVE_MADVISE
+        madvise(m_data, (size_t)m_size, random ? MADV_RANDOM : MADV_SEQUENTIAL);
+#endif
+        m_random = random;
+        m_run = 0;
+    }
+
+    SF_MMAP_STREAM() = default;
+
+public:
+    /* Throws if the file can't be mapped, caller falls back to SF_FILE_STREAM. */
+    SF_MMAP_STREAM(const char *filename)
+    {
+        int fd = open(filename, O_BINARY | O_RDONLY);
+        if (fd == -1)
+            throw sf::sndfile_error(SFE_BAD_FILE_PTR);
+
+        struct stat statbuf;
+
+        /* Pipes, devices and empty files can't be mapped. */
+        if (fstat(fd, &statbuf) == -1 || !S_ISREG(statbuf.st_mode) || statbuf.st_size <= 0 ||
+            (uint64_t)statbuf.st_size > (uint64_t)SIZE_MAX)
+        {
+            ::close(fd);
+            throw sf::sndfile_error(SFE_BAD_FILE_PTR);
+        }
+
+        void *data = mmap(nullptr, (size_t)statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        /* The mapping stays valid after the descriptor is closed. */
+        ::close(fd);
+        if (data == MAP_FAILED)
+            throw sf::sndfile_error(SFE_BAD_FILE_PTR);
+
+        m_data = static_cast<unsigned char *>(data);
+        m_size = statbuf.st_size;
+
+        advise(false);
+    }
+
+    ~SF_MMAP_STREAM()
+    {
+        if (m_data && !m_owner)
+            munmap(m_data, (size_t)m_size);
+    }
+
+    /* Returns a new stream on the same mapping with its own position. */
+    SF_MMAP_STREAM *view()
+    {
+        SF_MMAP_STREAM *s = new SF_MMAP_STREAM();
+
+        s->m_owner.copy(this);
+        s->m_data = m_data;
+        s->m_size = m_size;
+
+        return s;
+    }
+
+    const unsigned char *data() const
+    {
+        return m_data;
+    }
+
+    sf_count_t size() const
+    {
+        return m_size;
+    }
+
+    // Inherited via SF_STREAM
+    unsigned long ref() override
+    {
+        return ++m_ref;
+    }
+
+    void unref() override
+    {
+        if (--m_ref == 0)
+            delete this;
+    }
+
+    sf_count_t get_filelen() override
+    {
+        return m_size;
+    }
+
+    sf_count_t seek(sf_count_t offset, int whence) override
+    {
+        sf_count_t new_pos;
+
+        switch (whence)
+        {
+        case SEEK_SET:
+            new_pos = offset;
+            break;
+
+        case SEEK_CUR:
+            new_pos = m_pos + offset;
+            break;
+
+        case SEEK_END:
+            new_pos = m_size + offset;
+            break;
+
+        default:
+            return -1;
+        }
+
+        if (new_pos < 0)
+            return -1;
+
+        sf_count_t distance = new_pos > m_pos ? new_pos - m_pos : m_pos - new_pos;
+        if (distance > MMAP_RANDOM_SEEK_DISTANCE)
+        {
+            if (!m_random)
+                advise(true);
+            m_run = 0;
+        }
+
+        m_pos = new_pos;
+
+        return m_pos;
+    }
+
+    sf_count_t read(void *ptr, sf_count_t count) override
+    {
+        if (count <= 0 || m_pos >= m_size)
+            return 0;
+
+        if (count > m_size - m_pos)
+            count = m_size - m_pos;
+
+        memcpy(ptr, m_data + m_pos, (size_t)count);
+        m_pos += count;
+
+        m_run += count;
+        if (m_random && m_run > MMAP_SEQUENTIAL_RUN)
+            advise(false);
+
+        return count;
+    }
+
+    sf_count_t write(const void *UNUSED(ptr), sf_count_t UNUSED(count)) override
+    {
+        return 0;
+    }
+
+    sf_count_t tell() override
+    {
+        return m_pos;
+    }
+
+    void flush() override
+    {
+    }
+
+    int set_filelen(sf_count_t UNUSED(len)) override
+    {
+        return -1;
+    }
+};
+
+#endif
+
+const void *psf_stream_mapping(SF_STREAM *stream, sf_count_t *length)
+{
+#if (defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP))
+    SF_MMAP_STREAM *ms = dynamic_cast<SF_MMAP_STREAM *>(stream);
+    if (ms)
+    {
+        if (length)
+            *length = ms->size();
+        return ms->data();
+    }
+#endif
+
+    if (length)
+        *length = 0;
+    return nullptr;
+}
+
+int psf_open_stream_view(SF_STREAM *stream, SF_STREAM **view)
+{
+    if (!stream || !view)
+        return SFE_BAD_VIRTUAL_IO;
+
+    *view = nullptr;
+
+#if (defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP))
+    SF_MMAP_STREAM *ms = dynamic_cast<SF_MMAP_STREAM *>(stream);
+    if (ms)
+    {
+        SF_MMAP_STREAM *v = ms->view();
+
+        *view = static_cast<SF_STREAM *>(v);
+        v->ref();
+
+        return SFE_NO_ERROR;
+    }
+#endif
+
+    SF_STREAM *source = psf_buffered_stream_source(stream);
+    SF_FILE_STREAM *fs = dynamic_cast<SF_FILE_STREAM *>(source ? source : stream);
+    SF_FILE_STREAM *v = fs ? fs->view() : nullptr;
+    if (!v)
+        return SFE_NOT_CLONEABLE;
+
+    v->ref();
+    if (psf_open_buffered_stream(v, 0, view) != SFE_NO_ERROR)
+    {
+        *view = static_cast<SF_STREAM *>(v);
+        return SFE_NO_ERROR;
+    }
+    v->unref();
+
+    return SFE_NO_ERROR;
+}
+
 int psf_open_file_stream(const char * filename, SF_FILEMODE mode, SF_STREAM **stream)
 {
     if (!stream)
@@ -245,21 +598,51 @@ int psf_open_file_stream(const char * filename, SF_FILEMODE mode, SF_STREAM **st
 
     *stream = nullptr;
 
+#if (defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP))
+    /* Only when asked for, see sf_open(). */
+    if (mode == (SFM_READ | SFM_MMAP))
+    {
+        SF_MMAP_STREAM *ms = nullptr;
+        try
+        {
+            ms = new SF_MMAP_STREAM(filename);
+
+            *stream = static_cast<SF_STREAM *>(ms);
+            ms->ref();
+
+            return SFE_NO_ERROR;
+        }
+        catch (const sf::sndfile_error &)
+        {
+            /* Not a mappable file, use ordinary reads. */
+        }
+    }
+#endif
+
     SF_FILE_STREAM *s = nullptr;
     try
     {
-        s = new SF_FILE_STREAM(filename, mode);
-
-        *stream = static_cast<SF_STREAM *>(s);
+        s = new SF_FILE_STREAM(filename, (SF_FILEMODE)(mode & SFM_MASK));
         s->ref();
-
-        return SFE_NO_ERROR;
     }
     catch (const sf::sndfile_error &e)
     {
         delete s;
         return e.error();
     }
+
+    /* Header parsing does lots of tiny reads, serve them from a read-ahead buffer. */
+    if (psf_open_buffered_stream(s, 0, stream) != SFE_NO_ERROR)
+    {
+        /* Not seekable, use it as it is. */
+        *stream = static_cast<SF_STREAM *>(s);
+        return SFE_NO_ERROR;
+    }
+
+    /* The buffered stream holds its own reference. */
+    s->unref();
+
+    return SFE_NO_ERROR;
 }
 
 #ifdef _WIN32
@@ -274,7 +657,7 @@ int psf_open_file_stream(const wchar_t * filename, SF_FILEMODE mode, SF_STREAM *
     SF_FILE_STREAM *s = nullptr;
     try
     {
-        s = new SF_FILE_STREAM(filename, mode);
+        s = new SF_FILE_STREAM(filename, (SF_FILEMODE)(mode & SFM_MASK));
     }
     catch (const sf::sndfile_error &e)
     {
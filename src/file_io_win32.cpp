@@ -258,6 +258,22 @@ public:
     }
 };
 
+const void *psf_stream_mapping(SF_STREAM *UNUSED(stream), sf_count_t *length)
+{
+    if (length)
+        *length = 0;
+    return nullptr;
+}
+
+int psf_open_stream_view(SF_STREAM *stream, SF_STREAM **view)
+{
+    if (!stream || !view)
+        return SFE_BAD_VIRTUAL_IO;
+
+    *view = nullptr;
+    return SFE_NOT_CLONEABLE;
+}
+
 int psf_open_file_stream(const char * filename, SF_FILEMODE mode, SF_STREAM **stream)
 {
     if (!stream)
@@ -268,18 +284,27 @@ int psf_open_file_stream(const char * filename, SF_FILEMODE mode, SF_STREAM **st
     SF_FILE_STREAM *s = nullptr;
     try
     {
-        s = new SF_FILE_STREAM(filename, mode);
-
-        *stream = static_cast<SF_STREAM *>(s);
+        s = new SF_FILE_STREAM(filename, (SF_FILEMODE)(mode & SFM_MASK));
         s->ref();
-
-        return SFE_NO_ERROR;
     }
     catch (const sf::sndfile_error &e)
     {
         delete s;
         return e.error();
     }
+
+    /* Header parsing does lots of tiny reads, serve them from a read-ahead buffer. */
+    if (psf_open_buffered_stream(s, 0, stream) != SFE_NO_ERROR)
+    {
+        /* Not seekable, use it as it is. */
+        *stream = static_cast<SF_STREAM *>(s);
+        return SFE_NO_ERROR;
+    }
+
+    /* The buffered stream holds its own reference. */
+    s->unref();
+
+    return SFE_NO_ERROR;
 }
 
 int psf_open_file_stream(const wchar_t * filename, SF_FILEMODE mode, SF_STREAM **stream)
@@ -292,7 +317,7 @@ int psf_open_file_stream(const wchar_t * filename, SF_FILEMODE mode, SF_STREAM *
     SF_FILE_STREAM *s = nullptr;
     try
     {
-        s = new SF_FILE_STREAM(filename, mode);
+        s = new SF_FILE_STREAM(filename, (SF_FILEMODE)(mode & SFM_MASK));
     }
     catch (const sf::sndfile_error &e)
     {
@@ -28,6 +28,8 @@
 
 #include "sndfile2k/sndfile2k.h"
 #include "common.h"
+#include "simd.h"
+#include "md5.h"
 
 #ifdef HAVE_XIPH_CODECS
 
@@ -36,11 +38,62 @@
 #include <FLAC/metadata.h>
 
 #include <algorithm>
+#include <new>
+#include <thread>
+#include <vector>
 
 #define FLAC_DEFAULT_COMPRESSION_LEVEL (5)
 
 #define ENC_BUFFER_SIZE (8192)
 
+/*
+** The encoder does not know the length of the stream, so the seek table is
+** written with room for this many points and its spacing is doubled whenever
+** it fills up.
+*/
+#define FLAC_SEEKTABLE_POINTS (256)
+#define FLAC_DEFAULT_SEEKTABLE_SPACING (10.0)
+
+/*
+** Frame parallel encoding, see SFC_SET_ENCODER_THREADS.
+**
+** FLAC frames do not depend on each other, so the input is cut into jobs of
+** FLAC_JOB_BLOCKS blocks and each job is encoded by its own libFLAC encoder
+** on its own thread. The frames are then written in order with their frame
+** numbers patched. The main encoder never sees any audio, so STREAMINFO is
+** rewritten when the file is closed.
+*/
+#define FLAC_MAX_ENCODER_THREADS (64)
+#define FLAC_JOB_BLOCKS (64)
+
+/* STREAMINFO always follows the "fLaC" marker and its block header. */
+#define FLAC_STREAMINFO_OFFSET (8)
+#define FLAC_STREAMINFO_LENGTH (34)
+
+struct FLAC_JOB
+{
+    std::vector<int32_t> samples;
+    /* Encoded frames back to back, the end of each in output and its length in samples. */
+    std::vector<FLAC__byte> output;
+    std::vector<size_t> frame_end;
+    std::vector<unsigned> frame_samples;
+    bool ok;
+};
+
+struct FLAC_PARALLEL
+{
+    unsigned channels, bps, samplerate, compression, blocksize;
+    size_t job_frames;
+    std::vector<FLAC_JOB> jobs;
+    /* Number of jobs holding samples, the last of them may be partly filled. */
+    unsigned filled;
+    /* A renumbered frame. */
+    std::vector<FLAC__byte> frame;
+    uint64_t frame_number, total_samples;
+    unsigned min_framesize, max_framesize;
+    SF_MD5 md5;
+};
+
 typedef enum
 {
     PFLAC_PCM_SHORT = 50,
@@ -57,8 +110,16 @@ typedef struct
     PFLAC_PCM pcmtype;
     void *ptr;
     size_t pos, len, remain;
+    /*
+    ** For planar reads ptr points to the channel pointers, pos and len still
+    ** count the samples of all channels and planar_start is the number of
+    ** frames already in the channel buffers.
+    */
+    bool planar;
+    size_t planar_start;
 
     FLAC__StreamMetadata *metadata;
+    FLAC__StreamMetadata *seektable;
 
     const int32_t *const *wbuffer;
     int32_t *rbuffer[FLAC__MAX_CHANNELS];
@@ -70,6 +131,23 @@ typedef struct
 
     unsigned compression;
 
+    /* Seek table spacing in seconds, 0 for no seek table. */
+    double seektable_spacing;
+    /*
+    ** Number of seek points in use and on encode the spacing in samples, the
+    ** sample the next point is due at, the samples encoded so far and the
+    ** offset of the first frame, or -1 before it was written. On decode the
+    ** first and last point found in the file.
+    */
+    unsigned seek_points;
+    sf_count_t seek_spacing, seek_next;
+    sf_count_t enc_samples, audio_offset;
+    sf_count_t seek_first, seek_last;
+
+    /* Encoder threads requested and the state of the threaded encoder, if any. */
+    unsigned threads;
+    FLAC_PARALLEL *parallel;
+
 } FLAC_PRIVATE;
 
 typedef struct
@@ -90,6 +168,11 @@ static size_t flac_read_flac2i(SndFile *psf, int *ptr, size_t len);
 static size_t flac_read_flac2f(SndFile *psf, float *ptr, size_t len);
 static size_t flac_read_flac2d(SndFile *psf, double *ptr, size_t len);
 
+static size_t flac_read_flac2s_planar(SndFile *psf, short *const *ptr, size_t frames);
+static size_t flac_read_flac2i_planar(SndFile *psf, int *const *ptr, size_t frames);
+static size_t flac_read_flac2f_planar(SndFile *psf, float *const *ptr, size_t frames);
+static size_t flac_read_flac2d_planar(SndFile *psf, double *const *ptr, size_t frames);
+
 static size_t flac_write_s2flac(SndFile *psf, const short *ptr, size_t len);
 static size_t flac_write_i2flac(SndFile *psf, const int *ptr, size_t len);
 static size_t flac_write_f2flac(SndFile *psf, const float *ptr, size_t len);
@@ -200,12 +283,75 @@ static void i2flac24_array(const int *src, int32_t *dest, size_t count)
     }
 }
 
+/* Planar reads convert libFLAC's channel buffers straight into the caller's. */
+static void flac_planar_copy(SndFile *psf, const int32_t *const *src, size_t frames, unsigned channels)
+{
+    FLAC_PRIVATE *pflac = (FLAC_PRIVATE *)psf->m_codec_data;
+    unsigned bits = pflac->frame->header.bits_per_sample;
+    size_t i, start = pflac->planar_start + pflac->pos / channels;
+
+    for (unsigned j = 0; j < channels; j++)
+    {
+        switch (pflac->pcmtype)
+        {
+        case PFLAC_PCM_SHORT:
+        {
+            short *retpcm = ((short *const *)pflac->ptr)[j] + start;
+            int shift = 16 - bits;
+
+            if (shift < 0)
+                for (i = 0; i < frames; i++)
+                    retpcm[i] = src[j][i] >> -shift;
+            else
+                for (i = 0; i < frames; i++)
+                    retpcm[i] = ((uint16_t)src[j][i]) << shift;
+        };
+        break;
+
+        case PFLAC_PCM_INT:
+        {
+            int *retpcm = ((int *const *)pflac->ptr)[j] + start;
+            int shift = 32 - bits;
+
+            for (i = 0; i < frames; i++)
+                retpcm[i] = ((uint32_t)src[j][i]) << shift;
+        };
+        break;
+
+        case PFLAC_PCM_FLOAT:
+        {
+            float *retpcm = ((float *const *)pflac->ptr)[j] + start;
+            float norm = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / (1 << (bits - 1)) : 1.0);
+
+            for (i = 0; i < frames; i++)
+                retpcm[i] = src[j][i] * norm;
+        };
+        break;
+
+        case PFLAC_PCM_DOUBLE:
+        {
+            double *retpcm = ((double *const *)pflac->ptr)[j] + start;
+            double norm = (psf->m_norm_double == SF_TRUE) ? 1.0 / (1 << (bits - 1)) : 1.0;
+
+            for (i = 0; i < frames; i++)
+                retpcm[i] = src[j][i] * norm;
+        };
+        break;
+
+        default:
+            break;
+        };
+    };
+}
+
 static sf_count_t flac_buffer_copy(SndFile *psf)
 {
     FLAC_PRIVATE *pflac = (FLAC_PRIVATE *)psf->m_codec_data;
     const FLAC__Frame *frame = pflac->frame;
     const int32_t *const *buffer = pflac->wbuffer;
-    unsigned i = 0, j, offset, channels, len;
+    const int32_t *src[FLAC__MAX_CHANNELS];
+    size_t i, frames, head;
+    unsigned j, channels;
 
     if (psf->sf.channels != (int)frame->header.channels)
     {
@@ -241,8 +387,10 @@ static sf_count_t flac_buffer_copy(SndFile *psf)
     if (pflac->ptr == NULL)
     {
         /*
-		 * This pointer is reset to NULL each time the current frame has been
-		 * decoded. Somehow its used during encoding and decoding.
+		 * No destination, which happens for the frame a seek lands in. The
+		 * channel pointers libFLAC passes then don't outlive the callback, so
+		 * keep a copy of the samples for the next read. Otherwise frames are
+		 * converted straight from libFLAC's buffers.
 		 */
         for (i = 0; i < channels; i++)
         {
@@ -256,129 +404,85 @@ static sf_count_t flac_buffer_copy(SndFile *psf)
         return 0;
     };
 
-    len = std::min(pflac->len, (size_t)frame->header.blocksize);
-
     if (pflac->remain % channels != 0)
     {
         psf->log_printf("Error: pflac->remain %u    channels %u\n", pflac->remain, channels);
         return 0;
     };
 
+    /* Whole frames only, the rest of the block waits for the next read. */
+    frames = std::min((size_t)(frame->header.blocksize - pflac->bufferpos), (pflac->len - pflac->pos) / channels);
+    frames = std::min(frames, pflac->remain / channels);
+
+    for (j = 0; j < channels; j++)
+        src[j] = buffer[j] + pflac->bufferpos;
+
+    if (pflac->planar)
+    {
+        flac_planar_copy(psf, src, frames, channels);
+
+        pflac->bufferpos += frames;
+        pflac->remain -= frames * channels;
+        pflac->pos += frames * channels;
+
+        return frames * channels;
+    };
+
     switch (pflac->pcmtype)
     {
     case PFLAC_PCM_SHORT:
     {
-        short *retpcm = (short *)pflac->ptr;
+        short *retpcm = (short *)pflac->ptr + pflac->pos;
         int shift = 16 - frame->header.bits_per_sample;
-        if (shift < 0)
-        {
-            shift = abs(shift);
-            for (i = 0; i < len && pflac->remain > 0; i++)
-            {
-                offset = pflac->pos + i * channels;
 
-                if (pflac->bufferpos >= frame->header.blocksize)
-                    break;
-
-                if (offset + channels > pflac->len)
-                    break;
-
-                for (j = 0; j < channels; j++)
-                    retpcm[offset + j] = buffer[j][pflac->bufferpos] >> shift;
-                pflac->remain -= channels;
-                pflac->bufferpos++;
-            }
-        }
-        else
+        head = psf_simd_kernels()->pi2s(src, frames, channels, retpcm, shift);
+        for (i = 0; i < head; i++)
         {
-            for (i = 0; i < len && pflac->remain > 0; i++)
-            {
-                offset = pflac->pos + i * channels;
-
-                if (pflac->bufferpos >= frame->header.blocksize)
-                    break;
-
-                if (offset + channels > pflac->len)
-                    break;
-
+            if (shift < 0)
                 for (j = 0; j < channels; j++)
-                    retpcm[offset + j] = ((uint16_t)buffer[j][pflac->bufferpos]) << shift;
-
-                pflac->remain -= channels;
-                pflac->bufferpos++;
-            };
+                    retpcm[i * channels + j] = src[j][i] >> -shift;
+            else
+                for (j = 0; j < channels; j++)
+                    retpcm[i * channels + j] = ((uint16_t)src[j][i]) << shift;
         };
     };
     break;
 
     case PFLAC_PCM_INT:
     {
-        int *retpcm = (int *)pflac->ptr;
+        int *retpcm = (int *)pflac->ptr + pflac->pos;
         int shift = 32 - frame->header.bits_per_sample;
-        for (i = 0; i < len && pflac->remain > 0; i++)
-        {
-            offset = pflac->pos + i * channels;
-
-            if (pflac->bufferpos >= frame->header.blocksize)
-                break;
-
-            if (offset + channels > pflac->len)
-                break;
 
+        head = psf_simd_kernels()->pi2i(src, frames, channels, retpcm, shift);
+        for (i = 0; i < head; i++)
             for (j = 0; j < channels; j++)
-                retpcm[offset + j] = ((uint32_t)buffer[j][pflac->bufferpos]) << shift;
-            pflac->remain -= channels;
-            pflac->bufferpos++;
-        };
+                retpcm[i * channels + j] = ((uint32_t)src[j][i]) << shift;
     };
     break;
 
     case PFLAC_PCM_FLOAT:
     {
-        float *retpcm = (float *)pflac->ptr;
+        float *retpcm = (float *)pflac->ptr + pflac->pos;
         float norm =
             (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / (1 << (frame->header.bits_per_sample - 1))
                                                  : 1.0);
 
-        for (i = 0; i < len && pflac->remain > 0; i++)
-        {
-            offset = pflac->pos + i * channels;
-
-            if (pflac->bufferpos >= frame->header.blocksize)
-                break;
-
-            if (offset + channels > pflac->len)
-                break;
-
+        head = psf_simd_kernels()->pi2f(src, frames, channels, retpcm, norm);
+        for (i = 0; i < head; i++)
             for (j = 0; j < channels; j++)
-                retpcm[offset + j] = buffer[j][pflac->bufferpos] * norm;
-            pflac->remain -= channels;
-            pflac->bufferpos++;
-        };
+                retpcm[i * channels + j] = src[j][i] * norm;
     };
     break;
 
     case PFLAC_PCM_DOUBLE:
     {
-        double *retpcm = (double *)pflac->ptr;
+        double *retpcm = (double *)pflac->ptr + pflac->pos;
         double norm =
             (psf->m_norm_double == SF_TRUE) ? 1.0 / (1 << (frame->header.bits_per_sample - 1)) : 1.0;
 
-        for (i = 0; i < len && pflac->remain > 0; i++)
-        {
-            offset = pflac->pos + i * channels;
-
-            if (pflac->bufferpos >= frame->header.blocksize)
-                break;
-
-            if (offset + channels > pflac->len)
-                break;
-
+        for (i = 0; i < frames; i++)
             for (j = 0; j < channels; j++)
-                retpcm[offset + j] = buffer[j][pflac->bufferpos] * norm;
-            pflac->remain -= channels;
-            pflac->bufferpos++;
-        };
+                retpcm[i * channels + j] = src[j][i] * norm;
     };
     break;
 
@@ -386,10 +490,11 @@ static sf_count_t flac_buffer_copy(SndFile *psf)
         return 0;
     };
 
-    offset = i * channels;
-    pflac->pos += i * channels;
+    pflac->bufferpos += frames;
+    pflac->remain -= frames * channels;
+    pflac->pos += frames * channels;
 
-    return offset;
+    return frames * channels;
 } /* flac_buffer_copy */
 
 static FLAC__StreamDecoderReadStatus
@@ -589,8 +694,24 @@ static void sf_flac_meta_callback(const FLAC__StreamDecoder *UNUSED(decoder),
         break;
 
     case FLAC__METADATA_TYPE_SEEKTABLE:
-        psf->log_printf("Seektable Metadata\n");
+    {
+        FLAC_PRIVATE *pflac = (FLAC_PRIVATE *)psf->m_codec_data;
+        const FLAC__StreamMetadata_SeekTable *table = &metadata->data.seek_table;
+
+        pflac->seek_points = 0;
+        for (unsigned k = 0; k < table->num_points; k++)
+        {
+            if (table->points[k].sample_number == FLAC__STREAM_METADATA_SEEKPOINT_PLACEHOLDER)
+                continue;
+            if (pflac->seek_points == 0)
+                pflac->seek_first = table->points[k].sample_number;
+            pflac->seek_last = table->points[k].sample_number;
+            pflac->seek_points++;
+        };
+
+        psf->log_printf("Seektable Metadata : %u points\n", pflac->seek_points);
         break;
+    }
 
     case FLAC__METADATA_TYPE_CUESHEET:
         psf->log_printf("Cuesheet Metadata\n");
@@ -662,12 +783,62 @@ sf_flac_enc_tell_callback(const FLAC__StreamEncoder *UNUSED(encoder),
     return FLAC__STREAM_ENCODER_TELL_STATUS_OK;
 }
 
+/*
+** Adds a seek point for a frame about to be written at offset if one is due.
+** The encoder writes the table out again with these points when it finishes.
+*/
+static void flac_seektable_add(FLAC_PRIVATE *pflac, sf_count_t offset, unsigned samples)
+{
+    FLAC__StreamMetadata_SeekTable *table = &pflac->seektable->data.seek_table;
+    sf_count_t sample = pflac->enc_samples;
+    unsigned k;
+
+    pflac->enc_samples += samples;
+
+    if (pflac->audio_offset < 0)
+        pflac->audio_offset = offset;
+
+    if (sample < pflac->seek_next)
+        return;
+
+    if (pflac->seek_points == table->num_points)
+    {
+        /* Full, keep every other point. */
+        for (k = 0; 2 * k < pflac->seek_points; k++)
+            table->points[k] = table->points[2 * k];
+        pflac->seek_points = k;
+        for (; k < table->num_points; k++)
+        {
+            table->points[k].sample_number = FLAC__STREAM_METADATA_SEEKPOINT_PLACEHOLDER;
+            table->points[k].stream_offset = 0;
+            table->points[k].frame_samples = 0;
+        };
+
+        pflac->seek_spacing *= 2;
+        pflac->seek_next = table->points[pflac->seek_points - 1].sample_number + pflac->seek_spacing;
+        if (sample < pflac->seek_next)
+            return;
+    };
+
+    table->points[pflac->seek_points].sample_number = sample;
+    table->points[pflac->seek_points].stream_offset = offset - pflac->audio_offset;
+    table->points[pflac->seek_points].frame_samples = samples;
+    pflac->seek_points++;
+
+    pflac->seek_next = sample + pflac->seek_spacing;
+}
+
 static FLAC__StreamEncoderWriteStatus
 sf_flac_enc_write_callback(const FLAC__StreamEncoder *UNUSED(encoder), const FLAC__byte buffer[],
-                           size_t bytes, unsigned UNUSED(samples), unsigned UNUSED(current_frame),
+                           size_t bytes, unsigned samples, unsigned UNUSED(current_frame),
                            void *client_data)
 {
     SndFile *psf = (SndFile *)client_data;
+    FLAC_PRIVATE *pflac = (FLAC_PRIVATE *)psf->m_codec_data;
+
+    /* Metadata blocks are written with no samples. */
+    if (samples > 0 && pflac->seektable != NULL)
+        flac_seektable_add(pflac, psf->ftell(), samples);
 
     if (psf->fwrite(buffer, 1, bytes) == (sf_count_t)bytes && psf->m_error == 0)
         return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
@@ -675,6 +846,407 @@ sf_flac_enc_write_callback(const FLAC__StreamEncoder *UNUSED(encoder), const FLA
     return FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;
 }
 
+struct FLAC_CRC_TABLES
+{
+    uint8_t crc8[256];
+    uint16_t crc16[256];
+
+    FLAC_CRC_TABLES()
+    {
+        for (unsigned k = 0; k < 256; k++)
+        {
+            unsigned c8 = k, c16 = k << 8;
+
+            for (int b = 0; b < 8; b++)
+            {
+                c8 = (c8 & 0x80) ? (c8 << 1) ^ 0x07 : c8 << 1;
+                c16 = (c16 & 0x8000) ? (c16 << 1) ^ 0x8005 : c16 << 1;
+            };
+
+            crc8[k] = (uint8_t)c8;
+            crc16[k] = (uint16_t)c16;
+        };
+    }
+};
+
+static const FLAC_CRC_TABLES flac_crc_tables;
+
+/* Appends a frame number in the UTF-8 like coding of frame headers. */
+static void flac_utf8_append(std::vector<FLAC__byte> &dest, uint64_t value)
+{
+    unsigned n = 2;
+
+    if (value < 0x80)
+    {
+        dest.push_back((FLAC__byte)value);
+        return;
+    };
+
+    while (n < 7 && value >= ((uint64_t)1 << (5 * n + 1)))
+        n++;
+
+    dest.push_back((FLAC__byte)(((0xFF00 >> n) & 0xFF) | (value >> (6 * (n - 1)))));
+    while (--n > 0)
+        dest.push_back((FLAC__byte)(0x80 | ((value >> (6 * (n - 1))) & 0x3F)));
+}
+
+/*
+** Copies a frame to dest with its frame number replaced and both CRCs
+** recomputed. Returns false if the frame header is not one of a fixed block
+** size stream.
+*/
+static bool flac_frame_renumber(const FLAC__byte *frame, size_t bytes, uint64_t number,
+                                std::vector<FLAC__byte> &dest)
+{
+    size_t len, pos;
+    unsigned crc8 = 0, crc16 = 0;
+
+    if (bytes < 8 || frame[0] != 0xFF || frame[1] != 0xF8)
+        return false;
+
+    /* Length of the coded frame number, from the leading ones of its first byte. */
+    for (len = 0; len < 8 && (frame[4] & (0x80 >> len)); len++)
+        ;
+    if (len == 1 || len > 6)
+        return false;
+    len = std::max(len, (size_t)1);
+
+    /* Block size and sample rate may follow it, then the CRC-8. */
+    pos = 4 + len;
+    switch (frame[2] >> 4)
+    {
+    case 6:
+        pos += 1;
+        break;
+    case 7:
+        pos += 2;
+        break;
+    };
+    switch (frame[2] & 0x0F)
+    {
+    case 12:
+        pos += 1;
+        break;
+    case 13:
+    case 14:
+        pos += 2;
+        break;
+    };
+
+    if (pos + 3 > bytes)
+        return false;
+
+    dest.clear();
+    dest.insert(dest.end(), frame, frame + 4);
+    flac_utf8_append(dest, number);
+    dest.insert(dest.end(), frame + 4 + len, frame + pos);
+
+    for (FLAC__byte b : dest)
+        crc8 = flac_crc_tables.crc8[crc8 ^ b];
+    dest.push_back((FLAC__byte)crc8);
+
+    dest.insert(dest.end(), frame + pos + 1, frame + bytes - 2);
+
+    for (FLAC__byte b : dest)
+        crc16 = ((crc16 << 8) ^ flac_crc_tables.crc16[(crc16 >> 8) ^ b]) & 0xFFFF;
+    dest.push_back((FLAC__byte)(crc16 >> 8));
+    dest.push_back((FLAC__byte)crc16);
+
+    return true;
+}
+
+static FLAC__StreamEncoderWriteStatus
+flac_job_write_callback(const FLAC__StreamEncoder *UNUSED(encoder), const FLAC__byte buffer[],
+                        size_t bytes, unsigned samples, unsigned UNUSED(current_frame),
+                        void *client_data)
+{
+    FLAC_JOB *job = (FLAC_JOB *)client_data;
+
+    /* The stream header and metadata come from the main encoder. */
+    if (samples == 0)
+        return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+
+    try
+    {
+        job->output.insert(job->output.end(), buffer, buffer + bytes);
+        job->frame_end.push_back(job->output.size());
+        job->frame_samples.push_back(samples);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;
+    };
+
+    return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+}
+
+/*
+** Runs on a worker thread, must not touch the SndFile. The MD5 sum each job's
+** encoder keeps is thrown away, the one for the whole stream is summed in
+** flac_job_md5().
+*/
+static void flac_job_encode(const FLAC_PARALLEL *par, FLAC_JOB *job)
+{
+    FLAC__StreamEncoder *fse;
+
+    job->ok = false;
+
+    if ((fse = FLAC__stream_encoder_new()) == NULL)
+        return;
+
+    /* The compression level sets the block size too, so it goes first. */
+    if (FLAC__stream_encoder_set_channels(fse, par->channels) &&
+        FLAC__stream_encoder_set_sample_rate(fse, par->samplerate) &&
+        FLAC__stream_encoder_set_bits_per_sample(fse, par->bps) &&
+        FLAC__stream_encoder_set_compression_level(fse, par->compression) &&
+        FLAC__stream_encoder_set_blocksize(fse, par->blocksize) &&
+        FLAC__stream_encoder_init_stream(fse, flac_job_write_callback, NULL, NULL, NULL, job) ==
+            FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+    {
+        job->ok = FLAC__stream_encoder_process_interleaved(
+                      fse, job->samples.data(), (unsigned)(job->samples.size() / par->channels));
+        job->ok = FLAC__stream_encoder_finish(fse) && job->ok;
+    };
+
+    FLAC__stream_encoder_delete(fse);
+}
+
+/* Adds the samples of a job to the MD5 sum, as little endian bytes like libFLAC does. */
+static void flac_job_md5(FLAC_PARALLEL *par, const FLAC_JOB *job)
+{
+    unsigned char bytes[4096];
+    const unsigned width = (par->bps + 7) / 8;
+    const size_t count = job->samples.size();
+    size_t k = 0;
+
+    while (k < count)
+    {
+        size_t n = std::min(count - k, sizeof(bytes) / width);
+        unsigned char *p = bytes;
+
+        for (size_t j = 0; j < n; j++)
+        {
+            uint32_t sample = (uint32_t)job->samples[k + j];
+
+            for (unsigned b = 0; b < width; b++)
+                *p++ = (unsigned char)(sample >> (8 * b));
+        };
+
+        psf_md5_update(&par->md5, bytes, n * width);
+        k += n;
+    };
+}
+
+static int flac_job_emit(SndFile *psf, FLAC_PARALLEL *par, const FLAC_JOB *job)
+{
+    size_t start = 0;
+
+    for (size_t k = 0; k < job->frame_end.size(); k++)
+    {
+        const FLAC__byte *frame = job->output.data() + start;
+        size_t bytes = job->frame_end[k] - start;
+        unsigned samples = job->frame_samples[k];
+
+        start = job->frame_end[k];
+
+        if (par->frame_number != k)
+        {
+            try
+            {
+                if (!flac_frame_renumber(frame, bytes, par->frame_number, par->frame))
+                    return (psf->m_error = SFE_INTERNAL);
+            }
+            catch (const std::bad_alloc &)
+            {
+                return (psf->m_error = SFE_MALLOC_FAILED);
+            };
+
+            frame = par->frame.data();
+            bytes = par->frame.size();
+        };
+
+        if (sf_flac_enc_write_callback(NULL, frame, bytes, samples, 0, psf) !=
+            FLAC__STREAM_ENCODER_WRITE_STATUS_OK)
+            return psf->m_error ? psf->m_error : (psf->m_error = SFE_FLAC_UNKOWN_ERROR);
+
+        par->frame_number++;
+        par->total_samples += samples;
+        par->min_framesize = std::min(par->min_framesize, (unsigned)bytes);
+        par->max_framesize = std::max(par->max_framesize, (unsigned)bytes);
+    };
+
+    return 0;
+}
+
+/* Encodes the filled jobs and writes their frames. */
+static int flac_parallel_run(SndFile *psf, FLAC_PARALLEL *par)
+{
+    std::vector<std::thread> threads;
+    unsigned count = par->filled, started = 0, k;
+
+    /* The last job is encoded on this thread. */
+    try
+    {
+        threads.reserve(count);
+        for (; started + 1 < count; started++)
+            threads.emplace_back(flac_job_encode, par, &par->jobs[started]);
+    }
+    catch (const std::exception &)
+    {
+        /* Out of threads, encode the rest here. */
+    };
+
+    for (k = 0; k < count; k++)
+        flac_job_md5(par, &par->jobs[k]);
+
+    for (k = started; k < count; k++)
+        flac_job_encode(par, &par->jobs[k]);
+
+    for (auto &thread : threads)
+        thread.join();
+
+    for (k = 0; k < count; k++)
+    {
+        FLAC_JOB *job = &par->jobs[k];
+
+        if (psf->m_error == 0)
+        {
+            if (!job->ok)
+                psf->m_error = SFE_FLAC_UNKOWN_ERROR;
+            else
+                flac_job_emit(psf, par, job);
+        };
+
+        job->samples.clear();
+        job->output.clear();
+        job->frame_end.clear();
+        job->frame_samples.clear();
+    };
+
+    par->filled = 0;
+
+    return psf->m_error;
+}
+
+/* Takes the place of FLAC__stream_encoder_process_interleaved(). */
+static FLAC__bool flac_enc_process(SndFile *psf, FLAC_PRIVATE *pflac, const int32_t *buffer,
+                                   unsigned frames)
+{
+    FLAC_PARALLEL *par = pflac->parallel;
+    size_t count;
+
+    if (par == NULL)
+        return FLAC__stream_encoder_process_interleaved(pflac->fse, buffer, frames);
+
+    count = (size_t)frames * par->channels;
+    while (count > 0)
+    {
+        FLAC_JOB *job = &par->jobs[par->filled];
+        size_t n = std::min(count, par->job_frames * par->channels - job->samples.size());
+
+        /* Reserved up front, this does not allocate. */
+        job->samples.insert(job->samples.end(), buffer, buffer + n);
+        buffer += n;
+        count -= n;
+
+        if (job->samples.size() == par->job_frames * par->channels)
+        {
+            par->filled++;
+            if (par->filled == par->jobs.size() && flac_parallel_run(psf, par))
+                return false;
+        };
+    };
+
+    return psf->m_error == 0;
+}
+
+static int flac_parallel_init(SndFile *psf, FLAC_PRIVATE *pflac)
+{
+    FLAC_PARALLEL *par;
+
+    /* Without a fixed block size the jobs could not be cut, encode serially. */
+    if (pflac->threads < 2 || FLAC__stream_encoder_get_blocksize(pflac->fse) == 0)
+        return 0;
+
+    try
+    {
+        par = new FLAC_PARALLEL;
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SFE_MALLOC_FAILED;
+    };
+
+    par->channels = psf->sf.channels;
+    par->bps = FLAC__stream_encoder_get_bits_per_sample(pflac->fse);
+    par->samplerate = psf->sf.samplerate;
+    par->compression = pflac->compression;
+    par->blocksize = FLAC__stream_encoder_get_blocksize(pflac->fse);
+    par->job_frames = (size_t)par->blocksize * FLAC_JOB_BLOCKS;
+    par->filled = 0;
+    par->frame_number = 0;
+    par->total_samples = 0;
+    par->min_framesize = UINT32_MAX;
+    par->max_framesize = 0;
+    psf_md5_init(&par->md5);
+
+    try
+    {
+        par->jobs.resize(pflac->threads);
+        for (auto &job : par->jobs)
+            job.samples.reserve(par->job_frames * par->channels);
+    }
+    catch (const std::bad_alloc &)
+    {
+        delete par;
+        return SFE_MALLOC_FAILED;
+    };
+
+    pflac->parallel = par;
+
+    return 0;
+}
+
+/*
+** Writes out the last, partly filled, jobs. This has to happen before the
+** main encoder finishes.
+*/
+static void flac_parallel_flush(SndFile *psf, FLAC_PARALLEL *par)
+{
+    if (!par->jobs[par->filled].samples.empty())
+        par->filled++;
+
+    if (par->filled > 0)
+        flac_parallel_run(psf, par);
+}
+
+/* Replaces the STREAMINFO the main encoder wrote with one for the frames written here. */
+static void flac_parallel_write_streaminfo(SndFile *psf, FLAC_PARALLEL *par)
+{
+    unsigned char info[FLAC_STREAMINFO_LENGTH];
+    unsigned min_framesize = par->frame_number > 0 ? par->min_framesize : 0;
+    uint64_t packed;
+
+    info[0] = info[2] = (unsigned char)(par->blocksize >> 8);
+    info[1] = info[3] = (unsigned char)par->blocksize;
+    info[4] = (unsigned char)(min_framesize >> 16);
+    info[5] = (unsigned char)(min_framesize >> 8);
+    info[6] = (unsigned char)min_framesize;
+    info[7] = (unsigned char)(par->max_framesize >> 16);
+    info[8] = (unsigned char)(par->max_framesize >> 8);
+    info[9] = (unsigned char)par->max_framesize;
+
+    packed = ((uint64_t)par->samplerate << 44) | ((uint64_t)(par->channels - 1) << 41) |
+             ((uint64_t)(par->bps - 1) << 36) | (par->total_samples & 0xFFFFFFFFFULL);
+    for (int k = 0; k < 8; k++)
+        info[10 + k] = (unsigned char)(packed >> (56 - 8 * k));
+
+    psf_md5_final(&par->md5, info + 18);
+
+    if (psf->fseek(FLAC_STREAMINFO_OFFSET, SEEK_SET) == FLAC_STREAMINFO_OFFSET)
+        psf->fwrite(info, 1, sizeof(info));
+}
+
 static void flac_write_strings(SndFile *psf, FLAC_PRIVATE *pflac)
 {
     FLAC__StreamMetadata_VorbisComment_Entry entry;
@@ -743,21 +1315,52 @@ static void flac_write_strings(SndFile *psf, FLAC_PRIVATE *pflac)
                                                            /* copy */ SF_FALSE);
     };
 
-    if (!FLAC__stream_encoder_set_metadata(pflac->fse, &pflac->metadata, 1))
+    return;
+}
+
+static void flac_write_seektable(SndFile *psf, FLAC_PRIVATE *pflac)
+{
+    if (pflac->seektable_spacing <= 0.0)
+        return;
+
+    if ((pflac->seektable = FLAC__metadata_object_new(FLAC__METADATA_TYPE_SEEKTABLE)) == NULL ||
+        !FLAC__metadata_object_seektable_template_append_placeholders(pflac->seektable,
+                                                                      FLAC_SEEKTABLE_POINTS))
     {
-        printf("%s %d : fail\n", __func__, __LINE__);
+        psf->log_printf("%s : could not allocate the seek table.\n", __func__);
+        if (pflac->seektable != NULL)
+            FLAC__metadata_object_delete(pflac->seektable);
+        pflac->seektable = NULL;
         return;
     };
 
-    return;
+    pflac->seek_points = 0;
+    pflac->seek_spacing = (std::max)((sf_count_t)1, (sf_count_t)lrint(pflac->seektable_spacing * psf->sf.samplerate));
+    pflac->seek_next = 0;
+    pflac->enc_samples = 0;
+    pflac->audio_offset = -1;
 }
 
 static int flac_write_header(SndFile *psf, int UNUSED(calc_length))
 {
     FLAC_PRIVATE *pflac = (FLAC_PRIVATE *)psf->m_codec_data;
+    FLAC__StreamMetadata *metadata[2];
+    unsigned metadata_count = 0;
     int err;
 
     flac_write_strings(psf, pflac);
+    flac_write_seektable(psf, pflac);
+
+    if (pflac->seektable != NULL)
+        metadata[metadata_count++] = pflac->seektable;
+    if (pflac->metadata != NULL)
+        metadata[metadata_count++] = pflac->metadata;
+
+    if (metadata_count > 0 && !FLAC__stream_encoder_set_metadata(pflac->fse, metadata, metadata_count))
+    {
+        psf->log_printf("%s : FLAC__stream_encoder_set_metadata failed.\n", __func__);
+        return SFE_FLAC_INIT_DECODER;
+    };
 
     if ((err = FLAC__stream_encoder_init_stream(
              pflac->fse, sf_flac_enc_write_callback, sf_flac_enc_seek_callback,
@@ -775,6 +1378,10 @@ static int flac_write_header(SndFile *psf, int UNUSED(calc_length))
     /* can only call init_stream once */
     psf->write_header = NULL;
 
+    /* The encoder only knows its block size once initialised. */
+    if (psf->m_error == 0 && (err = flac_parallel_init(psf, pflac)))
+        return err;
+
     return psf->m_error;
 }
 
@@ -788,6 +1395,7 @@ int flac_open(SndFile *psf)
 
     /* Set the default value here. Over-ridden later if necessary. */
     pflac->compression = FLAC_DEFAULT_COMPRESSION_LEVEL;
+    pflac->seektable_spacing = FLAC_DEFAULT_SEEKTABLE_SPACING;
 
     if (psf->m_mode == SFM_RDWR)
         return SFE_BAD_MODE_RW;
@@ -852,16 +1460,26 @@ static int flac_close(SndFile *psf)
     if ((pflac = (FLAC_PRIVATE *)psf->m_codec_data) == NULL)
         return 0;
 
-    if (pflac->metadata != NULL)
-        FLAC__metadata_object_delete(pflac->metadata);
-
     if (psf->m_mode == SFM_WRITE)
     {
+        if (pflac->parallel != NULL)
+            flac_parallel_flush(psf, pflac->parallel);
         FLAC__stream_encoder_finish(pflac->fse);
+        if (pflac->parallel != NULL)
+        {
+            flac_parallel_write_streaminfo(psf, pflac->parallel);
+            delete pflac->parallel;
+        };
         FLAC__stream_encoder_delete(pflac->fse);
         free(pflac->encbuffer);
     };
 
+    /* The encoder uses the metadata until it is finished. */
+    if (pflac->metadata != NULL)
+        FLAC__metadata_object_delete(pflac->metadata);
+    if (pflac->seektable != NULL)
+        FLAC__metadata_object_delete(pflac->seektable);
+
     if (psf->m_mode == SFM_READ)
     {
         FLAC__stream_decoder_finish(pflac->fsd);
@@ -1015,6 +1633,57 @@ static size_t flac_command(SndFile *psf, int command, void *data, size_t datasiz
 
         return SF_TRUE;
 
+    case SFC_SET_SEEKTABLE_SPACING:
+        if (data == NULL || datasize != sizeof(double))
+            return SF_FALSE;
+
+        if (psf->m_mode != SFM_WRITE || psf->m_have_written || psf->write_header == NULL)
+            return SF_FALSE;
+
+        if (!(*((double *)data) >= 0.0))
+            return SF_FALSE;
+
+        pflac->seektable_spacing = *((double *)data);
+        return SF_TRUE;
+
+    case SFC_GET_SEEKTABLE_INFO:
+    {
+        if (data == NULL || datasize != sizeof(SF_SEEKTABLE_INFO))
+            return SF_FALSE;
+
+        SF_SEEKTABLE_INFO *info = (SF_SEEKTABLE_INFO *)data;
+
+        info->points = pflac->seek_points;
+        info->spacing = 0.0;
+
+        if (psf->m_mode == SFM_WRITE)
+        {
+            if (pflac->seektable != NULL)
+                info->spacing = (double)pflac->seek_spacing / psf->sf.samplerate;
+        }
+        else if (pflac->seek_points > 1)
+            info->spacing = (double)(pflac->seek_last - pflac->seek_first) /
+                            (pflac->seek_points - 1) / psf->sf.samplerate;
+
+        return info->points > 0 ? SF_TRUE : SF_FALSE;
+    }
+
+    case SFC_SET_ENCODER_THREADS:
+        if (data == NULL || datasize != sizeof(int))
+            return SF_FALSE;
+
+        if (psf->m_mode != SFM_WRITE || psf->m_have_written || psf->write_header == NULL)
+            return SF_FALSE;
+
+        if (*((int *)data) < 0)
+            return SF_FALSE;
+
+        pflac->threads = std::min(*((int *)data), FLAC_MAX_ENCODER_THREADS);
+
+        psf->log_printf("%s : Setting SFC_SET_ENCODER_THREADS to %u.\n", __func__, pflac->threads);
+
+        return SF_TRUE;
+
     default:
         return SF_FALSE;
     };
@@ -1033,6 +1702,11 @@ int flac_init(SndFile *psf)
         psf->read_int = flac_read_flac2i;
         psf->read_float = flac_read_flac2f;
         psf->read_double = flac_read_flac2d;
+
+        psf->read_short_planar = flac_read_flac2s_planar;
+        psf->read_int_planar = flac_read_flac2i_planar;
+        psf->read_float_planar = flac_read_flac2f_planar;
+        psf->read_double_planar = flac_read_flac2d_planar;
     };
 
     if (psf->m_mode == SFM_WRITE)
@@ -1180,6 +1854,52 @@ static size_t flac_read_flac2d(SndFile *psf, double *ptr, size_t len)
     return total;
 }
 
+static size_t flac_read_planar(SndFile *psf, void *const *ptr, size_t frames, PFLAC_PCM pcmtype)
+{
+    FLAC_PRIVATE *pflac = (FLAC_PRIVATE *)psf->m_codec_data;
+    const size_t channels = psf->sf.channels;
+    size_t total = 0, current;
+    size_t readlen;
+
+    pflac->pcmtype = pcmtype;
+    pflac->planar = true;
+
+    while (total < frames)
+    {
+        pflac->ptr = (void *)ptr;
+        pflac->planar_start = total;
+        readlen = std::min(frames - total, 0x1000000 / channels) * channels;
+        current = flac_read_loop(psf, readlen) / channels;
+        if (current == 0)
+            break;
+        total += current;
+    };
+
+    pflac->planar = false;
+
+    return total;
+}
+
+static size_t flac_read_flac2s_planar(SndFile *psf, short *const *ptr, size_t frames)
+{
+    return flac_read_planar(psf, (void *const *)ptr, frames, PFLAC_PCM_SHORT);
+}
+
+static size_t flac_read_flac2i_planar(SndFile *psf, int *const *ptr, size_t frames)
+{
+    return flac_read_planar(psf, (void *const *)ptr, frames, PFLAC_PCM_INT);
+}
+
+static size_t flac_read_flac2f_planar(SndFile *psf, float *const *ptr, size_t frames)
+{
+    return flac_read_planar(psf, (void *const *)ptr, frames, PFLAC_PCM_FLOAT);
+}
+
+static size_t flac_read_flac2d_planar(SndFile *psf, double *const *ptr, size_t frames)
+{
+    return flac_read_planar(psf, (void *const *)ptr, frames, PFLAC_PCM_DOUBLE);
+}
+
 static size_t flac_write_s2flac(SndFile *psf, const short *ptr, size_t len)
 {
     FLAC_PRIVATE *pflac = (FLAC_PRIVATE *)psf->m_codec_data;
@@ -1210,8 +1930,7 @@ static size_t flac_write_s2flac(SndFile *psf, const short *ptr, size_t len)
     {
         writecount = (len >= bufferlen) ? bufferlen : len;
         convert(ptr + total, buffer, writecount);
-        if (FLAC__stream_encoder_process_interleaved(pflac->fse, buffer,
-                                                     writecount / psf->sf.channels))
+        if (flac_enc_process(psf, pflac, buffer, writecount / psf->sf.channels))
             thiswrite = writecount;
         else
             break;
@@ -1255,8 +1974,7 @@ static size_t flac_write_i2flac(SndFile *psf, const int *ptr, size_t len)
     {
         writecount = (len >= bufferlen) ? bufferlen : len;
         convert(ptr + total, buffer, writecount);
-        if (FLAC__stream_encoder_process_interleaved(pflac->fse, buffer,
-                                                     writecount / psf->sf.channels))
+        if (flac_enc_process(psf, pflac, buffer, writecount / psf->sf.channels))
             thiswrite = writecount;
         else
             break;
@@ -1300,8 +2018,7 @@ static size_t flac_write_f2flac(SndFile *psf, const float *ptr, size_t len)
     {
         writecount = (len >= bufferlen) ? bufferlen : (int)len;
         convert(ptr + total, buffer, writecount, psf->m_norm_float);
-        if (FLAC__stream_encoder_process_interleaved(pflac->fse, buffer,
-                                                     writecount / psf->sf.channels))
+        if (flac_enc_process(psf, pflac, buffer, writecount / psf->sf.channels))
             thiswrite = writecount;
         else
             break;
@@ -1455,8 +2172,7 @@ static size_t flac_write_d2flac(SndFile *psf, const double *ptr, size_t len)
     {
         writecount = (len >= bufferlen) ? bufferlen : (int)len;
         convert(ptr + total, buffer, writecount, psf->m_norm_double);
-        if (FLAC__stream_encoder_process_interleaved(pflac->fse, buffer,
-                                                     writecount / psf->sf.channels))
+        if (flac_enc_process(psf, pflac, buffer, writecount / psf->sf.channels))
             thiswrite = writecount;
         else
             break;
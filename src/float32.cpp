@@ -27,6 +27,7 @@
 #include "sndfile2k/sndfile2k.h"
 #include "sfendian.h"
 #include "common.h"
+#include "simd.h"
 
 #if CPU_IS_LITTLE_ENDIAN
 #define FLOAT32_READ float32_le_read
@@ -446,6 +447,8 @@ static int float32_get_capability(SndFile *psf)
 
 static void f2s_array(const float *src, size_t count, short *dest, float scale)
 {
+    count = psf_simd_kernels()->f2s(src, count, dest, scale);
+
     while (count)
     {
         count--;
@@ -455,6 +458,8 @@ static void f2s_array(const float *src, size_t count, short *dest, float scale)
 
 static void f2s_clip_array(const float *src, size_t count, short *dest, float scale)
 {
+    count = psf_simd_kernels()->f2s_clip(src, count, dest, scale);
+
     while (count)
     {
         count--;
@@ -471,6 +476,8 @@ static void f2s_clip_array(const float *src, size_t count, short *dest, float sc
 
 static inline void f2i_array(const float *src, size_t count, int *dest, float scale)
 {
+    count = psf_simd_kernels()->f2i(src, count, dest, scale);
+
     while (count)
     {
         count--;
@@ -480,6 +487,8 @@ static inline void f2i_array(const float *src, size_t count, int *dest, float sc
 
 static inline void f2i_clip_array(const float *src, size_t count, int *dest, float scale)
 {
+    count = psf_simd_kernels()->f2i_clip(src, count, dest, scale);
+
     while (count)
     {
         count--;
@@ -532,14 +541,14 @@ static inline void d2f_array(const double *src, float *dest, size_t count)
 
 static size_t host_read_f2s(SndFile *psf, short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const float *, size_t, short *, float);
     size_t bufferlen, readcount;
     size_t total = 0;
     float scale;
 
     convert = (psf->m_add_clipping) ? f2s_clip_array : f2s_array;
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(float);
     scale = (float)((psf->m_float_int_mult == 0) ? 1.0 : 0x7FFF / psf->m_float_max);
 
     while (len > 0)
@@ -564,101 +573,66 @@ static size_t host_read_f2s(SndFile *psf, short *ptr, size_t len)
 
 static size_t host_read_f2i(SndFile *psf, int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    void (*convert)(const float *, size_t, int *, float);
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     float scale;
 
-    convert = (psf->m_add_clipping) ? f2i_clip_array : f2i_array;
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
     scale = (float)((psf->m_float_int_mult == 0) ? 1.0 : 0x7FFFFFFF / psf->m_float_max);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.fbuf, sizeof(float), bufferlen);
+    /* Ints and floats are the same width, so convert in the caller's buffer. */
+    readcount = psf->fread(ptr, sizeof(float), len);
 
-        if (psf->m_data_endswap == SF_TRUE)
-            endswap_int_array(ubuf.ibuf, bufferlen);
+    if (psf->m_data_endswap == SF_TRUE)
+        endswap_int_array(ptr, readcount);
 
-        convert(ubuf.fbuf, readcount, ptr + total, scale);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
+    if (psf->m_add_clipping)
+        f2i_clip_array((float *)ptr, readcount, ptr, scale);
+    else
+        f2i_array((float *)ptr, readcount, ptr, scale);
 
-    return total;
+    return readcount;
 }
 
 static size_t host_read_f(SndFile *psf, float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
 
-    if (psf->m_data_endswap != SF_TRUE)
-        return psf->fread(ptr, sizeof(float), len);
+    readcount = psf->fread(ptr, sizeof(float), len);
 
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    if (psf->m_data_endswap == SF_TRUE)
+        endswap_int_array((int *)ptr, readcount);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.fbuf, sizeof(float), bufferlen);
-
-        endswap_int_copy((int *)(ptr + total), ubuf.ibuf, readcount);
-
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t host_read_f2d(SndFile *psf, double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
 
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    /*
+    ** Read into the start of the caller's buffer and widen in place. This
+    ** works because f2d_array() runs from the end of the array to the start.
+    */
+    readcount = psf->fread(ptr, sizeof(float), len);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.fbuf, sizeof(float), bufferlen);
+    if (psf->m_data_endswap == SF_TRUE)
+        endswap_int_array((int *)ptr, readcount);
 
-        if (psf->m_data_endswap == SF_TRUE)
-            endswap_int_array(ubuf.ibuf, bufferlen);
+    /* Fix me : Need lef2d_array */
+    f2d_array((float *)ptr, readcount, ptr);
 
-        /* Fix me : Need lef2d_array */
-        f2d_array(ubuf.fbuf, readcount, ptr + total);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t host_write_s2f(SndFile *psf, const short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
     float scale;
 
     /* Erik */
     scale = (float)((psf->m_scale_int_float == 0) ? 1.0 : 1.0 / 0x8000);
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(float);
 
     while (len > 0)
     {
@@ -684,13 +658,13 @@ static size_t host_write_s2f(SndFile *psf, const short *ptr, size_t len)
 
 static size_t host_write_i2f(SndFile *psf, const int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
     float scale;
 
     scale = (float)((psf->m_scale_int_float == 0) ? 1.0 : 1.0 / (8.0 * 0x10000000));
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(float);
 
     while (len > 0)
     {
@@ -716,7 +690,7 @@ static size_t host_write_i2f(SndFile *psf, const int *ptr, size_t len)
 
 static size_t host_write_f(SndFile *psf, const float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
@@ -726,7 +700,7 @@ static size_t host_write_f(SndFile *psf, const float *ptr, size_t len)
     if (psf->m_data_endswap != SF_TRUE)
         return psf->fwrite(ptr, sizeof(float), len);
 
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(float);
 
     while (len > 0)
     {
@@ -747,11 +721,11 @@ static size_t host_write_f(SndFile *psf, const float *ptr, size_t len)
 
 static size_t host_write_d2f(SndFile *psf, const double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(float);
 
     while (len > 0)
     {
@@ -778,12 +752,12 @@ static size_t host_write_d2f(SndFile *psf, const double *ptr, size_t len)
 
 static size_t replace_read_f2s(SndFile *psf, short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
     float scale;
 
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(float);
     scale = (float)((psf->m_float_int_mult == 0) ? 1.0 : 0x7FFF / psf->m_float_max);
 
     while (len > 0)
@@ -809,12 +783,12 @@ static size_t replace_read_f2s(SndFile *psf, short *ptr, size_t len)
 
 static size_t replace_read_f2i(SndFile *psf, int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
     float scale;
 
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(float);
     scale = (float)((psf->m_float_int_mult == 0) ? 1.0 : 0x7FFF / psf->m_float_max);
 
     while (len > 0)
@@ -840,13 +814,13 @@ static size_t replace_read_f2i(SndFile *psf, int *ptr, size_t len)
 
 static size_t replace_read_f(SndFile *psf, float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
 
     /* FIX THIS */
 
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(float);
 
     while (len > 0)
     {
@@ -872,11 +846,11 @@ static size_t replace_read_f(SndFile *psf, float *ptr, size_t len)
 
 static size_t replace_read_f2d(SndFile *psf, double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(float);
 
     while (len > 0)
     {
@@ -901,13 +875,13 @@ static size_t replace_read_f2d(SndFile *psf, double *ptr, size_t len)
 
 static size_t replace_write_s2f(SndFile *psf, const short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
     float scale;
 
     scale = (float)((psf->m_scale_int_float == 0) ? 1.0 : 1.0 / 0x8000);
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(float);
 
     while (len > 0)
     {
@@ -935,13 +909,13 @@ static size_t replace_write_s2f(SndFile *psf, const short *ptr, size_t len)
 
 static size_t replace_write_i2f(SndFile *psf, const int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
     float scale;
 
     scale = (float)((psf->m_scale_int_float == 0) ? 1.0 : 1.0 / (8.0 * 0x10000000));
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(float);
 
     while (len > 0)
     {
@@ -969,7 +943,7 @@ static size_t replace_write_i2f(SndFile *psf, const int *ptr, size_t len)
 
 static size_t replace_write_f(SndFile *psf, const float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
@@ -977,7 +951,7 @@ static size_t replace_write_f(SndFile *psf, const float *ptr, size_t len)
     if (psf->m_peak_info)
         float32_peak_update(psf, ptr, len, 0);
 
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(float);
 
     while (len > 0)
     {
@@ -1003,11 +977,11 @@ static size_t replace_write_f(SndFile *psf, const float *ptr, size_t len)
 
 static size_t replace_write_d2f(SndFile *psf, const double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.fbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(float);
 
     while (len > 0)
     {
@@ -67,6 +67,7 @@ static size_t g72x_write_f(SndFile *psf, const float *ptr, size_t len);
 static size_t g72x_write_d(SndFile *psf, const double *ptr, size_t len);
 
 static sf_count_t g72x_seek(SndFile *psf, int mode, sf_count_t offset);
+static bool g72x_check_checkpoint(SndFile *psf, sf_count_t frame, sf_count_t offset, const int32_t *state);
 
 static int g72x_close(SndFile *psf);
 
@@ -85,7 +86,8 @@ int g72x_init(SndFile *psf)
         return SFE_INTERNAL;
     };
 
-    psf->sf.seekable = SF_FALSE;
+    if (psf->m_mode != SFM_READ)
+        psf->sf.seekable = SF_FALSE;
 
     if (psf->sf.channels != 1)
         return SFE_G72X_NOT_MONO;
@@ -158,6 +160,10 @@ int g72x_init(SndFile *psf)
 
         psf->sf.frames = pg72x->blocks_total * pg72x->samplesperblock;
 
+        psf->m_checkpoints = psf_checkpoints_new(G72x_STATE_LEN, g72x_check_checkpoint);
+        if (psf->m_checkpoints == NULL)
+            return SFE_MALLOC_FAILED;
+
         psf_g72x_decode_block(psf, pg72x);
     }
     else if (psf->m_mode == SFM_WRITE)
@@ -192,6 +198,8 @@ int g72x_init(SndFile *psf)
 
 static int psf_g72x_decode_block(SndFile *psf, G72x_PRIVATE *pg72x)
 {
+    sf_count_t frame;
+    int32_t state[G72x_STATE_LEN];
     size_t k;
 
     pg72x->block_curr++;
@@ -203,6 +211,14 @@ static int psf_g72x_decode_block(SndFile *psf, G72x_PRIVATE *pg72x)
         return 1;
     };
 
+    frame = (sf_count_t)(pg72x->block_curr - 1) * pg72x->samplesperblock;
+    if (frame >= psf_checkpoints_next(psf->m_checkpoints))
+    {
+        g72x_save_state(pg72x->priv, state);
+        psf_checkpoints_add(psf->m_checkpoints, frame,
+                            psf->m_dataoffset + (sf_count_t)(pg72x->block_curr - 1) * pg72x->bytesperblock, state);
+    };
+
     if ((k = psf->fread(pg72x->block, 1, pg72x->bytesperblock)) != pg72x->bytesperblock)
         psf->log_printf("*** Warning : short read (%z != %z).\n", k, pg72x->bytesperblock);
 
@@ -362,15 +378,48 @@ static size_t g72x_read_d(SndFile *psf, double *ptr, size_t len)
     return total;
 }
 
-static sf_count_t g72x_seek(SndFile *psf, int UNUSED(mode), sf_count_t UNUSED(offset))
+/*
+** The decoder state depends on every sample before, so seeks go back to the
+** last checkpoint before the goal and decode forward from there.
+*/
+static sf_count_t g72x_seek(SndFile *psf, int mode, sf_count_t offset)
 {
-    psf->log_printf("seek unsupported\n");
+    G72x_PRIVATE *pg72x;
+    int32_t state[G72x_STATE_LEN];
+    sf_count_t block, cp_frame, cp_offset;
 
-    /* No simple solution. To do properly, would need to seek
-	 * to start of file and decode everything up to seek position.
-	 * Maybe implement SEEK_SET to 0 only?
-	 */
-    return 0;
+    if (psf->m_codec_data == NULL)
+        return 0;
+    pg72x = (G72x_PRIVATE *)psf->m_codec_data;
+
+    if (mode != SFM_READ || !psf_checkpoints_find(psf->m_checkpoints, offset, &cp_frame, &cp_offset, state))
+    {
+        psf->m_error = SFE_BAD_SEEK;
+        return PSF_SEEK_ERROR;
+    };
+
+    if (psf->fseek(cp_offset, SEEK_SET) == PSF_SEEK_ERROR)
+        return PSF_SEEK_ERROR;
+
+    g72x_restore_state(pg72x->priv, state);
+    pg72x->block_curr = (int)(cp_frame / pg72x->samplesperblock);
+
+    block = offset / pg72x->samplesperblock;
+    while (pg72x->block_curr <= block)
+        psf_g72x_decode_block(psf, pg72x);
+
+    pg72x->sample_curr = (int)(offset - block * pg72x->samplesperblock);
+
+    return offset;
+}
+
+static bool g72x_check_checkpoint(SndFile *psf, sf_count_t frame, sf_count_t offset, const int32_t *state)
+{
+    G72x_PRIVATE *pg72x = (G72x_PRIVATE *)psf->m_codec_data;
+
+    return frame % pg72x->samplesperblock == 0 &&
+           offset == psf->m_dataoffset + (frame / pg72x->samplesperblock) * pg72x->bytesperblock &&
+           g72x_check_state(state);
 }
 
 static int psf_g72x_encode_block(SndFile *psf, G72x_PRIVATE *pg72x)
@@ -36,6 +36,9 @@ extern "C" {
 }
 #endif
 
+#include <algorithm>
+#include <mutex>
+
 #define GSM610_BLOCKSIZE (33)
 #define GSM610_SAMPLES (160)
 
@@ -48,13 +51,49 @@ typedef struct gsm610_tag
     int (*decode_block)(SndFile *psf, struct gsm610_tag *pgsm610);
     int (*encode_block)(SndFile *psf, struct gsm610_tag *pgsm610);
 
+    /* Decodes a block already in memory, see gsm610_read_batch(). */
+    int (*decode)(gsm state, const unsigned char *block, short *samples);
+
     short samples[WAVLIKE_GSM610_SAMPLES];
     unsigned char block[WAVLIKE_GSM610_BLOCKSIZE];
+    unsigned char *batch;
 
     /* Damn I hate typedef-ed pointers; yes, gsm is a pointer type. */
     gsm gsm_data;
 } GSM610_PRIVATE;
 
+/*
+** Blocks per thread for batch reads, see psf_read_batch(). The decoder state
+** runs on from one frame to the next, so every thread but the first one starts
+** with a fresh decoder, warmed up on the GSM610_WARMUP_FRAMES frames before
+** its first block.
+*/
+#define GSM610_BATCH_GRAIN (256)
+#define GSM610_WARMUP_FRAMES (32)
+
+typedef struct gsm610_run_tag
+{
+    int first, last;
+    int errors;
+    /* Decoder state and last samples after the warm-up, and the state at last. */
+    gsm start, end;
+    short prev[WAVLIKE_GSM610_SAMPLES];
+    struct gsm610_run_tag *next;
+} GSM610_RUN;
+
+typedef struct
+{
+    GSM610_PRIVATE *pgsm610;
+    const unsigned char *data;
+    short *dest;
+    int wav49;
+    /* Blocks decoded by the caller's thread with pgsm610->gsm_data. */
+    int head, head_errors;
+    /* The runs of the other threads, ordered by first block. */
+    std::mutex lock;
+    GSM610_RUN *runs;
+} GSM610_BATCH;
+
 static size_t gsm610_read_s(SndFile *psf, short *ptr, size_t len);
 static size_t gsm610_read_i(SndFile *psf, int *ptr, size_t len);
 static size_t gsm610_read_f(SndFile *psf, float *ptr, size_t len);
@@ -75,6 +114,9 @@ static int gsm610_encode_block(SndFile *psf, GSM610_PRIVATE *pgsm610);
 static int gsm610_wav_decode_block(SndFile *psf, GSM610_PRIVATE *pgsm610);
 static int gsm610_wav_encode_block(SndFile *psf, GSM610_PRIVATE *pgsm610);
 
+static int gsm610_decode(gsm state, const unsigned char *block, short *samples);
+static int gsm610_wav_decode(gsm state, const unsigned char *block, short *samples);
+
 static sf_count_t gsm610_seek(SndFile *psf, int mode, sf_count_t offset);
 
 static int gsm610_close(SndFile *psf);
@@ -120,6 +162,7 @@ int gsm610_init(SndFile *psf)
 
         pgsm610->encode_block = gsm610_wav_encode_block;
         pgsm610->decode_block = gsm610_wav_decode_block;
+        pgsm610->decode = gsm610_wav_decode;
 
         pgsm610->samplesperblock = WAVLIKE_GSM610_SAMPLES;
         pgsm610->blocksize = WAVLIKE_GSM610_BLOCKSIZE;
@@ -129,6 +172,7 @@ int gsm610_init(SndFile *psf)
     case SF_FORMAT_RAW:
         pgsm610->encode_block = gsm610_encode_block;
         pgsm610->decode_block = gsm610_decode_block;
+        pgsm610->decode = gsm610_decode;
 
         pgsm610->samplesperblock = GSM610_SAMPLES;
         pgsm610->blocksize = GSM610_BLOCKSIZE;
@@ -253,6 +297,182 @@ static int gsm610_decode_block(SndFile *psf, GSM610_PRIVATE *pgsm610)
     return 1;
 }
 
+static int gsm610_wav_decode(gsm state, const unsigned char *block, short *samples)
+{
+    if (gsm_decode(state, (gsm_byte *)block, samples) < 0)
+        return -1;
+
+    return gsm_decode(state, (gsm_byte *)block + (WAVLIKE_GSM610_BLOCKSIZE + 1) / 2,
+                      samples + WAVLIKE_GSM610_SAMPLES / 2);
+}
+
+static int gsm610_decode(gsm state, const unsigned char *block, short *samples)
+{
+    return gsm_decode(state, (gsm_byte *)block, samples);
+}
+
+/*
+** Decodes count blocks already in memory into dest. A block that fails to
+** decode keeps the samples of the one before, as with decode_block(), prev
+** holds those of the block before the first. Returns the number of failures.
+*/
+static int gsm610_decode_blocks(const GSM610_PRIVATE *pgsm610, gsm state, const unsigned char *data,
+                                short *dest, const short *prev, int count)
+{
+    int errors = 0;
+
+    for (int k = 0; k < count; k++)
+    {
+        short *samples = dest + (size_t)k * pgsm610->samplesperblock;
+
+        memcpy(samples, prev, pgsm610->samplesperblock * sizeof(short));
+        if (pgsm610->decode(state, data + (size_t)k * pgsm610->blocksize, samples) < 0)
+            errors++;
+        prev = samples;
+    };
+
+    return errors;
+}
+
+static void gsm610_free_run(GSM610_RUN *run)
+{
+    if (run->start)
+        gsm_destroy(run->start);
+    if (run->end)
+        gsm_destroy(run->end);
+    free(run);
+}
+
+static void gsm610_decode_run(void *data, int first, int last)
+{
+    GSM610_BATCH *batch = (GSM610_BATCH *)data;
+    const GSM610_PRIVATE *pgsm610 = batch->pgsm610;
+    GSM610_RUN *run, **pos;
+    int warmup;
+
+    if (first == 0)
+    {
+        batch->head = last;
+        batch->head_errors = gsm610_decode_blocks(pgsm610, pgsm610->gsm_data, batch->data, batch->dest,
+                                                  pgsm610->samples, last);
+        return;
+    };
+
+    /* Blocks without a run are left to gsm610_read_batch(). */
+    if ((run = (GSM610_RUN *)calloc(1, sizeof(GSM610_RUN))) == NULL)
+        return;
+
+    if ((run->start = gsm_create()) == NULL || (run->end = gsm_create()) == NULL)
+    {
+        gsm610_free_run(run);
+        return;
+    };
+
+    run->first = first;
+    run->last = last;
+
+    /* Failed blocks leave run->prev as it was, just as in decode_block(). */
+    gsm_option(run->end, GSM_OPT_WAV49, &batch->wav49);
+    warmup = GSM610_WARMUP_FRAMES * GSM610_SAMPLES / pgsm610->samplesperblock;
+    for (int k = std::max(first - warmup, 0); k < first; k++)
+        pgsm610->decode(run->end, batch->data + (size_t)k * pgsm610->blocksize, run->prev);
+
+    gsm_copy(run->start, run->end);
+    run->errors = gsm610_decode_blocks(pgsm610, run->end, batch->data + (size_t)first * pgsm610->blocksize,
+                                       batch->dest + (size_t)first * pgsm610->samplesperblock, run->prev,
+                                       last - first);
+
+    std::lock_guard<std::mutex> guard(batch->lock);
+
+    for (pos = &batch->runs; *pos != NULL && (*pos)->first < first; pos = &(*pos)->next)
+        ;
+    run->next = *pos;
+    *pos = run;
+}
+
+/*
+** Reads as many of the following blocks as fit in len with a single read and
+** decodes them straight into ptr. Returns the number of blocks decoded, 0 when
+** the caller has to go block by block.
+**
+** The decoders of the threads after the first one don't start from the true
+** state, but GSM 06.10 forgets its past quickly and after the warm-up they
+** have nearly always caught up with it. That is checked: a run is only kept if
+** its decoder started in the state the run before it ended in and with the
+** same last samples, in which case it decoded exactly what a single decoder
+** would have. Any other run is decoded again from the true state.
+*/
+static int gsm610_read_batch(SndFile *psf, GSM610_PRIVATE *pgsm610, short *ptr, size_t len)
+{
+    GSM610_BATCH batch;
+    GSM610_RUN *run;
+    sf_count_t remaining, count, readlen;
+    int done, last, errors;
+
+    remaining = std::min((sf_count_t)pgsm610->blocks, psf->m_datalength / pgsm610->blocksize) - pgsm610->blockcount;
+    count = (sf_count_t)(len / pgsm610->samplesperblock);
+    count = std::min(std::min(count, remaining), (sf_count_t)(PSF_BATCH_LEN / pgsm610->blocksize));
+
+    if (count <= 0)
+        return 0;
+
+    readlen = count * pgsm610->blocksize;
+    if (!psf_read_batch(psf, &pgsm610->batch, readlen))
+        return 0;
+
+    batch.pgsm610 = pgsm610;
+    batch.data = pgsm610->batch;
+    batch.dest = ptr;
+    batch.wav49 = gsm_option(pgsm610->gsm_data, GSM_OPT_WAV49, NULL);
+    batch.head = 0;
+    batch.head_errors = 0;
+    batch.runs = NULL;
+
+    psf_parallel_for(gsm610_decode_run, &batch, (int)count, GSM610_BATCH_GRAIN);
+
+    done = batch.head;
+    errors = batch.head_errors;
+    while (done < count)
+    {
+        const short *prev = done > 0 ? ptr + (size_t)(done - 1) * pgsm610->samplesperblock : pgsm610->samples;
+
+        run = batch.runs;
+        if (run != NULL && run->first == done && gsm_decoder_state_equal(run->start, pgsm610->gsm_data) &&
+            memcmp(run->prev, prev, pgsm610->samplesperblock * sizeof(short)) == 0)
+        {
+            gsm_copy(pgsm610->gsm_data, run->end);
+            errors += run->errors;
+            done = run->last;
+        }
+        else
+        {
+            last = run == NULL ? (int)count : (run->first > done ? run->first : run->last);
+            errors += gsm610_decode_blocks(pgsm610, pgsm610->gsm_data,
+                                           batch.data + (size_t)done * pgsm610->blocksize,
+                                           ptr + (size_t)done * pgsm610->samplesperblock, prev, last - done);
+            done = last;
+        };
+
+        if (run != NULL && run->first < done)
+        {
+            batch.runs = run->next;
+            gsm610_free_run(run);
+        };
+    };
+
+    if (errors > 0)
+        psf->log_printf("Error from gsm_decode() on %d frames.\n", errors);
+
+    pgsm610->blockcount += (int)count;
+    pgsm610->samplecount = pgsm610->samplesperblock;
+
+    memcpy(pgsm610->samples, ptr + (size_t)(count - 1) * pgsm610->samplesperblock,
+           pgsm610->samplesperblock * sizeof(short));
+    memcpy(pgsm610->block, pgsm610->batch + readlen - pgsm610->blocksize, pgsm610->blocksize);
+
+    return (int)count;
+}
+
 static size_t gsm610_read_block(SndFile *psf, GSM610_PRIVATE *pgsm610, short *ptr, size_t len)
 {
     size_t count, total = 0, indx = 0;
@@ -267,7 +487,16 @@ static size_t gsm610_read_block(SndFile *psf, GSM610_PRIVATE *pgsm610, short *pt
         };
 
         if (pgsm610->samplecount >= pgsm610->samplesperblock)
+        {
+            if ((count = gsm610_read_batch(psf, pgsm610, ptr + indx, len - indx)) > 0)
+            {
+                indx += count * pgsm610->samplesperblock;
+                total = indx;
+                continue;
+            };
+
             pgsm610->decode_block(psf, pgsm610);
+        };
 
         count = pgsm610->samplesperblock - pgsm610->samplecount;
         count = (len - indx > count) ? count : len - indx;
@@ -309,89 +538,17 @@ static size_t gsm610_read_s(SndFile *psf, short *ptr, size_t len)
 
 static size_t gsm610_read_i(SndFile *psf, int *ptr, size_t len)
 {
-    GSM610_PRIVATE *pgsm610;
-    BUF_UNION ubuf;
-    short *sptr;
-    size_t k, bufferlen, readcount = 0, count;
-    size_t total = 0;
-
-    if (psf->m_codec_data == NULL)
-        return 0;
-    pgsm610 = (GSM610_PRIVATE *)psf->m_codec_data;
-
-    sptr = ubuf.sbuf;
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
-    while (len > 0)
-    {
-        readcount = (len >= bufferlen) ? bufferlen : len;
-        count = gsm610_read_block(psf, pgsm610, sptr, readcount);
-        for (k = 0; k < readcount; k++)
-            ptr[total + k] = arith_shift_left(sptr[k], 16);
-
-        total += count;
-        len -= readcount;
-    };
-    return total;
+    return psf_read_widened(psf, ptr, len, gsm610_read_s);
 }
 
 static size_t gsm610_read_f(SndFile *psf, float *ptr, size_t len)
 {
-    GSM610_PRIVATE *pgsm610;
-    BUF_UNION ubuf;
-    short *sptr;
-    size_t k, bufferlen, readcount = 0, count;
-    size_t total = 0;
-    float normfact;
-
-    if (psf->m_codec_data == NULL)
-        return 0;
-    pgsm610 = (GSM610_PRIVATE *)psf->m_codec_data;
-
-    normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x8000) : 1.0);
-
-    sptr = ubuf.sbuf;
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
-    while (len > 0)
-    {
-        readcount = (len >= bufferlen) ? bufferlen : len;
-        count = gsm610_read_block(psf, pgsm610, sptr, readcount);
-        for (k = 0; k < readcount; k++)
-            ptr[total + k] = normfact * sptr[k];
-
-        total += count;
-        len -= readcount;
-    };
-    return total;
+    return psf_read_widened(psf, ptr, len, gsm610_read_s);
 }
 
 static size_t gsm610_read_d(SndFile *psf, double *ptr, size_t len)
 {
-    GSM610_PRIVATE *pgsm610;
-    BUF_UNION ubuf;
-    short *sptr;
-    size_t k, bufferlen, readcount = 0, count;
-    size_t total = 0;
-    double normfact;
-
-    normfact = (psf->m_norm_double == SF_TRUE) ? 1.0 / ((double)0x8000) : 1.0;
-
-    if (psf->m_codec_data == NULL)
-        return 0;
-    pgsm610 = (GSM610_PRIVATE *)psf->m_codec_data;
-
-    sptr = ubuf.sbuf;
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
-    while (len > 0)
-    {
-        readcount = (len >= bufferlen) ? bufferlen : len;
-        count = gsm610_read_block(psf, pgsm610, sptr, readcount);
-        for (k = 0; k < readcount; k++)
-            ptr[total + k] = normfact * sptr[k];
-
-        total += count;
-        len -= readcount;
-    };
-    return total;
+    return psf_read_widened(psf, ptr, len, gsm610_read_s);
 }
 
 static sf_count_t gsm610_seek(SndFile *psf, int UNUSED(mode), sf_count_t offset)
@@ -655,5 +812,8 @@ static int gsm610_close(SndFile *psf)
     if (pgsm610->gsm_data)
         gsm_destroy(pgsm610->gsm_data);
 
+    free(pgsm610->batch);
+    pgsm610->batch = NULL;
+
     return 0;
 }
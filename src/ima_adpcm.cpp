@@ -28,20 +28,44 @@
 #include "common.h"
 #include "shift.h"
 
+#include <algorithm>
+#include <atomic>
+
 typedef struct IMA_ADPCM_PRIVATE_tag
 {
     int (*decode_block)(SndFile *psf, struct IMA_ADPCM_PRIVATE_tag *pima);
     int (*encode_block)(SndFile *psf, struct IMA_ADPCM_PRIVATE_tag *pima);
 
+    /*
+    ** Decodes a block already in memory into samples, returns the number of
+    ** channels with a bad block header. NULL if the layout of the blocks
+    ** doesn't allow batch reads, see ima_read_batch().
+    */
+    int (*decode)(const struct IMA_ADPCM_PRIVATE_tag *pima, const unsigned char *block, short *samples);
+
     int channels, blocksize, samplesperblock, blocks;
     int blockcount, samplecount;
     int previous[2];
     int stepindx[2];
+    /* Bytes read and blockcount increment per decoded block. */
+    int batch_blocklen, batch_step;
+    unsigned char *batch;
     unsigned char *block;
     short *samples;
     short data[];
 } IMA_ADPCM_PRIVATE;
 
+/* Blocks per thread for batch reads, see psf_read_batch(). */
+#define IMA_BATCH_GRAIN (32)
+
+typedef struct
+{
+    const IMA_ADPCM_PRIVATE *pima;
+    const unsigned char *data;
+    short *dest;
+    std::atomic<int> errors;
+} IMA_BATCH;
+
 static int ima_indx_adjust[16] = {
     -1, -1, -1, -1, /* +0 - +3, decrease the step size */
     +2, +4, +6, +8, /* +4 - +7, increase the step size */
@@ -86,6 +110,9 @@ static int wavlike_ima_encode_block(SndFile *psf, IMA_ADPCM_PRIVATE *pima);
 static int aiff_ima_decode_block(SndFile *psf, IMA_ADPCM_PRIVATE *pima);
 static int aiff_ima_encode_block(SndFile *psf, IMA_ADPCM_PRIVATE *pima);
 
+static int wavlike_ima_decode(const IMA_ADPCM_PRIVATE *pima, const unsigned char *block, short *samples);
+static int aiff_ima_decode(const IMA_ADPCM_PRIVATE *pima, const unsigned char *block, short *samples);
+
 static inline int clamp_ima_step_index(int indx)
 {
     if (indx < 0)
@@ -96,6 +123,27 @@ static inline int clamp_ima_step_index(int indx)
     return indx;
 }
 
+/* Decodes one 4 bit code, predictor and stepindx are the state of its channel. */
+static inline short ima_decode_sample(int bytecode, int &predictor, int &stepindx)
+{
+    int step = ima_step_size[stepindx];
+    int diff = step >> 3;
+
+    if (bytecode & 1)
+        diff += step >> 2;
+    if (bytecode & 2)
+        diff += step >> 1;
+    if (bytecode & 4)
+        diff += step;
+    if (bytecode & 8)
+        diff = -diff;
+
+    predictor = std::min(std::max(predictor + diff, -32768), 32767);
+    stepindx = clamp_ima_step_index(stepindx + ima_indx_adjust[bytecode]);
+
+    return predictor;
+}
+
 int wavlike_ima_init(SndFile *psf, int blockalign, int samplesperblock)
 {
     int error;
@@ -162,6 +210,9 @@ static int ima_close(SndFile *psf)
         psf->sf.frames = pima->samplesperblock * pima->blockcount / psf->sf.channels;
     };
 
+    free(pima->batch);
+    pima->batch = NULL;
+
     return 0;
 }
 
@@ -223,12 +274,24 @@ static int ima_reader_init(SndFile *psf, int blockalign, int samplesperblock)
 
         pima->decode_block = wavlike_ima_decode_block;
 
+        /* Batches need whole groups of 4 bytes per channel, as every encoder writes them. */
+        if (pima->channels <= 2 && (pima->blocksize - 4 * pima->channels) % (4 * pima->channels) == 0)
+        {
+            pima->decode = wavlike_ima_decode;
+            pima->batch_blocklen = pima->blocksize;
+            pima->batch_step = 1;
+        };
+
         psf->sf.frames = pima->samplesperblock * pima->blocks;
         break;
 
     case SF_FORMAT_AIFF:
         psf->log_printf("still need to check block count\n");
         pima->decode_block = aiff_ima_decode_block;
+        pima->decode = aiff_ima_decode;
+        /* A block of each channel, blockcount counts them separately. */
+        pima->batch_blocklen = pima->blocksize * pima->channels;
+        pima->batch_step = pima->channels;
         psf->sf.frames = pima->samplesperblock * pima->blocks / pima->channels;
         break;
 
@@ -325,6 +388,30 @@ static int aiff_ima_decode_block(SndFile *psf, IMA_ADPCM_PRIVATE *pima)
     return 1;
 }
 
+/* As aiff_ima_decode_block(), with the codes decoded as they are unpacked. */
+static int aiff_ima_decode(const IMA_ADPCM_PRIVATE *pima, const unsigned char *block, short *samples)
+{
+    const int channels = pima->channels;
+
+    for (int chan = 0; chan < channels; chan++)
+    {
+        const unsigned char *blockdata = block + chan * pima->blocksize;
+        short *sampledata = samples + chan;
+        int predictor = (short)((blockdata[0] << 8) | (blockdata[1] & 0x80));
+        int stepindx = clamp_ima_step_index(blockdata[1] & 0x7F);
+
+        for (int k = 0; k < pima->blocksize - 2; k++)
+        {
+            int bytecode = blockdata[k + 2];
+
+            sampledata[channels * (2 * k + 0)] = ima_decode_sample(bytecode & 0xF, predictor, stepindx);
+            sampledata[channels * (2 * k + 1)] = ima_decode_sample((bytecode >> 4) & 0xF, predictor, stepindx);
+        };
+    };
+
+    return 0;
+}
+
 static int aiff_ima_encode_block(SndFile *psf, IMA_ADPCM_PRIVATE *pima)
 {
     int chan, k, step, diff, vpdiff, blockindx, indx;
@@ -509,6 +596,44 @@ static int wavlike_ima_decode_block(SndFile *psf, IMA_ADPCM_PRIVATE *pima)
     return 1;
 }
 
+/*
+** As wavlike_ima_decode_block(), for blocks made of whole groups of 4 bytes
+** per channel. The codes are decoded as they are unpacked.
+*/
+static int wavlike_ima_decode(const IMA_ADPCM_PRIVATE *pima, const unsigned char *block, short *samples)
+{
+    const int channels = pima->channels;
+    int errors = 0;
+
+    for (int chan = 0; chan < channels; chan++)
+    {
+        const unsigned char *header = block + chan * 4;
+        short *dest = samples + channels + chan;
+        int predictor = (short)(header[0] | (header[1] << 8));
+        int stepindx = clamp_ima_step_index(header[2]);
+
+        if (header[3] != 0)
+            errors++;
+
+        samples[chan] = predictor;
+
+        /* Each group holds 8 codes of this channel, two to a byte, low nibble first. */
+        for (int blockindx = 4 * channels + 4 * chan; blockindx < pima->blocksize; blockindx += 4 * channels)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                int bytecode = block[blockindx + k];
+
+                dest[0] = ima_decode_sample(bytecode & 0x0F, predictor, stepindx);
+                dest[channels] = ima_decode_sample((bytecode >> 4) & 0x0F, predictor, stepindx);
+                dest += 2 * channels;
+            };
+        };
+    };
+
+    return errors;
+}
+
 static int wavlike_ima_encode_block(SndFile *psf, IMA_ADPCM_PRIVATE *pima)
 {
     int chan, k, step, diff, vpdiff, blockindx, indx, indxstart;
@@ -605,6 +730,63 @@ static int wavlike_ima_encode_block(SndFile *psf, IMA_ADPCM_PRIVATE *pima)
     return 1;
 }
 
+static void ima_decode_batch(void *data, int first, int last)
+{
+    IMA_BATCH *batch = (IMA_BATCH *)data;
+    const IMA_ADPCM_PRIVATE *pima = batch->pima;
+    const size_t samples = (size_t)pima->samplesperblock * pima->channels;
+    int errors = 0;
+
+    for (int k = first; k < last; k++)
+        errors += pima->decode(pima, batch->data + (size_t)k * pima->batch_blocklen, batch->dest + k * samples);
+
+    batch->errors += errors;
+}
+
+/*
+** Reads as many of the following blocks as fit in len with a single read and
+** decodes them straight into ptr. Returns the number of blocks decoded, 0 when
+** the caller has to go block by block. Only blocks lying wholly inside the
+** data are batched, a short last block goes through decode_block() as before.
+*/
+static int ima_read_batch(SndFile *psf, IMA_ADPCM_PRIVATE *pima, short *ptr, size_t len)
+{
+    IMA_BATCH batch;
+    sf_count_t remaining, count, readlen;
+
+    if (pima->decode == NULL)
+        return 0;
+
+    remaining = (psf->m_datalength / pima->blocksize - pima->blockcount) / pima->batch_step;
+    count = (sf_count_t)(len / ((size_t)pima->samplesperblock * pima->channels));
+    count = std::min(std::min(count, remaining), (sf_count_t)(PSF_BATCH_LEN / pima->batch_blocklen));
+
+    if (count <= 0)
+        return 0;
+
+    readlen = count * pima->batch_blocklen;
+    if (!psf_read_batch(psf, &pima->batch, readlen))
+        return 0;
+
+    batch.pima = pima;
+    batch.data = pima->batch;
+    batch.dest = ptr;
+    batch.errors = 0;
+
+    psf_parallel_for(ima_decode_batch, &batch, (int)count, IMA_BATCH_GRAIN);
+
+    if (batch.errors > 0)
+        psf->log_printf("IMA ADPCM synchronisation error (%d blocks).\n", (int)batch.errors);
+
+    pima->blockcount += (int)count * pima->batch_step;
+    pima->samplecount = pima->samplesperblock;
+
+    /* decode_block() reads over the previous block, a short read leaves some of it in place. */
+    memcpy(pima->block, pima->batch + readlen - pima->batch_blocklen, pima->batch_blocklen);
+
+    return (int)count;
+}
+
 static size_t ima_read_block(SndFile *psf, IMA_ADPCM_PRIVATE *pima, short *ptr, size_t len)
 {
     size_t count, total = 0, indx = 0;
@@ -618,7 +800,16 @@ static size_t ima_read_block(SndFile *psf, IMA_ADPCM_PRIVATE *pima, short *ptr,
         };
 
         if (pima->samplecount >= pima->samplesperblock)
+        {
+            if ((count = ima_read_batch(psf, pima, ptr + indx, len - indx)) > 0)
+            {
+                indx += count * pima->samplesperblock * pima->channels;
+                total = indx;
+                continue;
+            };
+
             pima->decode_block(psf, pima);
+        };
 
         count = (pima->samplesperblock - pima->samplecount) * pima->channels;
         count = (len - indx > count) ? count : len - indx;
@@ -660,95 +851,17 @@ static size_t ima_read_s(SndFile *psf, short *ptr, size_t len)
 
 static size_t ima_read_i(SndFile *psf, int *ptr, size_t len)
 {
-    IMA_ADPCM_PRIVATE *pima;
-    BUF_UNION ubuf;
-    short *sptr;
-    size_t k, bufferlen, readcount, count;
-    size_t total = 0;
-
-    if (!psf->m_codec_data)
-        return 0;
-    pima = (IMA_ADPCM_PRIVATE *)psf->m_codec_data;
-
-    sptr = ubuf.sbuf;
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
-    while (len > 0)
-    {
-        readcount = (len >= bufferlen) ? bufferlen : len;
-        count = ima_read_block(psf, pima, sptr, readcount);
-        for (k = 0; k < readcount; k++)
-            ptr[total + k] = arith_shift_left(sptr[k], 16);
-        total += count;
-        len -= readcount;
-        if (count != readcount)
-            break;
-    };
-
-    return total;
+    return psf_read_widened(psf, ptr, len, ima_read_s);
 }
 
 static size_t ima_read_f(SndFile *psf, float *ptr, size_t len)
 {
-    IMA_ADPCM_PRIVATE *pima;
-    BUF_UNION ubuf;
-    short *sptr;
-    size_t k, bufferlen, readcount, count;
-    size_t total = 0;
-    float normfact;
-
-    if (!psf->m_codec_data)
-        return 0;
-    pima = (IMA_ADPCM_PRIVATE *)psf->m_codec_data;
-
-    normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x8000) : 1.0);
-
-    sptr = ubuf.sbuf;
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
-    while (len > 0)
-    {
-        readcount = (len >= bufferlen) ? bufferlen : len;
-        count = ima_read_block(psf, pima, sptr, readcount);
-        for (k = 0; k < readcount; k++)
-            ptr[total + k] = normfact * (float)(sptr[k]);
-        total += count;
-        len -= readcount;
-        if (count != readcount)
-            break;
-    };
-
-    return total;
+    return psf_read_widened(psf, ptr, len, ima_read_s);
 }
 
 static size_t ima_read_d(SndFile *psf, double *ptr, size_t len)
 {
-    IMA_ADPCM_PRIVATE *pima;
-    BUF_UNION ubuf;
-    short *sptr;
-    size_t k, bufferlen, readcount, count;
-    size_t total = 0;
-    double normfact;
-
-    if (!psf->m_codec_data)
-        return 0;
-    pima = (IMA_ADPCM_PRIVATE *)psf->m_codec_data;
-
-    normfact = (psf->m_norm_double == SF_TRUE) ? 1.0 / ((double)0x8000) : 1.0;
-
-    sptr = ubuf.sbuf;
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
-    while (len > 0)
-    {
-        readcount = (len >= bufferlen) ? bufferlen : len;
-        count = ima_read_block(psf, pima, sptr, readcount);
-        for (k = 0; k < readcount; k++)
-            ptr[total + k] = normfact * (double)(sptr[k]);
-        total += count;
-        len -= readcount;
-        if (count != readcount)
-            break;
-    };
-
-    return total;
+    return psf_read_widened(psf, ptr, len, ima_read_s);
 }
 
 static sf_count_t aiff_ima_seek(SndFile *psf, int mode, sf_count_t offset)
@@ -0,0 +1,38 @@
+/*
+** Copyright (C) 2026 agent <agent@local>
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation; either version 2.1 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+/*
+** MD5 message digest (RFC 1321), as needed for the audio signature in the
+** FLAC STREAMINFO block.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct SF_MD5
+{
+    uint32_t state[4];
+    uint64_t bytes;
+    unsigned char buffer[64];
+};
+
+void psf_md5_init(SF_MD5 *md5);
+void psf_md5_update(SF_MD5 *md5, const void *data, size_t len);
+void psf_md5_final(SF_MD5 *md5, unsigned char digest[16]);
@@ -29,6 +29,9 @@
 #include "shift.h"
 #include "wavlike.h"
 
+#include <algorithm>
+#include <atomic>
+
 typedef struct
 {
     int channels, blocksize, samplesperblock, blocks, dataremaining;
@@ -37,9 +40,22 @@ typedef struct
     sf_count_t samplecount;
     short *samples;
     unsigned char *block;
+    /* Whole blocks for msadpcm_read_batch(), allocated on first use. */
+    unsigned char *batch;
     short dummydata[];
 } MSADPCM_PRIVATE;
 
+/* Blocks per thread for batch reads, see psf_read_batch(). */
+#define MSADPCM_BATCH_GRAIN (32)
+
+typedef struct
+{
+    const MSADPCM_PRIVATE *pms;
+    short *dest;
+    /* The first out of range block predictor seen, 0 if none. */
+    std::atomic<int> bad_bpred;
+} MSADPCM_BATCH;
+
 static int AdaptationTable[] =
 {
     230, 230, 230, 230, 307, 409, 512, 614,
@@ -313,6 +329,128 @@ static int msadpcm_decode_block(SndFile *psf, MSADPCM_PRIVATE *pms)
     return 0;
 }
 
+/*
+** As msadpcm_decode_block(), for a block already in memory and with the codes
+** decoded as they are unpacked. Returns the first out of range block predictor,
+** decoded as 0, or 0 if there is none.
+*/
+static int msadpcm_decode(const MSADPCM_PRIVATE *pms, const unsigned char *block, short *samples)
+{
+    const int channels = pms->channels;
+    const int count = pms->samplesperblock * channels;
+    int bpred[2] = {0, 0}, coeff1[2], coeff2[2], bad = 0;
+    short chan_idelta[2];
+    int chan, k, blockindx;
+
+    for (chan = 0; chan < channels; chan++)
+    {
+        bpred[chan] = block[chan];
+        if (bpred[chan] >= WAVLIKE_MSADPCM_ADAPT_COEFF_COUNT)
+        {
+            if (bad == 0)
+                bad = bpred[chan];
+            bpred[chan] = 0;
+        };
+        coeff1[chan] = AdaptCoeff1[bpred[chan]];
+        coeff2[chan] = AdaptCoeff2[bpred[chan]];
+
+        chan_idelta[chan] = block[channels + 2 * chan] | (block[channels + 2 * chan + 1] << 8);
+
+        /* Sample 1 comes first in the header. */
+        samples[channels + chan] = block[3 * channels + 2 * chan] | (block[3 * channels + 2 * chan + 1] << 8);
+        samples[chan] = block[5 * channels + 2 * chan] | (block[5 * channels + 2 * chan + 1] << 8);
+    };
+
+    /* Codes alternate between the channels, high nibble first. */
+    blockindx = 7 * channels;
+    for (k = 2 * channels; k < count; k++)
+    {
+        int bytecode, idelta, predict, current;
+
+        chan = (channels > 1) ? (k % 2) : 0;
+
+        bytecode = (k & 1) ? (block[blockindx++] & 0x0F) : (block[blockindx] >> 4);
+
+        idelta = chan_idelta[chan];
+        chan_idelta[chan] = (AdaptationTable[bytecode] * idelta) >> 8;
+        if (chan_idelta[chan] < 16)
+            chan_idelta[chan] = 16;
+        if (bytecode & 0x8)
+            bytecode -= 0x10;
+
+        predict = (samples[k - channels] * coeff1[chan] + samples[k - 2 * channels] * coeff2[chan]) >> 8;
+        current = (bytecode * idelta) + predict;
+
+        if (current > 32767)
+            current = 32767;
+        else if (current < -32768)
+            current = -32768;
+
+        samples[k] = current;
+    };
+
+    return bad;
+}
+
+static void msadpcm_decode_batch(void *data, int first, int last)
+{
+    MSADPCM_BATCH *batch = (MSADPCM_BATCH *)data;
+    const MSADPCM_PRIVATE *pms = batch->pms;
+    const size_t samples = (size_t)pms->samplesperblock * pms->channels;
+    int expected = 0;
+
+    for (int k = first; k < last; k++)
+    {
+        int bad = msadpcm_decode(pms, pms->batch + (size_t)k * pms->blocksize, batch->dest + k * samples);
+
+        if (bad != 0)
+            batch->bad_bpred.compare_exchange_strong(expected, bad);
+    };
+}
+
+/*
+** Reads as many of the following blocks as fit in len with a single read and
+** decodes them straight into ptr. Returns the number of blocks decoded, 0 when
+** the caller has to go block by block. Only blocks lying wholly inside the
+** data are batched, a short last block goes through msadpcm_decode_block().
+*/
+static int msadpcm_read_batch(SndFile *psf, MSADPCM_PRIVATE *pms, short *ptr, size_t len)
+{
+    MSADPCM_BATCH batch;
+    sf_count_t remaining, count, readlen;
+
+    if (pms->channels > 2)
+        return 0;
+
+    remaining = psf->m_datalength / pms->blocksize - pms->blockcount;
+    count = (sf_count_t)(len / ((size_t)pms->samplesperblock * pms->channels));
+    count = std::min(std::min(count, remaining), (sf_count_t)(PSF_BATCH_LEN / pms->blocksize));
+
+    if (count <= 0)
+        return 0;
+
+    readlen = count * pms->blocksize;
+    if (!psf_read_batch(psf, &pms->batch, readlen))
+        return 0;
+
+    batch.pms = pms;
+    batch.dest = ptr;
+    batch.bad_bpred = 0;
+
+    psf_parallel_for(msadpcm_decode_batch, &batch, (int)count, MSADPCM_BATCH_GRAIN);
+
+    if (batch.bad_bpred != 0)
+        msadpcm_get_bpred(psf, pms, (unsigned char)batch.bad_bpred);
+
+    pms->blockcount += (int)count;
+    pms->samplecount = pms->samplesperblock;
+
+    /* msadpcm_decode_block() reads over the previous block, a short read leaves some of it in place. */
+    memcpy(pms->block, pms->batch + readlen - pms->blocksize, pms->blocksize);
+
+    return (int)count;
+}
+
 static int msadpcm_read_block(SndFile *psf, MSADPCM_PRIVATE *pms, short *ptr, size_t len)
 {
     size_t count, total = 0, indx = 0;
@@ -326,8 +464,17 @@ static int msadpcm_read_block(SndFile *psf, MSADPCM_PRIVATE *pms, short *ptr, si
         };
 
         if (pms->samplecount >= pms->samplesperblock)
+        {
+            if ((count = msadpcm_read_batch(psf, pms, ptr + indx, len - indx)) > 0)
+            {
+                indx += count * pms->samplesperblock * pms->channels;
+                total = indx;
+                continue;
+            };
+
             if (msadpcm_decode_block(psf, pms) != 0)
                 return total;
+        };
 
         count = (pms->samplesperblock - pms->samplecount) * pms->channels;
         count = (len - indx > count) ? count : len - indx;
@@ -370,100 +517,17 @@ static size_t msadpcm_read_s(SndFile *psf, short *ptr, size_t len)
 
 static size_t msadpcm_read_i(SndFile *psf, int *ptr, size_t len)
 {
-    MSADPCM_PRIVATE *pms;
-    BUF_UNION ubuf;
-    short *sptr;
-    size_t k, bufferlen, readcount = 0, count;
-    size_t total = 0;
-
-    if (!psf->m_codec_data)
-        return 0;
-    pms = (MSADPCM_PRIVATE *)psf->m_codec_data;
-
-    sptr = ubuf.sbuf;
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
-    while (len > 0)
-    {
-        readcount = (len >= bufferlen) ? bufferlen : len;
-
-        if ((count = msadpcm_read_block(psf, pms, sptr, readcount)) <= 0)
-            return -1;
-
-        for (k = 0; k < readcount; k++)
-            ptr[total + k] = arith_shift_left(sptr[k], 16);
-        total += count;
-        len -= readcount;
-        if (count != readcount)
-            break;
-    };
-    return total;
+    return psf_read_widened(psf, ptr, len, msadpcm_read_s);
 }
 
 static size_t msadpcm_read_f(SndFile *psf, float *ptr, size_t len)
 {
-    MSADPCM_PRIVATE *pms;
-    BUF_UNION ubuf;
-    short *sptr;
-    size_t k, bufferlen, readcount = 0, count;
-    size_t total = 0;
-    float normfact;
-
-    if (!psf->m_codec_data)
-        return 0;
-    pms = (MSADPCM_PRIVATE *)psf->m_codec_data;
-
-    normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x8000) : 1.0);
-    sptr = ubuf.sbuf;
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
-    while (len > 0)
-    {
-        readcount = (len >= bufferlen) ? bufferlen : len;
-
-        if ((count = msadpcm_read_block(psf, pms, sptr, readcount)) <= 0)
-            return -1;
-
-        for (k = 0; k < readcount; k++)
-            ptr[total + k] = normfact * (float)(sptr[k]);
-        total += count;
-        len -= readcount;
-        if (count != readcount)
-            break;
-    };
-    return total;
+    return psf_read_widened(psf, ptr, len, msadpcm_read_s);
 }
 
 static size_t msadpcm_read_d(SndFile *psf, double *ptr, size_t len)
 {
-    MSADPCM_PRIVATE *pms;
-    BUF_UNION ubuf;
-    short *sptr;
-    size_t k, bufferlen, readcount = 0, count;
-    size_t total = 0;
-    double normfact;
-
-    if (!psf->m_codec_data)
-        return 0;
-    pms = (MSADPCM_PRIVATE *)psf->m_codec_data;
-
-    normfact = (psf->m_norm_double == SF_TRUE) ? 1.0 / ((double)0x8000) : 1.0;
-    sptr = ubuf.sbuf;
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
-    while (len > 0)
-    {
-        readcount = (len >= bufferlen) ? bufferlen : len;
-
-        if ((count = msadpcm_read_block(psf, pms, sptr, readcount)) <= 0)
-            return -1;
-
-        for (k = 0; k < readcount; k++)
-            ptr[total + k] = normfact * (double)(sptr[k]);
-        total += count;
-        len -= readcount;
-        if (count != readcount)
-            break;
-    };
-
-    return total;
+    return psf_read_widened(psf, ptr, len, msadpcm_read_s);
 }
 
 static sf_count_t msadpcm_seek(SndFile *psf, int mode, sf_count_t offset)
@@ -809,6 +873,9 @@ static int msadpcm_close(SndFile *psf)
             msadpcm_encode_block(psf, pms);
     };
 
+    free(pms->batch);
+    pms->batch = NULL;
+
     return 0;
 }
 
@@ -117,6 +117,7 @@ static size_t nms_adpcm_write_d(SndFile *psf, const double *ptr, size_t len);
 
 static int nms_adpcm_close(SndFile *psf);
 static sf_count_t nms_adpcm_seek(SndFile *psf, int mode, sf_count_t offset);
+static bool nms_adpcm_check_checkpoint(SndFile *psf, sf_count_t frame, sf_count_t offset, const int32_t *state);
 
 /*
 ** An exponential function (antilog) approximation.
@@ -252,6 +253,53 @@ void nms_adpcm_codec_init(struct nms_adpcm_state *s, enum nms_enc_type type)
     s->t_off = (type == NMS32) ? 16 : (type == NMS24) ? 8 : 0;
 }
 
+/* Number of values nms_adpcm_save_state() stores, t_off is set by the type. */
+#define NMS_STATE_LEN (26)
+
+static void nms_adpcm_save_state(const struct nms_adpcm_state *s, int32_t *state)
+{
+    int i, k = 0;
+
+    state[k++] = s->yl;
+    state[k++] = s->y;
+    for (i = 0; i < 2; i++)
+        state[k++] = s->a[i];
+    for (i = 0; i < 6; i++)
+        state[k++] = s->b[i];
+    for (i = 0; i < 7; i++)
+        state[k++] = s->d_q[i];
+    for (i = 0; i < 3; i++)
+        state[k++] = s->p[i];
+    for (i = 0; i < 2; i++)
+        state[k++] = s->s_r[i];
+    state[k++] = s->s_ez;
+    state[k++] = s->s_e;
+    state[k++] = s->Ik;
+    state[k++] = s->parity;
+}
+
+static void nms_adpcm_restore_state(struct nms_adpcm_state *s, const int32_t *state)
+{
+    int i, k = 0;
+
+    s->yl = state[k++];
+    s->y = state[k++];
+    for (i = 0; i < 2; i++)
+        s->a[i] = state[k++];
+    for (i = 0; i < 6; i++)
+        s->b[i] = state[k++];
+    for (i = 0; i < 7; i++)
+        s->d_q[i] = state[k++];
+    for (i = 0; i < 3; i++)
+        s->p[i] = state[k++];
+    for (i = 0; i < 2; i++)
+        s->s_r[i] = state[k++];
+    s->s_ez = state[k++];
+    s->s_e = state[k++];
+    s->Ik = state[k++];
+    s->parity = state[k++];
+}
+
 /*
 ** nms_adpcm_encode_sample()
 **
@@ -667,8 +715,18 @@ static int nms_adpcm_encode_block(SndFile *psf, NMS_ADPCM_PRIVATE *pnms, int16_t
 
 static int psf_nms_adpcm_decode_block(SndFile *psf, NMS_ADPCM_PRIVATE *pnms)
 {
+    sf_count_t frame = (sf_count_t)pnms->block_curr * NMS_SAMPLES_PER_BLOCK;
+    int32_t state[NMS_STATE_LEN];
     int k;
 
+    if (frame >= psf_checkpoints_next(psf->m_checkpoints))
+    {
+        nms_adpcm_save_state(&pnms->state, state);
+        psf_checkpoints_add(psf->m_checkpoints, frame,
+                            psf->m_dataoffset + (sf_count_t)pnms->block_curr * pnms->shortsperblock * sizeof(short),
+                            state);
+    };
+
     if ((k = psf->fread(pnms->block, sizeof(short), pnms->shortsperblock)) != pnms->shortsperblock)
     {
         psf->log_printf("*** Warning : short read (%d != %d).\n", k, pnms->shortsperblock);
@@ -1014,7 +1072,8 @@ int nms_adpcm_init(SndFile *psf)
         return SFE_INTERNAL;
     };
 
-    psf->sf.seekable = SF_FALSE;
+    if (psf->m_mode != SFM_READ)
+        psf->sf.seekable = SF_FALSE;
 
     if (psf->sf.channels != 1)
         return SFE_NMS_ADPCM_NOT_MONO;
@@ -1061,6 +1120,10 @@ int nms_adpcm_init(SndFile *psf)
         psf->read_int = nms_adpcm_read_i;
         psf->read_float = nms_adpcm_read_f;
         psf->read_double = nms_adpcm_read_d;
+
+        psf->m_checkpoints = psf_checkpoints_new(NMS_STATE_LEN, nms_adpcm_check_checkpoint);
+        if (psf->m_checkpoints == NULL)
+            return SFE_MALLOC_FAILED;
     }
     else if (psf->m_mode == SFM_WRITE)
     {
@@ -1112,6 +1175,35 @@ static int nms_adpcm_close(SndFile *psf)
     return 0;
 }
 
+static sf_count_t nms_adpcm_seek_read(SndFile *psf, NMS_ADPCM_PRIVATE *pnms, sf_count_t offset)
+{
+    int32_t state[NMS_STATE_LEN];
+    sf_count_t newblock, cp_frame, cp_offset;
+
+    if (!psf_checkpoints_find(psf->m_checkpoints, offset, &cp_frame, &cp_offset, state))
+    {
+        psf->m_error = SFE_BAD_SEEK;
+        return PSF_SEEK_ERROR;
+    };
+
+    if (psf->fseek(cp_offset, SEEK_SET) == PSF_SEEK_ERROR)
+        return PSF_SEEK_ERROR;
+
+    nms_adpcm_restore_state(&pnms->state, state);
+    pnms->block_curr = (int)(cp_frame / NMS_SAMPLES_PER_BLOCK);
+
+    newblock = offset / NMS_SAMPLES_PER_BLOCK;
+    for (; pnms->block_curr < newblock; pnms->block_curr++)
+        psf_nms_adpcm_decode_block(psf, pnms);
+
+    /* A block is decoded when its first sample is read. */
+    pnms->sample_curr = (int)(offset - newblock * NMS_SAMPLES_PER_BLOCK);
+    if (pnms->sample_curr > 0)
+        psf_nms_adpcm_decode_block(psf, pnms);
+
+    return offset;
+}
+
 static sf_count_t nms_adpcm_seek(SndFile *psf, int mode, sf_count_t offset)
 {
     NMS_ADPCM_PRIVATE *pnms;
@@ -1129,9 +1221,12 @@ static sf_count_t nms_adpcm_seek(SndFile *psf, int mode, sf_count_t offset)
     };
 
     /*
-    ** NMS ADPCM cannot be seek'ed, as codec state depends on previous samples,
-    ** so only a seek to 0 is supported.
+    ** Codec state depends on previous samples. Reads go back to the last
+    ** checkpoint and decode forward, writes only seek to 0.
     */
+    if (mode == SFM_READ)
+        return nms_adpcm_seek_read(psf, pnms, offset);
+
     if (offset != 0)
     {
         psf->m_error = SFE_BAD_SEEK;
@@ -1146,3 +1241,13 @@ static sf_count_t nms_adpcm_seek(SndFile *psf, int mode, sf_count_t offset)
     pnms->sample_curr = 0;
     return 0;
 }
+
+static bool nms_adpcm_check_checkpoint(SndFile *psf, sf_count_t frame, sf_count_t offset, const int32_t *state)
+{
+    NMS_ADPCM_PRIVATE *pnms = (NMS_ADPCM_PRIVATE *)psf->m_codec_data;
+
+    return frame % NMS_SAMPLES_PER_BLOCK == 0 &&
+           offset == psf->m_dataoffset +
+                         (frame / NMS_SAMPLES_PER_BLOCK) * pnms->shortsperblock * (sf_count_t)sizeof(short) &&
+           state[0] >= 0 && state[0] <= 20480;
+}
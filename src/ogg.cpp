@@ -127,6 +127,225 @@ int ogg_read_first_page(SndFile *psf, OGG_PRIVATE *odata)
     return 0;
 }
 
+/* Bytes read at a time while scanning for pages. */
+#define OGG_SCAN_CHUNK (4096)
+
+void ogg_scan_start(SndFile *psf, ogg_sync_state *osync, sf_count_t offset, sf_count_t *position)
+{
+    ogg_sync_reset(osync);
+    psf->fseek(offset, SEEK_SET);
+    *position = offset;
+}
+
+int ogg_scan_next_page(SndFile *psf, ogg_sync_state *osync, long serialno, sf_count_t end, ogg_page *page,
+                       sf_count_t *start, sf_count_t *position)
+{
+    while (*position < end)
+    {
+        long result = ogg_sync_pageseek(osync, page);
+
+        if (result < 0)
+        {
+            /* Skipped some bytes looking for the capture pattern. */
+            *position -= result;
+            continue;
+        };
+
+        if (result > 0)
+        {
+            *start = *position;
+            *position += result;
+            if (ogg_page_serialno(page) == serialno)
+                return 1;
+            continue;
+        };
+
+        char *buffer = ogg_sync_buffer(osync, OGG_SCAN_CHUNK);
+        size_t bytes = psf->fread(buffer, 1, OGG_SCAN_CHUNK);
+        if (bytes == 0)
+            break;
+        ogg_sync_wrote(osync, (long)bytes);
+    };
+
+    return 0;
+}
+
+/* Leading bytes of an exported page index, the last one is the version. */
+static const unsigned char ogg_index_magic[] = {'O', 'g', 'I', 'x', 1};
+
+int ogg_index_build(SndFile *psf, OGG_PRIVATE *odata)
+{
+    ogg_sync_state osync;
+    ogg_page page;
+    OGG_INDEX_ENTRY *index = NULL;
+    size_t len = 0, alloc = 0;
+    sf_count_t start, position, gp, last = 0;
+    sf_count_t saved = psf->ftell();
+    sf_count_t filelen = psf->get_filelen();
+
+    ogg_sync_init(&osync);
+
+    ogg_scan_start(psf, &osync, 0, &position);
+    while (ogg_scan_next_page(psf, &osync, odata->ostream.serialno, filelen, &page, &start, &position))
+    {
+        gp = ogg_page_granulepos(&page);
+        /* Pages which end no packet carry -1, keep the index strictly ordered. */
+        if (gp <= last)
+            continue;
+
+        if (len == alloc)
+        {
+            alloc = alloc ? 2 * alloc : 256;
+            OGG_INDEX_ENTRY *temp = (OGG_INDEX_ENTRY *)realloc(index, alloc * sizeof(OGG_INDEX_ENTRY));
+            if (temp == NULL)
+            {
+                free(index);
+                ogg_sync_clear(&osync);
+                psf->fseek(saved, SEEK_SET);
+                return SFE_MALLOC_FAILED;
+            };
+            index = temp;
+        };
+
+        index[len].granulepos = gp;
+        index[len].offset = position;
+        len++;
+        last = gp;
+    };
+
+    ogg_sync_clear(&osync);
+
+    /* The decoder carries on from where it was. */
+    psf->fseek(saved, SEEK_SET);
+
+    free(odata->index);
+    odata->index = index;
+    odata->index_len = len;
+
+    psf->log_printf("Ogg page index : %d entries\n", (int)len);
+
+    return 0;
+}
+
+/*
+** The blob is the magic followed by LEB128 varints: the serial number, the
+** file length, the entry count and then for each entry the increase of the
+** granule position and of the page end offset over the previous entry.
+** Nothing is written unless the whole blob fits, the return value is its
+** size either way.
+*/
+size_t ogg_index_export(SndFile *psf, const OGG_PRIVATE *odata, void *data, size_t datasize)
+{
+    if (odata->index == NULL)
+        return 0;
+
+    size_t size = psf_varint_put(NULL, sizeof(ogg_index_magic), 0, (uint32_t)odata->ostream.serialno);
+    size = psf_varint_put(NULL, size, 0, psf->get_filelen());
+    size = psf_varint_put(NULL, size, 0, odata->index_len);
+
+    sf_count_t gp = 0, offset = 0;
+    for (size_t k = 0; k < odata->index_len; k++)
+    {
+        size = psf_varint_put(NULL, size, 0, odata->index[k].granulepos - gp);
+        size = psf_varint_put(NULL, size, 0, odata->index[k].offset - offset);
+        gp = odata->index[k].granulepos;
+        offset = odata->index[k].offset;
+    };
+
+    if (data == NULL || datasize < size)
+        return size;
+
+    unsigned char *bytes = (unsigned char *)data;
+    memcpy(bytes, ogg_index_magic, sizeof(ogg_index_magic));
+
+    size_t pos = psf_varint_put(bytes, sizeof(ogg_index_magic), size, (uint32_t)odata->ostream.serialno);
+    pos = psf_varint_put(bytes, pos, size, psf->get_filelen());
+    pos = psf_varint_put(bytes, pos, size, odata->index_len);
+
+    gp = offset = 0;
+    for (size_t k = 0; k < odata->index_len; k++)
+    {
+        pos = psf_varint_put(bytes, pos, size, odata->index[k].granulepos - gp);
+        pos = psf_varint_put(bytes, pos, size, odata->index[k].offset - offset);
+        gp = odata->index[k].granulepos;
+        offset = odata->index[k].offset;
+    };
+
+    return size;
+}
+
+/*
+** Only blobs exported for a file with the same serial number and length are
+** accepted. A stale index beyond that still only costs speed, the decoder
+** takes its position from the pages it lands on.
+*/
+int ogg_index_import(SndFile *psf, OGG_PRIVATE *odata, const void *data, size_t datasize)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    uint64_t serialno, filelen, count, gp_delta, offset_delta;
+    size_t pos = sizeof(ogg_index_magic);
+
+    if (data == NULL || datasize < sizeof(ogg_index_magic) ||
+        memcmp(bytes, ogg_index_magic, sizeof(ogg_index_magic)) != 0)
+        return SFE_BAD_COMMAND_PARAM;
+
+    if (!psf_varint_get(bytes, &pos, datasize, &serialno) || !psf_varint_get(bytes, &pos, datasize, &filelen) ||
+        !psf_varint_get(bytes, &pos, datasize, &count))
+        return SFE_BAD_COMMAND_PARAM;
+
+    if (serialno != (uint32_t)odata->ostream.serialno || filelen != (uint64_t)psf->get_filelen())
+        return SFE_BAD_COMMAND_PARAM;
+
+    /* Each entry takes at least two bytes. */
+    if (count > (datasize - pos) / 2)
+        return SFE_BAD_COMMAND_PARAM;
+
+    OGG_INDEX_ENTRY *index = (OGG_INDEX_ENTRY *)malloc((count ? count : 1) * sizeof(OGG_INDEX_ENTRY));
+    if (index == NULL)
+        return SFE_MALLOC_FAILED;
+
+    uint64_t gp = 0, offset = 0;
+    for (size_t k = 0; k < count; k++)
+    {
+        if (!psf_varint_get(bytes, &pos, datasize, &gp_delta) ||
+            !psf_varint_get(bytes, &pos, datasize, &offset_delta) || gp_delta == 0 || offset_delta == 0 ||
+            gp_delta > (uint64_t)SF_COUNT_MAX - gp || offset_delta > filelen - offset)
+        {
+            free(index);
+            return SFE_BAD_COMMAND_PARAM;
+        };
+
+        gp += gp_delta;
+        offset += offset_delta;
+        index[k].granulepos = (sf_count_t)gp;
+        index[k].offset = (sf_count_t)offset;
+    };
+
+    free(odata->index);
+    odata->index = index;
+    odata->index_len = count;
+
+    return 0;
+}
+
+sf_count_t ogg_index_find(const OGG_PRIVATE *odata, sf_count_t goal)
+{
+    size_t lo = 0, hi = odata->index_len;
+
+    /* Find the first entry past goal. */
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (odata->index[mid].granulepos <= goal)
+            lo = mid + 1;
+        else
+            hi = mid;
+    };
+
+    return lo > 0 ? odata->index[lo - 1].offset : -1;
+}
+
 int ogg_open(SndFile *psf)
 {
     OGG_PRIVATE *odata = (OGG_PRIVATE *)calloc(1, sizeof(OGG_PRIVATE));
@@ -184,6 +403,8 @@ static int ogg_close(SndFile *psf)
 
     ogg_sync_clear(&odata->osync);
     ogg_stream_clear(&odata->ostream);
+    free(odata->index);
+    odata->index = NULL;
 
     return 0;
 }
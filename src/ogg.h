@@ -33,6 +33,14 @@ enum
     OGG_VORBIS,
 };
 
+/* A page of the indexed logical stream, see ogg_index_build(). */
+typedef struct
+{
+    sf_count_t granulepos;
+    /* Offset of the byte following the page. */
+    sf_count_t offset;
+} OGG_INDEX_ENTRY;
+
 typedef struct
 {
     /* Sync and verify incoming physical bitstream */
@@ -45,6 +53,10 @@ typedef struct
     ogg_packet opacket;
     int eos;
     int codec;
+
+    /* Optional page index, ordered by granule position. */
+    OGG_INDEX_ENTRY *index;
+    size_t index_len;
 } OGG_PRIVATE;
 
 #define readint(buf, base)                                                       \
@@ -52,3 +64,27 @@ typedef struct
      ((buf[base + 1] << 8) & 0xff00) | (buf[base] & 0xff))
 
 int ogg_read_first_page(SndFile *, OGG_PRIVATE *);
+
+/*
+** Page by page scanning of the physical bitstream, independent of the decoder
+** state. ogg_scan_start() positions the scan at a byte offset and
+** ogg_scan_next_page() returns the next page of the stream with the given
+** serial number, its byte offset in *start and the offset of the byte after
+** it in *position. It returns 0 when there are no more pages before end.
+*/
+void ogg_scan_start(SndFile *psf, ogg_sync_state *osync, sf_count_t offset, sf_count_t *position);
+int ogg_scan_next_page(SndFile *psf, ogg_sync_state *osync, long serialno, sf_count_t end, ogg_page *page,
+                       sf_count_t *start, sf_count_t *position);
+
+/*
+** Optional index of the pages of the current logical stream which carry a
+** granule position above zero. ogg_index_build() scans the whole file for it,
+** ogg_index_export() and ogg_index_import() convert it to and from a compact
+** byte blob which can be stored next to the file and loaded on a later open.
+** ogg_index_find() returns the offset of the byte following the last page
+** with a granule position no greater than goal, or -1.
+*/
+int ogg_index_build(SndFile *psf, OGG_PRIVATE *odata);
+size_t ogg_index_export(SndFile *psf, const OGG_PRIVATE *odata, void *data, size_t datasize);
+int ogg_index_import(SndFile *psf, OGG_PRIVATE *odata, const void *data, size_t datasize);
+sf_count_t ogg_index_find(const OGG_PRIVATE *odata, sf_count_t goal);
@@ -557,6 +557,7 @@ int ogg_vorbis_open(SndFile *psf)
 
 static size_t vorbis_command(SndFile *psf, int command, void *data, size_t datasize)
 {
+    OGG_PRIVATE *odata = (OGG_PRIVATE *)psf->m_container_data;
     VORBIS_PRIVATE *vdata = (VORBIS_PRIVATE *)psf->m_codec_data;
 
     switch (command)
@@ -577,6 +578,24 @@ static size_t vorbis_command(SndFile *psf, int command, void *data, size_t datas
                        vdata->quality);
         return SF_TRUE;
 
+    case SFC_OGG_BUILD_PAGE_INDEX:
+        if (psf->m_mode != SFM_READ || !psf->sf.seekable)
+            return SF_FALSE;
+
+        return ogg_index_build(psf, odata) == 0 ? SF_TRUE : SF_FALSE;
+
+    case SFC_OGG_GET_PAGE_INDEX:
+        if (psf->m_mode != SFM_READ)
+            return 0;
+
+        return ogg_index_export(psf, odata, data, datasize);
+
+    case SFC_OGG_SET_PAGE_INDEX:
+        if (psf->m_mode != SFM_READ)
+            return SF_FALSE;
+
+        return ogg_index_import(psf, odata, data, datasize) == 0 ? SF_TRUE : SF_FALSE;
+
     default:
         return SF_FALSE;
     };
@@ -878,6 +897,129 @@ static size_t vorbis_write_d(SndFile *psf, const double *ptr, size_t lens)
     return lens;
 }
 
+/*
+** Seeking further than this decodes forward instead of searching for the
+** page to start from.
+*/
+#define VORBIS_SEEK_DECODE_FRAMES (1 << 14)
+
+/* Once the range to search is this small, it is scanned page by page. */
+#define VORBIS_SEEK_SCAN_BYTES (1 << 16)
+
+/*
+** Finds the last page whose granule position is above zero and no greater than
+** goal by bisecting the file on page granule positions. Returns the offset of
+** the byte following that page, or -1 if there is no such page.
+*/
+static sf_count_t vorbis_seek_search(SndFile *psf, OGG_PRIVATE *odata, sf_count_t goal)
+{
+    ogg_sync_state osync;
+    ogg_page page;
+    sf_count_t lo = 0, hi = psf->get_filelen(), best = -1;
+    sf_count_t start, position, gp;
+    long serialno = odata->ostream.serialno;
+
+    ogg_sync_init(&osync);
+
+    while (hi - lo > VORBIS_SEEK_SCAN_BYTES)
+    {
+        sf_count_t mid = lo + (hi - lo) / 2;
+
+        /* Find the first page from mid on which ends a packet. */
+        gp = -1;
+        ogg_scan_start(psf, &osync, mid, &position);
+        while (ogg_scan_next_page(psf, &osync, serialno, hi, &page, &start, &position))
+        {
+            if ((gp = ogg_page_granulepos(&page)) != -1)
+                break;
+        };
+
+        if (gp == -1 || gp > goal)
+        {
+            hi = mid;
+            continue;
+        };
+
+        lo = position;
+        if (gp > 0)
+            best = position;
+    };
+
+    /* Granule positions only go up, so stop at the first page past the goal. */
+    ogg_scan_start(psf, &osync, lo, &position);
+    while (ogg_scan_next_page(psf, &osync, serialno, psf->get_filelen(), &page, &start, &position))
+    {
+        gp = ogg_page_granulepos(&page);
+        if (gp == -1)
+            continue;
+        if (gp > goal)
+            break;
+        if (gp > 0)
+            best = position;
+    };
+
+    ogg_sync_clear(&osync);
+
+    return best;
+}
+
+/*
+** Restarts decoding at the page starting at offset. The position of the
+** decoded data is unknown until a packet which ends a page has been decoded,
+** its granule position less the samples still pending is the position of
+** the first pending sample. Anything decoded before that is dropped.
+*/
+static int vorbis_seek_sync(SndFile *psf, OGG_PRIVATE *odata, VORBIS_PRIVATE *vdata, sf_count_t offset)
+{
+    ogg_sync_reset(&odata->osync);
+    ogg_stream_reset(&odata->ostream);
+    vorbis_synthesis_restart(&vdata->vdsp);
+    odata->eos = 0;
+
+    if (psf->fseek(offset, SEEK_SET) != offset)
+        return SFE_BAD_SEEK;
+
+    while (1)
+    {
+        int result = ogg_stream_packetout(&odata->ostream, &odata->opacket);
+
+        if (result == 0)
+        {
+            result = ogg_sync_pageout(&odata->osync, &odata->opage);
+            if (result > 0)
+            {
+                /* Pages from other logical streams are rejected here. */
+                ogg_stream_pagein(&odata->ostream, &odata->opage);
+                continue;
+            };
+            if (result < 0)
+                continue;
+
+            char *buffer = ogg_sync_buffer(&odata->osync, 4096);
+            int bytes = psf->fread(buffer, 1, 4096);
+            if (bytes <= 0)
+                return SFE_BAD_SEEK;
+            ogg_sync_wrote(&odata->osync, bytes);
+            continue;
+        };
+
+        /* A hole in the data, the next packet is fine. */
+        if (result < 0)
+            continue;
+
+        vorbis_synthesis_read(&vdata->vdsp, vorbis_synthesis_pcmout(&vdata->vdsp, NULL));
+
+        if (vorbis_synthesis(&vdata->vblock, &odata->opacket) == 0)
+            vorbis_synthesis_blockin(&vdata->vdsp, &vdata->vblock);
+
+        if (odata->opacket.granulepos != -1)
+        {
+            vdata->loc = odata->opacket.granulepos - vorbis_synthesis_pcmout(&vdata->vdsp, NULL);
+            return 0;
+        };
+    };
+}
+
 static sf_count_t vorbis_seek(SndFile *psf, int UNUSED(mode), sf_count_t offset)
 {
     OGG_PRIVATE *odata = (OGG_PRIVATE *)psf->m_container_data;
@@ -896,6 +1038,25 @@ static sf_count_t vorbis_seek(SndFile *psf, int UNUSED(mode), sf_count_t offset)
     {
         sf_count_t target = offset - vdata->loc;
 
+        if (psf->sf.seekable && (target < 0 || target > VORBIS_SEEK_DECODE_FRAMES))
+        {
+            /*
+            ** The first packet decoded after a restart only primes the
+            ** decoder, so start at least a long block before the target.
+            */
+            sf_count_t goal = offset - vorbis_info_blocksize(&vdata->vinfo, 1);
+            sf_count_t page_end = -1;
+
+            if (goal > 0)
+                page_end = odata->index ? ogg_index_find(odata, goal) : vorbis_seek_search(psf, odata, goal);
+
+            if (page_end >= 0 && vorbis_seek_sync(psf, odata, vdata, page_end) == 0 && vdata->loc <= offset)
+                target = offset - vdata->loc;
+            else if (goal > 0)
+                /* The search has moved the file position, start again from the top. */
+                target = -1;
+        };
+
         if (target < 0)
         {
             ogg_read_first_page(psf, odata);
@@ -1182,14 +1343,65 @@ static sf_count_t vorbis_length_aux(SndFile *psf)
     return len;
 }
 
+/* Bytes at the end of the file searched for the last page, doubled up to the limit. */
+#define VORBIS_LENGTH_SCAN_BYTES (1 << 16)
+#define VORBIS_LENGTH_SCAN_LIMIT (1 << 22)
+
+/*
+** The length is the granule position of the last page. If that page is not
+** the last thing in the file there is more than one logical stream (or
+** garbage) and -1 is returned, leaving it to the full scan.
+*/
+static sf_count_t vorbis_length_from_end(SndFile *psf, OGG_PRIVATE *odata)
+{
+    ogg_sync_state osync;
+    ogg_page page;
+    sf_count_t filelen = psf->get_filelen(), chunk, start, position, length = -1;
+    long serialno = odata->ostream.serialno;
+
+    ogg_sync_init(&osync);
+
+    for (chunk = VORBIS_LENGTH_SCAN_BYTES; chunk <= VORBIS_LENGTH_SCAN_LIMIT; chunk *= 2)
+    {
+        sf_count_t begin = filelen > chunk ? filelen - chunk : 0, last_end = -1;
+
+        ogg_scan_start(psf, &osync, begin, &position);
+        while (ogg_scan_next_page(psf, &osync, serialno, filelen, &page, &start, &position))
+        {
+            if (ogg_page_granulepos(&page) == -1)
+                continue;
+            length = ogg_page_granulepos(&page);
+            last_end = position;
+        };
+
+        if (last_end >= 0 || begin == 0)
+        {
+            if (last_end != filelen)
+                length = -1;
+            break;
+        };
+    };
+
+    ogg_sync_clear(&osync);
+
+    return length;
+}
+
 static sf_count_t vorbis_length(SndFile *psf)
 {
-    sf_count_t length;
+    sf_count_t length, position;
     int error;
 
     if (psf->sf.seekable == 0)
         return SF_COUNT_MAX;
 
+    /* The decoder has its own sync state, just put the file position back. */
+    position = psf->ftell();
+    length = vorbis_length_from_end(psf, (OGG_PRIVATE *)psf->m_container_data);
+    psf->fseek(position, SEEK_SET);
+    if (length >= 0)
+        return length;
+
     psf->fseek(0, SEEK_SET);
     length = vorbis_length_aux(psf);
 
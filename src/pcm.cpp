@@ -24,6 +24,7 @@
 #include "sfendian.h"
 #include "common.h"
 #include "shift.h"
+#include "simd.h"
 
 /*
  * Need to be able to handle 3 byte (24 bit) integers. So defined a
@@ -395,6 +396,8 @@ static inline void bet2i_array(tribyte *src, size_t count, int *dest)
 {
     unsigned char *ucptr;
 
+    count = psf_simd_kernels()->bet2i((unsigned char *)src, count, dest);
+
     ucptr = ((unsigned char *)src) + 3 * count;
     while (count)
     {
@@ -408,6 +411,8 @@ static inline void let2i_array(tribyte *src, size_t count, int *dest)
 {
     unsigned char *ucptr;
 
+    count = psf_simd_kernels()->let2i((unsigned char *)src, count, dest);
+
     ucptr = ((unsigned char *)src) + 3 * count;
     while (count)
     {
@@ -439,6 +444,8 @@ static inline void les2f_array(short *src, size_t count, float *dest, float norm
 {
     short value;
 
+    count = psf_simd_kernels()->les2f(src, count, dest, normfact);
+
     while (count)
     {
         count--;
@@ -452,6 +459,8 @@ static inline void bes2f_array(short *src, size_t count, float *dest, float norm
 {
     short value;
 
+    count = psf_simd_kernels()->bes2f(src, count, dest, normfact);
+
     while (count)
     {
         count--;
@@ -466,6 +475,8 @@ static inline void let2f_array(tribyte *src, size_t count, float *dest, float no
     unsigned char *ucptr;
     int value;
 
+    count = psf_simd_kernels()->let2f((unsigned char *)src, count, dest, normfact);
+
     ucptr = ((unsigned char *)src) + 3 * count;
     while (count)
     {
@@ -481,6 +492,8 @@ static inline void bet2f_array(tribyte *src, size_t count, float *dest, float no
     unsigned char *ucptr;
     int value;
 
+    count = psf_simd_kernels()->bet2f((unsigned char *)src, count, dest, normfact);
+
     ucptr = ((unsigned char *)src) + 3 * count;
     while (count)
     {
@@ -495,6 +508,8 @@ static inline void lei2f_array(int *src, size_t count, float *dest, float normfa
 {
     int value;
 
+    count = psf_simd_kernels()->lei2f(src, count, dest, normfact);
+
     while (count)
     {
         count--;
@@ -508,6 +523,8 @@ static inline void bei2f_array(int *src, size_t count, float *dest, float normfa
 {
     int value;
 
+    count = psf_simd_kernels()->bei2f(src, count, dest, normfact);
+
     while (count)
     {
         count--;
@@ -777,50 +794,32 @@ static inline void i2bet_array(const int *src, tribyte *dest, size_t count)
     };
 }
 
+/*
+** When the output type is at least as wide as the file's sample type the raw
+** data is read straight into the start of the caller's buffer and converted
+** in place. The *_array() functions above work from the end of the array to
+** the start, so no sample is overwritten before it has been converted. Only
+** the narrowing readers still go through the I/O buffer.
+*/
+
 static size_t pcm_read_sc2s(SndFile *psf, short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
-
-    bufferlen = ARRAY_LEN(ubuf.scbuf);
+    size_t readcount;
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.scbuf, sizeof(signed char), bufferlen);
-        sc2s_array(ubuf.scbuf, readcount, ptr + total);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
+    readcount = psf->fread(ptr, sizeof(signed char), len);
+    sc2s_array((signed char *)ptr, readcount, ptr);
 
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_uc2s(SndFile *psf, short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    readcount = psf->fread(ptr, sizeof(unsigned char), len);
+    uc2s_array((unsigned char *)ptr, readcount, ptr);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.ucbuf, sizeof(unsigned char), bufferlen);
-        uc2s_array(ubuf.ucbuf, readcount, ptr + total);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_bes2s(SndFile *psf, short *ptr, size_t len)
@@ -847,11 +846,11 @@ static size_t pcm_read_les2s(SndFile *psf, short *ptr, size_t len)
 
 static size_t pcm_read_bet2s(SndFile *psf, short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
 
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    bufferlen = psf->get_io_buffer(&ubuf) / SIZEOF_TRIBYTE;
 
     while (len > 0)
     {
@@ -870,11 +869,11 @@ static size_t pcm_read_bet2s(SndFile *psf, short *ptr, size_t len)
 
 static size_t pcm_read_let2s(SndFile *psf, short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
 
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    bufferlen = psf->get_io_buffer(&ubuf) / SIZEOF_TRIBYTE;
 
     while (len > 0)
     {
@@ -893,11 +892,11 @@ static size_t pcm_read_let2s(SndFile *psf, short *ptr, size_t len)
 
 static size_t pcm_read_bei2s(SndFile *psf, short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.ibuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(int);
 
     while (len > 0)
     {
@@ -916,11 +915,11 @@ static size_t pcm_read_bei2s(SndFile *psf, short *ptr, size_t len)
 
 static size_t pcm_read_lei2s(SndFile *psf, short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.ibuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(int);
 
     while (len > 0)
     {
@@ -939,140 +938,62 @@ static size_t pcm_read_lei2s(SndFile *psf, short *ptr, size_t len)
 
 static size_t pcm_read_sc2i(SndFile *psf, int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
-
-    bufferlen = ARRAY_LEN(ubuf.scbuf);
+    size_t readcount;
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.scbuf, sizeof(signed char), bufferlen);
-        sc2i_array(ubuf.scbuf, readcount, ptr + total);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
+    readcount = psf->fread(ptr, sizeof(signed char), len);
+    sc2i_array((signed char *)ptr, readcount, ptr);
 
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_uc2i(SndFile *psf, int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    readcount = psf->fread(ptr, sizeof(unsigned char), len);
+    uc2i_array((unsigned char *)ptr, readcount, ptr);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.ucbuf, sizeof(unsigned char), bufferlen);
-        uc2i_array(ubuf.ucbuf, readcount, ptr + total);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_bes2i(SndFile *psf, int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
 
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
+    readcount = psf->fread(ptr, sizeof(short), len);
+    bes2i_array((short *)ptr, readcount, ptr);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.sbuf, sizeof(short), bufferlen);
-        bes2i_array(ubuf.sbuf, readcount, ptr + total);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_les2i(SndFile *psf, int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
 
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
+    readcount = psf->fread(ptr, sizeof(short), len);
+    les2i_array((short *)ptr, readcount, ptr);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.sbuf, sizeof(short), bufferlen);
-        les2i_array(ubuf.sbuf, readcount, ptr + total);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_bet2i(SndFile *psf, int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
 
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    readcount = psf->fread(ptr, SIZEOF_TRIBYTE, len);
+    bet2i_array((tribyte *)ptr, readcount, ptr);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.ucbuf, SIZEOF_TRIBYTE, bufferlen);
-        bet2i_array((tribyte *)(ubuf.ucbuf), readcount, ptr + total);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_let2i(SndFile *psf, int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
 
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    readcount = psf->fread(ptr, SIZEOF_TRIBYTE, len);
+    let2i_array((tribyte *)ptr, readcount, ptr);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.ucbuf, SIZEOF_TRIBYTE, bufferlen);
-        let2i_array((tribyte *)(ubuf.ucbuf), readcount, ptr + total);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_bei2i(SndFile *psf, int *ptr, size_t len)
@@ -1099,430 +1020,222 @@ static size_t pcm_read_lei2i(SndFile *psf, int *ptr, size_t len)
 
 static size_t pcm_read_sc2f(SndFile *psf, float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     float normfact;
 
     normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x80) : 1.0);
 
-    bufferlen = ARRAY_LEN(ubuf.scbuf);
+    readcount = psf->fread(ptr, sizeof(signed char), len);
+    sc2f_array((signed char *)ptr, readcount, ptr, normfact);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.scbuf, sizeof(signed char), bufferlen);
-        sc2f_array(ubuf.scbuf, readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_uc2f(SndFile *psf, float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     float normfact;
 
     normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x80) : 1.0);
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    readcount = psf->fread(ptr, sizeof(unsigned char), len);
+    uc2f_array((unsigned char *)ptr, readcount, ptr, normfact);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.ucbuf, sizeof(unsigned char), bufferlen);
-        uc2f_array(ubuf.ucbuf, readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_bes2f(SndFile *psf, float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     float normfact;
 
     normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x8000) : 1.0);
 
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
+    readcount = psf->fread(ptr, sizeof(short), len);
+    bes2f_array((short *)ptr, readcount, ptr, normfact);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.sbuf, sizeof(short), bufferlen);
-        bes2f_array(ubuf.sbuf, readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_les2f(SndFile *psf, float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     float normfact;
 
     normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x8000) : 1.0);
 
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
+    readcount = psf->fread(ptr, sizeof(short), len);
+    les2f_array((short *)ptr, readcount, ptr, normfact);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.sbuf, sizeof(short), bufferlen);
-        les2f_array(ubuf.sbuf, readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_bet2f(SndFile *psf, float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     float normfact;
 
     /* Special normfactor because tribyte value is read into an int. */
     normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x80000000) : 1.0 / 256.0);
 
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    readcount = psf->fread(ptr, SIZEOF_TRIBYTE, len);
+    bet2f_array((tribyte *)ptr, readcount, ptr, normfact);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.ucbuf, SIZEOF_TRIBYTE, bufferlen);
-        bet2f_array((tribyte *)(ubuf.ucbuf), readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_let2f(SndFile *psf, float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     float normfact;
 
     /* Special normfactor because tribyte value is read into an int. */
     normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x80000000) : 1.0 / 256.0);
 
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
-
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.ucbuf, SIZEOF_TRIBYTE, bufferlen);
-        let2f_array((tribyte *)(ubuf.ucbuf), readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
+    readcount = psf->fread(ptr, SIZEOF_TRIBYTE, len);
+    let2f_array((tribyte *)ptr, readcount, ptr, normfact);
 
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_bei2f(SndFile *psf, float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     float normfact;
 
     normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x80000000) : 1.0);
 
-    bufferlen = ARRAY_LEN(ubuf.ibuf);
+    readcount = psf->fread(ptr, sizeof(int), len);
+    bei2f_array((int *)ptr, readcount, ptr, normfact);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.ibuf, sizeof(int), bufferlen);
-        bei2f_array(ubuf.ibuf, readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_lei2f(SndFile *psf, float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     float normfact;
 
     normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x80000000) : 1.0);
 
-    bufferlen = ARRAY_LEN(ubuf.ibuf);
+    readcount = psf->fread(ptr, sizeof(int), len);
+    lei2f_array((int *)ptr, readcount, ptr, normfact);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.ibuf, sizeof(int), bufferlen);
-        lei2f_array(ubuf.ibuf, readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_sc2d(SndFile *psf, double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     double normfact;
 
     normfact = (psf->m_norm_double == SF_TRUE) ? 1.0 / ((double)0x80) : 1.0;
 
-    bufferlen = ARRAY_LEN(ubuf.scbuf);
+    readcount = psf->fread(ptr, sizeof(signed char), len);
+    sc2d_array((signed char *)ptr, readcount, ptr, normfact);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.scbuf, sizeof(signed char), bufferlen);
-        sc2d_array(ubuf.scbuf, readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_uc2d(SndFile *psf, double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     double normfact;
 
     normfact = (psf->m_norm_double == SF_TRUE) ? 1.0 / ((double)0x80) : 1.0;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
-
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.ucbuf, sizeof(unsigned char), bufferlen);
-        uc2d_array(ubuf.ucbuf, readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
+    readcount = psf->fread(ptr, sizeof(unsigned char), len);
+    uc2d_array((unsigned char *)ptr, readcount, ptr, normfact);
 
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_bes2d(SndFile *psf, double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     double normfact;
 
     normfact = (psf->m_norm_double == SF_TRUE) ? 1.0 / ((double)0x8000) : 1.0;
 
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
+    readcount = psf->fread(ptr, sizeof(short), len);
+    bes2d_array((short *)ptr, readcount, ptr, normfact);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.sbuf, sizeof(short), bufferlen);
-        bes2d_array(ubuf.sbuf, readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_les2d(SndFile *psf, double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     double normfact;
 
     normfact = (psf->m_norm_double == SF_TRUE) ? 1.0 / ((double)0x8000) : 1.0;
 
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
-
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.sbuf, sizeof(short), bufferlen);
-        les2d_array(ubuf.sbuf, readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
+    readcount = psf->fread(ptr, sizeof(short), len);
+    les2d_array((short *)ptr, readcount, ptr, normfact);
 
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_bet2d(SndFile *psf, double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     double normfact;
 
     normfact = (psf->m_norm_double == SF_TRUE) ? 1.0 / ((double)0x80000000) : 1.0 / 256.0;
 
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    readcount = psf->fread(ptr, SIZEOF_TRIBYTE, len);
+    bet2d_array((tribyte *)ptr, readcount, ptr, normfact);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.ucbuf, SIZEOF_TRIBYTE, bufferlen);
-        bet2d_array((tribyte *)(ubuf.ucbuf), readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_let2d(SndFile *psf, double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     double normfact;
 
     /* Special normfactor because tribyte value is read into an int. */
     normfact = (psf->m_norm_double == SF_TRUE) ? 1.0 / ((double)0x80000000) : 1.0 / 256.0;
 
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    readcount = psf->fread(ptr, SIZEOF_TRIBYTE, len);
+    let2d_array((tribyte *)ptr, readcount, ptr, normfact);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.ucbuf, SIZEOF_TRIBYTE, bufferlen);
-        let2d_array((tribyte *)(ubuf.ucbuf), readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_bei2d(SndFile *psf, double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     double normfact;
 
     normfact = (psf->m_norm_double == SF_TRUE) ? 1.0 / ((double)0x80000000) : 1.0;
 
-    bufferlen = ARRAY_LEN(ubuf.ibuf);
+    readcount = psf->fread(ptr, sizeof(int), len);
+    bei2d_array((int *)ptr, readcount, ptr, normfact);
 
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.ibuf, sizeof(int), bufferlen);
-        bei2d_array(ubuf.ibuf, readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
-
-    return total;
+    return readcount;
 }
 
 static size_t pcm_read_lei2d(SndFile *psf, double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
-    size_t bufferlen, readcount;
-    size_t total = 0;
+    size_t readcount;
     double normfact;
 
     normfact = (psf->m_norm_double == SF_TRUE) ? 1.0 / ((double)0x80000000) : 1.0;
 
-    bufferlen = ARRAY_LEN(ubuf.ibuf);
-
-    while (len > 0)
-    {
-        if (len < bufferlen)
-            bufferlen = len;
-        readcount = psf->fread(ubuf.ibuf, sizeof(int), bufferlen);
-        lei2d_array(ubuf.ibuf, readcount, ptr + total, normfact);
-        total += readcount;
-        if (readcount < bufferlen)
-            break;
-        len -= readcount;
-    };
+    readcount = psf->fread(ptr, sizeof(int), len);
+    lei2d_array((int *)ptr, readcount, ptr, normfact);
 
-    return total;
+    return readcount;
 }
 
 static size_t pcm_write_s2sc(SndFile *psf, const short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.scbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(signed char);
 
     while (len > 0)
     {
@@ -1541,11 +1254,11 @@ static size_t pcm_write_s2sc(SndFile *psf, const short *ptr, size_t len)
 
 static size_t pcm_write_s2uc(SndFile *psf, const short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -1564,14 +1277,14 @@ static size_t pcm_write_s2uc(SndFile *psf, const short *ptr, size_t len)
 
 static size_t pcm_write_s2bes(SndFile *psf, const short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
     if (CPU_IS_BIG_ENDIAN)
         return psf->fwrite(ptr, sizeof(short), len);
     else
-        bufferlen = ARRAY_LEN(ubuf.sbuf);
+        bufferlen = psf->get_io_buffer(&ubuf) / sizeof(short);
 
     while (len > 0)
     {
@@ -1590,14 +1303,14 @@ static size_t pcm_write_s2bes(SndFile *psf, const short *ptr, size_t len)
 
 static size_t pcm_write_s2les(SndFile *psf, const short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
     if (CPU_IS_LITTLE_ENDIAN)
         return psf->fwrite(ptr, sizeof(short), len);
 
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(short);
 
     while (len > 0)
     {
@@ -1616,11 +1329,11 @@ static size_t pcm_write_s2les(SndFile *psf, const short *ptr, size_t len)
 
 static size_t pcm_write_s2bet(SndFile *psf, const short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    bufferlen = psf->get_io_buffer(&ubuf) / SIZEOF_TRIBYTE;
 
     while (len > 0)
     {
@@ -1639,11 +1352,11 @@ static size_t pcm_write_s2bet(SndFile *psf, const short *ptr, size_t len)
 
 static size_t pcm_write_s2let(SndFile *psf, const short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    bufferlen = psf->get_io_buffer(&ubuf) / SIZEOF_TRIBYTE;
 
     while (len > 0)
     {
@@ -1662,11 +1375,11 @@ static size_t pcm_write_s2let(SndFile *psf, const short *ptr, size_t len)
 
 static size_t pcm_write_s2bei(SndFile *psf, const short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.ibuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(int);
 
     while (len > 0)
     {
@@ -1685,11 +1398,11 @@ static size_t pcm_write_s2bei(SndFile *psf, const short *ptr, size_t len)
 
 static size_t pcm_write_s2lei(SndFile *psf, const short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.ibuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(int);
 
     while (len > 0)
     {
@@ -1708,11 +1421,11 @@ static size_t pcm_write_s2lei(SndFile *psf, const short *ptr, size_t len)
 
 static size_t pcm_write_i2sc(SndFile *psf, const int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.scbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(signed char);
 
     while (len > 0)
     {
@@ -1731,11 +1444,11 @@ static size_t pcm_write_i2sc(SndFile *psf, const int *ptr, size_t len)
 
 static size_t pcm_write_i2uc(SndFile *psf, const int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -1754,11 +1467,11 @@ static size_t pcm_write_i2uc(SndFile *psf, const int *ptr, size_t len)
 
 static size_t pcm_write_i2bes(SndFile *psf, const int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(short);
 
     while (len > 0)
     {
@@ -1777,11 +1490,11 @@ static size_t pcm_write_i2bes(SndFile *psf, const int *ptr, size_t len)
 
 static size_t pcm_write_i2les(SndFile *psf, const int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(short);
 
     while (len > 0)
     {
@@ -1800,11 +1513,11 @@ static size_t pcm_write_i2les(SndFile *psf, const int *ptr, size_t len)
 
 static size_t pcm_write_i2bet(SndFile *psf, const int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    bufferlen = psf->get_io_buffer(&ubuf) / SIZEOF_TRIBYTE;
 
     while (len > 0)
     {
@@ -1823,11 +1536,11 @@ static size_t pcm_write_i2bet(SndFile *psf, const int *ptr, size_t len)
 
 static size_t pcm_write_i2let(SndFile *psf, const int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    bufferlen = psf->get_io_buffer(&ubuf) / SIZEOF_TRIBYTE;
 
     while (len > 0)
     {
@@ -1846,14 +1559,14 @@ static size_t pcm_write_i2let(SndFile *psf, const int *ptr, size_t len)
 
 static size_t pcm_write_i2bei(SndFile *psf, const int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
     if (CPU_IS_BIG_ENDIAN)
         return psf->fwrite(ptr, sizeof(int), len);
 
-    bufferlen = ARRAY_LEN(ubuf.ibuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(int);
 
     while (len > 0)
     {
@@ -1872,14 +1585,14 @@ static size_t pcm_write_i2bei(SndFile *psf, const int *ptr, size_t len)
 
 static size_t pcm_write_i2lei(SndFile *psf, const int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
     if (CPU_IS_LITTLE_ENDIAN)
         return psf->fwrite(ptr, sizeof(int), len);
 
-    bufferlen = ARRAY_LEN(ubuf.ibuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(int);
 
     while (len > 0)
     {
@@ -1936,13 +1649,13 @@ static void f2sc_clip_array(const float *src, signed char *dest, int count, int
 
 static size_t pcm_write_f2sc(SndFile *psf, const float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const float *, signed char *, int, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? f2sc_clip_array : f2sc_array;
-    bufferlen = ARRAY_LEN(ubuf.scbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(signed char);
 
     while (len > 0)
     {
@@ -1999,13 +1712,13 @@ static void f2uc_clip_array(const float *src, unsigned char *dest, size_t count,
 
 static size_t pcm_write_f2uc(SndFile *psf, const float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const float *, unsigned char *, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? f2uc_clip_array : f2uc_array;
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -2076,13 +1789,13 @@ static void f2bes_clip_array(const float *src, short *dest, size_t count, int no
 
 static size_t pcm_write_f2bes(SndFile *psf, const float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const float *, short *t, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? f2bes_clip_array : f2bes_array;
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(short);
 
     while (len > 0)
     {
@@ -2153,13 +1866,13 @@ static void f2les_clip_array(const float *src, short *dest, size_t count, int no
 
 static size_t pcm_write_f2les(SndFile *psf, const float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const float *, short *t, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? f2les_clip_array : f2les_array;
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(short);
 
     while (len > 0)
     {
@@ -2183,6 +1896,7 @@ static void f2let_array(const float *src, tribyte *dest, size_t count, int norma
     int value;
 
     normfact = (float)(normalize ? (1.0 * 0x7FFFFF) : 1.0);
+    count = psf_simd_kernels()->f2let(src, (unsigned char *)dest, count, normfact);
     ucptr = ((unsigned char *)dest) + 3 * count;
 
     while (count)
@@ -2203,6 +1917,7 @@ static void f2let_clip_array(const float *src, tribyte *dest, size_t count, int
     int value;
 
     normfact = (float)(normalize ? (8.0 * 0x10000000) : (1.0 * 0x100));
+    count = psf_simd_kernels()->f2let_clip(src, (unsigned char *)dest, count, normfact);
     ucptr = ((unsigned char *)dest) + 3 * count;
 
     while (count)
@@ -2234,13 +1949,13 @@ static void f2let_clip_array(const float *src, tribyte *dest, size_t count, int
 
 static size_t pcm_write_f2let(SndFile *psf, const float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const float *, tribyte *, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? f2let_clip_array : f2let_array;
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    bufferlen = psf->get_io_buffer(&ubuf) / SIZEOF_TRIBYTE;
 
     while (len > 0)
     {
@@ -2315,13 +2030,13 @@ static void f2bet_clip_array(const float *src, tribyte *dest, size_t count, int
 
 static size_t pcm_write_f2bet(SndFile *psf, const float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const float *, tribyte *, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? f2bet_clip_array : f2bet_array;
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    bufferlen = psf->get_io_buffer(&ubuf) / SIZEOF_TRIBYTE;
 
     while (len > 0)
     {
@@ -2399,13 +2114,13 @@ static void f2bei_clip_array(const float *src, int *dest, size_t count, int norm
 
 static size_t pcm_write_f2bei(SndFile *psf, const float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const float *, int *, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? f2bei_clip_array : f2bei_array;
-    bufferlen = ARRAY_LEN(ubuf.ibuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(int);
 
     while (len > 0)
     {
@@ -2484,13 +2199,13 @@ static void f2lei_clip_array(const float *src, int *dest, size_t count, int norm
 
 static size_t pcm_write_f2lei(SndFile *psf, const float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const float *, int *, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? f2lei_clip_array : f2lei_array;
-    bufferlen = ARRAY_LEN(ubuf.ibuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(int);
 
     while (len > 0)
     {
@@ -2547,13 +2262,13 @@ static void d2sc_clip_array(const double *src, signed char *dest, size_t count,
 
 static size_t pcm_write_d2sc(SndFile *psf, const double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const double *, signed char *, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? d2sc_clip_array : d2sc_array;
-    bufferlen = ARRAY_LEN(ubuf.scbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(signed char);
 
     while (len > 0)
     {
@@ -2610,13 +2325,13 @@ static void d2uc_clip_array(const double *src, unsigned char *dest, size_t count
 
 static size_t pcm_write_d2uc(SndFile *psf, const double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const double *, unsigned char *, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? d2uc_clip_array : d2uc_array;
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -2687,13 +2402,13 @@ static void d2bes_clip_array(const double *src, short *dest, size_t count, int n
 
 static size_t pcm_write_d2bes(SndFile *psf, const double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const double *, short *, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? d2bes_clip_array : d2bes_array;
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(short);
 
     while (len > 0)
     {
@@ -2764,13 +2479,13 @@ static void d2les_clip_array(const double *src, short *dest, size_t count, int n
 
 static size_t pcm_write_d2les(SndFile *psf, const double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const double *, short *, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? d2les_clip_array : d2les_array;
-    bufferlen = ARRAY_LEN(ubuf.sbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(short);
 
     while (len > 0)
     {
@@ -2845,13 +2560,13 @@ static void d2let_clip_array(const double *src, tribyte *dest, size_t count, int
 
 static size_t pcm_write_d2let(SndFile *psf, const double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const double *, tribyte *, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? d2let_clip_array : d2let_array;
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    bufferlen = psf->get_io_buffer(&ubuf) / SIZEOF_TRIBYTE;
 
     while (len > 0)
     {
@@ -2926,13 +2641,13 @@ static void d2bet_clip_array(const double *src, tribyte *dest, size_t count, int
 
 static size_t pcm_write_d2bet(SndFile *psf, const double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const double *, tribyte *, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? d2bet_clip_array : d2bet_array;
-    bufferlen = sizeof(ubuf.ucbuf) / SIZEOF_TRIBYTE;
+    bufferlen = psf->get_io_buffer(&ubuf) / SIZEOF_TRIBYTE;
 
     while (len > 0)
     {
@@ -3011,13 +2726,13 @@ static void d2bei_clip_array(const double *src, int *dest, size_t count, int nor
 
 static size_t pcm_write_d2bei(SndFile *psf, const double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const double *, int *, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? d2bei_clip_array : d2bei_array;
-    bufferlen = ARRAY_LEN(ubuf.ibuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(int);
 
     while (len > 0)
     {
@@ -3096,13 +2811,13 @@ static void d2lei_clip_array(const double *src, int *dest, size_t count, int nor
 
 static size_t pcm_write_d2lei(SndFile *psf, const double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     void (*convert)(const double *, int *, size_t, int);
     size_t bufferlen, writecount;
     size_t total = 0;
 
     convert = (psf->m_add_clipping) ? d2lei_clip_array : d2lei_array;
-    bufferlen = ARRAY_LEN(ubuf.ibuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(int);
 
     while (len > 0)
     {
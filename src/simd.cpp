@@ -0,0 +1,1629 @@
+/*
+** Copyright (C) 2026 agent <agent@local>
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation; either version 2.1 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "config.h"
+
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+
+#include "common.h"
+#include "simd.h"
+#include "ALAC/matrixlib.h"
+#include "GSM610/gsm610_simd.h"
+
+#if (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+#define SIMD_HAVE_X86 1
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#elif (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#define SIMD_HAVE_X86 1
+#define SIMD_TARGET(isa)
+#endif
+
+#ifdef SIMD_HAVE_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+/*------------------------------------------------------------------------------
+** Fallback kernels, they leave all of the work to the scalar code.
+*/
+
+static size_t none_s2f(const short *UNUSED(src), size_t count, float *UNUSED(dest), float UNUSED(normfact))
+{
+    return count;
+}
+
+static size_t none_i2f(const int *UNUSED(src), size_t count, float *UNUSED(dest), float UNUSED(normfact))
+{
+    return count;
+}
+
+static size_t none_t2f(const unsigned char *UNUSED(src), size_t count, float *UNUSED(dest), float UNUSED(normfact))
+{
+    return count;
+}
+
+static size_t none_t2i(const unsigned char *UNUSED(src), size_t count, int *UNUSED(dest))
+{
+    return count;
+}
+
+static size_t none_f2s(const float *UNUSED(src), size_t count, short *UNUSED(dest), float UNUSED(scale))
+{
+    return count;
+}
+
+static size_t none_f2i(const float *UNUSED(src), size_t count, int *UNUSED(dest), float UNUSED(scale))
+{
+    return count;
+}
+
+static size_t none_f2t(const float *UNUSED(src), unsigned char *UNUSED(dest), size_t count, float UNUSED(normfact))
+{
+    return count;
+}
+
+static size_t none_stats(const double *UNUSED(src), size_t frames, int UNUSED(channels), SIMD_SIGNAL_STATS *UNUSED(stats))
+{
+    return frames;
+}
+
+static size_t none_pi2s(const int32_t *const *UNUSED(src), size_t frames, int UNUSED(channels), short *UNUSED(dest),
+                        int UNUSED(shift))
+{
+    return frames;
+}
+
+static size_t none_pi2i(const int32_t *const *UNUSED(src), size_t frames, int UNUSED(channels), int *UNUSED(dest),
+                        int UNUSED(shift))
+{
+    return frames;
+}
+
+static size_t none_pi2f(const int32_t *const *UNUSED(src), size_t frames, int UNUSED(channels), float *UNUSED(dest),
+                        float UNUSED(normfact))
+{
+    return frames;
+}
+
+static size_t none_alac_unmix(const int32_t *UNUSED(u), const int32_t *UNUSED(v), int32_t *UNUSED(out), size_t frames,
+                              int UNUSED(mixbits), int UNUSED(mixres), const uint16_t *UNUSED(shift_uv),
+                              int UNUSED(bytes_shifted), int UNUSED(out_shift))
+{
+    return frames;
+}
+
+static bool none_gsm_autocorr(const float *UNUSED(s), int32_t *UNUSED(acf))
+{
+    return false;
+}
+
+static bool none_gsm_ltp_xcorr(const float *UNUSED(wt), const float *UNUSED(dp), float *UNUSED(corr))
+{
+    return false;
+}
+
+static bool none_gsm_weighting(const int16_t *UNUSED(e), int16_t *UNUSED(x))
+{
+    return false;
+}
+
+static bool none_gsm_grid_energy(const int16_t *UNUSED(x), int32_t *UNUSED(energy))
+{
+    return false;
+}
+
+static bool none_gsm_ltp_synth(int16_t UNUSED(brp), const int16_t *UNUSED(lagged), const int16_t *UNUSED(erp),
+                               int16_t *UNUSED(drp))
+{
+    return false;
+}
+
+static const SIMD_KERNELS none_kernels = {
+    SIMD_ISA_NONE, "none",
+    none_s2f, none_s2f, none_i2f, none_i2f, none_t2f, none_t2f, none_t2i, none_t2i,
+    none_f2s, none_f2s, none_f2i, none_f2i,
+    none_f2t, none_f2t,
+    none_stats,
+    none_pi2s, none_pi2i, none_pi2f,
+    none_alac_unmix,
+    none_gsm_autocorr, none_gsm_ltp_xcorr, none_gsm_weighting, none_gsm_grid_energy, none_gsm_ltp_synth,
+};
+
+#ifdef SIMD_HAVE_X86
+
+/*------------------------------------------------------------------------------
+** Scalar versions of the float to int conversions, used for blocks containing
+** values the vector conversion doesn't handle the way lrintf() does (NaNs and
+** values outside the int range). These must match the loops in pcm.cpp and
+** float32.cpp exactly.
+*/
+
+static inline void scalar_f2s(const float *src, size_t count, short *dest, float scale)
+{
+    while (count)
+    {
+        count--;
+        dest[count] = (short)lrintf(scale * src[count]);
+    };
+}
+
+static inline void scalar_f2s_clip(const float *src, size_t count, short *dest, float scale)
+{
+    while (count)
+    {
+        count--;
+        float tmp = scale * src[count];
+
+        if (CPU_CLIPS_POSITIVE == 0 && tmp > 32767.0)
+            dest[count] = SHRT_MAX;
+        else if (CPU_CLIPS_NEGATIVE == 0 && tmp < -32768.0)
+            dest[count] = SHRT_MIN;
+        else
+            dest[count] = (short)lrintf(tmp);
+    };
+}
+
+static inline void scalar_f2i(const float *src, size_t count, int *dest, float scale)
+{
+    while (count)
+    {
+        count--;
+        dest[count] = lrintf(scale * src[count]);
+    };
+}
+
+static inline void scalar_f2i_clip(const float *src, size_t count, int *dest, float scale)
+{
+    while (count)
+    {
+        count--;
+        float tmp = scale * src[count];
+
+        if (CPU_CLIPS_POSITIVE == 0 && tmp > (1.0 * INT_MAX))
+            dest[count] = INT_MAX;
+        else if (CPU_CLIPS_NEGATIVE == 0 && tmp < (-1.0 * INT_MAX))
+            dest[count] = INT_MIN;
+        else
+            dest[count] = lrintf(tmp);
+    };
+}
+
+static inline void scalar_f2let(const float *src, unsigned char *dest, size_t count, float normfact)
+{
+    unsigned char *ucptr = dest + 3 * count;
+    int value;
+
+    while (count)
+    {
+        count--;
+        ucptr -= 3;
+        value = lrintf(src[count] * normfact);
+        ucptr[0] = value;
+        ucptr[1] = value >> 8;
+        ucptr[2] = value >> 16;
+    };
+}
+
+static inline void scalar_f2let_clip(const float *src, unsigned char *dest, size_t count, float normfact)
+{
+    unsigned char *ucptr = dest + 3 * count;
+    float scaled_value;
+    int value;
+
+    while (count)
+    {
+        count--;
+        ucptr -= 3;
+        scaled_value = src[count] * normfact;
+        if (CPU_CLIPS_POSITIVE == 0 && scaled_value >= (1.0 * 0x7FFFFFFF))
+        {
+            ucptr[0] = 0xFF;
+            ucptr[1] = 0xFF;
+            ucptr[2] = 0x7F;
+            continue;
+        };
+        if (CPU_CLIPS_NEGATIVE == 0 && scaled_value <= (-8.0 * 0x10000000))
+        {
+            ucptr[0] = 0x00;
+            ucptr[1] = 0x00;
+            ucptr[2] = 0x80;
+            continue;
+        };
+
+        value = lrintf(scaled_value);
+        ucptr[0] = value >> 8;
+        ucptr[1] = value >> 16;
+        ucptr[2] = value >> 24;
+    };
+}
+
+/*
+** The clipping kernels rely on the vector conversion returning INT_MIN for
+** large negative values and on explicit clipping of large positive ones, which
+** is what the scalar code does when the CPU doesn't clip by itself.
+*/
+#define SIMD_CLIP_KERNELS (CPU_CLIPS_POSITIVE == 0 && CPU_CLIPS_NEGATIVE == 0)
+
+/* 2^31 as a float, the first value which doesn't fit an int. */
+#define SIMD_INT_LIMIT (2147483648.0f)
+
+/*
+** The stats kernels step through the samples a period at a time, the shortest
+** run which is a whole number of both frames and vectors. Lane j of a period
+** always holds channel j % channels, so each lane gets its own accumulators
+** and they are folded into the channels at the end.
+*/
+#define SIMD_STATS_MAX_LANES (16)
+
+static inline size_t stats_period(int channels, size_t width)
+{
+    if (channels < 1 || channels > SIMD_STATS_MAX_LANES)
+        return 0;
+    if (channels % width == 0)
+        return channels;
+    if (width % channels == 0)
+        return width;
+    return 0;
+}
+
+static void stats_reduce(const double *peak, const double *sum, const double *sum_sq, const int64_t *clips,
+                         const int64_t *crossings, size_t lanes, int channels, SIMD_SIGNAL_STATS *stats)
+{
+    for (size_t j = 0; j < lanes; j++)
+    {
+        SIMD_SIGNAL_STATS *s = stats + j % channels;
+
+        s->peak = peak[j] > s->peak ? peak[j] : s->peak;
+        s->sum += sum[j];
+        s->sum_sq += sum_sq[j];
+        s->clips += clips[j];
+        s->crossings += crossings[j];
+    };
+}
+
+/* One lag of the GSM long term cross correlation, in the order of the scalar code. */
+static inline float scalar_gsm_xcorr(const float *wt, const float *lagged)
+{
+    float sum = 0.0f;
+
+    for (int k = 0; k < 40; k++)
+        sum += wt[k] * lagged[k];
+
+    return sum;
+}
+
+/*------------------------------------------------------------------------------
+** SSE2 kernels.
+*/
+
+static inline SIMD_TARGET("sse2") __m128i sse2_bswap16(__m128i x)
+{
+    return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+}
+
+static inline SIMD_TARGET("sse2") __m128i sse2_bswap32(__m128i x)
+{
+    x = _mm_or_si128(_mm_slli_epi32(x, 16), _mm_srli_epi32(x, 16));
+    return sse2_bswap16(x);
+}
+
+static inline SIMD_TARGET("sse2") __m128i sse2_blend(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/* Non zero if any lane is a NaN or doesn't fit an int. */
+static inline SIMD_TARGET("sse2") int sse2_out_of_range(__m128 x)
+{
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    return _mm_movemask_ps(_mm_cmpnlt_ps(_mm_and_ps(x, abs_mask), _mm_set1_ps(SIMD_INT_LIMIT)));
+}
+
+static inline SIMD_TARGET("sse2") int sse2_has_nan(__m128 x)
+{
+    return _mm_movemask_ps(_mm_cmpunord_ps(x, x));
+}
+
+/* Converts 8 shorts to floats, the source is consumed before dest is written. */
+static inline SIMD_TARGET("sse2") void sse2_s2f_block(__m128i s, float *dest, __m128 scale)
+{
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+    _mm_storeu_ps(dest + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+}
+
+static SIMD_TARGET("sse2") size_t sse2_les2f(const short *src, size_t count, float *dest, float normfact)
+{
+    const __m128 scale = _mm_set1_ps(normfact);
+
+    while (count >= 8)
+    {
+        count -= 8;
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + count));
+        sse2_s2f_block(s, dest + count, scale);
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("sse2") size_t sse2_bes2f(const short *src, size_t count, float *dest, float normfact)
+{
+    const __m128 scale = _mm_set1_ps(normfact);
+
+    while (count >= 8)
+    {
+        count -= 8;
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + count));
+        sse2_s2f_block(sse2_bswap16(s), dest + count, scale);
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("sse2") size_t sse2_lei2f(const int *src, size_t count, float *dest, float normfact)
+{
+    const __m128 scale = _mm_set1_ps(normfact);
+
+    while (count >= 4)
+    {
+        count -= 4;
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + count));
+        _mm_storeu_ps(dest + count, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("sse2") size_t sse2_bei2f(const int *src, size_t count, float *dest, float normfact)
+{
+    const __m128 scale = _mm_set1_ps(normfact);
+
+    while (count >= 4)
+    {
+        count -= 4;
+        __m128i s = sse2_bswap32(_mm_loadu_si128((const __m128i *)(src + count)));
+        _mm_storeu_ps(dest + count, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("sse2") size_t sse2_f2s(const float *src, size_t count, short *dest, float scale)
+{
+    const __m128 vscale = _mm_set1_ps(scale);
+
+    while (count >= 8)
+    {
+        count -= 8;
+        __m128 a = _mm_mul_ps(vscale, _mm_loadu_ps(src + count));
+        __m128 b = _mm_mul_ps(vscale, _mm_loadu_ps(src + count + 4));
+
+        if (sse2_out_of_range(a) | sse2_out_of_range(b))
+        {
+            scalar_f2s(src + count, 8, dest + count, scale);
+            continue;
+        };
+
+        /* Truncate rather than saturate, like the cast to short does. */
+        __m128i ia = _mm_srai_epi32(_mm_slli_epi32(_mm_cvtps_epi32(a), 16), 16);
+        __m128i ib = _mm_srai_epi32(_mm_slli_epi32(_mm_cvtps_epi32(b), 16), 16);
+        _mm_storeu_si128((__m128i *)(dest + count), _mm_packs_epi32(ia, ib));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("sse2") size_t sse2_f2s_clip(const float *src, size_t count, short *dest, float scale)
+{
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 pos_limit = _mm_set1_ps(32767.0f);
+    const __m128 neg_limit = _mm_set1_ps(-32768.0f);
+
+    while (count >= 8)
+    {
+        count -= 8;
+        __m128 a = _mm_mul_ps(vscale, _mm_loadu_ps(src + count));
+        __m128 b = _mm_mul_ps(vscale, _mm_loadu_ps(src + count + 4));
+
+        if (sse2_has_nan(a) | sse2_has_nan(b))
+        {
+            scalar_f2s_clip(src + count, 8, dest + count, scale);
+            continue;
+        };
+
+        /* Once clipped every lane fits a short, so saturation never kicks in. */
+        a = _mm_min_ps(_mm_max_ps(a, neg_limit), pos_limit);
+        b = _mm_min_ps(_mm_max_ps(b, neg_limit), pos_limit);
+        _mm_storeu_si128((__m128i *)(dest + count), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("sse2") size_t sse2_f2i(const float *src, size_t count, int *dest, float scale)
+{
+    const __m128 vscale = _mm_set1_ps(scale);
+
+    while (count >= 4)
+    {
+        count -= 4;
+        __m128 a = _mm_mul_ps(vscale, _mm_loadu_ps(src + count));
+
+        if (sse2_out_of_range(a))
+        {
+            scalar_f2i(src + count, 4, dest + count, scale);
+            continue;
+        };
+
+        _mm_storeu_si128((__m128i *)(dest + count), _mm_cvtps_epi32(a));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("sse2") size_t sse2_f2i_clip(const float *src, size_t count, int *dest, float scale)
+{
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 pos_limit = _mm_set1_ps(SIMD_INT_LIMIT);
+    const __m128i int_max = _mm_set1_epi32(INT_MAX);
+
+    while (count >= 4)
+    {
+        count -= 4;
+        __m128 a = _mm_mul_ps(vscale, _mm_loadu_ps(src + count));
+
+        if (sse2_has_nan(a))
+        {
+            scalar_f2i_clip(src + count, 4, dest + count, scale);
+            continue;
+        };
+
+        /* Large negative values already convert to INT_MIN. */
+        __m128i clip = _mm_castps_si128(_mm_cmpge_ps(a, pos_limit));
+        _mm_storeu_si128((__m128i *)(dest + count), sse2_blend(clip, int_max, _mm_cvtps_epi32(a)));
+    };
+
+    return count;
+}
+
+/*
+** Comparison masks are all ones, ie. -1 as a 64 bit integer, so subtracting
+** them counts the lanes that matched. NaNs fail every comparison and are
+** ignored by the peak, as in the scalar code.
+*/
+static SIMD_TARGET("sse2") size_t sse2_stats(const double *src, size_t frames, int channels, SIMD_SIGNAL_STATS *stats)
+{
+    const size_t period = stats_period(channels, 2);
+    if (period == 0 || frames == 0)
+        return frames;
+
+    const size_t count = frames * channels;
+    const size_t tail = (count - channels) / period * period;
+    if (tail == 0)
+        return frames;
+
+    const size_t vectors = period / 2;
+    const __m128d sign_mask = _mm_set1_pd(-0.0);
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d zero = _mm_setzero_pd();
+
+    __m128d peak[SIMD_STATS_MAX_LANES / 2], sum[SIMD_STATS_MAX_LANES / 2], sum_sq[SIMD_STATS_MAX_LANES / 2];
+    __m128i clips[SIMD_STATS_MAX_LANES / 2], crossings[SIMD_STATS_MAX_LANES / 2];
+
+    for (size_t v = 0; v < vectors; v++)
+    {
+        peak[v] = sum[v] = sum_sq[v] = zero;
+        clips[v] = crossings[v] = _mm_setzero_si128();
+    };
+
+    for (const double *ptr = src + count - tail; ptr < src + count; ptr += period)
+    {
+        for (size_t v = 0; v < vectors; v++)
+        {
+            __m128d x = _mm_loadu_pd(ptr + 2 * v);
+            __m128d prev = _mm_loadu_pd(ptr + 2 * v - channels);
+            __m128d ax = _mm_andnot_pd(sign_mask, x);
+
+            peak[v] = _mm_max_pd(ax, peak[v]);
+            sum[v] = _mm_add_pd(sum[v], x);
+            sum_sq[v] = _mm_add_pd(sum_sq[v], _mm_mul_pd(x, x));
+            clips[v] = _mm_sub_epi64(clips[v], _mm_castpd_si128(_mm_cmpge_pd(ax, one)));
+            crossings[v] = _mm_sub_epi64(crossings[v],
+                                         _mm_castpd_si128(_mm_xor_pd(_mm_cmplt_pd(x, zero), _mm_cmplt_pd(prev, zero))));
+        };
+    };
+
+    double lane_peak[SIMD_STATS_MAX_LANES], lane_sum[SIMD_STATS_MAX_LANES], lane_sum_sq[SIMD_STATS_MAX_LANES];
+    int64_t lane_clips[SIMD_STATS_MAX_LANES], lane_crossings[SIMD_STATS_MAX_LANES];
+
+    for (size_t v = 0; v < vectors; v++)
+    {
+        _mm_storeu_pd(lane_peak + 2 * v, peak[v]);
+        _mm_storeu_pd(lane_sum + 2 * v, sum[v]);
+        _mm_storeu_pd(lane_sum_sq + 2 * v, sum_sq[v]);
+        _mm_storeu_si128((__m128i *)(lane_clips + 2 * v), clips[v]);
+        _mm_storeu_si128((__m128i *)(lane_crossings + 2 * v), crossings[v]);
+    };
+
+    stats_reduce(lane_peak, lane_sum, lane_sum_sq, lane_clips, lane_crossings, period, channels, stats);
+
+    return frames - tail / channels;
+}
+
+/* Shifts as pi2s does, leaving the low 16 bits sign extended so packing doesn't saturate. */
+static inline SIMD_TARGET("sse2") __m128i sse2_pi2s_shift(__m128i x, __m128i left, __m128i right)
+{
+    x = _mm_sra_epi32(_mm_sll_epi32(x, left), right);
+    return _mm_srai_epi32(_mm_slli_epi32(x, 16), 16);
+}
+
+static SIMD_TARGET("sse2") size_t sse2_pi2s(const int32_t *const *src, size_t frames, int channels, short *dest,
+                                            int shift)
+{
+    const __m128i left = _mm_cvtsi32_si128(shift > 0 ? shift : 0);
+    const __m128i right = _mm_cvtsi32_si128(shift < 0 ? -shift : 0);
+
+    if (channels == 1)
+    {
+        while (frames >= 8)
+        {
+            frames -= 8;
+            __m128i a = sse2_pi2s_shift(_mm_loadu_si128((const __m128i *)(src[0] + frames)), left, right);
+            __m128i b = sse2_pi2s_shift(_mm_loadu_si128((const __m128i *)(src[0] + frames + 4)), left, right);
+            _mm_storeu_si128((__m128i *)(dest + frames), _mm_packs_epi32(a, b));
+        };
+    }
+    else if (channels == 2)
+    {
+        while (frames >= 4)
+        {
+            frames -= 4;
+            __m128i l = sse2_pi2s_shift(_mm_loadu_si128((const __m128i *)(src[0] + frames)), left, right);
+            __m128i r = sse2_pi2s_shift(_mm_loadu_si128((const __m128i *)(src[1] + frames)), left, right);
+            _mm_storeu_si128((__m128i *)(dest + 2 * frames),
+                             _mm_packs_epi32(_mm_unpacklo_epi32(l, r), _mm_unpackhi_epi32(l, r)));
+        };
+    };
+
+    return frames;
+}
+
+static SIMD_TARGET("sse2") size_t sse2_pi2i(const int32_t *const *src, size_t frames, int channels, int *dest, int shift)
+{
+    const __m128i left = _mm_cvtsi32_si128(shift);
+
+    if (channels == 1)
+    {
+        while (frames >= 4)
+        {
+            frames -= 4;
+            __m128i a = _mm_loadu_si128((const __m128i *)(src[0] + frames));
+            _mm_storeu_si128((__m128i *)(dest + frames), _mm_sll_epi32(a, left));
+        };
+    }
+    else if (channels == 2)
+    {
+        while (frames >= 4)
+        {
+            frames -= 4;
+            __m128i l = _mm_sll_epi32(_mm_loadu_si128((const __m128i *)(src[0] + frames)), left);
+            __m128i r = _mm_sll_epi32(_mm_loadu_si128((const __m128i *)(src[1] + frames)), left);
+            _mm_storeu_si128((__m128i *)(dest + 2 * frames), _mm_unpacklo_epi32(l, r));
+            _mm_storeu_si128((__m128i *)(dest + 2 * frames + 4), _mm_unpackhi_epi32(l, r));
+        };
+    };
+
+    return frames;
+}
+
+static SIMD_TARGET("sse2") size_t sse2_pi2f(const int32_t *const *src, size_t frames, int channels, float *dest,
+                                            float normfact)
+{
+    const __m128 scale = _mm_set1_ps(normfact);
+
+    if (channels == 1)
+    {
+        while (frames >= 4)
+        {
+            frames -= 4;
+            __m128i a = _mm_loadu_si128((const __m128i *)(src[0] + frames));
+            _mm_storeu_ps(dest + frames, _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+        };
+    }
+    else if (channels == 2)
+    {
+        while (frames >= 4)
+        {
+            frames -= 4;
+            __m128 l = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(src[0] + frames))), scale);
+            __m128 r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(src[1] + frames))), scale);
+            _mm_storeu_ps(dest + 2 * frames, _mm_unpacklo_ps(l, r));
+            _mm_storeu_ps(dest + 2 * frames + 4, _mm_unpackhi_ps(l, r));
+        };
+    };
+
+    return frames;
+}
+
+/* Low 32 bits of the products, as pmulld would give them. */
+static inline SIMD_TARGET("sse2") __m128i sse2_mullo_epi32(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/*
+** A mixbits of 32 or more is undefined in the scalar code, such streams are
+** left to it so they decode as they always did.
+*/
+static SIMD_TARGET("sse2") size_t sse2_alac_unmix(const int32_t *u, const int32_t *v, int32_t *out, size_t frames,
+                                                  int mixbits, int mixres, const uint16_t *shift_uv, int bytes_shifted,
+                                                  int out_shift)
+{
+    const __m128i res = _mm_set1_epi32(mixres);
+    const __m128i bits = _mm_cvtsi32_si128(mixbits);
+    const __m128i shift = _mm_cvtsi32_si128(8 * bytes_shifted);
+    const __m128i left = _mm_cvtsi32_si128(out_shift);
+    const __m128i zero = _mm_setzero_si128();
+
+    if (mixbits < 0 || mixbits > 31)
+        return frames;
+
+    while (frames >= 4)
+    {
+        frames -= 4;
+        __m128i l = _mm_loadu_si128((const __m128i *)(u + frames));
+        __m128i r = _mm_loadu_si128((const __m128i *)(v + frames));
+
+        if (mixres != 0)
+        {
+            l = _mm_sub_epi32(_mm_add_epi32(l, r), _mm_sra_epi32(sse2_mullo_epi32(res, r), bits));
+            r = _mm_sub_epi32(l, r);
+        };
+
+        __m128i lo = _mm_unpacklo_epi32(l, r);
+        __m128i hi = _mm_unpackhi_epi32(l, r);
+
+        if (shift_uv != NULL)
+        {
+            __m128i s = _mm_loadu_si128((const __m128i *)(shift_uv + 2 * frames));
+            lo = _mm_or_si128(_mm_sll_epi32(lo, shift), _mm_unpacklo_epi16(s, zero));
+            hi = _mm_or_si128(_mm_sll_epi32(hi, shift), _mm_unpackhi_epi16(s, zero));
+        };
+
+        _mm_storeu_si128((__m128i *)(out + 2 * frames), _mm_sll_epi32(lo, left));
+        _mm_storeu_si128((__m128i *)(out + 2 * frames + 4), _mm_sll_epi32(hi, left));
+    };
+
+    return frames;
+}
+
+static inline SIMD_TARGET("sse2") int32_t sse2_hsum_epi32(__m128i x)
+{
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtsi128_si32(x);
+}
+
+/*
+** The products are rounded to float and truncated exactly as in the scalar
+** code. Their sum is the same in any order, it never gets near the int range
+** but wraps like the vector adds would if it did.
+*/
+static SIMD_TARGET("sse2") bool sse2_gsm_autocorr(const float *s, int32_t *acf)
+{
+    for (int k = 0; k <= 8; k++)
+    {
+        __m128i sum = _mm_setzero_si128();
+        int i = k;
+
+        for (; i + 4 <= 160; i += 4)
+            sum = _mm_add_epi32(sum, _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(s + i), _mm_loadu_ps(s + i - k))));
+
+        int32_t total = sse2_hsum_epi32(sum);
+        for (; i < 160; i++)
+            total = (int32_t)((uint32_t)total + (uint32_t)(int32_t)(s[i] * s[i - k]));
+
+        acf[k] = total;
+    };
+
+    return true;
+}
+
+/*
+** Each lane sums one lag over k, like S0 to S8 in the scalar code. The lanes
+** hold lags lambda + 3 down to lambda as they lie in dp and are reversed at
+** the end. Lag 120 is left over.
+*/
+static SIMD_TARGET("sse2") bool sse2_gsm_ltp_xcorr(const float *wt, const float *dp, float *corr)
+{
+    for (int lambda = 40; lambda + 3 < 120; lambda += 4)
+    {
+        const float *lp = dp - lambda - 3;
+        __m128 sum = _mm_setzero_ps();
+
+        for (int k = 0; k < 40; k++)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(wt[k]), _mm_loadu_ps(lp + k)));
+
+        _mm_storeu_ps(corr + lambda - 40, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(0, 1, 2, 3)));
+    };
+
+    corr[80] = scalar_gsm_xcorr(wt, dp - 120);
+
+    return true;
+}
+
+/*
+** Pairs of taps are applied with pmaddwd, H[2] and H[8] are 0 but keep the
+** pairs lined up. The last tap is paired with 0 rather than e[45], which is
+** past the end.
+*/
+static SIMD_TARGET("sse2") bool sse2_gsm_weighting(const int16_t *e, int16_t *x)
+{
+    static const int16_t H[12] = {-134, -374, 0, 2054, 5741, 8192, 5741, 2054, 0, -374, -134, 0};
+    const __m128i round = _mm_set1_epi32(8192 >> 1);
+
+    for (int k = 0; k < 40; k += 8)
+    {
+        __m128i lo = round, hi = round;
+
+        for (int i = 0; i < 12; i += 2)
+        {
+            const __m128i taps = _mm_set1_epi32((int)((uint16_t)H[i] | ((uint32_t)(uint16_t)H[i + 1] << 16)));
+            __m128i a = _mm_loadu_si128((const __m128i *)(e + k + i - 5));
+            __m128i b = i < 10 ? _mm_loadu_si128((const __m128i *)(e + k + i - 4)) : _mm_setzero_si128();
+
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), taps));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), taps));
+        };
+
+        _mm_storeu_si128((__m128i *)(x + k), _mm_packs_epi32(_mm_srai_epi32(lo, 13), _mm_srai_epi32(hi, 13)));
+    };
+
+    return true;
+}
+
+/*
+** Sample 8 * v + j is on grid m when j % 3 == (m + v) % 3. Grids 0 and 3 share
+** all samples but x[0] and x[39], both are found from the sum over all three.
+*/
+static SIMD_TARGET("sse2") bool sse2_gsm_grid_energy(const int16_t *x, int32_t *energy)
+{
+    const __m128i lanes[3] = {
+        _mm_setr_epi16(-1, 0, 0, -1, 0, 0, -1, 0),
+        _mm_setr_epi16(0, -1, 0, 0, -1, 0, 0, -1),
+        _mm_setr_epi16(0, 0, -1, 0, 0, -1, 0, 0),
+    };
+    __m128i sum[3] = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+
+    for (int v = 0; v < 5; v++)
+    {
+        __m128i y = _mm_srai_epi16(_mm_loadu_si128((const __m128i *)(x + 8 * v)), 2);
+
+        for (int m = 0; m < 3; m++)
+            sum[m] = _mm_add_epi32(sum[m], _mm_madd_epi16(_mm_and_si128(y, lanes[(m + v) % 3]), y));
+    };
+
+    const int32_t first = x[0] >> 2, last = x[39] >> 2;
+    const int32_t common = sse2_hsum_epi32(sum[0]);
+
+    energy[0] = common - last * last;
+    energy[1] = sse2_hsum_epi32(sum[1]);
+    energy[2] = sse2_hsum_epi32(sum[2]);
+    energy[3] = common - first * first;
+
+    return true;
+}
+
+/* Products of 16 bit values with a gain other than -32768 round back into 16 bits. */
+static SIMD_TARGET("sse2") bool sse2_gsm_ltp_synth(int16_t brp, const int16_t *lagged, const int16_t *erp, int16_t *drp)
+{
+    const __m128i gain = _mm_set1_epi16(brp);
+    const __m128i round = _mm_set1_epi32(16384);
+
+    for (int k = 0; k < 40; k += 8)
+    {
+        __m128i d = _mm_loadu_si128((const __m128i *)(lagged + k));
+        __m128i lo = _mm_mullo_epi16(gain, d);
+        __m128i hi = _mm_mulhi_epi16(gain, d);
+
+        __m128i p0 = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), round), 15);
+        __m128i p1 = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), round), 15);
+
+        __m128i e = _mm_loadu_si128((const __m128i *)(erp + k));
+        _mm_storeu_si128((__m128i *)(drp + k), _mm_adds_epi16(e, _mm_packs_epi32(p0, p1)));
+    };
+
+    return true;
+}
+
+/*------------------------------------------------------------------------------
+** SSSE3 kernels, for tribytes which need byte shuffles.
+**
+** Four tribytes are loaded with a 16 byte load ending at the last byte of
+** the block, so the load never reads past the end of the source array. That
+** needs 4 bytes in front of the block, hence the count >= 6 loop conditions.
+*/
+
+static SIMD_TARGET("ssse3") size_t ssse3_let2i(const unsigned char *src, size_t count, int *dest)
+{
+    const __m128i shuffle = _mm_setr_epi8(-1, 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15);
+
+    while (count >= 6)
+    {
+        count -= 4;
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + 3 * count - 4));
+        _mm_storeu_si128((__m128i *)(dest + count), _mm_shuffle_epi8(s, shuffle));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("ssse3") size_t ssse3_bet2i(const unsigned char *src, size_t count, int *dest)
+{
+    const __m128i shuffle = _mm_setr_epi8(-1, 6, 5, 4, -1, 9, 8, 7, -1, 12, 11, 10, -1, 15, 14, 13);
+
+    while (count >= 6)
+    {
+        count -= 4;
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + 3 * count - 4));
+        _mm_storeu_si128((__m128i *)(dest + count), _mm_shuffle_epi8(s, shuffle));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("ssse3") size_t ssse3_let2f(const unsigned char *src, size_t count, float *dest, float normfact)
+{
+    const __m128i shuffle = _mm_setr_epi8(-1, 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15);
+    const __m128 scale = _mm_set1_ps(normfact);
+
+    while (count >= 6)
+    {
+        count -= 4;
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + 3 * count - 4));
+        s = _mm_shuffle_epi8(s, shuffle);
+        _mm_storeu_ps(dest + count, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("ssse3") size_t ssse3_bet2f(const unsigned char *src, size_t count, float *dest, float normfact)
+{
+    const __m128i shuffle = _mm_setr_epi8(-1, 6, 5, 4, -1, 9, 8, 7, -1, 12, 11, 10, -1, 15, 14, 13);
+    const __m128 scale = _mm_set1_ps(normfact);
+
+    while (count >= 6)
+    {
+        count -= 4;
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + 3 * count - 4));
+        s = _mm_shuffle_epi8(s, shuffle);
+        _mm_storeu_ps(dest + count, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+    };
+
+    return count;
+}
+
+/*
+** The packed tribytes end up in the top 12 bytes of the register and are
+** stored 4 bytes in front of the block. Those 4 bytes belong to the next block
+** down, which is written afterwards.
+*/
+
+static SIMD_TARGET("ssse3") size_t ssse3_f2let(const float *src, unsigned char *dest, size_t count, float normfact)
+{
+    const __m128i shuffle = _mm_setr_epi8(-1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14);
+    const __m128 scale = _mm_set1_ps(normfact);
+
+    while (count >= 6)
+    {
+        count -= 4;
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(src + count), scale);
+
+        if (sse2_out_of_range(a))
+        {
+            scalar_f2let(src + count, dest + 3 * count, 4, normfact);
+            continue;
+        };
+
+        __m128i v = _mm_shuffle_epi8(_mm_cvtps_epi32(a), shuffle);
+        _mm_storeu_si128((__m128i *)(dest + 3 * count - 4), v);
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("ssse3") size_t ssse3_f2let_clip(const float *src, unsigned char *dest, size_t count, float normfact)
+{
+    const __m128i shuffle = _mm_setr_epi8(-1, -1, -1, -1, 1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15);
+    const __m128 scale = _mm_set1_ps(normfact);
+    const __m128 pos_limit = _mm_set1_ps(SIMD_INT_LIMIT);
+    const __m128i int_max = _mm_set1_epi32(INT_MAX);
+
+    while (count >= 6)
+    {
+        count -= 4;
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(src + count), scale);
+
+        if (sse2_has_nan(a))
+        {
+            scalar_f2let_clip(src + count, dest + 3 * count, 4, normfact);
+            continue;
+        };
+
+        __m128i clip = _mm_castps_si128(_mm_cmpge_ps(a, pos_limit));
+        __m128i v = sse2_blend(clip, int_max, _mm_cvtps_epi32(a));
+        _mm_storeu_si128((__m128i *)(dest + 3 * count - 4), _mm_shuffle_epi8(v, shuffle));
+    };
+
+    return count;
+}
+
+/*------------------------------------------------------------------------------
+** AVX2 kernels.
+*/
+
+#define AVX2_BSWAP16_SHUFFLE                                                                                              \
+    _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+#define AVX2_BSWAP32_SHUFFLE                                                                                              \
+    _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+#define AVX2_LET2I_SHUFFLE                                                                                                \
+    _mm256_setr_epi8(-1, 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1, 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13,   \
+                     14, 15)
+#define AVX2_BET2I_SHUFFLE                                                                                                \
+    _mm256_setr_epi8(-1, 6, 5, 4, -1, 9, 8, 7, -1, 12, 11, 10, -1, 15, 14, 13, -1, 6, 5, 4, -1, 9, 8, 7, -1, 12, 11, 10, -1, 15,   \
+                     14, 13)
+
+static inline SIMD_TARGET("avx2") int avx2_out_of_range(__m256 x)
+{
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_and_ps(x, abs_mask), _mm256_set1_ps(SIMD_INT_LIMIT), _CMP_NLT_UQ));
+}
+
+static inline SIMD_TARGET("avx2") int avx2_has_nan(__m256 x)
+{
+    return _mm256_movemask_ps(_mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+}
+
+/* Loads 8 tribytes, each 128 bit lane gets 4 of them in its top 12 bytes. */
+static inline SIMD_TARGET("avx2") __m256i avx2_load_tribytes(const unsigned char *src)
+{
+    __m128i lo = _mm_loadu_si128((const __m128i *)(src - 4));
+    __m128i hi = _mm_loadu_si128((const __m128i *)(src + 8));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+/* Stores 8 tribytes packed in the top 12 bytes of each 128 bit lane. */
+static inline SIMD_TARGET("avx2") void avx2_store_tribytes(unsigned char *dest, __m256i v)
+{
+    /* The high lane first, the low lane overwrites its 4 leading bytes. */
+    _mm_storeu_si128((__m128i *)(dest + 8), _mm256_extracti128_si256(v, 1));
+    _mm_storeu_si128((__m128i *)(dest - 4), _mm256_castsi256_si128(v));
+}
+
+static inline SIMD_TARGET("avx2") void avx2_s2f_block(__m256i s, float *dest, __m256 scale)
+{
+    __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(s));
+    __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(s, 1));
+
+    _mm256_storeu_ps(dest, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+    _mm256_storeu_ps(dest + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+}
+
+static SIMD_TARGET("avx2") size_t avx2_les2f(const short *src, size_t count, float *dest, float normfact)
+{
+    const __m256 scale = _mm256_set1_ps(normfact);
+
+    while (count >= 16)
+    {
+        count -= 16;
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + count));
+        avx2_s2f_block(s, dest + count, scale);
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_bes2f(const short *src, size_t count, float *dest, float normfact)
+{
+    const __m256 scale = _mm256_set1_ps(normfact);
+    const __m256i bswap = AVX2_BSWAP16_SHUFFLE;
+
+    while (count >= 16)
+    {
+        count -= 16;
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + count));
+        avx2_s2f_block(_mm256_shuffle_epi8(s, bswap), dest + count, scale);
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_lei2f(const int *src, size_t count, float *dest, float normfact)
+{
+    const __m256 scale = _mm256_set1_ps(normfact);
+
+    while (count >= 8)
+    {
+        count -= 8;
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + count));
+        _mm256_storeu_ps(dest + count, _mm256_mul_ps(_mm256_cvtepi32_ps(s), scale));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_bei2f(const int *src, size_t count, float *dest, float normfact)
+{
+    const __m256 scale = _mm256_set1_ps(normfact);
+    const __m256i bswap = AVX2_BSWAP32_SHUFFLE;
+
+    while (count >= 8)
+    {
+        count -= 8;
+        __m256i s = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src + count)), bswap);
+        _mm256_storeu_ps(dest + count, _mm256_mul_ps(_mm256_cvtepi32_ps(s), scale));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_let2i(const unsigned char *src, size_t count, int *dest)
+{
+    const __m256i shuffle = AVX2_LET2I_SHUFFLE;
+
+    while (count >= 10)
+    {
+        count -= 8;
+        __m256i s = _mm256_shuffle_epi8(avx2_load_tribytes(src + 3 * count), shuffle);
+        _mm256_storeu_si256((__m256i *)(dest + count), s);
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_bet2i(const unsigned char *src, size_t count, int *dest)
+{
+    const __m256i shuffle = AVX2_BET2I_SHUFFLE;
+
+    while (count >= 10)
+    {
+        count -= 8;
+        __m256i s = _mm256_shuffle_epi8(avx2_load_tribytes(src + 3 * count), shuffle);
+        _mm256_storeu_si256((__m256i *)(dest + count), s);
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_let2f(const unsigned char *src, size_t count, float *dest, float normfact)
+{
+    const __m256i shuffle = AVX2_LET2I_SHUFFLE;
+    const __m256 scale = _mm256_set1_ps(normfact);
+
+    while (count >= 10)
+    {
+        count -= 8;
+        __m256i s = _mm256_shuffle_epi8(avx2_load_tribytes(src + 3 * count), shuffle);
+        _mm256_storeu_ps(dest + count, _mm256_mul_ps(_mm256_cvtepi32_ps(s), scale));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_bet2f(const unsigned char *src, size_t count, float *dest, float normfact)
+{
+    const __m256i shuffle = AVX2_BET2I_SHUFFLE;
+    const __m256 scale = _mm256_set1_ps(normfact);
+
+    while (count >= 10)
+    {
+        count -= 8;
+        __m256i s = _mm256_shuffle_epi8(avx2_load_tribytes(src + 3 * count), shuffle);
+        _mm256_storeu_ps(dest + count, _mm256_mul_ps(_mm256_cvtepi32_ps(s), scale));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_f2s(const float *src, size_t count, short *dest, float scale)
+{
+    const __m256 vscale = _mm256_set1_ps(scale);
+
+    while (count >= 16)
+    {
+        count -= 16;
+        __m256 a = _mm256_mul_ps(vscale, _mm256_loadu_ps(src + count));
+        __m256 b = _mm256_mul_ps(vscale, _mm256_loadu_ps(src + count + 8));
+
+        if (avx2_out_of_range(a) | avx2_out_of_range(b))
+        {
+            scalar_f2s(src + count, 16, dest + count, scale);
+            continue;
+        };
+
+        __m256i ia = _mm256_srai_epi32(_mm256_slli_epi32(_mm256_cvtps_epi32(a), 16), 16);
+        __m256i ib = _mm256_srai_epi32(_mm256_slli_epi32(_mm256_cvtps_epi32(b), 16), 16);
+        /* Packing works per 128 bit lane, put the quadwords back in order. */
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi32(ia, ib), 0xD8);
+        _mm256_storeu_si256((__m256i *)(dest + count), v);
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_f2s_clip(const float *src, size_t count, short *dest, float scale)
+{
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 pos_limit = _mm256_set1_ps(32767.0f);
+    const __m256 neg_limit = _mm256_set1_ps(-32768.0f);
+
+    while (count >= 16)
+    {
+        count -= 16;
+        __m256 a = _mm256_mul_ps(vscale, _mm256_loadu_ps(src + count));
+        __m256 b = _mm256_mul_ps(vscale, _mm256_loadu_ps(src + count + 8));
+
+        if (avx2_has_nan(a) | avx2_has_nan(b))
+        {
+            scalar_f2s_clip(src + count, 16, dest + count, scale);
+            continue;
+        };
+
+        a = _mm256_min_ps(_mm256_max_ps(a, neg_limit), pos_limit);
+        b = _mm256_min_ps(_mm256_max_ps(b, neg_limit), pos_limit);
+        __m256i v = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        _mm256_storeu_si256((__m256i *)(dest + count), _mm256_permute4x64_epi64(v, 0xD8));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_f2i(const float *src, size_t count, int *dest, float scale)
+{
+    const __m256 vscale = _mm256_set1_ps(scale);
+
+    while (count >= 8)
+    {
+        count -= 8;
+        __m256 a = _mm256_mul_ps(vscale, _mm256_loadu_ps(src + count));
+
+        if (avx2_out_of_range(a))
+        {
+            scalar_f2i(src + count, 8, dest + count, scale);
+            continue;
+        };
+
+        _mm256_storeu_si256((__m256i *)(dest + count), _mm256_cvtps_epi32(a));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_f2i_clip(const float *src, size_t count, int *dest, float scale)
+{
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 pos_limit = _mm256_set1_ps(SIMD_INT_LIMIT);
+    const __m256i int_max = _mm256_set1_epi32(INT_MAX);
+
+    while (count >= 8)
+    {
+        count -= 8;
+        __m256 a = _mm256_mul_ps(vscale, _mm256_loadu_ps(src + count));
+
+        if (avx2_has_nan(a))
+        {
+            scalar_f2i_clip(src + count, 8, dest + count, scale);
+            continue;
+        };
+
+        __m256i clip = _mm256_castps_si256(_mm256_cmp_ps(a, pos_limit, _CMP_GE_OQ));
+        _mm256_storeu_si256((__m256i *)(dest + count), _mm256_blendv_epi8(_mm256_cvtps_epi32(a), int_max, clip));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_f2let(const float *src, unsigned char *dest, size_t count, float normfact)
+{
+    const __m256i shuffle = _mm256_setr_epi8(-1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, 0, 1, 2, 4, 5,
+                                             6, 8, 9, 10, 12, 13, 14);
+    const __m256 scale = _mm256_set1_ps(normfact);
+
+    while (count >= 10)
+    {
+        count -= 8;
+        __m256 a = _mm256_mul_ps(_mm256_loadu_ps(src + count), scale);
+
+        if (avx2_out_of_range(a))
+        {
+            scalar_f2let(src + count, dest + 3 * count, 8, normfact);
+            continue;
+        };
+
+        avx2_store_tribytes(dest + 3 * count, _mm256_shuffle_epi8(_mm256_cvtps_epi32(a), shuffle));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_f2let_clip(const float *src, unsigned char *dest, size_t count, float normfact)
+{
+    const __m256i shuffle = _mm256_setr_epi8(-1, -1, -1, -1, 1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1, 1, 2, 3, 5,
+                                             6, 7, 9, 10, 11, 13, 14, 15);
+    const __m256 scale = _mm256_set1_ps(normfact);
+    const __m256 pos_limit = _mm256_set1_ps(SIMD_INT_LIMIT);
+    const __m256i int_max = _mm256_set1_epi32(INT_MAX);
+
+    while (count >= 10)
+    {
+        count -= 8;
+        __m256 a = _mm256_mul_ps(_mm256_loadu_ps(src + count), scale);
+
+        if (avx2_has_nan(a))
+        {
+            scalar_f2let_clip(src + count, dest + 3 * count, 8, normfact);
+            continue;
+        };
+
+        __m256i clip = _mm256_castps_si256(_mm256_cmp_ps(a, pos_limit, _CMP_GE_OQ));
+        __m256i v = _mm256_blendv_epi8(_mm256_cvtps_epi32(a), int_max, clip);
+        avx2_store_tribytes(dest + 3 * count, _mm256_shuffle_epi8(v, shuffle));
+    };
+
+    return count;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_stats(const double *src, size_t frames, int channels, SIMD_SIGNAL_STATS *stats)
+{
+    const size_t period = stats_period(channels, 4);
+    if (period == 0 || frames == 0)
+        return frames;
+
+    const size_t count = frames * channels;
+    const size_t tail = (count - channels) / period * period;
+    if (tail == 0)
+        return frames;
+
+    const size_t vectors = period / 4;
+    const __m256d sign_mask = _mm256_set1_pd(-0.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d zero = _mm256_setzero_pd();
+
+    __m256d peak[SIMD_STATS_MAX_LANES / 4], sum[SIMD_STATS_MAX_LANES / 4], sum_sq[SIMD_STATS_MAX_LANES / 4];
+    __m256i clips[SIMD_STATS_MAX_LANES / 4], crossings[SIMD_STATS_MAX_LANES / 4];
+
+    for (size_t v = 0; v < vectors; v++)
+    {
+        peak[v] = sum[v] = sum_sq[v] = zero;
+        clips[v] = crossings[v] = _mm256_setzero_si256();
+    };
+
+    for (const double *ptr = src + count - tail; ptr < src + count; ptr += period)
+    {
+        for (size_t v = 0; v < vectors; v++)
+        {
+            __m256d x = _mm256_loadu_pd(ptr + 4 * v);
+            __m256d prev = _mm256_loadu_pd(ptr + 4 * v - channels);
+            __m256d ax = _mm256_andnot_pd(sign_mask, x);
+            __m256d crossed = _mm256_xor_pd(_mm256_cmp_pd(x, zero, _CMP_LT_OQ), _mm256_cmp_pd(prev, zero, _CMP_LT_OQ));
+
+            peak[v] = _mm256_max_pd(ax, peak[v]);
+            sum[v] = _mm256_add_pd(sum[v], x);
+            sum_sq[v] = _mm256_add_pd(sum_sq[v], _mm256_mul_pd(x, x));
+            clips[v] = _mm256_sub_epi64(clips[v], _mm256_castpd_si256(_mm256_cmp_pd(ax, one, _CMP_GE_OQ)));
+            crossings[v] = _mm256_sub_epi64(crossings[v], _mm256_castpd_si256(crossed));
+        };
+    };
+
+    double lane_peak[SIMD_STATS_MAX_LANES], lane_sum[SIMD_STATS_MAX_LANES], lane_sum_sq[SIMD_STATS_MAX_LANES];
+    int64_t lane_clips[SIMD_STATS_MAX_LANES], lane_crossings[SIMD_STATS_MAX_LANES];
+
+    for (size_t v = 0; v < vectors; v++)
+    {
+        _mm256_storeu_pd(lane_peak + 4 * v, peak[v]);
+        _mm256_storeu_pd(lane_sum + 4 * v, sum[v]);
+        _mm256_storeu_pd(lane_sum_sq + 4 * v, sum_sq[v]);
+        _mm256_storeu_si256((__m256i *)(lane_clips + 4 * v), clips[v]);
+        _mm256_storeu_si256((__m256i *)(lane_crossings + 4 * v), crossings[v]);
+    };
+
+    stats_reduce(lane_peak, lane_sum, lane_sum_sq, lane_clips, lane_crossings, period, channels, stats);
+
+    return frames - tail / channels;
+}
+
+static SIMD_TARGET("avx2") size_t avx2_alac_unmix(const int32_t *u, const int32_t *v, int32_t *out, size_t frames,
+                                                  int mixbits, int mixres, const uint16_t *shift_uv, int bytes_shifted,
+                                                  int out_shift)
+{
+    const __m256i res = _mm256_set1_epi32(mixres);
+    const __m128i bits = _mm_cvtsi32_si128(mixbits);
+    const __m128i shift = _mm_cvtsi32_si128(8 * bytes_shifted);
+    const __m128i left = _mm_cvtsi32_si128(out_shift);
+
+    if (mixbits < 0 || mixbits > 31)
+        return frames;
+
+    while (frames >= 8)
+    {
+        frames -= 8;
+        __m256i l = _mm256_loadu_si256((const __m256i *)(u + frames));
+        __m256i r = _mm256_loadu_si256((const __m256i *)(v + frames));
+
+        if (mixres != 0)
+        {
+            l = _mm256_sub_epi32(_mm256_add_epi32(l, r), _mm256_sra_epi32(_mm256_mullo_epi32(res, r), bits));
+            r = _mm256_sub_epi32(l, r);
+        };
+
+        /* Unpacking works within 128 bit lanes, the permutes put the frames back in order. */
+        __m256i a = _mm256_unpacklo_epi32(l, r);
+        __m256i b = _mm256_unpackhi_epi32(l, r);
+        __m256i lo = _mm256_permute2x128_si256(a, b, 0x20);
+        __m256i hi = _mm256_permute2x128_si256(a, b, 0x31);
+
+        if (shift_uv != NULL)
+        {
+            __m256i s = _mm256_loadu_si256((const __m256i *)(shift_uv + 2 * frames));
+            lo = _mm256_or_si256(_mm256_sll_epi32(lo, shift), _mm256_cvtepu16_epi32(_mm256_castsi256_si128(s)));
+            hi = _mm256_or_si256(_mm256_sll_epi32(hi, shift), _mm256_cvtepu16_epi32(_mm256_extracti128_si256(s, 1)));
+        };
+
+        _mm256_storeu_si256((__m256i *)(out + 2 * frames), _mm256_sll_epi32(lo, left));
+        _mm256_storeu_si256((__m256i *)(out + 2 * frames + 8), _mm256_sll_epi32(hi, left));
+    };
+
+    return frames;
+}
+
+static SIMD_TARGET("avx2") bool avx2_gsm_autocorr(const float *s, int32_t *acf)
+{
+    for (int k = 0; k <= 8; k++)
+    {
+        __m256i sum = _mm256_setzero_si256();
+        int i = k;
+
+        for (; i + 8 <= 160; i += 8)
+        {
+            __m256 prod = _mm256_mul_ps(_mm256_loadu_ps(s + i), _mm256_loadu_ps(s + i - k));
+            sum = _mm256_add_epi32(sum, _mm256_cvttps_epi32(prod));
+        };
+
+        int32_t total = sse2_hsum_epi32(_mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)));
+        for (; i < 160; i++)
+            total = (int32_t)((uint32_t)total + (uint32_t)(int32_t)(s[i] * s[i - k]));
+
+        acf[k] = total;
+    };
+
+    return true;
+}
+
+static SIMD_TARGET("avx2") bool avx2_gsm_ltp_xcorr(const float *wt, const float *dp, float *corr)
+{
+    const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+    for (int lambda = 40; lambda + 7 < 120; lambda += 8)
+    {
+        const float *lp = dp - lambda - 7;
+        __m256 sum = _mm256_setzero_ps();
+
+        for (int k = 0; k < 40; k++)
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(wt[k]), _mm256_loadu_ps(lp + k)));
+
+        _mm256_storeu_ps(corr + lambda - 40, _mm256_permutevar8x32_ps(sum, reverse));
+    };
+
+    corr[80] = scalar_gsm_xcorr(wt, dp - 120);
+
+    return true;
+}
+
+#if SIMD_CLIP_KERNELS
+#define SSE2_F2S_CLIP sse2_f2s_clip
+#define SSE2_F2I_CLIP sse2_f2i_clip
+#define SSSE3_F2LET_CLIP ssse3_f2let_clip
+#define AVX2_F2S_CLIP avx2_f2s_clip
+#define AVX2_F2I_CLIP avx2_f2i_clip
+#define AVX2_F2LET_CLIP avx2_f2let_clip
+#else
+#define SSE2_F2S_CLIP none_f2s
+#define SSE2_F2I_CLIP none_f2i
+#define SSSE3_F2LET_CLIP none_f2t
+#define AVX2_F2S_CLIP none_f2s
+#define AVX2_F2I_CLIP none_f2i
+#define AVX2_F2LET_CLIP none_f2t
+#endif
+
+static const SIMD_KERNELS sse2_kernels = {
+    SIMD_ISA_SSE2, "sse2",
+    sse2_les2f, sse2_bes2f, sse2_lei2f, sse2_bei2f, none_t2f, none_t2f, none_t2i, none_t2i,
+    sse2_f2s, SSE2_F2S_CLIP, sse2_f2i, SSE2_F2I_CLIP,
+    none_f2t, none_f2t,
+    sse2_stats,
+    sse2_pi2s, sse2_pi2i, sse2_pi2f,
+    sse2_alac_unmix,
+    sse2_gsm_autocorr, sse2_gsm_ltp_xcorr, sse2_gsm_weighting, sse2_gsm_grid_energy, sse2_gsm_ltp_synth,
+};
+
+static const SIMD_KERNELS ssse3_kernels = {
+    SIMD_ISA_SSSE3, "ssse3",
+    sse2_les2f, sse2_bes2f, sse2_lei2f, sse2_bei2f, ssse3_let2f, ssse3_bet2f, ssse3_let2i, ssse3_bet2i,
+    sse2_f2s, SSE2_F2S_CLIP, sse2_f2i, SSE2_F2I_CLIP,
+    ssse3_f2let, SSSE3_F2LET_CLIP,
+    sse2_stats,
+    sse2_pi2s, sse2_pi2i, sse2_pi2f,
+    sse2_alac_unmix,
+    sse2_gsm_autocorr, sse2_gsm_ltp_xcorr, sse2_gsm_weighting, sse2_gsm_grid_energy, sse2_gsm_ltp_synth,
+};
+
+static const SIMD_KERNELS avx2_kernels = {
+    SIMD_ISA_AVX2, "avx2",
+    avx2_les2f, avx2_bes2f, avx2_lei2f, avx2_bei2f, avx2_let2f, avx2_bet2f, avx2_let2i, avx2_bet2i,
+    avx2_f2s, AVX2_F2S_CLIP, avx2_f2i, AVX2_F2I_CLIP,
+    avx2_f2let, AVX2_F2LET_CLIP,
+    avx2_stats,
+    sse2_pi2s, sse2_pi2i, sse2_pi2f,
+    avx2_alac_unmix,
+    avx2_gsm_autocorr, avx2_gsm_ltp_xcorr, sse2_gsm_weighting, sse2_gsm_grid_energy, sse2_gsm_ltp_synth,
+};
+
+static bool cpu_supports(SIMD_ISA isa)
+{
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+
+    switch (isa)
+    {
+    case SIMD_ISA_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case SIMD_ISA_SSSE3:
+        return __builtin_cpu_supports("ssse3");
+    case SIMD_ISA_AVX2:
+        return __builtin_cpu_supports("avx2");
+    default:
+        return false;
+    };
+#else
+    int info[4];
+
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+
+    __cpuid(info, 1);
+    switch (isa)
+    {
+    case SIMD_ISA_SSE2:
+        return (info[3] & (1 << 26)) != 0;
+    case SIMD_ISA_SSSE3:
+        return (info[2] & (1 << 9)) != 0;
+    case SIMD_ISA_AVX2:
+        /* The OS must save the YMM registers too. */
+        if (max_leaf < 7 || !(info[2] & (1 << 27)) || (_xgetbv(0) & 6) != 6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    default:
+        return false;
+    };
+#endif
+}
+
+#endif /* SIMD_HAVE_X86 */
+
+const SIMD_KERNELS *psf_simd_kernels_for(SIMD_ISA isa)
+{
+    switch (isa)
+    {
+    case SIMD_ISA_NONE:
+        return &none_kernels;
+
+#ifdef SIMD_HAVE_X86
+    case SIMD_ISA_SSE2:
+        return cpu_supports(SIMD_ISA_SSE2) ? &sse2_kernels : NULL;
+    case SIMD_ISA_SSSE3:
+        return cpu_supports(SIMD_ISA_SSSE3) ? &ssse3_kernels : NULL;
+    case SIMD_ISA_AVX2:
+        return cpu_supports(SIMD_ISA_AVX2) ? &avx2_kernels : NULL;
+#endif
+
+    /* No NEON kernels yet, ARM builds use the scalar code. */
+    default:
+        return NULL;
+    };
+}
+
+static const SIMD_KERNELS *select_kernels(void)
+{
+    static const SIMD_ISA preferred[] = {SIMD_ISA_AVX2, SIMD_ISA_SSSE3, SIMD_ISA_SSE2, SIMD_ISA_NEON};
+
+    for (size_t k = 0; k < sizeof(preferred) / sizeof(preferred[0]); k++)
+    {
+        const SIMD_KERNELS *kernels = psf_simd_kernels_for(preferred[k]);
+        if (kernels)
+            return kernels;
+    };
+
+    return &none_kernels;
+}
+
+const SIMD_KERNELS *psf_simd_kernels(void)
+{
+    static const SIMD_KERNELS *kernels = select_kernels();
+
+    return kernels;
+}
+
+/* The bundled ALAC decoder is C, it reaches the kernels through this. */
+int32_t unmix_simd(const int32_t *u, const int32_t *v, int32_t *out, uint32_t stride, int32_t numSamples,
+                   int32_t mixbits, int32_t mixres, const uint16_t *shiftUV, int32_t bytesShifted, int32_t outShift)
+{
+    if (stride != 2 || numSamples <= 0)
+        return numSamples;
+
+    return (int32_t)psf_simd_kernels()->alac_unmix(u, v, out, (size_t)numSamples, mixbits, mixres, shiftUV,
+                                                   bytesShifted, outShift);
+}
+
+/*
+** And so is the bundled GSM 6.10 codec. Its float loops round every operation
+** to single precision only when FLT_EVAL_METHOD is 0, with x87 arithmetic the
+** kernels wouldn't match them.
+*/
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+#define GSM_SIMD_FLOAT 1
+#else
+#define GSM_SIMD_FLOAT 0
+#endif
+
+int gsm_simd_autocorrelation(const float *s, int32_t *L_ACF)
+{
+    return GSM_SIMD_FLOAT && psf_simd_kernels()->gsm_autocorr(s, L_ACF);
+}
+
+int gsm_simd_ltp_correlation(const float *wt, const float *dp, float *L_corr)
+{
+    return GSM_SIMD_FLOAT && psf_simd_kernels()->gsm_ltp_xcorr(wt, dp, L_corr);
+}
+
+int gsm_simd_weighting_filter(const int16_t *e, int16_t *x)
+{
+    return psf_simd_kernels()->gsm_weighting(e, x);
+}
+
+int gsm_simd_grid_energy(const int16_t *x, int32_t *L_energy)
+{
+    return psf_simd_kernels()->gsm_grid_energy(x, L_energy);
+}
+
+int gsm_simd_ltp_synthesis(int16_t brp, const int16_t *lagged, const int16_t *erp, int16_t *drp)
+{
+    return psf_simd_kernels()->gsm_ltp_synth(brp, lagged, erp, drp);
+}
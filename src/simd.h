@@ -0,0 +1,148 @@
+/*
+** Copyright (C) 2026 agent <agent@local>
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation; either version 2.1 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+/*------------------------------------------------------------------------------------
+** Vectorised sample conversion kernels.
+**
+** Every kernel converts the tail of the array and returns the number of items
+** at the head which are left for the scalar code. Results are bit exact with
+** the scalar loops in pcm.cpp and float32.cpp.
+**
+** Kernels work from the end of the array to the start and load each block
+** before storing it, so the widening kernels (les2f, let2f, let2i, ...) may be
+** used in place with the source data at the start of the destination buffer,
+** just like their scalar counterparts.
+**
+** Tribyte values are unpacked the way psf_get_le24() and psf_get_be24() do
+** it, ie. into the top 24 bits of an int.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum SIMD_ISA
+{
+    SIMD_ISA_NONE = 0,
+    SIMD_ISA_SSE2,
+    SIMD_ISA_SSSE3,
+    SIMD_ISA_AVX2,
+    SIMD_ISA_NEON
+};
+
+/* Running statistics of one channel, see the stats kernel. */
+struct SIMD_SIGNAL_STATS
+{
+    double peak;
+    double sum;
+    double sum_sq;
+    int64_t clips;
+    int64_t crossings;
+};
+
+struct SIMD_KERNELS
+{
+    SIMD_ISA isa;
+    const char *name;
+
+    size_t (*les2f)(const short *src, size_t count, float *dest, float normfact);
+    size_t (*bes2f)(const short *src, size_t count, float *dest, float normfact);
+    size_t (*lei2f)(const int *src, size_t count, float *dest, float normfact);
+    size_t (*bei2f)(const int *src, size_t count, float *dest, float normfact);
+    size_t (*let2f)(const unsigned char *src, size_t count, float *dest, float normfact);
+    size_t (*bet2f)(const unsigned char *src, size_t count, float *dest, float normfact);
+    size_t (*let2i)(const unsigned char *src, size_t count, int *dest);
+    size_t (*bet2i)(const unsigned char *src, size_t count, int *dest);
+
+    /* Host endian floats to short and int, as in float32.cpp. */
+    size_t (*f2s)(const float *src, size_t count, short *dest, float scale);
+    size_t (*f2s_clip)(const float *src, size_t count, short *dest, float scale);
+    size_t (*f2i)(const float *src, size_t count, int *dest, float scale);
+    size_t (*f2i_clip)(const float *src, size_t count, int *dest, float scale);
+
+    /* Floats to little endian tribytes, as in pcm.cpp. */
+    size_t (*f2let)(const float *src, unsigned char *dest, size_t count, float normfact);
+    size_t (*f2let_clip)(const float *src, unsigned char *dest, size_t count, float normfact);
+
+    /*
+    ** Adds the interleaved frames to the per channel statistics in stats. A
+    ** sample is clipped when its magnitude is 1.0 or more and a zero crossing
+    ** is a change of sign from the previous frame. Returns the number of frames
+    ** at the head left for the scalar code, at least one because the first
+    ** frame must be compared with the end of the previous block. The sums may
+    ** differ from a scalar loop in the last bits as they are added in another
+    ** order.
+    */
+    size_t (*stats)(const double *src, size_t frames, int channels, SIMD_SIGNAL_STATS *stats);
+
+    /*
+    ** Planar 32 bit ints, one array per channel as libFLAC decodes them, to
+    ** interleaved samples, as in flac.cpp. Counts are in frames. pi2s shifts
+    ** left by shift when it is positive and right by -shift otherwise and
+    ** keeps the low 16 bits, pi2i shifts left. Only mono and stereo are
+    ** vectorised, other channel counts are left to the scalar code.
+    */
+    size_t (*pi2s)(const int32_t *const *src, size_t frames, int channels, short *dest, int shift);
+    size_t (*pi2i)(const int32_t *const *src, size_t frames, int channels, int *dest, int shift);
+    size_t (*pi2f)(const int32_t *const *src, size_t frames, int channels, float *dest, float normfact);
+
+    /*
+    ** ALAC stereo unmix into interleaved stereo, as unmix16(), unmix20(),
+    ** unmix24() and unmix32() in ALAC/matrix_dec.c do it for a stride of 2.
+    ** When mixres isn't 0 the u and v channels are unmatrixed. The samples are
+    ** then shifted left by 8 * bytes_shifted and or-ed with the interleaved
+    ** values in shift_uv, unless it is NULL, and finally shifted left by
+    ** out_shift. Counts are in frames.
+    */
+    size_t (*alac_unmix)(const int32_t *u, const int32_t *v, int32_t *out, size_t frames, int mixbits, int mixres,
+                         const uint16_t *shift_uv, int bytes_shifted, int out_shift);
+
+    /*
+    ** GSM 6.10 loops, as in the GSM610 directory. They work on a whole frame or
+    ** subframe and return false when the scalar code has to do it instead.
+    **
+    ** gsm_autocorr adds up the truncated float products of Autocorrelation()
+    ** for the 9 lags of 160 samples. gsm_ltp_xcorr gives the float cross
+    ** correlations of Calculation_of_the_LTP_parameters() for lags 40 to 120,
+    ** dp points past the end of the 120 previous samples. Each lag is summed in
+    ** the same order as the scalar code so the results are bit exact.
+    **
+    ** gsm_weighting is Weighting_filter() for e[-5..44]. gsm_grid_energy gives
+    ** the energy of each of the 4 RPE grids, before the doubling. gsm_ltp_synth
+    ** is the loop of Gsm_Long_Term_Synthesis_Filtering(), lagged must not
+    ** overlap the 40 output samples and brp must not be -32768.
+    */
+    bool (*gsm_autocorr)(const float *s, int32_t *acf);
+    bool (*gsm_ltp_xcorr)(const float *wt, const float *dp, float *corr);
+    bool (*gsm_weighting)(const int16_t *e, int16_t *x);
+    bool (*gsm_grid_energy)(const int16_t *x, int32_t *energy);
+    bool (*gsm_ltp_synth)(int16_t brp, const int16_t *lagged, const int16_t *erp, int16_t *drp);
+};
+
+/*
+** Returns the best kernels for the running CPU. They are selected on the first
+** call, the result never changes afterwards.
+*/
+const SIMD_KERNELS *psf_simd_kernels(void);
+
+/*
+** Returns the kernels for a specific instruction set or NULL if they are not
+** compiled in or not supported by the running CPU. Used for testing.
+*/
+const SIMD_KERNELS *psf_simd_kernels_for(SIMD_ISA isa);
@@ -33,6 +33,10 @@
 
 #include <algorithm>
 #include <memory>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 #ifdef __APPLE__
 /*
@@ -265,6 +269,10 @@ static ErrorStruct SndfileErrors[] = {
 
     {SFE_ALREADY_INITIALIZED, "Error : Already initialized." },
 
+    {SFE_FRAMES_BORROWED, "Error : Borrowed frames must be released before borrowing again."},
+    {SFE_BAD_RELEASE, "Error : Pointer passed to sf_release_frames() was not borrowed."},
+    {SFE_NOT_CLONEABLE, "Error : Only files opened for reading with sf_open() can be cloned."},
+
     {SFE_MAX_ERROR, "Maximum error number."},
     {SFE_MAX_ERROR + 1, NULL}};
 
@@ -291,6 +299,10 @@ static char sf_syserr[SF_SYSERR_LEN] = {0};
 
 int sf_open(const char *path, SF_FILEMODE mode, SF_INFO *sfinfo, SNDFILE **sndfile)
 {
+    // Open flags only matter to the stream, see psf_open_file_stream()
+    SF_FILEMODE stream_mode = mode;
+    mode = (SF_FILEMODE)(mode & ~SFM_MMAP);
+
     // Input parameters check
 
     if (mode != SFM_READ && mode != SFM_WRITE && mode != SFM_RDWR)
@@ -340,7 +352,7 @@ int sf_open(const char *path, SF_FILEMODE mode, SF_INFO *sfinfo, SNDFILE **sndfi
         psf = new SndFile();
 
         sf::ref_ptr<SF_STREAM> stream;
-        int error = psf_open_file_stream(path, mode, stream.get_address_of());
+        int error = psf_open_file_stream(path, stream_mode, stream.get_address_of());
         if (error != SFE_NO_ERROR)
             throw sf::sndfile_error(error);
 
@@ -792,6 +804,19 @@ int sf_open_stream(SF_STREAM *stream, SF_FILEMODE mode, SF_INFO *sfinfo, SNDFILE
     };
 } /* sf_open_virtual */
 
+int sf_create_buffered_stream(SF_STREAM *stream, size_t buffer_size, SF_STREAM **buffered)
+{
+    return psf_open_buffered_stream(stream, buffer_size, buffered);
+}
+
+int sf_clone(SNDFILE *sndfile, SNDFILE **clone)
+{
+    if (!sndfile)
+        return SFE_BAD_SNDFILE_PTR;
+
+    return sndfile->clone(clone);
+}
+
 int sf_close(SNDFILE *sndfile)
 {
     if (!sndfile)
@@ -1399,6 +1424,233 @@ sf_count_t sf_readf_double(SNDFILE *sndfile, double *ptr, sf_count_t frames)
     return sndfile->readDoubleFrames(ptr, frames);
 }
 
+sf_count_t sf_borrow_frames(SNDFILE *sndfile, const void **ptr, sf_count_t frames)
+{
+    if (!sndfile)
+        return 0;
+
+    return sndfile->borrowFrames(ptr, frames);
+}
+
+int sf_release_frames(SNDFILE *sndfile, const void *ptr)
+{
+    if (!sndfile)
+        return SFE_BAD_SNDFILE_PTR;
+
+    return sndfile->releaseFrames(ptr);
+}
+
+sf_count_t sf_readf_short_planar(SNDFILE *sndfile, short *const *ptr, sf_count_t frames)
+{
+    if (!sndfile)
+        return 0;
+
+    return sndfile->readShortPlanar(ptr, frames);
+}
+
+sf_count_t sf_readf_int_planar(SNDFILE *sndfile, int *const *ptr, sf_count_t frames)
+{
+    if (!sndfile)
+        return 0;
+
+    return sndfile->readIntPlanar(ptr, frames);
+}
+
+sf_count_t sf_readf_float_planar(SNDFILE *sndfile, float *const *ptr, sf_count_t frames)
+{
+    if (!sndfile)
+        return 0;
+
+    return sndfile->readFloatPlanar(ptr, frames);
+}
+
+sf_count_t sf_readf_double_planar(SNDFILE *sndfile, double *const *ptr, sf_count_t frames)
+{
+    if (!sndfile)
+        return 0;
+
+    return sndfile->readDoublePlanar(ptr, frames);
+}
+
+sf_count_t sf_writef_short_planar(SNDFILE *sndfile, const short *const *ptr, sf_count_t frames)
+{
+    if (!sndfile)
+        return 0;
+
+    return sndfile->writeShortPlanar(ptr, frames);
+}
+
+sf_count_t sf_writef_int_planar(SNDFILE *sndfile, const int *const *ptr, sf_count_t frames)
+{
+    if (!sndfile)
+        return 0;
+
+    return sndfile->writeIntPlanar(ptr, frames);
+}
+
+sf_count_t sf_writef_float_planar(SNDFILE *sndfile, const float *const *ptr, sf_count_t frames)
+{
+    if (!sndfile)
+        return 0;
+
+    return sndfile->writeFloatPlanar(ptr, frames);
+}
+
+sf_count_t sf_writef_double_planar(SNDFILE *sndfile, const double *const *ptr, sf_count_t frames)
+{
+    if (!sndfile)
+        return 0;
+
+    return sndfile->writeDoublePlanar(ptr, frames);
+}
+
+/* Parts smaller than this are not worth a thread of their own. */
+#define PARALLEL_READ_MIN_FRAMES (1 << 16)
+#define PARALLEL_READ_MAX_THREADS (64)
+
+struct PARALLEL_READ_PART
+{
+    SNDFILE *file;
+    sf_count_t start;
+    sf_count_t frames;
+    sf_count_t read;
+    int error;
+};
+
+/*
+** Splits the frames from the current position into contiguous parts. The
+** first is read by sndfile itself, the others by clones which seek to the
+** start of their part first.
+*/
+template <typename T>
+static sf_count_t read_frames_parallel(SNDFILE *sndfile, T *ptr, sf_count_t frames, int threads,
+                                       sf_count_t (*readf)(SNDFILE *, T *, sf_count_t))
+{
+    if (!sndfile)
+        return 0;
+
+    SndFile *psf = static_cast<SndFile *>(sndfile);
+
+    if (frames <= 0 || psf->m_mode != SFM_READ || !psf->sf.seekable)
+        return readf(sndfile, ptr, frames);
+
+    sf_count_t position = sf_seek(sndfile, 0, SEEK_CUR);
+    if (position < 0)
+        return readf(sndfile, ptr, frames);
+
+    frames = std::min(frames, std::max(psf->sf.frames - position, (sf_count_t)0));
+
+    if (threads <= 0)
+        threads = (int)std::thread::hardware_concurrency();
+    threads = std::min(threads, PARALLEL_READ_MAX_THREADS);
+
+    int count = (int)std::min(frames / PARALLEL_READ_MIN_FRAMES, (sf_count_t)threads);
+    if (count < 2 || psf_seeks_by_decoding(psf))
+        return readf(sndfile, ptr, frames);
+
+    std::vector<PARALLEL_READ_PART> parts;
+    std::vector<std::thread> workers;
+    try
+    {
+        parts.resize(count);
+        workers.reserve(count);
+    }
+    catch (const std::bad_alloc &)
+    {
+        psf->m_error = SFE_MALLOC_FAILED;
+        return 0;
+    };
+
+    for (int k = 0; k < count; k++)
+    {
+        PARALLEL_READ_PART &part = parts[k];
+
+        part.start = position + frames * k / count;
+        part.frames = position + frames * (k + 1) / count - part.start;
+        part.read = 0;
+        part.error = SFE_NO_ERROR;
+        part.file = sndfile;
+
+        if (k > 0 && sf_clone(sndfile, &part.file) != SFE_NO_ERROR)
+        {
+            /* Not opened with sf_open(), read it all through this handle instead. */
+            for (int j = 1; j < k; j++)
+                sf_close(parts[j].file);
+            return readf(sndfile, ptr, frames);
+        };
+    };
+
+    const int channels = psf->sf.channels;
+    auto read_part = [=](PARALLEL_READ_PART *part) {
+        if (part->file != sndfile && sf_seek(part->file, part->start, SEEK_SET) != part->start)
+        {
+            part->error = sf_error(part->file);
+            return;
+        };
+
+        part->read = readf(part->file, ptr + (part->start - position) * channels, part->frames);
+        part->error = sf_error(part->file);
+    };
+
+    for (int k = 1; k < count; k++)
+    {
+        try
+        {
+            workers.emplace_back(read_part, &parts[k]);
+        }
+        catch (const std::system_error &)
+        {
+            read_part(&parts[k]);
+        };
+    };
+
+    read_part(&parts[0]);
+
+    for (auto &worker : workers)
+        worker.join();
+
+    /* The frames read end at the first part that came up short. */
+    sf_count_t total = 0;
+    int error = SFE_NO_ERROR;
+    for (auto &part : parts)
+    {
+        total += part.read;
+        if (part.read != part.frames)
+        {
+            error = part.error;
+            break;
+        };
+    };
+
+    for (int k = 1; k < count; k++)
+        sf_close(parts[k].file);
+
+    sf_seek(sndfile, position + total, SEEK_SET);
+    psf->m_error = error;
+
+    return total;
+}
+
+sf_count_t sf_readf_short_parallel(SNDFILE *sndfile, short *ptr, sf_count_t frames, int threads)
+{
+    return read_frames_parallel(sndfile, ptr, frames, threads, sf_readf_short);
+}
+
+sf_count_t sf_readf_int_parallel(SNDFILE *sndfile, int *ptr, sf_count_t frames, int threads)
+{
+    return read_frames_parallel(sndfile, ptr, frames, threads, sf_readf_int);
+}
+
+sf_count_t sf_readf_float_parallel(SNDFILE *sndfile, float *ptr, sf_count_t frames, int threads)
+{
+    return read_frames_parallel(sndfile, ptr, frames, threads, sf_readf_float);
+}
+
+sf_count_t sf_readf_double_parallel(SNDFILE *sndfile, double *ptr, sf_count_t frames, int threads)
+{
+    return read_frames_parallel(sndfile, ptr, frames, threads, sf_readf_double);
+}
+
 sf_count_t sf_write_raw(SNDFILE *sndfile, const void *ptr, sf_count_t len)
 {
     if (!sndfile)
@@ -2077,6 +2329,11 @@ int SndFile::command(int command, void *data, int datasize)
             return (m_error = SFE_BAD_COMMAND_PARAM);
         return psf_calc_max_all_channels(this, (double *)data, SF_TRUE);
 
+    case SFC_CALC_SIGNAL_STATS:
+        if (data == NULL || datasize != SIGNED_SIZEOF(SF_SIGNAL_STATS) * sf.channels)
+            return (m_error = SFE_BAD_COMMAND_PARAM);
+        return psf_calc_signal_stats(this, (SF_SIGNAL_STATS *)data);
+
     case SFC_GET_SIGNAL_MAX:
         if (data == NULL || datasize != sizeof(double))
         {
@@ -2341,6 +2598,50 @@ int SndFile::command(int command, void *data, int datasize)
         quality = 1.0 - (std::max)(0.0, (std::min)(1.0, quality));
         return this->command(SFC_SET_COMPRESSION_LEVEL, &quality, sizeof(quality));
 
+    case SFC_SET_IO_BLOCK_SIZE:
+    {
+        if (data == NULL || datasize != sizeof(sf_count_t))
+            return (m_error = SFE_BAD_COMMAND_PARAM);
+
+        sf_count_t block_size = *((sf_count_t *)data);
+        if (block_size < SF_MIN_IO_BLOCK_SIZE || block_size > SF_MAX_IO_BLOCK_SIZE)
+            return (m_error = SFE_BAD_COMMAND_PARAM);
+
+        /*
+        ** Allocate the buffer here, where a failure can be reported, rather than
+        ** in the read and write paths. The old buffer is kept if it fails.
+        */
+        std::vector<double> buffer;
+        try
+        {
+            buffer.resize(((size_t)block_size & ~(sizeof(double) - 1)) / sizeof(double));
+        }
+        catch (const std::bad_alloc &)
+        {
+            return (m_error = SFE_MALLOC_FAILED);
+        };
+
+        m_io_block_size = buffer.size() * sizeof(double);
+        m_io_buffer.swap(buffer);
+        break;
+    }
+
+    case SFC_BUILD_SEEK_INDEX:
+    case SFC_GET_SEEK_INDEX:
+    case SFC_SET_SEEK_INDEX:
+        if (datasize < 0)
+        {
+            m_error = SFE_BAD_COMMAND_PARAM;
+            return SF_FALSE;
+        };
+        return (int)psf_checkpoints_command(this, command, data, datasize);
+
+    case SFC_GET_IO_BLOCK_SIZE:
+        if (data == NULL || datasize != sizeof(sf_count_t))
+            return (m_error = SFE_BAD_COMMAND_PARAM);
+        *((sf_count_t *)data) = m_io_block_size;
+        break;
+
     default:
         /* Must be a file specific command. Pass it on. */
         if (on_command)
@@ -3437,6 +3738,363 @@ sf_count_t SndFile::writeDoubleFrames(const double *ptr, sf_count_t frames)
     return count / sf.channels;
 }
 
+/*
+** The clone parses the header again from its own view of the stream. Nothing
+** is written to this handle, it may be in use on another thread, so errors are
+** only returned.
+*/
+int SndFile::clone(ISndFile **clone)
+{
+    if (!clone)
+        return SFE_BAD_FILE_PTR;
+
+    *clone = nullptr;
+
+    if (m_mode != SFM_READ)
+        return SFE_NOT_READMODE;
+
+    sf::ref_ptr<SF_STREAM> view;
+    int error = psf_open_stream_view(m_stream.get(), view.get_address_of());
+    if (error != SFE_NO_ERROR)
+        return error;
+
+    /* RAW files need the format, it is ignored for everything else. */
+    SF_INFO sfinfo = sf;
+    SNDFILE *sndfile = nullptr;
+    error = sf_open_stream(view.get(), SFM_READ, &sfinfo, &sndfile);
+    if (error != SFE_NO_ERROR)
+        return error;
+
+    /* Carry over the settings that affect reading. */
+    SndFile *psf = static_cast<SndFile *>(sndfile);
+    strcpy(psf->m_path, m_path);
+    psf->m_norm_float = m_norm_float;
+    psf->m_norm_double = m_norm_double;
+    psf->m_float_int_mult = m_float_int_mult;
+    psf->m_float_max = m_float_max;
+    psf->m_add_clipping = m_add_clipping;
+    if (m_io_block_size != psf->m_io_block_size)
+    {
+        sf_count_t block_size = m_io_block_size;
+        if ((error = psf->command(SFC_SET_IO_BLOCK_SIZE, &block_size, sizeof(block_size))) != 0)
+        {
+            sf_close(sndfile);
+            return error;
+        };
+    };
+    if ((SF_CONTAINER(sf.format)) == SF_FORMAT_RAW && psf->m_dataoffset != m_dataoffset)
+        psf->command(SFC_SET_RAW_START_OFFSET, &m_dataoffset, sizeof(m_dataoffset));
+    if (m_read_dither.type != 0)
+        psf->command(SFC_SET_DITHER_ON_READ, &m_read_dither, sizeof(m_read_dither));
+
+    *clone = sndfile;
+
+    return SFE_NO_ERROR;
+}
+
+/* Upper limit of the staging buffer used when frames can't be borrowed in place. */
+#define BORROW_BUFFER_LEN (1024 * 1024)
+
+sf_count_t SndFile::borrowFrames(const void **ptr, sf_count_t frames)
+{
+    m_error = SFE_NO_ERROR;
+
+    if (!ptr)
+    {
+        m_error = SFE_BAD_COMMAND_PARAM;
+        return 0;
+    };
+
+    *ptr = nullptr;
+
+    if (frames == 0)
+        return 0;
+
+    if (frames < 0)
+    {
+        m_error = SFE_NEGATIVE_RW_LEN;
+        return 0;
+    };
+
+    if (m_mode == SFM_WRITE)
+    {
+        m_error = SFE_NOT_READMODE;
+        return 0;
+    };
+
+    if (m_borrowed)
+    {
+        m_error = SFE_FRAMES_BORROWED;
+        return 0;
+    };
+
+    /* Only formats with a matching native sample type can be borrowed. */
+    int width;
+    switch (SF_CODEC(sf.format))
+    {
+    case SF_FORMAT_PCM_16:
+        width = sizeof(short);
+        break;
+    case SF_FORMAT_PCM_32:
+        width = sizeof(int);
+        break;
+    case SF_FORMAT_FLOAT:
+        width = sizeof(float);
+        break;
+    case SF_FORMAT_DOUBLE:
+        width = sizeof(double);
+        break;
+    default:
+        m_error = SFE_UNIMPLEMENTED;
+        return 0;
+    };
+
+    if (m_read_current >= sf.frames)
+        return 0; /* End of file. */
+
+    if (frames > sf.frames - m_read_current)
+        frames = sf.frames - m_read_current;
+
+    /*
+    ** If the file is memory mapped and the samples are stored exactly as
+    ** the host would store them, hand out a pointer into the mapping.
+    */
+    sf_count_t maplen;
+    const unsigned char *map = static_cast<const unsigned char *>(psf_stream_mapping(m_stream.get(), &maplen));
+
+    if (map && !m_codec_data && !m_data_endswap && !m_ieee_replace && m_read_dither.type == 0 &&
+        m_blockwidth == width * sf.channels && seek_from_start)
+    {
+        sf_count_t offset = m_dataoffset + m_read_current * m_blockwidth;
+
+        if (offset >= 0 && offset + frames * m_blockwidth <= maplen &&
+            (reinterpret_cast<uintptr_t>(map + offset) % width) == 0)
+        {
+            if (seek_from_start(this, SFM_READ, m_read_current + frames) < 0)
+                return 0;
+
+            m_read_current += frames;
+            m_last_op = SFM_READ;
+
+            m_borrowed = map + offset;
+            *ptr = m_borrowed;
+
+            return frames;
+        };
+    };
+
+    /* Otherwise decode into the staging buffer. */
+    sf_count_t max_frames = BORROW_BUFFER_LEN / (width * sf.channels);
+    if (max_frames < 1)
+        max_frames = 1;
+    if (frames > max_frames)
+        frames = max_frames;
+
+    size_t bytes = (size_t)(frames * width * sf.channels);
+    m_borrow_buffer.resize((bytes + sizeof(double) - 1) / sizeof(double));
+
+    sf_count_t count;
+    switch (width)
+    {
+    case sizeof(short):
+        count = readShortFrames(reinterpret_cast<short *>(m_borrow_buffer.data()), frames);
+        break;
+    case sizeof(int):
+        if (SF_CODEC(sf.format) == SF_FORMAT_PCM_32)
+            count = readIntFrames(reinterpret_cast<int *>(m_borrow_buffer.data()), frames);
+        else
+            count = readFloatFrames(reinterpret_cast<float *>(m_borrow_buffer.data()), frames);
+        break;
+    default:
+        count = readDoubleFrames(m_borrow_buffer.data(), frames);
+        break;
+    };
+
+    if (count <= 0)
+        return 0;
+
+    m_borrowed = m_borrow_buffer.data();
+    *ptr = m_borrowed;
+
+    return count;
+}
+
+int SndFile::releaseFrames(const void *ptr)
+{
+    if (!m_borrowed || ptr != m_borrowed)
+    {
+        m_error = SFE_BAD_RELEASE;
+        return m_error;
+    };
+
+    m_borrowed = nullptr;
+    m_error = SFE_NO_ERROR;
+
+    return SFE_NO_ERROR;
+}
+
+/*
+** Planar reads and writes of codecs without planar readers go through an
+** interleaved staging buffer of this many bytes, or of PLANAR_MIN_FRAMES
+** frames for very many channels. It stays in cache while it is transposed
+** to or from the channel buffers a channel at a time.
+*/
+#define PLANAR_CHUNK_BYTES (1 << 15)
+#define PLANAR_MIN_FRAMES (64)
+
+template <typename T>
+static T *planar_buffer(SndFile *psf, sf_count_t *chunk)
+{
+    *chunk = std::max((sf_count_t)(PLANAR_CHUNK_BYTES / (psf->sf.channels * sizeof(T))), (sf_count_t)PLANAR_MIN_FRAMES);
+
+    try
+    {
+        psf->m_planar_buffer.resize((*chunk * psf->sf.channels * sizeof(T) + sizeof(double) - 1) / sizeof(double));
+    }
+    catch (const std::bad_alloc &)
+    {
+        psf->m_error = SFE_MALLOC_FAILED;
+        return nullptr;
+    };
+
+    return reinterpret_cast<T *>(psf->m_planar_buffer.data());
+}
+
+template <typename T>
+static sf_count_t read_planar(SndFile *psf, T *const *ptr, sf_count_t frames,
+                              size_t (*read_planar)(SndFile *, T *const *, size_t),
+                              sf_count_t (SndFile::*read_frames)(T *, sf_count_t))
+{
+    const int channels = psf->sf.channels;
+    sf_count_t count, total = 0, chunk;
+    T *buffer;
+
+    if (channels == 1 || frames <= 0 || psf->m_mode == SFM_WRITE)
+        return (psf->*read_frames)(ptr ? ptr[0] : nullptr, frames);
+
+    if (read_planar)
+    {
+        psf->m_error = SFE_NO_ERROR;
+
+        if (psf->m_last_op != SFM_READ)
+            if (psf->seek_from_start(psf, SFM_READ, psf->m_read_current) < 0)
+                return 0;
+
+        if (psf->m_read_current < psf->sf.frames)
+            total = read_planar(psf, ptr, (size_t)std::min(frames, psf->sf.frames - psf->m_read_current));
+
+        for (int k = 0; k < channels; k++)
+            psf_memset(ptr[k] + total, 0, (frames - total) * sizeof(T));
+
+        psf->m_read_current += total;
+        psf->m_last_op = SFM_READ;
+
+        return total;
+    };
+
+    if ((buffer = planar_buffer<T>(psf, &chunk)) == nullptr)
+        return 0;
+
+    while (total < frames)
+    {
+        chunk = std::min(chunk, frames - total);
+        count = (psf->*read_frames)(buffer, chunk);
+
+        for (int k = 0; k < channels; k++)
+        {
+            T *dest = ptr[k] + total;
+            for (sf_count_t n = 0; n < count; n++)
+                dest[n] = buffer[n * channels + k];
+        };
+
+        total += count;
+        if (count < chunk)
+        {
+            /* Like the interleaved reads, frames past the end are zeroed. */
+            if (psf->m_error == SFE_NO_ERROR)
+                for (int k = 0; k < channels; k++)
+                    psf_memset(ptr[k] + total, 0, (frames - total) * sizeof(T));
+            break;
+        };
+    };
+
+    return total;
+}
+
+template <typename T>
+static sf_count_t write_planar(SndFile *psf, const T *const *ptr, sf_count_t frames,
+                               sf_count_t (SndFile::*write_frames)(const T *, sf_count_t))
+{
+    const int channels = psf->sf.channels;
+    sf_count_t count, total = 0, chunk;
+    T *buffer;
+
+    if (channels == 1 || frames <= 0 || psf->m_mode == SFM_READ)
+        return (psf->*write_frames)(ptr ? ptr[0] : nullptr, frames);
+
+    if ((buffer = planar_buffer<T>(psf, &chunk)) == nullptr)
+        return 0;
+
+    while (total < frames)
+    {
+        chunk = std::min(chunk, frames - total);
+
+        for (int k = 0; k < channels; k++)
+        {
+            const T *src = ptr[k] + total;
+            for (sf_count_t n = 0; n < chunk; n++)
+                buffer[n * channels + k] = src[n];
+        };
+
+        count = (psf->*write_frames)(buffer, chunk);
+        total += count;
+        if (count < chunk)
+            break;
+    };
+
+    return total;
+}
+
+sf_count_t SndFile::readShortPlanar(short *const *ptr, sf_count_t frames)
+{
+    return read_planar(this, ptr, frames, read_short_planar, &SndFile::readShortFrames);
+}
+
+sf_count_t SndFile::readIntPlanar(int *const *ptr, sf_count_t frames)
+{
+    return read_planar(this, ptr, frames, read_int_planar, &SndFile::readIntFrames);
+}
+
+sf_count_t SndFile::readFloatPlanar(float *const *ptr, sf_count_t frames)
+{
+    return read_planar(this, ptr, frames, read_float_planar, &SndFile::readFloatFrames);
+}
+
+sf_count_t SndFile::readDoublePlanar(double *const *ptr, sf_count_t frames)
+{
+    return read_planar(this, ptr, frames, read_double_planar, &SndFile::readDoubleFrames);
+}
+
+sf_count_t SndFile::writeShortPlanar(const short *const *ptr, sf_count_t frames)
+{
+    return write_planar(this, ptr, frames, &SndFile::writeShortFrames);
+}
+
+sf_count_t SndFile::writeIntPlanar(const int *const *ptr, sf_count_t frames)
+{
+    return write_planar(this, ptr, frames, &SndFile::writeIntFrames);
+}
+
+sf_count_t SndFile::writeFloatPlanar(const float *const *ptr, sf_count_t frames)
+{
+    return write_planar(this, ptr, frames, &SndFile::writeFloatFrames);
+}
+
+sf_count_t SndFile::writeDoublePlanar(const double *const *ptr, sf_count_t frames)
+{
+    return write_planar(this, ptr, frames, &SndFile::writeDoubleFrames);
+}
+
 int SndFile::getCurrentByterate() const
 {
     /* This should cover all PCM and floating point formats. */
@@ -0,0 +1,152 @@
+/*
+** Copyright (C) 2026 agent <agent@local>
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation; either version 2.1 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "common.h"
+#include "test_main.h"
+
+#include "ALAC/dplib.h"
+
+#define TEST_LEN (4096)
+
+static int32_t ref_sign_of_int(int32_t i)
+{
+    return (int32_t)(((uint32_t)-i) >> 31) | (i >> 31);
+}
+
+/*
+** The general case loop of unpc_block() in ALAC/dp_dec.c as it was before the
+** common orders got their own expansions. It serves every order here.
+*/
+static void ref_unpc_block(const int32_t *pc1, int32_t *out, int32_t num, int16_t *coefs, int32_t numactive,
+                           uint32_t chanbits, uint32_t denshift)
+{
+    const uint32_t chanshift = 32 - chanbits;
+    const int32_t denhalf = 1 << (denshift - 1);
+    int32_t j, k;
+
+    out[0] = pc1[0];
+    for (j = 1; j <= numactive; j++)
+        out[j] = (int32_t)((uint32_t)(pc1[j] + out[j - 1]) << chanshift) >> chanshift;
+
+    for (j = numactive + 1; j < num; j++)
+    {
+        const int32_t *pout = out + j - 1;
+        const int32_t top = out[j - numactive - 1];
+        int32_t sum1 = 0, del, del0, sg, sgn, dd;
+
+        for (k = 0; k < numactive; k++)
+            sum1 += coefs[k] * (pout[-k] - top);
+
+        del = del0 = pc1[j];
+        sg = ref_sign_of_int(del);
+        del += top + ((sum1 + denhalf) >> denshift);
+        out[j] = (int32_t)((uint32_t)del << chanshift) >> chanshift;
+
+        if (sg > 0)
+        {
+            for (k = numactive - 1; k >= 0; k--)
+            {
+                dd = top - pout[-k];
+                sgn = ref_sign_of_int(dd);
+                coefs[k] -= sgn;
+                del0 -= (numactive - k) * ((sgn * dd) >> denshift);
+                if (del0 <= 0)
+                    break;
+            };
+        }
+        else if (sg < 0)
+        {
+            for (k = numactive - 1; k >= 0; k--)
+            {
+                dd = top - pout[-k];
+                sgn = ref_sign_of_int(dd);
+                coefs[k] += sgn;
+                del0 -= (numactive - k) * ((-sgn * dd) >> denshift);
+                if (del0 >= 0)
+                    break;
+            };
+        };
+    };
+}
+
+/*
+** Residuals come from the encoder's pc_block(), so decoding must give back the
+** signal, and the decoder must track the coefficients exactly like the
+** reference loop does.
+*/
+void test_alac_predictor(void)
+{
+    static const int32_t orders[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 12, 16};
+    static const uint32_t widths[] = {16, 24};
+    static int32_t signal[TEST_LEN], residual[TEST_LEN], expected[TEST_LEN], result[TEST_LEN];
+
+    print_test_name(__func__);
+
+    for (size_t w = 0; w < ARRAY_LEN(widths); w++)
+    {
+        const uint32_t chanbits = widths[w];
+        const double amplitude = (double)(1 << (chanbits - 2));
+
+        for (int32_t k = 0; k < TEST_LEN; k++)
+            signal[k] = (int32_t)lrint(amplitude * (0.6 * sin(k * 0.031) + 0.3 * sin(k * 0.57 + 1.0)) +
+                                       (k * 7919 % 97) - 48);
+
+        for (size_t o = 0; o < ARRAY_LEN(orders); o++)
+        {
+            const int32_t numactive = orders[o];
+            int16_t enc_coefs[32], ref_coefs[32], coefs[32];
+
+            memset(enc_coefs, 0, sizeof(enc_coefs));
+            enc_coefs[0] = 160;
+            enc_coefs[1] = -60;
+            pc_block(signal, residual, TEST_LEN, enc_coefs, numactive, chanbits, DENSHIFT_DEFAULT);
+
+            memset(coefs, 0, sizeof(coefs));
+            coefs[0] = 160;
+            coefs[1] = -60;
+            memcpy(ref_coefs, coefs, sizeof(coefs));
+
+            ref_unpc_block(residual, expected, TEST_LEN, ref_coefs, numactive, chanbits, DENSHIFT_DEFAULT);
+            unpc_block(residual, result, TEST_LEN, coefs, numactive, chanbits, DENSHIFT_DEFAULT);
+
+            if (memcmp(expected, signal, sizeof(signal)) != 0)
+            {
+                printf("\n\nLine %d : reference decode of order %d doesn't match the signal.\n\n", __LINE__,
+                       numactive);
+                exit(1);
+            };
+
+            if (memcmp(result, expected, sizeof(expected)) != 0 ||
+                memcmp(coefs, ref_coefs, numactive * sizeof(coefs[0])) != 0)
+            {
+                printf("\n\nLine %d : unpc_block() differs from the reference for order %d, %u bits.\n\n", __LINE__,
+                       numactive, chanbits);
+                exit(1);
+            };
+        };
+    };
+
+    puts("ok");
+}
@@ -32,6 +32,7 @@
 int main(void)
 {
     test_conversions();
+    test_simd_kernels();
     test_endswap();
     test_float_convert();
     test_double_convert();
@@ -45,6 +46,8 @@ int main(void)
 
     test_psf_strlcpy_crlf();
     test_nms_adpcm();
+    test_alac_predictor();
+    test_md5();
 
     return 0;
 }
@@ -37,3 +37,9 @@ void test_ima_oki_adpcm(void);
 void test_psf_strlcpy_crlf(void);
 
 void test_nms_adpcm (void);
+
+void test_simd_kernels(void);
+
+void test_alac_predictor(void);
+
+void test_md5(void);
@@ -0,0 +1,85 @@
+/*
+** Copyright (C) 2026 agent <agent@local>
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation; either version 2.1 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "md5.h"
+#include "test_main.h"
+
+static void md5_hex(const unsigned char digest[16], char hex[33])
+{
+    for (int k = 0; k < 16; k++)
+        snprintf(hex + 2 * k, 3, "%02x", digest[k]);
+}
+
+void test_md5(void)
+{
+    /* Test suite from RFC 1321. */
+    static const struct
+    {
+        const char *message;
+        const char *digest;
+    } vectors[] = {
+        {"", "d41d8cd98f00b204e9800998ecf8427e"},
+        {"a", "0cc175b9c0f1b6a831c399e269772661"},
+        {"abc", "900150983cd24fb0d6963f7d28e17f72"},
+        {"message digest", "f96b697d7cb7938d525a2f31aaf161d0"},
+        {"abcdefghijklmnopqrstuvwxyz", "c3fcd3d76192e4007dfb496cca67e13b"},
+        {"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", "d174ab98d277d9f5a5611c2c9f419d9f"},
+        {"12345678901234567890123456789012345678901234567890123456789012345678901234567890",
+         "57edf4a22be3c955ac49da2e2107b67a"},
+    };
+
+    print_test_name(__func__);
+
+    for (size_t k = 0; k < ARRAY_LEN(vectors); k++)
+    {
+        size_t len = strlen(vectors[k].message);
+
+        /* Whole and a byte at a time, to cover the buffering. */
+        for (int pass = 0; pass < 2; pass++)
+        {
+            SF_MD5 md5;
+            unsigned char digest[16];
+            char hex[33];
+
+            psf_md5_init(&md5);
+            if (pass == 0)
+                psf_md5_update(&md5, vectors[k].message, len);
+            else
+                for (size_t n = 0; n < len; n++)
+                    psf_md5_update(&md5, vectors[k].message + n, 1);
+            psf_md5_final(&md5, digest);
+
+            md5_hex(digest, hex);
+            if (strcmp(hex, vectors[k].digest) != 0)
+            {
+                printf("\n\nLine %d : MD5 of \"%s\" is %s (should be %s).\n\n", __LINE__, vectors[k].message, hex,
+                       vectors[k].digest);
+                exit(1);
+            };
+        };
+    };
+
+    puts("ok");
+}
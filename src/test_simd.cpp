@@ -0,0 +1,712 @@
+/*
+** Copyright (C) 2026 agent <agent@local>
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation; either version 2.1 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "common.h"
+#include "sfendian.h"
+#include "simd.h"
+#include "test_main.h"
+
+/*
+** Checks that every kernel gives exactly the same result as the scalar code,
+** for all lengths up to TEST_LEN so every head/tail split gets exercised.
+*/
+
+#define TEST_LEN (67)
+
+static unsigned int rand_state = 1;
+
+static unsigned int test_rand(void)
+{
+    rand_state = rand_state * 1103515245 + 12345;
+    return rand_state >> 8;
+}
+
+static float test_float(void)
+{
+    /* Mostly ordinary samples with some values right on the clipping edges. */
+    static const float special[] = {
+        0.0f, -0.0f, 1.0f, -1.0f, 0.5f, -0.5f, 1.5f, -1.5f, 32767.0f, 32767.4f, 32767.6f, -32768.0f, -32768.6f,
+        2147483520.0f, 2147483648.0f, -2147483648.0f, -2147483904.0f, 1e10f, -1e10f, 1e30f, -1e30f,
+        (float)NAN, (float)INFINITY, (float)-INFINITY,
+    };
+
+    if (test_rand() % 8 == 0)
+        return special[test_rand() % ARRAY_LEN(special)];
+
+    return ((float)(int)(test_rand() % 20001) - 10000.0f) / 8000.0f;
+}
+
+/* Reference versions of the scalar loops in pcm.cpp and float32.cpp. */
+
+static void ref_les2f(const short *src, size_t count, float *dest, float normfact)
+{
+    while (count)
+    {
+        count--;
+        short value = LE2H_16(src[count]);
+        dest[count] = ((float)value) * normfact;
+    };
+}
+
+static void ref_bes2f(const short *src, size_t count, float *dest, float normfact)
+{
+    while (count)
+    {
+        count--;
+        short value = BE2H_16(src[count]);
+        dest[count] = ((float)value) * normfact;
+    };
+}
+
+static void ref_lei2f(const int *src, size_t count, float *dest, float normfact)
+{
+    while (count)
+    {
+        count--;
+        int value = LE2H_32(src[count]);
+        dest[count] = ((float)value) * normfact;
+    };
+}
+
+static void ref_bei2f(const int *src, size_t count, float *dest, float normfact)
+{
+    while (count)
+    {
+        count--;
+        int value = BE2H_32(src[count]);
+        dest[count] = ((float)value) * normfact;
+    };
+}
+
+static void ref_let2i(const unsigned char *src, size_t count, int *dest)
+{
+    while (count)
+    {
+        count--;
+        dest[count] = psf_get_le24((uint8_t *)src + 3 * count, 0);
+    };
+}
+
+static void ref_bet2i(const unsigned char *src, size_t count, int *dest)
+{
+    while (count)
+    {
+        count--;
+        dest[count] = psf_get_be24((uint8_t *)src + 3 * count, 0);
+    };
+}
+
+static void ref_f2s(const float *src, size_t count, short *dest, float scale)
+{
+    while (count)
+    {
+        count--;
+        dest[count] = (short)lrintf(scale * src[count]);
+    };
+}
+
+static void ref_f2s_clip(const float *src, size_t count, short *dest, float scale)
+{
+    while (count)
+    {
+        count--;
+        float tmp = scale * src[count];
+
+        if (CPU_CLIPS_POSITIVE == 0 && tmp > 32767.0)
+            dest[count] = SHRT_MAX;
+        else if (CPU_CLIPS_NEGATIVE == 0 && tmp < -32768.0)
+            dest[count] = SHRT_MIN;
+        else
+            dest[count] = (short)lrintf(tmp);
+    };
+}
+
+static void ref_f2i(const float *src, size_t count, int *dest, float scale)
+{
+    while (count)
+    {
+        count--;
+        dest[count] = lrintf(scale * src[count]);
+    };
+}
+
+static void ref_f2i_clip(const float *src, size_t count, int *dest, float scale)
+{
+    while (count)
+    {
+        count--;
+        float tmp = scale * src[count];
+
+        if (CPU_CLIPS_POSITIVE == 0 && tmp > (1.0 * INT_MAX))
+            dest[count] = INT_MAX;
+        else if (CPU_CLIPS_NEGATIVE == 0 && tmp < (-1.0 * INT_MAX))
+            dest[count] = INT_MIN;
+        else
+            dest[count] = lrintf(tmp);
+    };
+}
+
+static void ref_f2let(const float *src, unsigned char *dest, size_t count, float normfact)
+{
+    while (count)
+    {
+        count--;
+        int value = lrintf(src[count] * normfact);
+        dest[3 * count] = value;
+        dest[3 * count + 1] = value >> 8;
+        dest[3 * count + 2] = value >> 16;
+    };
+}
+
+static void ref_f2let_clip(const float *src, unsigned char *dest, size_t count, float normfact)
+{
+    while (count)
+    {
+        count--;
+        unsigned char *ucptr = dest + 3 * count;
+        float scaled_value = src[count] * normfact;
+        if (CPU_CLIPS_POSITIVE == 0 && scaled_value >= (1.0 * 0x7FFFFFFF))
+        {
+            ucptr[0] = 0xFF;
+            ucptr[1] = 0xFF;
+            ucptr[2] = 0x7F;
+            continue;
+        };
+        if (CPU_CLIPS_NEGATIVE == 0 && scaled_value <= (-8.0 * 0x10000000))
+        {
+            ucptr[0] = 0x00;
+            ucptr[1] = 0x00;
+            ucptr[2] = 0x80;
+            continue;
+        };
+
+        int value = lrintf(scaled_value);
+        ucptr[0] = value >> 8;
+        ucptr[1] = value >> 16;
+        ucptr[2] = value >> 24;
+    };
+}
+
+/* Reference version of the statistics loop in command.cpp, without the first frame's crossing. */
+static void ref_stats(const double *src, size_t frames, int channels, SIMD_SIGNAL_STATS *stats)
+{
+    for (size_t k = 0; k < frames; k++)
+    {
+        for (int chan = 0; chan < channels; chan++)
+        {
+            double x = src[k * channels + chan];
+            double temp = fabs(x);
+
+            stats[chan].peak = temp > stats[chan].peak ? temp : stats[chan].peak;
+            stats[chan].sum += x;
+            stats[chan].sum_sq += x * x;
+            if (temp >= 1.0)
+                stats[chan].clips++;
+            if (k > 0 && (x < 0.0) != (src[(k - 1) * channels + chan] < 0.0))
+                stats[chan].crossings++;
+        };
+    };
+}
+
+/* Reference versions of the planar to interleaved loops in flac.cpp. */
+static void ref_pi2s(const int32_t *const *src, size_t frames, int channels, short *dest, int shift)
+{
+    for (size_t k = 0; k < frames; k++)
+        for (int chan = 0; chan < channels; chan++)
+        {
+            if (shift < 0)
+                dest[k * channels + chan] = src[chan][k] >> -shift;
+            else
+                dest[k * channels + chan] = ((uint16_t)src[chan][k]) << shift;
+        };
+}
+
+static void ref_pi2i(const int32_t *const *src, size_t frames, int channels, int *dest, int shift)
+{
+    for (size_t k = 0; k < frames; k++)
+        for (int chan = 0; chan < channels; chan++)
+            dest[k * channels + chan] = ((uint32_t)src[chan][k]) << shift;
+}
+
+static void ref_pi2f(const int32_t *const *src, size_t frames, int channels, float *dest, float normfact)
+{
+    for (size_t k = 0; k < frames; k++)
+        for (int chan = 0; chan < channels; chan++)
+            dest[k * channels + chan] = src[chan][k] * normfact;
+}
+
+/* Reference version of the stereo unmix loops in ALAC/matrix_dec.c. */
+static void ref_alac_unmix(const int32_t *u, const int32_t *v, int32_t *out, size_t frames, int mixbits, int mixres,
+                           const uint16_t *shift_uv, int bytes_shifted, int out_shift)
+{
+    for (size_t k = 0; k < frames; k++)
+    {
+        int32_t l = u[k], r = v[k];
+
+        if (mixres != 0)
+        {
+            l = u[k] + v[k] - ((mixres * v[k]) >> mixbits);
+            r = l - v[k];
+        };
+
+        if (shift_uv != NULL)
+        {
+            l = (int32_t)(((uint32_t)l << (8 * bytes_shifted)) | shift_uv[2 * k]);
+            r = (int32_t)(((uint32_t)r << (8 * bytes_shifted)) | shift_uv[2 * k + 1]);
+        };
+
+        out[2 * k] = (int32_t)((uint32_t)l << out_shift);
+        out[2 * k + 1] = (int32_t)((uint32_t)r << out_shift);
+    };
+}
+
+static void check_or_die(const void *a, const void *b, size_t bytes, const char *isa, const char *kernel, size_t count,
+                         int line)
+{
+    if (memcmp(a, b, bytes) != 0)
+    {
+        printf("\n\nLine %d : %s %s kernel differs from scalar code for count %zu.\n\n", line, isa, kernel, count);
+        exit(1);
+    };
+}
+
+/*
+** Runs a widening kernel both out of place and in place, with the source
+** bytes at the start of the destination buffer like the read functions do.
+*/
+#define CHECK_WIDENING(KERNEL, SRC_T, SRC, SRC_BYTES, DEST_T, ...)                                                     \
+    {                                                                                                                  \
+        DEST_T expected[TEST_LEN], result[TEST_LEN];                                                                   \
+        ref_##KERNEL(SRC, count, expected, ##__VA_ARGS__);                                                             \
+        size_t left = kernels->KERNEL(SRC, count, result, ##__VA_ARGS__);                                              \
+        ref_##KERNEL(SRC, left, result, ##__VA_ARGS__);                                                                \
+        check_or_die(expected, result, count * sizeof(DEST_T), kernels->name, #KERNEL, count, __LINE__);               \
+        memcpy(result, SRC, SRC_BYTES);                                                                                \
+        left = kernels->KERNEL((const SRC_T *)result, count, result, ##__VA_ARGS__);                                   \
+        ref_##KERNEL((const SRC_T *)result, left, result, ##__VA_ARGS__);                                              \
+        check_or_die(expected, result, count * sizeof(DEST_T), kernels->name, #KERNEL " in place", count, __LINE__);   \
+    }
+
+static void test_kernels(const SIMD_KERNELS *kernels)
+{
+    static short sbuf[TEST_LEN];
+    static int ibuf[TEST_LEN];
+    static unsigned char tbuf[3 * TEST_LEN];
+    static float fbuf[TEST_LEN];
+
+    for (int pass = 0; pass < 8; pass++)
+    {
+        for (size_t k = 0; k < TEST_LEN; k++)
+        {
+            sbuf[k] = (short)test_rand();
+            ibuf[k] = (int)(test_rand() ^ (test_rand() << 16));
+            tbuf[3 * k] = test_rand();
+            tbuf[3 * k + 1] = test_rand();
+            tbuf[3 * k + 2] = test_rand();
+            fbuf[k] = test_float();
+        };
+
+        for (size_t count = 0; count <= TEST_LEN; count++)
+        {
+            const float normfact = 1.0f / 0x8000;
+            const float scale = (pass & 1) ? 32767.0f : 1.0f;
+
+            CHECK_WIDENING(les2f, short, sbuf, count * sizeof(short), float, normfact);
+            CHECK_WIDENING(bes2f, short, sbuf, count * sizeof(short), float, normfact);
+            CHECK_WIDENING(lei2f, int, ibuf, count * sizeof(int), float, normfact);
+            CHECK_WIDENING(bei2f, int, ibuf, count * sizeof(int), float, normfact);
+            CHECK_WIDENING(let2i, unsigned char, tbuf, count * 3, int);
+            CHECK_WIDENING(bet2i, unsigned char, tbuf, count * 3, int);
+
+            /* Tribyte to float is the tribyte to int reference plus scaling. */
+            {
+                int ivalues[TEST_LEN];
+                float expected[TEST_LEN], result[TEST_LEN];
+
+                ref_let2i(tbuf, count, ivalues);
+                for (size_t k = 0; k < count; k++)
+                    expected[k] = ((float)ivalues[k]) * normfact;
+                memcpy(result, tbuf, count * 3);
+                size_t left = kernels->let2f((const unsigned char *)result, count, result, normfact);
+                ref_let2i((const unsigned char *)result, left, ivalues);
+                for (size_t k = 0; k < left; k++)
+                    result[k] = ((float)ivalues[k]) * normfact;
+                check_or_die(expected, result, count * sizeof(float), kernels->name, "let2f", count, __LINE__);
+
+                ref_bet2i(tbuf, count, ivalues);
+                for (size_t k = 0; k < count; k++)
+                    expected[k] = ((float)ivalues[k]) * normfact;
+                memcpy(result, tbuf, count * 3);
+                left = kernels->bet2f((const unsigned char *)result, count, result, normfact);
+                ref_bet2i((const unsigned char *)result, left, ivalues);
+                for (size_t k = 0; k < left; k++)
+                    result[k] = ((float)ivalues[k]) * normfact;
+                check_or_die(expected, result, count * sizeof(float), kernels->name, "bet2f", count, __LINE__);
+            };
+
+            {
+                short expected[TEST_LEN], result[TEST_LEN];
+
+                ref_f2s(fbuf, count, expected, scale);
+                ref_f2s(fbuf, kernels->f2s(fbuf, count, result, scale), result, scale);
+                check_or_die(expected, result, count * sizeof(short), kernels->name, "f2s", count, __LINE__);
+
+                ref_f2s_clip(fbuf, count, expected, scale);
+                ref_f2s_clip(fbuf, kernels->f2s_clip(fbuf, count, result, scale), result, scale);
+                check_or_die(expected, result, count * sizeof(short), kernels->name, "f2s_clip", count, __LINE__);
+            };
+
+            {
+                const float iscale = (pass & 1) ? 2147483647.0f : 1.0f;
+                int expected[TEST_LEN], result[TEST_LEN];
+
+                ref_f2i(fbuf, count, expected, iscale);
+                ref_f2i(fbuf, kernels->f2i(fbuf, count, result, iscale), result, iscale);
+                check_or_die(expected, result, count * sizeof(int), kernels->name, "f2i", count, __LINE__);
+
+                ref_f2i_clip(fbuf, count, expected, iscale);
+                ref_f2i_clip(fbuf, kernels->f2i_clip(fbuf, count, result, iscale), result, iscale);
+                check_or_die(expected, result, count * sizeof(int), kernels->name, "f2i_clip", count, __LINE__);
+            };
+
+            {
+                const float tnorm = (pass & 1) ? (float)(1.0 * 0x7FFFFF) : 1.0f;
+                const float tnorm_clip = (pass & 1) ? (float)(8.0 * 0x10000000) : (float)(1.0 * 0x100);
+                unsigned char expected[3 * TEST_LEN], result[3 * TEST_LEN];
+
+                ref_f2let(fbuf, expected, count, tnorm);
+                ref_f2let(fbuf, result, kernels->f2let(fbuf, result, count, tnorm), tnorm);
+                check_or_die(expected, result, count * 3, kernels->name, "f2let", count, __LINE__);
+
+                ref_f2let_clip(fbuf, expected, count, tnorm_clip);
+                ref_f2let_clip(fbuf, result, kernels->f2let_clip(fbuf, result, count, tnorm_clip), tnorm_clip);
+                check_or_die(expected, result, count * 3, kernels->name, "f2let_clip", count, __LINE__);
+            };
+        };
+    };
+}
+
+/*
+** The stats kernel adds its sums in another order, so they only have to be
+** close. Every channel count up to one more than the widest period is tried.
+*/
+static void test_stats_kernel(const SIMD_KERNELS *kernels)
+{
+    static const double special[] = {0.0, -0.0, 1.0, -1.0, 1.5, -1.5, (double)NAN};
+    static double dbuf[17 * TEST_LEN];
+
+    for (size_t k = 0; k < ARRAY_LEN(dbuf); k++)
+    {
+        if (test_rand() % 8 == 0)
+            dbuf[k] = special[test_rand() % ARRAY_LEN(special)];
+        else
+            dbuf[k] = ((double)(int)(test_rand() % 20001) - 10000.0) / 8000.0;
+    };
+
+    for (int channels = 1; channels <= 17; channels++)
+    {
+        for (size_t frames = 0; frames <= TEST_LEN; frames++)
+        {
+            SIMD_SIGNAL_STATS expected[17], result[17];
+
+            memset(expected, 0, sizeof(expected));
+            memset(result, 0, sizeof(result));
+
+            ref_stats(dbuf, frames, channels, expected);
+
+            size_t head = kernels->stats(dbuf, frames, channels, result);
+            if (head > frames || (frames > 0 && head == 0))
+            {
+                printf("\n\nLine %d : %s stats kernel left %zu of %zu frames.\n\n", __LINE__, kernels->name, head, frames);
+                exit(1);
+            };
+
+            /* The scalar code does the head, as in command.cpp. */
+            ref_stats(dbuf, head, channels, result);
+
+            for (int chan = 0; chan < channels; chan++)
+            {
+                const SIMD_SIGNAL_STATS &a = expected[chan], &b = result[chan];
+
+                if (a.clips != b.clips || a.crossings != b.crossings ||
+                    (isnan(a.sum) ? !isnan(b.sum) : fabs(a.sum - b.sum) > 1e-9 * (1.0 + fabs(a.sum))) ||
+                    (isnan(a.sum_sq) ? !isnan(b.sum_sq) : fabs(a.sum_sq - b.sum_sq) > 1e-9 * (1.0 + a.sum_sq)))
+                {
+                    printf("\n\nLine %d : %s stats kernel differs from scalar code for %d channels, %zu frames.\n\n",
+                           __LINE__, kernels->name, channels, frames);
+                    exit(1);
+                };
+
+                check_or_die(&a.peak, &b.peak, sizeof(double), kernels->name, "stats", frames, __LINE__);
+            };
+        };
+    };
+}
+
+/*
+** Samples are decoded FLAC samples of the given width, so the shifted values
+** fit the destination just like in flac.cpp.
+*/
+static void test_planar_kernels(const SIMD_KERNELS *kernels)
+{
+    static const int widths[] = {8, 12, 16, 20, 24, 32};
+    static int32_t planes[3][TEST_LEN];
+    const int32_t *src[3] = {planes[0], planes[1], planes[2]};
+
+    for (size_t w = 0; w < ARRAY_LEN(widths); w++)
+    {
+        const int bits = widths[w];
+
+        for (int chan = 0; chan < 3; chan++)
+            for (size_t k = 0; k < TEST_LEN; k++)
+                planes[chan][k] = (int32_t)((uint32_t)(test_rand() ^ (test_rand() << 16)) << (32 - bits)) >> (32 - bits);
+
+        for (int channels = 1; channels <= 3; channels++)
+        {
+            for (size_t frames = 0; frames <= TEST_LEN; frames++)
+            {
+                const float normfact = (float)(1.0 / ((int64_t)1 << (bits - 1)));
+                const int shift = 16 - bits;
+                short sexpected[3 * TEST_LEN], sresult[3 * TEST_LEN];
+                int iexpected[3 * TEST_LEN], iresult[3 * TEST_LEN];
+                float fexpected[3 * TEST_LEN], fresult[3 * TEST_LEN];
+
+                ref_pi2s(src, frames, channels, sexpected, shift);
+                ref_pi2s(src, kernels->pi2s(src, frames, channels, sresult, shift), channels, sresult, shift);
+                check_or_die(sexpected, sresult, frames * channels * sizeof(short), kernels->name, "pi2s", frames,
+                             __LINE__);
+
+                ref_pi2i(src, frames, channels, iexpected, 32 - bits);
+                ref_pi2i(src, kernels->pi2i(src, frames, channels, iresult, 32 - bits), channels, iresult, 32 - bits);
+                check_or_die(iexpected, iresult, frames * channels * sizeof(int), kernels->name, "pi2i", frames,
+                             __LINE__);
+
+                ref_pi2f(src, frames, channels, fexpected, normfact);
+                ref_pi2f(src, kernels->pi2f(src, frames, channels, fresult, normfact), channels, fresult, normfact);
+                check_or_die(fexpected, fresult, frames * channels * sizeof(float), kernels->name, "pi2f", frames,
+                             __LINE__);
+            };
+        };
+    };
+}
+
+/*
+** Mixed channels of each ALAC bit depth with the shift buffer settings the
+** decoder uses for it, u and v keep to the widths the encoder produces.
+*/
+static void test_alac_kernels(const SIMD_KERNELS *kernels)
+{
+    static const struct
+    {
+        int bits, bytes_shifted, with_shift_uv, out_shift;
+    } depths[] = {
+        {16, 0, 0, 16}, {20, 0, 0, 12}, {24, 0, 0, 8}, {16, 1, 1, 8}, {16, 1, 1, 0}, {8, 2, 1, 0}, {24, 0, 1, 0},
+    };
+    static const int mixres_values[] = {0, 1, 2, 3, -1};
+    static int32_t u[TEST_LEN], v[TEST_LEN];
+    static uint16_t shift_uv[2 * TEST_LEN];
+
+    for (size_t d = 0; d < ARRAY_LEN(depths); d++)
+    {
+        const int bits = depths[d].bits;
+        const uint16_t *suv = depths[d].with_shift_uv ? shift_uv : NULL;
+
+        /* Without shifted bytes the shift buffer holds whatever the previous packet left there. */
+        const unsigned mask = depths[d].bytes_shifted ? (1u << (8 * depths[d].bytes_shifted)) - 1 : 0xFFFF;
+
+        for (size_t k = 0; k < TEST_LEN; k++)
+        {
+            u[k] = (int32_t)((uint32_t)(test_rand() ^ (test_rand() << 16)) << (32 - bits)) >> (32 - bits);
+            v[k] = (int32_t)((uint32_t)(test_rand() ^ (test_rand() << 16)) << (31 - bits)) >> (31 - bits);
+            shift_uv[2 * k] = (uint16_t)(test_rand() & mask);
+            shift_uv[2 * k + 1] = (uint16_t)(test_rand() & mask);
+        };
+
+        for (size_t m = 0; m < ARRAY_LEN(mixres_values); m++)
+        {
+            for (size_t frames = 0; frames <= TEST_LEN; frames++)
+            {
+                const int mixres = mixres_values[m];
+                const int mixbits = 2;
+                int32_t expected[2 * TEST_LEN], result[2 * TEST_LEN];
+
+                ref_alac_unmix(u, v, expected, frames, mixbits, mixres, suv, depths[d].bytes_shifted,
+                               depths[d].out_shift);
+                size_t left = kernels->alac_unmix(u, v, result, frames, mixbits, mixres, suv, depths[d].bytes_shifted,
+                                                  depths[d].out_shift);
+                ref_alac_unmix(u, v, result, left, mixbits, mixres, suv, depths[d].bytes_shifted, depths[d].out_shift);
+                check_or_die(expected, result, 2 * frames * sizeof(int32_t), kernels->name, "alac_unmix", frames,
+                             __LINE__);
+            };
+        };
+    };
+}
+
+/* The GSM 6.10 loops as they are in the GSM610 directory. */
+static void ref_gsm_autocorr(const float *s, int32_t *acf)
+{
+    for (int k = 0; k <= 8; k++)
+    {
+        uint32_t sum = 0;
+        for (int i = k; i < 160; i++)
+            sum += (uint32_t)(int32_t)(s[i] * s[i - k]);
+        acf[k] = (int32_t)sum;
+    };
+}
+
+static void ref_gsm_ltp_xcorr(const float *wt, const float *dp, float *corr)
+{
+    for (int lambda = 40; lambda <= 120; lambda++)
+    {
+        float sum = 0.0f;
+        for (int k = 0; k < 40; k++)
+            sum += wt[k] * dp[k - lambda];
+        corr[lambda - 40] = sum;
+    };
+}
+
+static void ref_gsm_weighting(const int16_t *e, int16_t *x)
+{
+    static const int16_t H[11] = {-134, -374, 0, 2054, 5741, 8192, 5741, 2054, 0, -374, -134};
+
+    for (int k = 0; k < 40; k++)
+    {
+        int32_t sum = 8192 >> 1;
+        for (int i = 0; i < 11; i++)
+            sum += e[k + i - 5] * (int32_t)H[i];
+        sum >>= 13;
+        x[k] = (int16_t)(sum < -32768 ? -32768 : (sum > 32767 ? 32767 : sum));
+    };
+}
+
+static void ref_gsm_grid_energy(const int16_t *x, int32_t *energy)
+{
+    for (int m = 0; m <= 3; m++)
+    {
+        energy[m] = 0;
+        for (int i = 0; i <= 12; i++)
+            energy[m] += (x[m + 3 * i] >> 2) * (x[m + 3 * i] >> 2);
+    };
+}
+
+static void ref_gsm_ltp_synth(int16_t brp, const int16_t *lagged, const int16_t *erp, int16_t *drp)
+{
+    for (int k = 0; k < 40; k++)
+    {
+        int32_t sum = erp[k] + (int16_t)((brp * lagged[k] + 16384) >> 15);
+        drp[k] = (int16_t)(sum < -32768 ? -32768 : (sum > 32767 ? 32767 : sum));
+    };
+}
+
+/* Pick a 16 bit sample, with the extremes coming up often. */
+static int16_t test_gsm_sample(int bits)
+{
+    switch (test_rand() % 8)
+    {
+    case 0:
+        return (int16_t)(-(1 << (bits - 1)));
+    case 1:
+        return (int16_t)((1 << (bits - 1)) - 1);
+    default:
+        return (int16_t)((int32_t)(test_rand() << 16) >> (32 - bits));
+    };
+}
+
+/*
+** Autocorrelation gets samples of up to 15 bits so the float products get
+** rounded and the sum wraps, the other loops get whatever they can be fed.
+*/
+static void test_gsm_kernels(const SIMD_KERNELS *kernels)
+{
+    static const int16_t gains[] = {3277, 11469, 21299, 32767, -32767, 1, 0};
+
+    for (int pass = 0; pass < 64; pass++)
+    {
+        float s[160], wt[40], dp_base[120], *dp = dp_base + 120;
+        int16_t e_base[50], *e = e_base + 5, x[40], lagged[40], erp[40];
+        int32_t acf[2][9], energy[2][4];
+        float corr[2][81];
+        int16_t out[2][40];
+        const int bits = 2 + pass % 14;
+
+        for (int k = 0; k < 160; k++)
+            s[k] = test_gsm_sample(bits);
+        for (int k = 0; k < 40; k++)
+        {
+            wt[k] = test_gsm_sample(bits);
+            x[k] = test_gsm_sample(16);
+            lagged[k] = test_gsm_sample(16);
+            erp[k] = test_gsm_sample(16);
+        };
+        for (int k = 0; k < 120; k++)
+            dp_base[k] = test_gsm_sample(16);
+        for (int k = 0; k < 50; k++)
+            e_base[k] = test_gsm_sample(16);
+
+        ref_gsm_autocorr(s, acf[0]);
+        if (kernels->gsm_autocorr(s, acf[1]))
+            check_or_die(acf[0], acf[1], sizeof(acf[0]), kernels->name, "gsm_autocorr", pass, __LINE__);
+
+        ref_gsm_ltp_xcorr(wt, dp, corr[0]);
+        if (kernels->gsm_ltp_xcorr(wt, dp, corr[1]))
+            check_or_die(corr[0], corr[1], sizeof(corr[0]), kernels->name, "gsm_ltp_xcorr", pass, __LINE__);
+
+        ref_gsm_weighting(e, out[0]);
+        if (kernels->gsm_weighting(e, out[1]))
+            check_or_die(out[0], out[1], sizeof(out[0]), kernels->name, "gsm_weighting", pass, __LINE__);
+
+        ref_gsm_grid_energy(x, energy[0]);
+        if (kernels->gsm_grid_energy(x, energy[1]))
+            check_or_die(energy[0], energy[1], sizeof(energy[0]), kernels->name, "gsm_grid_energy", pass, __LINE__);
+
+        const int16_t brp = gains[pass % ARRAY_LEN(gains)];
+        ref_gsm_ltp_synth(brp, lagged, erp, out[0]);
+        if (kernels->gsm_ltp_synth(brp, lagged, erp, out[1]))
+            check_or_die(out[0], out[1], sizeof(out[0]), kernels->name, "gsm_ltp_synth", pass, __LINE__);
+    };
+}
+
+void test_simd_kernels(void)
+{
+    static const SIMD_ISA isas[] = {SIMD_ISA_SSE2, SIMD_ISA_SSSE3, SIMD_ISA_AVX2, SIMD_ISA_NEON};
+
+    print_test_name(__func__);
+
+    for (size_t k = 0; k < ARRAY_LEN(isas); k++)
+    {
+        const SIMD_KERNELS *kernels = psf_simd_kernels_for(isas[k]);
+        if (kernels)
+        {
+            test_kernels(kernels);
+            test_stats_kernel(kernels);
+            test_planar_kernels(kernels);
+            test_alac_kernels(kernels);
+            test_gsm_kernels(kernels);
+        };
+    };
+
+    puts("ok");
+}
@@ -694,11 +694,11 @@ static inline void d2ulaw_array(const double *ptr, size_t count, unsigned char *
 
 static size_t ulaw_read_ulaw2s(SndFile *psf, short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -717,11 +717,11 @@ static size_t ulaw_read_ulaw2s(SndFile *psf, short *ptr, size_t len)
 
 static size_t ulaw_read_ulaw2i(SndFile *psf, int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -740,14 +740,14 @@ static size_t ulaw_read_ulaw2i(SndFile *psf, int *ptr, size_t len)
 
 static size_t ulaw_read_ulaw2f(SndFile *psf, float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
     float normfact;
 
     normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x8000) : 1.0);
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -766,13 +766,13 @@ static size_t ulaw_read_ulaw2f(SndFile *psf, float *ptr, size_t len)
 
 static size_t ulaw_read_ulaw2d(SndFile *psf, double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, readcount;
     size_t total = 0;
     double normfact;
 
     normfact = (psf->m_norm_double) ? 1.0 / ((double)0x8000) : 1.0;
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -791,11 +791,11 @@ static size_t ulaw_read_ulaw2d(SndFile *psf, double *ptr, size_t len)
 
 static size_t ulaw_write_s2ulaw(SndFile *psf, const short *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -814,11 +814,11 @@ static size_t ulaw_write_s2ulaw(SndFile *psf, const short *ptr, size_t len)
 
 static size_t ulaw_write_i2ulaw(SndFile *psf, const int *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -837,7 +837,7 @@ static size_t ulaw_write_i2ulaw(SndFile *psf, const int *ptr, size_t len)
 
 static size_t ulaw_write_f2ulaw(SndFile *psf, const float *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
     float normfact;
@@ -845,7 +845,7 @@ static size_t ulaw_write_f2ulaw(SndFile *psf, const float *ptr, size_t len)
     /* Factor in a divide by 4. */
     normfact = (float)((psf->m_norm_float == SF_TRUE) ? (0.25 * 0x7FFF) : 0.25);
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -864,7 +864,7 @@ static size_t ulaw_write_f2ulaw(SndFile *psf, const float *ptr, size_t len)
 
 static size_t ulaw_write_d2ulaw(SndFile *psf, const double *ptr, size_t len)
 {
-    BUF_UNION ubuf;
+    IO_BUFFER ubuf;
     size_t bufferlen, writecount;
     size_t total = 0;
     double normfact;
@@ -872,7 +872,7 @@ static size_t ulaw_write_d2ulaw(SndFile *psf, const double *ptr, size_t len)
     /* Factor in a divide by 4. */
     normfact = (psf->m_norm_double) ? (0.25 * 0x7FFF) : 0.25;
 
-    bufferlen = ARRAY_LEN(ubuf.ucbuf);
+    bufferlen = psf->get_io_buffer(&ubuf) / sizeof(unsigned char);
 
     while (len > 0)
     {
@@ -42,6 +42,21 @@
 #include "shift.h"
 #include "ima_oki_adpcm.h"
 
+typedef struct
+{
+    IMA_OKI_ADPCM codec;
+
+    /* Bytes of codes read so far. */
+    sf_count_t position;
+
+    /* Second sample of the last code byte when a read ended between them. */
+    bool has_pending;
+    short pending;
+} VOX_PRIVATE;
+
+/* The codec's last_output and step_index. */
+#define VOX_STATE_LEN (2)
+
 static size_t vox_read_s(SndFile *psf, short *ptr, size_t len);
 static size_t vox_read_i(SndFile *psf, int *ptr, size_t len);
 static size_t vox_read_f(SndFile *psf, float *ptr, size_t len);
@@ -52,11 +67,14 @@ static size_t vox_write_i(SndFile *psf, const int *ptr, size_t len);
 static size_t vox_write_f(SndFile *psf, const float *ptr, size_t len);
 static size_t vox_write_d(SndFile *psf, const double *ptr, size_t len);
 
-static size_t vox_read_block(SndFile *psf, IMA_OKI_ADPCM *pvox, short *ptr, size_t len);
+static size_t vox_read_block(SndFile *psf, VOX_PRIVATE *pvox, short *ptr, size_t len);
+
+static sf_count_t vox_seek(SndFile *psf, int mode, sf_count_t offset);
+static bool vox_check_checkpoint(SndFile *psf, sf_count_t frame, sf_count_t offset, const int32_t *state);
 
 static int codec_close(SndFile *psf)
 {
-    IMA_OKI_ADPCM *p = (IMA_OKI_ADPCM *)psf->m_codec_data;
+    IMA_OKI_ADPCM *p = &((VOX_PRIVATE *)psf->m_codec_data)->codec;
 
     if (p->errors)
         psf->log_printf("*** Warning : ADPCM state errors: %d\n", p->errors);
@@ -65,7 +83,7 @@ static int codec_close(SndFile *psf)
 
 int vox_adpcm_init(SndFile *psf)
 {
-    IMA_OKI_ADPCM *pvox = NULL;
+    VOX_PRIVATE *pvox = NULL;
 
     if (psf->m_mode == SFM_RDWR)
         return SFE_BAD_MODE_RW;
@@ -73,11 +91,11 @@ int vox_adpcm_init(SndFile *psf)
     if (psf->m_mode == SFM_WRITE && psf->sf.channels != 1)
         return SFE_CHANNEL_COUNT;
 
-    if ((pvox = (IMA_OKI_ADPCM *)malloc(sizeof(IMA_OKI_ADPCM))) == NULL)
+    if ((pvox = (VOX_PRIVATE *)malloc(sizeof(VOX_PRIVATE))) == NULL)
         return SFE_MALLOC_FAILED;
 
     psf->m_codec_data = (void *)pvox;
-    memset(pvox, 0, sizeof(IMA_OKI_ADPCM));
+    memset(pvox, 0, sizeof(VOX_PRIVATE));
 
     if (psf->m_mode == SFM_WRITE)
     {
@@ -95,6 +113,12 @@ int vox_adpcm_init(SndFile *psf)
         psf->read_int = vox_read_i;
         psf->read_float = vox_read_f;
         psf->read_double = vox_read_d;
+
+        psf->seek_from_start = vox_seek;
+
+        psf->m_checkpoints = psf_checkpoints_new(VOX_STATE_LEN, vox_check_checkpoint);
+        if (psf->m_checkpoints == NULL)
+            return SFE_MALLOC_FAILED;
     };
 
     /* Standard sample rate chennels etc. */
@@ -104,41 +128,67 @@ int vox_adpcm_init(SndFile *psf)
 
     psf->sf.frames = psf->m_filelength * 2;
 
-    psf->sf.seekable = SF_FALSE;
+    if (psf->m_mode == SFM_WRITE)
+        psf->sf.seekable = SF_FALSE;
     psf->codec_close = codec_close;
 
     /* Seek back to start of data. */
     if (psf->fseek(0, SEEK_SET) == -1)
         return SFE_BAD_SEEK;
 
-    ima_oki_adpcm_init(pvox, IMA_OKI_ADPCM_TYPE_OKI);
+    ima_oki_adpcm_init(&pvox->codec, IMA_OKI_ADPCM_TYPE_OKI);
 
     return 0;
 }
 
-static size_t vox_read_block(SndFile *psf, IMA_OKI_ADPCM *pvox, short *ptr, size_t len)
+static size_t vox_read_block(SndFile *psf, VOX_PRIVATE *pvox, short *ptr, size_t len)
 {
-    size_t indx = 0, k;
+    IMA_OKI_ADPCM *codec = &pvox->codec;
+    int32_t state[VOX_STATE_LEN];
+    size_t indx = 0, k, count;
+
+    if (len > 0 && pvox->has_pending)
+    {
+        ptr[indx++] = pvox->pending;
+        pvox->has_pending = false;
+    };
 
     while (indx < len)
     {
-        pvox->code_count =
+        codec->code_count =
             (len - indx > IMA_OKI_ADPCM_PCM_LEN) ? IMA_OKI_ADPCM_CODE_LEN : (len - indx + 1) / 2;
 
-        if ((k = psf->fread(pvox->codes, 1, pvox->code_count)) != pvox->code_count)
+        if (2 * pvox->position >= psf_checkpoints_next(psf->m_checkpoints))
+        {
+            state[0] = codec->last_output;
+            state[1] = codec->step_index;
+            psf_checkpoints_add(psf->m_checkpoints, 2 * pvox->position, pvox->position, state);
+        };
+
+        if ((k = psf->fread(codec->codes, 1, codec->code_count)) != codec->code_count)
         {
             if (psf->ftell() != psf->m_filelength)
-                psf->log_printf("*** Warning : short read (%d != %d).\n", k, pvox->code_count);
+                psf->log_printf("*** Warning : short read (%d != %d).\n", k, codec->code_count);
             if (k == 0)
                 break;
         };
 
-        pvox->code_count = k;
+        codec->code_count = k;
+        pvox->position += k;
 
-        ima_oki_adpcm_decode_block(pvox);
+        ima_oki_adpcm_decode_block(codec);
 
-        memcpy(&(ptr[indx]), pvox->pcm, pvox->pcm_count * sizeof(short));
-        indx += pvox->pcm_count;
+        /* Each code byte holds two samples, an odd length leaves one over. */
+        count = (size_t)codec->pcm_count;
+        if (count > len - indx)
+        {
+            count = len - indx;
+            pvox->has_pending = true;
+            pvox->pending = codec->pcm[count];
+        };
+
+        memcpy(&(ptr[indx]), codec->pcm, count * sizeof(short));
+        indx += count;
     };
 
     return indx;
@@ -146,13 +196,13 @@ static size_t vox_read_block(SndFile *psf, IMA_OKI_ADPCM *pvox, short *ptr, size
 
 static size_t vox_read_s(SndFile *psf, short *ptr, size_t len)
 {
-    IMA_OKI_ADPCM *pvox;
+    VOX_PRIVATE *pvox;
     size_t readcount, count;
     size_t total = 0;
 
     if (!psf->m_codec_data)
         return 0;
-    pvox = (IMA_OKI_ADPCM *)psf->m_codec_data;
+    pvox = (VOX_PRIVATE *)psf->m_codec_data;
 
     while (len > 0)
     {
@@ -171,7 +221,7 @@ static size_t vox_read_s(SndFile *psf, short *ptr, size_t len)
 
 static size_t vox_read_i(SndFile *psf, int *ptr, size_t len)
 {
-    IMA_OKI_ADPCM *pvox;
+    VOX_PRIVATE *pvox;
     BUF_UNION ubuf;
     short *sptr;
     size_t k, bufferlen, readcount, count;
@@ -179,7 +229,7 @@ static size_t vox_read_i(SndFile *psf, int *ptr, size_t len)
 
     if (!psf->m_codec_data)
         return 0;
-    pvox = (IMA_OKI_ADPCM *)psf->m_codec_data;
+    pvox = (VOX_PRIVATE *)psf->m_codec_data;
 
     sptr = ubuf.sbuf;
     bufferlen = ARRAY_LEN(ubuf.sbuf);
@@ -200,7 +250,7 @@ static size_t vox_read_i(SndFile *psf, int *ptr, size_t len)
 
 static size_t vox_read_f(SndFile *psf, float *ptr, size_t len)
 {
-    IMA_OKI_ADPCM *pvox;
+    VOX_PRIVATE *pvox;
     BUF_UNION ubuf;
     short *sptr;
     size_t k, bufferlen, readcount, count;
@@ -209,7 +259,7 @@ static size_t vox_read_f(SndFile *psf, float *ptr, size_t len)
 
     if (!psf->m_codec_data)
         return 0;
-    pvox = (IMA_OKI_ADPCM *)psf->m_codec_data;
+    pvox = (VOX_PRIVATE *)psf->m_codec_data;
 
     normfact = (float)((psf->m_norm_float == SF_TRUE) ? 1.0 / ((float)0x8000) : 1.0);
 
@@ -232,7 +282,7 @@ static size_t vox_read_f(SndFile *psf, float *ptr, size_t len)
 
 static size_t vox_read_d(SndFile *psf, double *ptr, size_t len)
 {
-    IMA_OKI_ADPCM *pvox;
+    VOX_PRIVATE *pvox;
     BUF_UNION ubuf;
     short *sptr;
     size_t k, bufferlen, readcount, count;
@@ -241,7 +291,7 @@ static size_t vox_read_d(SndFile *psf, double *ptr, size_t len)
 
     if (!psf->m_codec_data)
         return 0;
-    pvox = (IMA_OKI_ADPCM *)psf->m_codec_data;
+    pvox = (VOX_PRIVATE *)psf->m_codec_data;
 
     normfact = (psf->m_norm_double == SF_TRUE) ? 1.0 / ((double)0x8000) : 1.0;
 
@@ -262,22 +312,23 @@ static size_t vox_read_d(SndFile *psf, double *ptr, size_t len)
     return total;
 }
 
-static size_t vox_write_block(SndFile *psf, IMA_OKI_ADPCM *pvox, const short *ptr, size_t len)
+static size_t vox_write_block(SndFile *psf, VOX_PRIVATE *pvox, const short *ptr, size_t len)
 {
+    IMA_OKI_ADPCM *codec = &pvox->codec;
     size_t indx = 0, k;
 
     while (indx < len)
     {
-        pvox->pcm_count = (len - indx > IMA_OKI_ADPCM_PCM_LEN) ? IMA_OKI_ADPCM_PCM_LEN : len - indx;
+        codec->pcm_count = (len - indx > IMA_OKI_ADPCM_PCM_LEN) ? IMA_OKI_ADPCM_PCM_LEN : len - indx;
 
-        memcpy(pvox->pcm, &(ptr[indx]), pvox->pcm_count * sizeof(short));
+        memcpy(codec->pcm, &(ptr[indx]), codec->pcm_count * sizeof(short));
 
-        ima_oki_adpcm_encode_block(pvox);
+        ima_oki_adpcm_encode_block(codec);
 
-        if ((k = psf->fwrite(pvox->codes, 1, pvox->code_count)) != pvox->code_count)
-            psf->log_printf("*** Warning : short write (%d != %d).\n", k, pvox->code_count);
+        if ((k = psf->fwrite(codec->codes, 1, codec->code_count)) != codec->code_count)
+            psf->log_printf("*** Warning : short write (%d != %d).\n", k, codec->code_count);
 
-        indx += pvox->pcm_count;
+        indx += codec->pcm_count;
     };
 
     return indx;
@@ -285,13 +336,13 @@ static size_t vox_write_block(SndFile *psf, IMA_OKI_ADPCM *pvox, const short *pt
 
 static size_t vox_write_s(SndFile *psf, const short *ptr, size_t len)
 {
-    IMA_OKI_ADPCM *pvox;
+    VOX_PRIVATE *pvox;
     size_t writecount, count;
     size_t total = 0;
 
     if (!psf->m_codec_data)
         return 0;
-    pvox = (IMA_OKI_ADPCM *)psf->m_codec_data;
+    pvox = (VOX_PRIVATE *)psf->m_codec_data;
 
     while (len)
     {
@@ -310,7 +361,7 @@ static size_t vox_write_s(SndFile *psf, const short *ptr, size_t len)
 
 static size_t vox_write_i(SndFile *psf, const int *ptr, size_t len)
 {
-    IMA_OKI_ADPCM *pvox;
+    VOX_PRIVATE *pvox;
     BUF_UNION ubuf;
     short *sptr;
     size_t k, bufferlen, writecount, count;
@@ -318,7 +369,7 @@ static size_t vox_write_i(SndFile *psf, const int *ptr, size_t len)
 
     if (!psf->m_codec_data)
         return 0;
-    pvox = (IMA_OKI_ADPCM *)psf->m_codec_data;
+    pvox = (VOX_PRIVATE *)psf->m_codec_data;
 
     sptr = ubuf.sbuf;
     bufferlen = ARRAY_LEN(ubuf.sbuf);
@@ -339,7 +390,7 @@ static size_t vox_write_i(SndFile *psf, const int *ptr, size_t len)
 
 static size_t vox_write_f(SndFile *psf, const float *ptr, size_t len)
 {
-    IMA_OKI_ADPCM *pvox;
+    VOX_PRIVATE *pvox;
     BUF_UNION ubuf;
     short *sptr;
     size_t k, bufferlen, writecount, count;
@@ -348,7 +399,7 @@ static size_t vox_write_f(SndFile *psf, const float *ptr, size_t len)
 
     if (!psf->m_codec_data)
         return 0;
-    pvox = (IMA_OKI_ADPCM *)psf->m_codec_data;
+    pvox = (VOX_PRIVATE *)psf->m_codec_data;
 
     normfact = (float)((psf->m_norm_float == SF_TRUE) ? (1.0 * 0x7FFF) : 1.0);
 
@@ -371,7 +422,7 @@ static size_t vox_write_f(SndFile *psf, const float *ptr, size_t len)
 
 static size_t vox_write_d(SndFile *psf, const double *ptr, size_t len)
 {
-    IMA_OKI_ADPCM *pvox;
+    VOX_PRIVATE *pvox;
     BUF_UNION ubuf;
     short *sptr;
     size_t k, bufferlen, writecount, count;
@@ -380,7 +431,7 @@ static size_t vox_write_d(SndFile *psf, const double *ptr, size_t len)
 
     if (!psf->m_codec_data)
         return 0;
-    pvox = (IMA_OKI_ADPCM *)psf->m_codec_data;
+    pvox = (VOX_PRIVATE *)psf->m_codec_data;
 
     normfact = (psf->m_norm_double == SF_TRUE) ? (1.0 * 0x7FFF) : 1.0;
 
@@ -400,3 +451,53 @@ static size_t vox_write_d(SndFile *psf, const double *ptr, size_t len)
 
     return total;
 }
+
+/*
+** The codec state depends on every sample before, so seeks restore the last
+** checkpoint before offset and decode forward from there.
+*/
+static sf_count_t vox_seek(SndFile *psf, int mode, sf_count_t offset)
+{
+    VOX_PRIVATE *pvox;
+    BUF_UNION ubuf;
+    int32_t state[VOX_STATE_LEN];
+    sf_count_t cp_frame, cp_offset, skip;
+    size_t readcount, count;
+
+    if (!psf->m_codec_data)
+        return 0;
+    pvox = (VOX_PRIVATE *)psf->m_codec_data;
+
+    if (mode != SFM_READ || !psf_checkpoints_find(psf->m_checkpoints, offset, &cp_frame, &cp_offset, state))
+    {
+        psf->m_error = SFE_BAD_SEEK;
+        return PSF_SEEK_ERROR;
+    };
+
+    if (psf->fseek(cp_offset, SEEK_SET) == PSF_SEEK_ERROR)
+        return PSF_SEEK_ERROR;
+
+    pvox->codec.last_output = state[0];
+    pvox->codec.step_index = state[1];
+    pvox->position = cp_offset;
+    pvox->has_pending = false;
+
+    skip = offset - cp_frame;
+    while (skip > 0)
+    {
+        readcount = (skip > (sf_count_t)ARRAY_LEN(ubuf.sbuf)) ? ARRAY_LEN(ubuf.sbuf) : (size_t)skip;
+        count = vox_read_block(psf, pvox, ubuf.sbuf, readcount);
+        skip -= count;
+        if (count != readcount)
+            break;
+    };
+
+    return offset - skip;
+}
+
+static bool vox_check_checkpoint(SndFile *psf, sf_count_t frame, sf_count_t offset, const int32_t *state)
+{
+    VOX_PRIVATE *pvox = (VOX_PRIVATE *)psf->m_codec_data;
+
+    return frame == 2 * offset && state[1] >= 0 && state[1] <= pvox->codec.max_step_index;
+}
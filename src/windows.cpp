@@ -43,6 +43,9 @@ void save_header_info(SndFile *psf);
 
 int sf_wchar_open(const wchar_t *path, SF_FILEMODE mode, SF_INFO *sfinfo, SNDFILE **sndfile)
 {
+    // Files are never memory mapped on Windows
+    mode = (SF_FILEMODE)(mode & ~SFM_MMAP);
+
     // Input parameters check
 
     if (mode != SFM_READ && mode != SFM_WRITE && mode != SFM_RDWR)
@@ -0,0 +1,189 @@
+/*
+** Copyright (C) 2026 agent <agent@local>
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "config.h"
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sf_unistd.h"
+
+#include "sndfile2k/sndfile2k.h"
+
+#include "utils.h"
+
+#define BUFFER_LEN (1 << 12)
+#define CHANNELS (2)
+#define CHUNK_FRAMES (300)
+
+template <typename T>
+static void borrow_test(const char *filename, int format);
+static void borrow_error_test(const char *filename);
+
+int main(void)
+{
+    /* Host layout, served from the mapping when possible. */
+    borrow_test<short>("borrow_short.wav", SF_FORMAT_WAV | SF_FORMAT_PCM_16);
+    borrow_test<int>("borrow_int.wav", SF_FORMAT_WAV | SF_FORMAT_PCM_32);
+    borrow_test<float>("borrow_float.wav", SF_FORMAT_WAV | SF_FORMAT_FLOAT);
+    borrow_test<double>("borrow_double.wav", SF_FORMAT_WAV | SF_FORMAT_DOUBLE);
+
+    /* Opposite endianness, served from the staging buffer. */
+    borrow_test<short>("borrow_short_be.raw", SF_FORMAT_RAW | SF_FORMAT_PCM_16 | SF_ENDIAN_BIG);
+    borrow_test<short>("borrow_short_le.raw", SF_FORMAT_RAW | SF_FORMAT_PCM_16 | SF_ENDIAN_LITTLE);
+    borrow_test<float>("borrow_float_be.raw", SF_FORMAT_RAW | SF_FORMAT_FLOAT | SF_ENDIAN_BIG);
+    borrow_test<double>("borrow_double_le.raw", SF_FORMAT_RAW | SF_FORMAT_DOUBLE | SF_ENDIAN_LITTLE);
+
+    borrow_error_test("borrow_error.wav");
+
+    return 0;
+}
+
+template <typename T>
+static void borrow_test(const char *filename, int format)
+{
+    static T data[BUFFER_LEN];
+    static const SF_FILEMODE modes[] = {SFM_READ, (SF_FILEMODE)(SFM_READ | SFM_MMAP)};
+
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    sf_count_t frames, total = 0;
+    const void *ptr;
+
+    print_test_name(__func__, filename);
+
+    for (int k = 0; k < BUFFER_LEN; k++)
+        data[k] = (T)(k * 3 - BUFFER_LEN);
+
+    sf_info_clear(&sfinfo);
+    sfinfo.samplerate = 44100;
+    sfinfo.channels = CHANNELS;
+    sfinfo.format = format;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    sf_command(file, SFC_SET_NORM_FLOAT, NULL, SF_FALSE);
+    sf_command(file, SFC_SET_NORM_DOUBLE, NULL, SF_FALSE);
+    if (sizeof(T) == sizeof(short))
+        test_write_short_or_die(file, 0, (const short *)data, BUFFER_LEN, __LINE__);
+    else if ((format & SF_FORMAT_SUBMASK) == SF_FORMAT_PCM_32)
+        test_write_int_or_die(file, 0, (const int *)data, BUFFER_LEN, __LINE__);
+    else if (sizeof(T) == sizeof(float))
+        test_write_float_or_die(file, 0, (const float *)data, BUFFER_LEN, __LINE__);
+    else
+        test_write_double_or_die(file, 0, (const double *)data, BUFFER_LEN, __LINE__);
+    sf_close(file);
+
+    /* Read into the internal buffer, then straight from the mapping. */
+    for (size_t m = 0; m < ARRAY_LEN(modes); m++)
+    {
+        file = test_open_file_or_die(filename, modes[m], &sfinfo, __LINE__);
+        total = 0;
+
+        while ((frames = sf_borrow_frames(file, &ptr, CHUNK_FRAMES)) > 0)
+        {
+            const T *borrowed = (const T *)ptr;
+
+            exit_if_true(total + frames > BUFFER_LEN / CHANNELS, "\n\nLine %d : Borrowed past end of file.\n", __LINE__);
+
+            for (sf_count_t k = 0; k < frames * CHANNELS; k++)
+                exit_if_true(borrowed[k] != data[total * CHANNELS + k], "\n\nLine %d : Mismatch at sample %" PRId64 ".\n",
+                             __LINE__, total * CHANNELS + k);
+
+            total += frames;
+
+            exit_if_true(sf_seek(file, 0, SEEK_CUR) != total,
+                         "\n\nLine %d : Bad read position %" PRId64 " (should be %" PRId64 ").\n", __LINE__,
+                         sf_seek(file, 0, SEEK_CUR), total);
+
+            exit_if_true(sf_release_frames(file, ptr) != SF_ERR_NO_ERROR, "\n\nLine %d : sf_release_frames failed : %s\n",
+                         __LINE__, sf_strerror(file));
+        };
+
+        exit_if_true(sf_error(file) != SF_ERR_NO_ERROR, "\n\nLine %d : sf_borrow_frames failed : %s\n", __LINE__,
+                     sf_strerror(file));
+        exit_if_true(total != BUFFER_LEN / CHANNELS, "\n\nLine %d : Borrowed %" PRId64 " frames (should be %d).\n", __LINE__,
+                     total, BUFFER_LEN / CHANNELS);
+
+        /* Ordinary reads must carry on from where borrowing left off. */
+        test_seek_or_die(file, 10, SEEK_SET, 10, CHANNELS, __LINE__);
+        exit_if_true(sf_borrow_frames(file, &ptr, 1) != 1, "\n\nLine %d : sf_borrow_frames failed.\n", __LINE__);
+        exit_if_true(((const T *)ptr)[0] != data[10 * CHANNELS], "\n\nLine %d : Bad frame after seek.\n", __LINE__);
+        sf_release_frames(file, ptr);
+
+        sf_close(file);
+    };
+
+    unlink(filename);
+    puts("ok");
+}
+
+static void borrow_error_test(const char *filename)
+{
+    static int data[BUFFER_LEN];
+
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    const void *ptr, *other;
+
+    print_test_name(__func__, filename);
+
+    sf_info_clear(&sfinfo);
+    sfinfo.samplerate = 44100;
+    sfinfo.channels = 1;
+    sfinfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_24;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+
+    exit_if_true(sf_borrow_frames(file, &ptr, 10) != 0 || sf_error(file) == SF_ERR_NO_ERROR,
+                 "\n\nLine %d : Borrowing from write mode file should fail.\n", __LINE__);
+
+    test_write_int_or_die(file, 0, data, BUFFER_LEN, __LINE__);
+    sf_close(file);
+
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    exit_if_true(sf_borrow_frames(file, &ptr, 10) != 0 || sf_error(file) == SF_ERR_NO_ERROR,
+                 "\n\nLine %d : Borrowing 24 bit frames should fail.\n", __LINE__);
+    sf_close(file);
+
+    sfinfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    test_write_int_or_die(file, 0, data, BUFFER_LEN, __LINE__);
+    sf_close(file);
+
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+
+    exit_if_true(sf_release_frames(file, data) == SF_ERR_NO_ERROR, "\n\nLine %d : Releasing unborrowed frames should fail.\n",
+                 __LINE__);
+
+    exit_if_true(sf_borrow_frames(file, &ptr, 10) != 10, "\n\nLine %d : sf_borrow_frames failed : %s\n", __LINE__,
+                 sf_strerror(file));
+    exit_if_true(sf_borrow_frames(file, &other, 10) != 0 || sf_error(file) == SF_ERR_NO_ERROR,
+                 "\n\nLine %d : Second borrow should fail.\n", __LINE__);
+    exit_if_true(sf_release_frames(file, ptr) != SF_ERR_NO_ERROR, "\n\nLine %d : sf_release_frames failed : %s\n", __LINE__,
+                 sf_strerror(file));
+    exit_if_true(sf_release_frames(file, ptr) == SF_ERR_NO_ERROR, "\n\nLine %d : Double release should fail.\n", __LINE__);
+
+    sf_close(file);
+
+    unlink(filename);
+    puts("ok");
+}
@@ -36,6 +36,7 @@
 static void chunk_test(const char *filename, int format);
 static void wav_subchunk_test(size_t chunk_size);
 static void large_free_test(const char *filename, int format, size_t chunk_size);
+static void alac_layout_test(const char *filename);
 
 int main(int argc, char *argv[])
 {
@@ -80,6 +81,7 @@ int main(int argc, char *argv[])
         chunk_test("chunks_alac.caf", SF_FORMAT_CAF | SF_FORMAT_ALAC_16);
         large_free_test("large_free.caf", SF_FORMAT_CAF | SF_FORMAT_PCM_16, 100);
         large_free_test("large_free.caf", SF_FORMAT_CAF | SF_FORMAT_PCM_16, 20000);
+        alac_layout_test("alac_layout.caf");
         test_count++;
     };
 
@@ -386,3 +388,85 @@ static void large_free_test(const char *filename, int format, size_t chunk_size)
     unlink(filename);
     puts("ok");
 }
+
+static uint64_t read_be64(const unsigned char *p)
+{
+    uint64_t value = 0;
+
+    for (int k = 0; k < 8; k++)
+        value = (value << 8) | p[k];
+
+    return value;
+}
+
+/* ALAC packets are written straight after the header, the 'pakt' chunk follows the data. */
+static void alac_layout_test(const char *filename)
+{
+    const sf_count_t frames = 10000;
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    FILE *raw;
+    short *data, *check;
+    unsigned char header[12];
+    long data_pos = -1, pakt_pos = -1, pos = 8, filelen;
+
+    print_test_name(__func__, filename);
+
+    data = (short *)malloc(frames * 2 * sizeof(short));
+    check = (short *)malloc(frames * 2 * sizeof(short));
+    exit_if_true(data == NULL || check == NULL, "\n\nLine %d : malloc failed.\n", __LINE__);
+
+    for (sf_count_t k = 0; k < frames * 2; k++)
+        data[k] = (short)(10000.0 * sin(k * 0.01) + (k % 7) * 300);
+
+    sfinfo.samplerate = 44100;
+    sfinfo.channels = 2;
+    sfinfo.frames = 0;
+    sfinfo.format = SF_FORMAT_CAF | SF_FORMAT_ALAC_16;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    test_writef_short_or_die(file, 0, data, frames, __LINE__);
+    /* Set after the data, so it goes after it too. */
+    sf_set_string(file, SF_STR_COMMENT, "alac layout");
+    sf_close(file);
+
+    raw = fopen(filename, "rb");
+    exit_if_true(raw == NULL, "\n\nLine %d : fopen failed.\n", __LINE__);
+    fseek(raw, 0, SEEK_END);
+    filelen = ftell(raw);
+
+    /* Walk the chunks, they have to cover the file exactly. */
+    while (pos < filelen)
+    {
+        fseek(raw, pos, SEEK_SET);
+        exit_if_true(fread(header, 1, sizeof(header), raw) != sizeof(header),
+                     "\n\nLine %d : Short chunk header at %ld.\n", __LINE__, pos);
+
+        if (memcmp(header, "data", 4) == 0)
+            data_pos = pos;
+        else if (memcmp(header, "pakt", 4) == 0)
+            pakt_pos = pos;
+
+        pos += sizeof(header) + (long)read_be64(header + 4);
+    };
+    fclose(raw);
+
+    exit_if_true(pos != filelen, "\n\nLine %d : Chunks end at %ld, file is %ld bytes.\n", __LINE__, pos, filelen);
+    exit_if_true(data_pos < 0 || pakt_pos < data_pos,
+                 "\n\nLine %d : 'data' at %ld, 'pakt' at %ld.\n", __LINE__, data_pos, pakt_pos);
+
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    exit_if_true(sfinfo.frames != frames, "\n\nLine %d : %ld frames, should be %ld.\n", __LINE__,
+                 (long)sfinfo.frames, (long)frames);
+    test_readf_short_or_die(file, 0, check, frames, __LINE__);
+    exit_if_true(memcmp(check, data, frames * 2 * sizeof(short)) != 0,
+                 "\n\nLine %d : Data read back differs.\n", __LINE__);
+    exit_if_true(sf_get_string(file, SF_STR_COMMENT) == NULL || strcmp(sf_get_string(file, SF_STR_COMMENT), "alac layout") != 0,
+                 "\n\nLine %d : Comment string lost.\n", __LINE__);
+    sf_close(file);
+
+    free(data);
+    free(check);
+    unlink(filename);
+    puts("ok");
+}
@@ -0,0 +1,266 @@
+/*
+** Copyright (C) 2026 agent <agent@local>
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "config.h"
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <thread>
+#include <vector>
+
+#include "sf_unistd.h"
+
+#include "sndfile2k/sndfile2k.h"
+
+#include "utils.h"
+
+#define BUFFER_LEN (1 << 16)
+#define CHANNELS (2)
+#define READERS (4)
+
+static void clone_test(const char *filename, int format, SF_FILEMODE mode);
+static void clone_error_test(const char *filename);
+static void parallel_read_test(const char *filename, int format, int channels);
+
+int main(void)
+{
+    /* Memory mapped. */
+    clone_test("clone_mmap.wav", SF_FORMAT_WAV | SF_FORMAT_PCM_16, (SF_FILEMODE)(SFM_READ | SFM_MMAP));
+    clone_test("clone_mmap.aiff", SF_FORMAT_AIFF | SF_FORMAT_FLOAT, (SF_FILEMODE)(SFM_READ | SFM_MMAP));
+    clone_test("clone_mmap.raw", SF_FORMAT_RAW | SF_FORMAT_PCM_16 | SF_ENDIAN_BIG, (SF_FILEMODE)(SFM_READ | SFM_MMAP));
+
+    /* Read with pread() through a dup()ed descriptor. */
+    clone_test("clone_pread.wav", SF_FORMAT_WAV | SF_FORMAT_PCM_16, SFM_READ);
+    clone_test("clone_pread.aiff", SF_FORMAT_AIFF | SF_FORMAT_FLOAT, SFM_READ);
+    clone_test("clone_pread.raw", SF_FORMAT_RAW | SF_FORMAT_PCM_16 | SF_ENDIAN_BIG, SFM_READ);
+
+    clone_error_test("clone_error.wav");
+
+    parallel_read_test("parallel.wav", SF_FORMAT_WAV | SF_FORMAT_PCM_16, CHANNELS);
+    parallel_read_test("parallel.w64", SF_FORMAT_W64 | SF_FORMAT_IMA_ADPCM, CHANNELS);
+    /* Seeks by decoding, read on one thread. */
+    parallel_read_test("parallel.aiff", SF_FORMAT_AIFF | SF_FORMAT_DWVW_16, 1);
+#ifdef HAVE_XIPH_CODECS
+    parallel_read_test("parallel.flac", SF_FORMAT_FLAC | SF_FORMAT_PCM_16, CHANNELS);
+#endif
+
+    return 0;
+}
+
+static void clone_test(const char *filename, int format, SF_FILEMODE mode)
+{
+    static short data[BUFFER_LEN];
+
+    SNDFILE *file;
+    SNDFILE *clones[READERS];
+    SF_INFO sfinfo;
+    bool failed[READERS] = {};
+    std::vector<std::thread> threads;
+
+    print_test_name(__func__, filename);
+
+    for (int k = 0; k < BUFFER_LEN; k++)
+        data[k] = (short)(k * 7 - BUFFER_LEN);
+
+    sf_info_clear(&sfinfo);
+    sfinfo.samplerate = 44100;
+    sfinfo.channels = CHANNELS;
+    sfinfo.format = format;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    test_write_short_or_die(file, 0, data, BUFFER_LEN, __LINE__);
+    sf_close(file);
+
+    file = test_open_file_or_die(filename, mode, &sfinfo, __LINE__);
+
+    /* Clones start at the beginning, whatever the position of the original. */
+    test_seek_or_die(file, 100, SEEK_SET, 100, CHANNELS, __LINE__);
+
+    for (int k = 0; k < READERS; k++)
+    {
+        clones[k] = NULL;
+        exit_if_true(sf_clone(file, &clones[k]) != SF_ERR_NO_ERROR, "\n\nLine %d : sf_clone failed : %s\n", __LINE__,
+                     sf_strerror(file));
+        exit_if_true(sf_seek(clones[k], 0, SEEK_CUR) != 0, "\n\nLine %d : Clone %d not at start of data.\n", __LINE__, k);
+    }
+
+    const sf_count_t frames = BUFFER_LEN / CHANNELS;
+    const sf_count_t span = frames / READERS;
+
+    /* Each reader walks its own part of the file, the first one backwards. */
+    for (int k = 0; k < READERS; k++)
+    {
+        threads.emplace_back([&, k]() {
+            short buffer[CHANNELS * 64];
+            SNDFILE *reader = clones[k];
+
+            for (sf_count_t pos = 0; pos < span; pos += 64)
+            {
+                sf_count_t start = k * span + (k == 0 ? span - 64 - pos : pos);
+
+                if (sf_seek(reader, start, SEEK_SET) != start || sf_readf_short(reader, buffer, 64) != 64 ||
+                    memcmp(buffer, data + start * CHANNELS, sizeof(buffer)) != 0)
+                {
+                    failed[k] = true;
+                    return;
+                }
+            }
+        });
+    }
+
+    for (auto &t : threads)
+        t.join();
+
+    for (int k = 0; k < READERS; k++)
+        exit_if_true(failed[k], "\n\nLine %d : Reader %d read bad data.\n", __LINE__, k);
+
+    /* The original is not disturbed by its clones. */
+    exit_if_true(sf_seek(file, 0, SEEK_CUR) != 100, "\n\nLine %d : Original handle moved.\n", __LINE__);
+
+    /* Clones outlive the handle they were cloned from. */
+    sf_close(file);
+
+    for (int k = 0; k < READERS; k++)
+    {
+        short value[CHANNELS];
+
+        test_seek_or_die(clones[k], frames - 1, SEEK_SET, frames - 1, CHANNELS, __LINE__);
+        test_readf_short_or_die(clones[k], 0, value, 1, __LINE__);
+        exit_if_true(memcmp(value, data + BUFFER_LEN - CHANNELS, sizeof(value)) != 0,
+                     "\n\nLine %d : Bad last frame from clone %d.\n", __LINE__, k);
+        sf_close(clones[k]);
+    }
+
+    unlink(filename);
+    puts("ok");
+}
+
+static void clone_error_test(const char *filename)
+{
+    static short data[BUFFER_LEN];
+
+    SNDFILE *file, *clone = NULL;
+    SF_INFO sfinfo;
+
+    print_test_name(__func__, filename);
+
+    sf_info_clear(&sfinfo);
+    sfinfo.samplerate = 44100;
+    sfinfo.channels = 1;
+    sfinfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+
+    exit_if_true(sf_clone(file, &clone) == SF_ERR_NO_ERROR || clone != NULL,
+                 "\n\nLine %d : Cloning a write mode file should fail.\n", __LINE__);
+
+    test_write_short_or_die(file, 0, data, BUFFER_LEN, __LINE__);
+    sf_close(file);
+
+    exit_if_true(sf_clone(NULL, &clone) == SF_ERR_NO_ERROR, "\n\nLine %d : Cloning NULL should fail.\n", __LINE__);
+
+    /* A failed clone only returns its error, the original may be in use on another thread. */
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    exit_if_true(sf_clone(file, NULL) == SF_ERR_NO_ERROR, "\n\nLine %d : Cloning into NULL should fail.\n", __LINE__);
+    exit_if_true(sf_error(file) != SF_ERR_NO_ERROR, "\n\nLine %d : Failed clone set an error on the original : %s\n",
+                 __LINE__, sf_strerror(file));
+    sf_close(file);
+
+    unlink(filename);
+    puts("ok");
+}
+
+static void parallel_read_test(const char *filename, int format, int channels)
+{
+    /* Enough for several parts of the minimum size, with an uneven tail. */
+    const sf_count_t frames = 5 * 65536 + 321;
+    const sf_count_t start = 1000;
+
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    short *data, *serial, *parallel;
+    int *idata, *iparallel;
+    sf_count_t count, length;
+
+    print_test_name(__func__, filename);
+
+    data = (short *)malloc(frames * channels * sizeof(short));
+    /* Block based codecs pad the last block. */
+    serial = (short *)calloc((frames + 4096) * channels, sizeof(short));
+    parallel = (short *)calloc((frames + 4096) * channels, sizeof(short));
+    idata = (int *)calloc((frames + 4096) * channels, sizeof(int));
+    iparallel = (int *)calloc((frames + 4096) * channels, sizeof(int));
+    exit_if_true(!data || !serial || !parallel || !idata || !iparallel, "\n\nLine %d : malloc failed.\n", __LINE__);
+
+    for (sf_count_t k = 0; k < frames * channels; k++)
+        data[k] = (short)((k * 7919) % 20011 - 10005);
+
+    sf_info_clear(&sfinfo);
+    sfinfo.samplerate = 44100;
+    sfinfo.channels = channels;
+    sfinfo.format = format;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    test_writef_short_or_die(file, 0, data, frames, __LINE__);
+    sf_close(file);
+
+    /* Lossy codecs don't give back what was written, compare with a serial read. */
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    length = sfinfo.frames;
+    exit_if_true(length < frames || length > frames + 4096, "\n\nLine %d : File has %" PRId64 " frames.\n",
+                 __LINE__, length);
+    test_readf_short_or_die(file, 0, serial, length, __LINE__);
+    test_seek_or_die(file, 0, SEEK_SET, 0, channels, __LINE__);
+    test_readf_int_or_die(file, 0, idata, length, __LINE__);
+
+    test_seek_or_die(file, start, SEEK_SET, start, channels, __LINE__);
+    count = sf_readf_short_parallel(file, parallel, length, 4);
+    exit_if_true(count != length - start, "\n\nLine %d : Read %" PRId64 " frames, should be %" PRId64 ".\n",
+                 __LINE__, count, length - start);
+    exit_if_true(memcmp(parallel, serial + start * channels, count * channels * sizeof(short)) != 0,
+                 "\n\nLine %d : Parallel read differs from serial read.\n", __LINE__);
+    exit_if_true(sf_seek(file, 0, SEEK_CUR) != length, "\n\nLine %d : Read position not at end.\n", __LINE__);
+
+    /* One part per core. */
+    test_seek_or_die(file, 0, SEEK_SET, 0, channels, __LINE__);
+    count = sf_readf_int_parallel(file, iparallel, length - 17, 0);
+    exit_if_true(count != length - 17, "\n\nLine %d : Read %" PRId64 " frames, should be %" PRId64 ".\n",
+                 __LINE__, count, length - 17);
+    exit_if_true(memcmp(iparallel, idata, count * channels * sizeof(int)) != 0,
+                 "\n\nLine %d : Parallel read differs from serial read.\n", __LINE__);
+
+    /* Reading carries on where the parallel read stopped. */
+    test_readf_int_or_die(file, 0, iparallel, 17, __LINE__);
+    exit_if_true(memcmp(iparallel, idata + (length - 17) * channels, 17 * channels * sizeof(int)) != 0,
+                 "\n\nLine %d : Bad data after parallel read.\n", __LINE__);
+
+    sf_close(file);
+
+    free(data);
+    free(serial);
+    free(parallel);
+    free(idata);
+    free(iparallel);
+    unlink(filename);
+    puts("ok");
+}
@@ -50,6 +50,13 @@ static void cue_points_test(const char *filename, int filetype);
 static void channel_map_test(const char *filename, int filetype);
 static void current_sf_info_test(const char *filename);
 static void raw_needs_endswap_test(const char *filename, int filetype);
+static void io_block_size_test(const char *filename, int filetype);
+static void signal_stats_test(const char *filename, int filetype, int channels);
+static void alac_encoder_threads_test(const char *filename, int filetype);
+#ifdef HAVE_XIPH_CODECS
+static void seektable_test(const char *filename, int filetype);
+static void encoder_threads_test(const char *filename, int filetype);
+#endif
 
 /* Force the start of this buffer to be double aligned. Sparc-solaris will
 ** choke if its not.
@@ -77,6 +84,10 @@ int main(int argc, char *argv[])
         printf("           cue     - test set/get of SF_CUES and SF_CUE_POINTS.\n");
         printf("           chanmap - test set/get of channel map data..\n");
         printf("           rawend  - test SFC_RAW_NEEDS_ENDSWAP.\n");
+        printf("           ioblock - test SFC_SET_IO_BLOCK_SIZE.\n");
+        printf("           stats   - test SFC_CALC_SIGNAL_STATS.\n");
+        printf("           seektab - test SFC_SET_SEEKTABLE_SPACING.\n");
+        printf("           encthr  - test SFC_SET_ENCODER_THREADS.\n");
         printf("           all     - perform all tests\n");
         exit(1);
     };
@@ -172,6 +183,38 @@ int main(int argc, char *argv[])
         test_count++;
     };
 
+    if (do_all || strcmp(argv[1], "ioblock") == 0)
+    {
+        io_block_size_test("ioblock.wav", SF_FORMAT_WAV | SF_FORMAT_PCM_24);
+        io_block_size_test("ioblock.au", SF_FORMAT_AU | SF_FORMAT_ULAW);
+        test_count++;
+    };
+
+    if (do_all || strcmp(argv[1], "stats") == 0)
+    {
+        signal_stats_test("stats.wav", SF_FORMAT_WAV | SF_FORMAT_PCM_16, 2);
+        signal_stats_test("stats.aiff", SF_FORMAT_AIFF | SF_FORMAT_PCM_16, 3);
+        signal_stats_test("stats.caf", SF_FORMAT_CAF | SF_FORMAT_FLOAT, 1);
+        test_count++;
+    };
+
+    if (do_all || strcmp(argv[1], "seektab") == 0)
+    {
+#ifdef HAVE_XIPH_CODECS
+        seektable_test("seektable.flac", SF_FORMAT_FLAC | SF_FORMAT_PCM_16);
+#endif
+        test_count++;
+    };
+
+    if (do_all || strcmp(argv[1], "encthr") == 0)
+    {
+#ifdef HAVE_XIPH_CODECS
+        encoder_threads_test("encthr.flac", SF_FORMAT_FLAC | SF_FORMAT_PCM_24);
+#endif
+        alac_encoder_threads_test("encthr.caf", SF_FORMAT_CAF | SF_FORMAT_ALAC_24);
+        test_count++;
+    };
+
     if (test_count == 0)
     {
         printf("Mono : ************************************\n");
@@ -1130,3 +1173,416 @@ static void raw_needs_endswap_test(const char *filename, int filetype)
     unlink(filename);
     puts("ok");
 }
+
+static void io_block_size_test(const char *filename, int filetype)
+{
+    static short short_data[BUFFER_LEN], short_test[BUFFER_LEN];
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    sf_count_t block_size;
+    int k, tolerance;
+
+    print_test_name(__func__, filename);
+
+    for (k = 0; k < BUFFER_LEN; k++)
+        short_data[k] = (short)(k * 61);
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    sfinfo.samplerate = 11025;
+    sfinfo.format = filetype;
+    sfinfo.channels = 1;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+
+    /* Out of range values must be rejected. */
+    block_size = 100;
+    exit_if_true(sf_command(file, SFC_SET_IO_BLOCK_SIZE, &block_size, sizeof(block_size)) == 0,
+                 "\n\nLine %d : SFC_SET_IO_BLOCK_SIZE accepted %d.\n\n", __LINE__, (int)block_size);
+    block_size = 0;
+    sf_command(file, SFC_GET_IO_BLOCK_SIZE, &block_size, sizeof(block_size));
+    exit_if_true(block_size != 8192, "\n\nLine %d : Default block size is %d.\n\n", __LINE__, (int)block_size);
+
+    /* Smallest allowed block, so the write is split up. */
+    block_size = 1029;
+    exit_if_true(sf_command(file, SFC_SET_IO_BLOCK_SIZE, &block_size, sizeof(block_size)) != 0,
+                 "\n\nLine %d : SFC_SET_IO_BLOCK_SIZE failed.\n\n", __LINE__);
+    sf_command(file, SFC_GET_IO_BLOCK_SIZE, &block_size, sizeof(block_size));
+    exit_if_true(block_size != 1024, "\n\nLine %d : Block size is %d, should be 1024.\n\n", __LINE__, (int)block_size);
+
+    test_write_short_or_die(file, 0, short_data, BUFFER_LEN, __LINE__);
+    sf_close(file);
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+
+    block_size = 1024 * 1024;
+    exit_if_true(sf_command(file, SFC_SET_IO_BLOCK_SIZE, &block_size, sizeof(block_size)) != 0,
+                 "\n\nLine %d : SFC_SET_IO_BLOCK_SIZE failed.\n\n", __LINE__);
+
+    test_read_short_or_die(file, 0, short_test, BUFFER_LEN, __LINE__);
+    sf_close(file);
+
+    /* u-law is lossy. */
+    tolerance = ((filetype & SF_FORMAT_SUBMASK) == SF_FORMAT_ULAW) ? 1024 : 0;
+
+    for (k = 0; k < BUFFER_LEN; k++)
+    {
+        if (abs(short_data[k] - short_test[k]) > tolerance)
+        {
+            printf("\n\nLine %d : Mismatch at index %d (%d != %d).\n\n", __LINE__, k, short_data[k], short_test[k]);
+            exit(1);
+        };
+    };
+
+    unlink(filename);
+    puts("ok");
+}
+
+static void signal_stats_test(const char *filename, int filetype, int channels)
+{
+    /* Long enough to be split between several threads. */
+    const sf_count_t frames = 300001;
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    SF_SIGNAL_STATS stats[3], expected[3];
+    sf_count_t crossings[3];
+    char label[128];
+    short *data;
+    int k, chan;
+
+    snprintf(label, sizeof(label), "signal_stats_test (%d channels)", channels);
+    print_test_name(label, filename);
+
+    data = (short *)malloc(frames * channels * sizeof(short));
+    exit_if_true(data == NULL, "\n\nLine %d : malloc failed.\n", __LINE__);
+
+    /* Full scale negative samples count as clipped. */
+    for (k = 0; k < frames * channels; k++)
+        data[k] = (short)(((k / channels) * (k % channels + 3) * 97) % 65536 - 32768 + 1000 * (k % channels));
+
+    memset(expected, 0, sizeof(expected));
+    memset(crossings, 0, sizeof(crossings));
+    for (k = 0; k < frames; k++)
+    {
+        for (chan = 0; chan < channels; chan++)
+        {
+            double x = data[k * channels + chan] / 32768.0;
+
+            expected[chan].peak = fabs(x) > expected[chan].peak ? fabs(x) : expected[chan].peak;
+            expected[chan].rms += x * x;
+            expected[chan].dc_offset += x;
+            expected[chan].clip_count += fabs(x) >= 1.0;
+            if (k > 0 && (x < 0.0) != (data[(k - 1) * channels + chan] < 0))
+                crossings[chan]++;
+        };
+    };
+
+    sfinfo.samplerate = 44100;
+    sfinfo.format = filetype;
+    sfinfo.channels = channels;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    if ((filetype & SF_FORMAT_SUBMASK) == SF_FORMAT_FLOAT)
+    {
+        /* Written as floats, so they land in the same range as normalised shorts. */
+        for (k = 0; k < frames; k += BUFFER_LEN / channels)
+        {
+            int count = (int)(frames - k < BUFFER_LEN / channels ? frames - k : BUFFER_LEN / channels);
+
+            for (chan = 0; chan < count * channels; chan++)
+                float_data[chan] = data[k * channels + chan] / 32768.0f;
+            test_writef_float_or_die(file, 0, float_data, count, __LINE__);
+        };
+    }
+    else
+        test_writef_short_or_die(file, 0, data, frames, __LINE__);
+    sf_close(file);
+
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    test_seek_or_die(file, 1000, SEEK_SET, 1000, channels, __LINE__);
+
+    exit_if_true(sf_command(file, SFC_CALC_SIGNAL_STATS, stats, sizeof(stats[0])) == 0 && channels != 1,
+                 "\n\nLine %d : SFC_CALC_SIGNAL_STATS accepted a short buffer.\n", __LINE__);
+
+    exit_if_true(sf_command(file, SFC_CALC_SIGNAL_STATS, stats, channels * sizeof(stats[0])) != 0,
+                 "\n\nLine %d : SFC_CALC_SIGNAL_STATS failed : %s\n", __LINE__, sf_strerror(file));
+
+    for (chan = 0; chan < channels; chan++)
+    {
+        double rms = sqrt(expected[chan].rms / frames);
+        double dc_offset = expected[chan].dc_offset / frames;
+        double zcr = (double)crossings[chan] / (frames - 1);
+
+        exit_if_true(stats[chan].peak != expected[chan].peak, "\n\nLine %d : Channel %d peak is %f (should be %f).\n",
+                     __LINE__, chan, stats[chan].peak, expected[chan].peak);
+        exit_if_true(stats[chan].clip_count != expected[chan].clip_count,
+                     "\n\nLine %d : Channel %d clip count is %" PRId64 " (should be %" PRId64 ").\n", __LINE__, chan,
+                     stats[chan].clip_count, expected[chan].clip_count);
+        exit_if_true(fabs(stats[chan].rms - rms) > 1e-9, "\n\nLine %d : Channel %d RMS is %f (should be %f).\n", __LINE__,
+                     chan, stats[chan].rms, rms);
+        exit_if_true(fabs(stats[chan].dc_offset - dc_offset) > 1e-9,
+                     "\n\nLine %d : Channel %d DC offset is %f (should be %f).\n", __LINE__, chan, stats[chan].dc_offset,
+                     dc_offset);
+        exit_if_true(fabs(stats[chan].zero_crossing_rate - zcr) > 1e-12,
+                     "\n\nLine %d : Channel %d zero crossing rate is %f (should be %f).\n", __LINE__, chan,
+                     stats[chan].zero_crossing_rate, zcr);
+    };
+
+    /* The handle must be left where it was. */
+    exit_if_true(sf_seek(file, 0, SEEK_CUR) != 1000, "\n\nLine %d : Read position moved.\n", __LINE__);
+
+    sf_close(file);
+
+    free(data);
+    unlink(filename);
+    puts("ok");
+}
+
+static void alac_encoder_threads_test(const char *filename, int filetype)
+{
+    /* Several batches, the last one partly filled and ending in a short packet. */
+    const sf_count_t frames = 4096 * 200 + 777;
+    const int channels = 2;
+    char serial_name[64];
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    int *data, *check, threads;
+    sf_count_t k;
+
+    print_test_name("alac_encoder_threads_test", filename);
+
+    snprintf(serial_name, sizeof(serial_name), "serial-%s", filename);
+
+    data = (int *)malloc(frames * channels * sizeof(int));
+    check = (int *)malloc(frames * channels * sizeof(int));
+    exit_if_true(data == NULL || check == NULL, "\n\nLine %d : malloc failed.\n", __LINE__);
+
+    for (k = 0; k < frames; k++)
+    {
+        data[2 * k] = (int)lrint(0x30000000 * sin(k * 0.003) + 0x08000000 * sin(k * 0.41)) & ~0xFF;
+        data[2 * k + 1] = (int)lrint(0x20000000 * sin(k * 0.007)) & ~0xFF;
+    };
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    sfinfo.samplerate = 44100;
+    sfinfo.format = filetype;
+    sfinfo.channels = channels;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    threads = 3;
+    exit_if_true(sf_command(file, SFC_SET_ENCODER_THREADS, &threads, sizeof(threads)) != SF_TRUE,
+                 "\n\nLine %d : SFC_SET_ENCODER_THREADS failed.\n", __LINE__);
+    for (k = 0; k < frames; k += 10007)
+        test_writef_int_or_die(file, 0, data + k * channels, frames - k < 10007 ? frames - k : 10007, __LINE__);
+    exit_if_true(sf_command(file, SFC_SET_ENCODER_THREADS, &threads, sizeof(threads)) != SF_FALSE,
+                 "\n\nLine %d : SFC_SET_ENCODER_THREADS accepted after writing.\n", __LINE__);
+    sf_close(file);
+
+    file = test_open_file_or_die(serial_name, SFM_WRITE, &sfinfo, __LINE__);
+    test_writef_int_or_die(file, 0, data, frames, __LINE__);
+    sf_close(file);
+
+    /*
+    ** Each worker carries its own adaptive predictor state, so the packets
+    ** differ from a serial encode but must still decode to the same data.
+    */
+    for (int j = 0; j < 2; j++)
+    {
+        file = test_open_file_or_die(j == 0 ? filename : serial_name, SFM_READ, &sfinfo, __LINE__);
+        exit_if_true(sfinfo.frames != frames, "\n\nLine %d : Frame count is %" PRId64 ", should be %" PRId64 ".\n",
+                     __LINE__, sfinfo.frames, frames);
+        memset(check, 0, frames * channels * sizeof(int));
+        test_readf_int_or_die(file, 0, check, frames, __LINE__);
+        exit_if_true(memcmp(check, data, frames * channels * sizeof(int)) != 0,
+                     "\n\nLine %d : Data read back from '%s' differs from data written.\n", __LINE__,
+                     j == 0 ? filename : serial_name);
+        sf_close(file);
+    };
+
+    free(data);
+    free(check);
+    unlink(filename);
+    unlink(serial_name);
+    puts("ok");
+}
+
+#ifdef HAVE_XIPH_CODECS
+
+static void seektable_test(const char *filename, int filetype)
+{
+    /* Long enough for the seek table to fill up and be thinned out. */
+    const sf_count_t frames = 8000 * 300;
+    static const sf_count_t positions[] = {8000 * 250 + 17, 8000 * 3, 8000 * 299, 100, 8000 * 120 + 4000};
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    SF_SEEKTABLE_INFO info;
+    short *data, seek_data[16];
+    double spacing;
+    sf_count_t k;
+
+    print_test_name("seektable_test", filename);
+
+    data = (short *)malloc(frames * sizeof(short));
+    exit_if_true(data == NULL, "\n\nLine %d : malloc failed.\n", __LINE__);
+
+    for (k = 0; k < frames; k++)
+        data[k] = (short)lrint(16000.0 * sin(k * 0.01) + 8000.0 * sin(k * 0.37));
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    sfinfo.samplerate = 8000;
+    sfinfo.format = filetype;
+    sfinfo.channels = 1;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+
+    spacing = -1.0;
+    exit_if_true(sf_command(file, SFC_SET_SEEKTABLE_SPACING, &spacing, sizeof(spacing)) != SF_FALSE,
+                 "\n\nLine %d : Negative seek table spacing was accepted.\n", __LINE__);
+    spacing = 1.0;
+    exit_if_true(sf_command(file, SFC_SET_SEEKTABLE_SPACING, &spacing, sizeof(spacing)) != SF_TRUE,
+                 "\n\nLine %d : SFC_SET_SEEKTABLE_SPACING failed.\n", __LINE__);
+
+    test_writef_short_or_die(file, 0, data, frames, __LINE__);
+
+    exit_if_true(sf_command(file, SFC_SET_SEEKTABLE_SPACING, &spacing, sizeof(spacing)) != SF_FALSE,
+                 "\n\nLine %d : SFC_SET_SEEKTABLE_SPACING accepted after writing.\n", __LINE__);
+    sf_close(file);
+
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+
+    exit_if_true(sf_command(file, SFC_GET_SEEKTABLE_INFO, &info, sizeof(info)) != SF_TRUE,
+                 "\n\nLine %d : No seek table found.\n", __LINE__);
+
+    /* 300 points at 1 second don't fit, so the spacing must have been doubled. */
+    exit_if_true(info.points < 100 || info.points > 256, "\n\nLine %d : Seek table has %d points.\n", __LINE__,
+                 info.points);
+    exit_if_true(info.spacing < 2.0 || info.spacing > 3.0, "\n\nLine %d : Seek point spacing is %f seconds.\n",
+                 __LINE__, info.spacing);
+
+    for (k = 0; k < (sf_count_t)ARRAY_LEN(positions); k++)
+    {
+        test_seek_or_die(file, positions[k], SEEK_SET, positions[k], sfinfo.channels, __LINE__);
+        test_readf_short_or_die(file, 0, seek_data, ARRAY_LEN(seek_data), __LINE__);
+        exit_if_true(memcmp(seek_data, data + positions[k], sizeof(seek_data)) != 0,
+                     "\n\nLine %d : Bad data after seeking to %" PRId64 ".\n", __LINE__, positions[k]);
+    };
+
+    sf_close(file);
+
+    /* A spacing of 0 turns the seek table off. */
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    spacing = 0.0;
+    exit_if_true(sf_command(file, SFC_SET_SEEKTABLE_SPACING, &spacing, sizeof(spacing)) != SF_TRUE,
+                 "\n\nLine %d : SFC_SET_SEEKTABLE_SPACING failed.\n", __LINE__);
+    test_writef_short_or_die(file, 0, data, 8000, __LINE__);
+    sf_close(file);
+
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    exit_if_true(sf_command(file, SFC_GET_SEEKTABLE_INFO, &info, sizeof(info)) != SF_FALSE,
+                 "\n\nLine %d : Unexpected seek table with %d points.\n", __LINE__, info.points);
+    sf_close(file);
+
+    free(data);
+    unlink(filename);
+    puts("ok");
+}
+
+/* Reads the STREAMINFO block, which starts 8 bytes into the file. */
+static void read_streaminfo(const char *filename, unsigned char *info, int line_num)
+{
+    FILE *file;
+
+    file = fopen(filename, "rb");
+    exit_if_true(file == NULL, "\n\nLine %d : fopen failed.\n", line_num);
+    exit_if_true(fseek(file, 8, SEEK_SET) != 0 || fread(info, 1, 34, file) != 34,
+                 "\n\nLine %d : Could not read STREAMINFO.\n", line_num);
+    fclose(file);
+}
+
+static void encoder_threads_test(const char *filename, int filetype)
+{
+    /* Several batches of jobs, the last one partly filled. */
+    const sf_count_t frames = 44100 * 40 + 1234;
+    static const sf_count_t positions[] = {44100 * 33 + 5, 17, 44100 * 40, 44100 * 6 + 4096, 44100 * 18};
+    const int channels = 2;
+    char serial_name[64];
+    unsigned char info[34], serial_info[34];
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    int *data, *check, threads;
+    sf_count_t k;
+
+    print_test_name("encoder_threads_test", filename);
+
+    snprintf(serial_name, sizeof(serial_name), "serial-%s", filename);
+
+    data = (int *)malloc(frames * channels * sizeof(int));
+    check = (int *)malloc(frames * channels * sizeof(int));
+    exit_if_true(data == NULL || check == NULL, "\n\nLine %d : malloc failed.\n", __LINE__);
+
+    for (k = 0; k < frames; k++)
+    {
+        data[2 * k] = (int)lrint(0x30000000 * sin(k * 0.003) + 0x08000000 * sin(k * 0.41)) & ~0xFF;
+        data[2 * k + 1] = (int)lrint(0x20000000 * sin(k * 0.007)) & ~0xFF;
+    };
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    sfinfo.samplerate = 44100;
+    sfinfo.format = filetype;
+    sfinfo.channels = channels;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+
+    threads = -1;
+    exit_if_true(sf_command(file, SFC_SET_ENCODER_THREADS, &threads, sizeof(threads)) != SF_FALSE,
+                 "\n\nLine %d : Negative thread count was accepted.\n", __LINE__);
+    threads = 4;
+    exit_if_true(sf_command(file, SFC_SET_ENCODER_THREADS, &threads, sizeof(threads)) != SF_TRUE,
+                 "\n\nLine %d : SFC_SET_ENCODER_THREADS failed.\n", __LINE__);
+
+    /* Odd sized writes, so jobs are filled across calls. */
+    for (k = 0; k < frames; k += 10007)
+        test_writef_int_or_die(file, 0, data + k * channels, frames - k < 10007 ? frames - k : 10007, __LINE__);
+
+    exit_if_true(sf_command(file, SFC_SET_ENCODER_THREADS, &threads, sizeof(threads)) != SF_FALSE,
+                 "\n\nLine %d : SFC_SET_ENCODER_THREADS accepted after writing.\n", __LINE__);
+    sf_close(file);
+
+    file = test_open_file_or_die(serial_name, SFM_WRITE, &sfinfo, __LINE__);
+    test_writef_int_or_die(file, 0, data, frames, __LINE__);
+    sf_close(file);
+
+    /* The block sizes, stream parameters, length and MD5 must match, the frame sizes may not. */
+    read_streaminfo(filename, info, __LINE__);
+    read_streaminfo(serial_name, serial_info, __LINE__);
+    exit_if_true(memcmp(info, serial_info, 4) != 0 || memcmp(info + 10, serial_info + 10, 24) != 0,
+                 "\n\nLine %d : STREAMINFO differs from the one written without threads.\n", __LINE__);
+
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    exit_if_true(sfinfo.frames != frames, "\n\nLine %d : Frame count is %" PRId64 ", should be %" PRId64 ".\n",
+                 __LINE__, sfinfo.frames, frames);
+
+    test_readf_int_or_die(file, 0, check, frames, __LINE__);
+    exit_if_true(memcmp(check, data, frames * channels * sizeof(int)) != 0,
+                 "\n\nLine %d : Data read back differs from data written.\n", __LINE__);
+
+    for (k = 0; k < (sf_count_t)ARRAY_LEN(positions); k++)
+    {
+        sf_count_t count = frames - positions[k] < 64 ? frames - positions[k] : 64;
+
+        test_seek_or_die(file, positions[k], SEEK_SET, positions[k], sfinfo.channels, __LINE__);
+        test_readf_int_or_die(file, 0, check, count, __LINE__);
+        exit_if_true(memcmp(check, data + positions[k] * channels, count * channels * sizeof(int)) != 0,
+                     "\n\nLine %d : Bad data after seeking to %" PRId64 ".\n", __LINE__, positions[k]);
+    };
+
+    sf_close(file);
+
+    free(data);
+    free(check);
+    unlink(filename);
+    unlink(serial_name);
+    puts("ok");
+}
+
+#endif
@@ -0,0 +1,115 @@
+/*
+** Copyright (C) 2026 agent <agent@local>
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "sf_unistd.h"
+
+#include "sndfile2k/sndfile2k.h"
+
+#include "utils.h"
+
+#define FRAMES (20000)
+#define CHANNELS (2)
+#define INPUT_PEAK (2.0)
+
+/* sndfile-convert's copy loop, from programs/common.cpp. */
+void sfe_copy_data_fp(SNDFILE *outfile, SNDFILE *infile, int channels, int normalize);
+
+static void convert_peak_test(const char *filename, int format);
+
+int main(void)
+{
+    /* These get a PEAK chunk. */
+    convert_peak_test("convert_float.wav", SF_FORMAT_WAV | SF_FORMAT_FLOAT);
+    convert_peak_test("convert_double.wav", SF_FORMAT_WAV | SF_FORMAT_DOUBLE);
+    convert_peak_test("convert_float.aiff", SF_FORMAT_AIFF | SF_FORMAT_FLOAT);
+
+    /* Copied, then rewound and copied again scaled down. */
+    convert_peak_test("convert_pcm16.wav", SF_FORMAT_WAV | SF_FORMAT_PCM_16);
+
+    return 0;
+}
+
+/*
+** Float data past full scale, from a file without a PEAK chunk, is scaled
+** down to full scale. The PEAK chunk of the output, if it has one, has to
+** match the data that ended up in it.
+*/
+static void convert_peak_test(const char *filename, int format)
+{
+    static const char *inname = "convert_in.au";
+    std::vector<double> data(FRAMES * CHANNELS), check(FRAMES * CHANNELS);
+    SNDFILE *infile, *outfile;
+    SF_INFO sfinfo;
+    double peak = 0.0, max = 0.0;
+
+    print_test_name(__func__, filename);
+
+    for (int k = 0; k < FRAMES * CHANNELS; k++)
+        data[k] = INPUT_PEAK * sin(0.01 * k + (k % CHANNELS));
+    data[FRAMES] = -INPUT_PEAK;
+
+    /* AU has no PEAK chunk. */
+    sf_info_clear(&sfinfo);
+    sfinfo.samplerate = 44100;
+    sfinfo.channels = CHANNELS;
+    sfinfo.format = SF_FORMAT_AU | SF_FORMAT_FLOAT;
+    infile = test_open_file_or_die(inname, SFM_WRITE, &sfinfo, __LINE__);
+    test_writef_double_or_die(infile, 0, data.data(), FRAMES, __LINE__);
+    sf_close(infile);
+
+    sf_info_clear(&sfinfo);
+    infile = test_open_file_or_die(inname, SFM_READ, &sfinfo, __LINE__);
+    exit_if_true(sf_command(infile, SFC_GET_SIGNAL_MAX, &peak, sizeof(peak)) == SF_TRUE,
+                 "\n\nLine %d : Input file has a peak.\n", __LINE__);
+
+    sfinfo.format = format;
+    outfile = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    sfe_copy_data_fp(outfile, infile, CHANNELS, SF_FALSE);
+    sf_close(outfile);
+    sf_close(infile);
+
+    sf_info_clear(&sfinfo);
+    outfile = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    test_readf_double_or_die(outfile, 0, check.data(), FRAMES, __LINE__);
+
+    for (int k = 0; k < FRAMES * CHANNELS; k++)
+    {
+        exit_if_true(fabs(check[k] - data[k] / INPUT_PEAK) > 1.0 / 0x4000,
+                     "\n\nLine %d : Sample %d is %f, should be %f.\n", __LINE__, k, check[k], data[k] / INPUT_PEAK);
+        max = fabs(check[k]) > max ? fabs(check[k]) : max;
+    };
+
+    if (sf_command(outfile, SFC_GET_SIGNAL_MAX, &peak, sizeof(peak)) == SF_TRUE)
+        exit_if_true(fabs(peak - max) > 1e-6, "\n\nLine %d : PEAK chunk says %f, data peaks at %f.\n", __LINE__,
+                     peak, max);
+
+    sf_close(outfile);
+
+    unlink(inname);
+    unlink(filename);
+    puts("ok");
+}
@@ -99,6 +99,18 @@ static void dwvw_test(const char *filename, int format, int bit_width)
         };
     };
 
+    /* Seeks decode forward from the nearest checkpoint. */
+    for (k = BUFFER_SIZE - 10; k > 0; k -= 997)
+    {
+        test_seek_or_die(file, k, SEEK_SET, k, 1, __LINE__);
+        test_read_int_or_die(file, 0, read_buf, 10, __LINE__);
+        if (memcmp(read_buf, write_buf + k, 10 * sizeof(int)) != 0)
+        {
+            printf("Error (line %d) : Data after seeking to %d differs.\n", __LINE__, k);
+            exit(1);
+        };
+    };
+
     sf_close(file);
 
     unlink(filename);
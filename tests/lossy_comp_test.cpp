@@ -40,6 +40,7 @@
 #endif
 
 #define LCT_MAX(x, y) ((x) > (y) ? (x) : (y))
+#define LCT_MIN(x, y) ((x) < (y) ? (x) : (y))
 
 static void lcomp_test_short(const char *filename, int filetype, int chan, double margin);
 static void lcomp_test_int(const char *filename, int filetype, int chan, double margin);
@@ -53,6 +54,9 @@ static void sdlcomp_test_double(const char *filename, int filetype, int chan, do
 
 static void read_raw_test(const char *filename, int filetype, int chan);
 
+static void block_read_test(const char *filename, int filetype, int chan);
+static void seek_index_test(const char *filename, int filetype);
+
 static int error_function(double data, double orig, double margin);
 static int decay_response(int k);
 
@@ -145,6 +149,9 @@ int main(int argc, char *argv[])
         sdlcomp_test_int("ima.wav", SF_FORMAT_WAV | SF_FORMAT_IMA_ADPCM, 2, 0.18);
         sdlcomp_test_float("ima.wav", SF_FORMAT_WAV | SF_FORMAT_IMA_ADPCM, 2, 0.18);
         sdlcomp_test_double("ima.wav", SF_FORMAT_WAV | SF_FORMAT_IMA_ADPCM, 2, 0.18);
+
+        block_read_test("ima.wav", SF_FORMAT_WAV | SF_FORMAT_IMA_ADPCM, 1);
+        block_read_test("ima.wav", SF_FORMAT_WAV | SF_FORMAT_IMA_ADPCM, 2);
         test_count++;
     };
 
@@ -165,6 +172,8 @@ int main(int argc, char *argv[])
         sdlcomp_test_float("msadpcm.wav", SF_FORMAT_WAV | SF_FORMAT_MS_ADPCM, 2, 0.36);
         sdlcomp_test_double("msadpcm.wav", SF_FORMAT_WAV | SF_FORMAT_MS_ADPCM, 2, 0.36);
 
+        block_read_test("msadpcm.wav", SF_FORMAT_WAV | SF_FORMAT_MS_ADPCM, 1);
+        block_read_test("msadpcm.wav", SF_FORMAT_WAV | SF_FORMAT_MS_ADPCM, 2);
         test_count++;
     };
 
@@ -177,6 +186,7 @@ int main(int argc, char *argv[])
         lcomp_test_short("g721.rifx", SF_ENDIAN_BIG | SF_FORMAT_WAV | SF_FORMAT_G721_32, 1, 0.7);
         lcomp_test_int("g721.rifx", SF_ENDIAN_BIG | SF_FORMAT_WAV | SF_FORMAT_G721_32, 1, 0.7);
 
+        seek_index_test("g721.wav", SF_FORMAT_WAV | SF_FORMAT_G721_32);
         test_count++;
     };
     /* Lite remove end */
@@ -222,6 +232,8 @@ int main(int argc, char *argv[])
 
         sdlcomp_test_float("gsm610.wav", SF_FORMAT_WAV | SF_FORMAT_GSM610, 1, 0.24);
         sdlcomp_test_double("gsm610.wav", SF_FORMAT_WAV | SF_FORMAT_GSM610, 1, 0.24);
+
+        block_read_test("gsm610.wav", SF_FORMAT_WAV | SF_FORMAT_GSM610, 1);
         test_count++;
     };
 
@@ -257,6 +269,7 @@ int main(int argc, char *argv[])
         sdlcomp_test_float("nms_32.wav", SF_FORMAT_WAV | SF_FORMAT_NMS_ADPCM_32, 1, 0.018);
         sdlcomp_test_double("nms_32.wav", SF_FORMAT_WAV | SF_FORMAT_NMS_ADPCM_32, 1, 0.018);
 
+        seek_index_test("nms_24.wav", SF_FORMAT_WAV | SF_FORMAT_NMS_ADPCM_24);
         test_count++;
     };
 
@@ -340,6 +353,8 @@ int main(int argc, char *argv[])
         lcomp_test_int("g723_40.au", SF_ENDIAN_BIG | SF_FORMAT_AU | SF_FORMAT_G723_40, 1, 0.84);
         lcomp_test_float("g723_40.au", SF_ENDIAN_LITTLE | SF_FORMAT_AU | SF_FORMAT_G723_40, 1, 0.86);
         lcomp_test_double("g723_40.au", SF_ENDIAN_BIG | SF_FORMAT_AU | SF_FORMAT_G723_40, 1, 0.86);
+
+        seek_index_test("g723_24.au", SF_FORMAT_AU | SF_FORMAT_G723_24);
         test_count++;
     };
 
@@ -390,6 +405,8 @@ int main(int argc, char *argv[])
         sdlcomp_test_int("raw.gsm", SF_FORMAT_RAW | SF_FORMAT_GSM610, 1, 0.24);
         sdlcomp_test_float("raw.gsm", SF_FORMAT_RAW | SF_FORMAT_GSM610, 1, 0.24);
         sdlcomp_test_double("raw.gsm", SF_FORMAT_RAW | SF_FORMAT_GSM610, 1, 0.24);
+
+        block_read_test("raw.gsm", SF_FORMAT_RAW | SF_FORMAT_GSM610, 1);
         test_count++;
     };
 
@@ -533,6 +550,9 @@ int main(int argc, char *argv[])
         sdlcomp_test_int("ima.w64", SF_FORMAT_W64 | SF_FORMAT_IMA_ADPCM, 2, 0.18);
         sdlcomp_test_float("ima.w64", SF_FORMAT_W64 | SF_FORMAT_IMA_ADPCM, 2, 0.18);
         sdlcomp_test_double("ima.w64", SF_FORMAT_W64 | SF_FORMAT_IMA_ADPCM, 2, 0.18);
+
+        block_read_test("ima.w64", SF_FORMAT_W64 | SF_FORMAT_IMA_ADPCM, 1);
+        block_read_test("ima.w64", SF_FORMAT_W64 | SF_FORMAT_IMA_ADPCM, 2);
         test_count++;
     };
 
@@ -547,6 +567,9 @@ int main(int argc, char *argv[])
         sdlcomp_test_int("msadpcm.w64", SF_FORMAT_W64 | SF_FORMAT_MS_ADPCM, 2, 0.36);
         sdlcomp_test_float("msadpcm.w64", SF_FORMAT_W64 | SF_FORMAT_MS_ADPCM, 2, 0.36);
         sdlcomp_test_double("msadpcm.w64", SF_FORMAT_W64 | SF_FORMAT_MS_ADPCM, 2, 0.36);
+
+        block_read_test("msadpcm.w64", SF_FORMAT_W64 | SF_FORMAT_MS_ADPCM, 1);
+        block_read_test("msadpcm.w64", SF_FORMAT_W64 | SF_FORMAT_MS_ADPCM, 2);
         test_count++;
     };
 
@@ -580,6 +603,8 @@ int main(int argc, char *argv[])
         sdlcomp_test_int("adpcm.vox", SF_FORMAT_RAW | SF_FORMAT_VOX_ADPCM, 1, 0.072);
         sdlcomp_test_float("adpcm.vox", SF_FORMAT_RAW | SF_FORMAT_VOX_ADPCM, 1, 0.072);
         sdlcomp_test_double("adpcm.vox", SF_FORMAT_RAW | SF_FORMAT_VOX_ADPCM, 1, 0.072);
+
+        seek_index_test("adpcm.vox", SF_FORMAT_RAW | SF_FORMAT_VOX_ADPCM);
         test_count++;
     };
 
@@ -1659,7 +1684,7 @@ static void sdlcomp_test_short(const char *filename, int filetype, int channels,
             test_readf_short_or_die(file, m, data, datalen / 7, __LINE__);
 
             smoothed_diff_short(data, datalen / 7);
-            memcpy(smooth, orig + m * datalen / 7, datalen / 7 * sizeof(short));
+            memcpy(smooth, orig + m * (datalen / 7), datalen / 7 * sizeof(short));
             smoothed_diff_short(smooth, datalen / 7);
 
             for (k = 0; k < datalen / 7; k++)
@@ -1904,7 +1929,7 @@ static void sdlcomp_test_int(const char *filename, int filetype, int channels, d
             test_readf_int_or_die(file, m, data, datalen / 7, __LINE__);
 
             smoothed_diff_int(data, datalen / 7);
-            memcpy(smooth, orig + m * datalen / 7, datalen / 7 * sizeof(int));
+            memcpy(smooth, orig + m * (datalen / 7), datalen / 7 * sizeof(int));
             smoothed_diff_int(smooth, datalen / 7);
 
             for (k = 0; k < datalen / 7; k++)
@@ -2136,7 +2161,7 @@ static void sdlcomp_test_float(const char *filename, int filetype, int channels,
             test_read_float_or_die(file, 0, data, datalen / 7, __LINE__);
 
             smoothed_diff_float(data, datalen / 7);
-            memcpy(smooth, orig + m * datalen / 7, datalen / 7 * sizeof(float));
+            memcpy(smooth, orig + m * (datalen / 7), datalen / 7 * sizeof(float));
             smoothed_diff_float(smooth, datalen / 7);
 
             for (k = 0; k < datalen / 7; k++)
@@ -2363,7 +2388,7 @@ static void sdlcomp_test_double(const char *filename, int filetype, int channels
             test_read_double_or_die(file, m, data, datalen / 7, __LINE__);
 
             smoothed_diff_double(data, datalen / 7);
-            memcpy(smooth, orig + m * datalen / 7, datalen / 7 * sizeof(double));
+            memcpy(smooth, orig + m * (datalen / 7), datalen / 7 * sizeof(double));
             smoothed_diff_double(smooth, datalen / 7);
 
             for (k = 0; k < datalen / 7; k++)
@@ -2719,3 +2744,274 @@ static int is_lossy(int filetype)
 
     return 1;
 }
+
+/*
+** Block based decoders can decode many blocks per read call. Reading a long
+** file in one go must give the same samples as reading it a few frames at a
+** time, and small reads going on after a large one must pick up where it ended.
+*/
+static void block_read_test(const char *filename, int filetype, int channels)
+{
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    sf_count_t k, frames, datalen, half;
+    short *orig, *whole, *data;
+    int *idata;
+    float *fdata;
+    double *ddata;
+    char name[64];
+
+    snprintf(name, sizeof(name), "block_read_test (%d)", channels);
+    print_test_name(name, filename);
+
+    datalen = 200000;
+
+    orig = (short *)calloc(channels * datalen, sizeof(short));
+    whole = (short *)calloc(channels * datalen, sizeof(short));
+    data = (short *)calloc(channels * datalen, sizeof(short));
+    ddata = (double *)calloc(channels * datalen, sizeof(double));
+    idata = (int *)ddata;
+    fdata = (float *)ddata;
+
+    if (orig == NULL || whole == NULL || data == NULL || ddata == NULL)
+    {
+        printf("\n\nLine %d : calloc failed.\n\n", __LINE__);
+        exit(1);
+    };
+
+    for (k = 0; k < channels * datalen; k++)
+        orig[k] = (short)lrint(20000.0 * sin(0.0021 * k + 0.3 * (k % channels)) + ((k * 7919) % 1001) - 500);
+
+    sfinfo.samplerate = SAMPLE_RATE;
+    sfinfo.frames = 123456789; /* Ridiculous value. */
+    sfinfo.channels = channels;
+    sfinfo.format = filetype;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    test_writef_short_or_die(file, 0, orig, datalen, __LINE__);
+    sf_close(file);
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    frames = LCT_MIN(sfinfo.frames, datalen);
+    test_readf_short_or_die(file, 0, whole, frames, __LINE__);
+    sf_close(file);
+
+    /* A few frames at a time, so every block is decoded on its own. */
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    for (k = 0; k < frames; k += 97)
+        test_readf_short_or_die(file, 0, data + k * channels, LCT_MIN(97, frames - k), __LINE__);
+    sf_close(file);
+
+    if (memcmp(whole, data, frames * channels * sizeof(short)) != 0)
+    {
+        printf("\n\nLine %d : one large read differs from many small ones.\n\n", __LINE__);
+        exit(1);
+    };
+
+    /* Half in one read, the rest a few frames at a time. */
+    half = frames / 2 + 13;
+    memset(data, 0, frames * channels * sizeof(short));
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    test_readf_short_or_die(file, 0, data, half, __LINE__);
+    for (k = half; k < frames; k += 101)
+        test_readf_short_or_die(file, 0, data + k * channels, LCT_MIN(101, frames - k), __LINE__);
+    sf_close(file);
+
+    if (memcmp(whole, data, frames * channels * sizeof(short)) != 0)
+    {
+        printf("\n\nLine %d : small reads after a large one differ.\n\n", __LINE__);
+        exit(1);
+    };
+
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    test_readf_int_or_die(file, 0, idata, frames, __LINE__);
+    sf_close(file);
+
+    for (k = 0; k < frames * channels; k++)
+        if (idata[k] != whole[k] * 0x10000)
+        {
+            printf("\n\nLine %d : int sample #%" PRId64 " is %d, should be %d.\n\n", __LINE__, k, idata[k],
+                   whole[k] * 0x10000);
+            exit(1);
+        };
+
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    test_readf_float_or_die(file, 0, fdata, frames, __LINE__);
+    sf_close(file);
+
+    for (k = 0; k < frames * channels; k++)
+        if (fdata[k] != whole[k] / 32768.0f)
+        {
+            printf("\n\nLine %d : float sample #%" PRId64 " is %f, should be %f.\n\n", __LINE__, k, fdata[k],
+                   whole[k] / 32768.0f);
+            exit(1);
+        };
+
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    test_readf_double_or_die(file, 0, ddata, frames, __LINE__);
+    sf_close(file);
+
+    for (k = 0; k < frames * channels; k++)
+        if (ddata[k] != whole[k] / 32768.0)
+        {
+            printf("\n\nLine %d : double sample #%" PRId64 " is %f, should be %f.\n\n", __LINE__, k, ddata[k],
+                   whole[k] / 32768.0);
+            exit(1);
+        };
+
+    free(orig);
+    free(whole);
+    free(data);
+    free(ddata);
+
+    unlink(filename);
+    printf("ok\n");
+}
+
+/*
+** Seeks of codecs that restore decoder checkpoints must land on exactly the
+** samples a single read from the start gives, also with an exported index.
+*/
+static void seek_index_test(const char *filename, int filetype)
+{
+    static const sf_count_t positions[] = {
+        150001, 7, 99999, 0, 180000, 16384, 16383, 123457, 60000, 60001, 1,
+    };
+
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    sf_count_t k, frames, datalen, spacing;
+    short *orig, *whole, *data;
+    unsigned char *blob;
+    size_t blob_size;
+    unsigned m;
+    int pass;
+
+    print_test_name("seek_index_test", filename);
+
+    datalen = 200000;
+
+    orig = (short *)calloc(datalen, sizeof(short));
+    whole = (short *)calloc(datalen, sizeof(short));
+    data = (short *)calloc(1000, sizeof(short));
+
+    if (orig == NULL || whole == NULL || data == NULL)
+    {
+        printf("\n\nLine %d : calloc failed.\n\n", __LINE__);
+        exit(1);
+    };
+
+    for (k = 0; k < datalen; k++)
+        orig[k] = (short)lrint(20000.0 * sin(0.0021 * k) + ((k * 7919) % 1001) - 500);
+
+    sfinfo.samplerate = SAMPLE_RATE;
+    sfinfo.frames = 123456789; /* Ridiculous value. */
+    sfinfo.channels = 1;
+    sfinfo.format = filetype;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    test_writef_short_or_die(file, 0, orig, datalen, __LINE__);
+    sf_close(file);
+
+    if ((filetype & SF_FORMAT_TYPEMASK) != SF_FORMAT_RAW)
+        memset(&sfinfo, 0, sizeof(sfinfo));
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    frames = LCT_MIN(sfinfo.frames, datalen);
+    test_readf_short_or_die(file, 0, whole, frames, __LINE__);
+
+    if (!sfinfo.seekable)
+    {
+        printf("\n\nLine %d : File is not seekable.\n\n", __LINE__);
+        exit(1);
+    };
+
+    spacing = 0;
+    if (sf_command(file, SFC_BUILD_SEEK_INDEX, &spacing, sizeof(spacing)) != SF_FALSE)
+    {
+        printf("\n\nLine %d : SFC_BUILD_SEEK_INDEX accepted a spacing of 0.\n\n", __LINE__);
+        exit(1);
+    };
+
+    spacing = 3000;
+    if (sf_command(file, SFC_BUILD_SEEK_INDEX, &spacing, sizeof(spacing)) != SF_TRUE)
+    {
+        printf("\n\nLine %d : SFC_BUILD_SEEK_INDEX failed.\n\n", __LINE__);
+        exit(1);
+    };
+
+    blob_size = sf_command(file, SFC_GET_SEEK_INDEX, NULL, 0);
+    blob = (unsigned char *)malloc(blob_size);
+    if (blob_size == 0 || blob == NULL ||
+        (size_t)sf_command(file, SFC_GET_SEEK_INDEX, blob, (int)blob_size) != blob_size)
+    {
+        printf("\n\nLine %d : SFC_GET_SEEK_INDEX failed.\n\n", __LINE__);
+        exit(1);
+    };
+
+    /* Once with the index built by decoding, once with the imported one. */
+    for (pass = 0; pass < 2; pass++)
+    {
+        for (m = 0; m < ARRAY_LEN(positions); m++)
+        {
+            sf_count_t count = LCT_MIN(1000, frames - positions[m]);
+
+            test_seek_or_die(file, positions[m], SEEK_SET, positions[m], 1, __LINE__);
+            test_readf_short_or_die(file, 0, data, count, __LINE__);
+            if (memcmp(data, whole + positions[m], count * sizeof(short)) != 0)
+            {
+                printf("\n\nLine %d : Data after seeking to %" PRId64 " differs (pass %d).\n\n", __LINE__,
+                       positions[m], pass);
+                exit(1);
+            };
+        };
+
+        sf_close(file);
+        if (pass == 1)
+            break;
+
+        file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+
+        blob[0] ^= 0xff;
+        if (sf_command(file, SFC_SET_SEEK_INDEX, blob, (int)blob_size) != SF_FALSE)
+        {
+            printf("\n\nLine %d : Damaged seek index was accepted.\n\n", __LINE__);
+            exit(1);
+        };
+        blob[0] ^= 0xff;
+
+        if (sf_command(file, SFC_SET_SEEK_INDEX, blob, (int)blob_size - 1) != SF_FALSE)
+        {
+            printf("\n\nLine %d : Truncated seek index was accepted.\n\n", __LINE__);
+            exit(1);
+        };
+
+        /* The last value of a G72x state is the tone detect flag, 0 or 1. */
+        if ((filetype & SF_FORMAT_SUBMASK) == SF_FORMAT_G721_32 || (filetype & SF_FORMAT_SUBMASK) == SF_FORMAT_G723_24)
+        {
+            unsigned char td = blob[blob_size - 1];
+
+            blob[blob_size - 1] = 0x7e;
+            if (sf_command(file, SFC_SET_SEEK_INDEX, blob, (int)blob_size) != SF_FALSE)
+            {
+                printf("\n\nLine %d : Seek index with a bad decoder state was accepted.\n\n", __LINE__);
+                exit(1);
+            };
+            blob[blob_size - 1] = td;
+        };
+
+        if (sf_command(file, SFC_SET_SEEK_INDEX, blob, (int)blob_size) != SF_TRUE)
+        {
+            printf("\n\nLine %d : SFC_SET_SEEK_INDEX failed.\n\n", __LINE__);
+            exit(1);
+        };
+    };
+
+    free(blob);
+    free(orig);
+    free(whole);
+    free(data);
+
+    unlink(filename);
+    puts("ok");
+}
@@ -325,6 +325,210 @@ static void ogg_stereo_seek_test(const char *filename, int format)
     unlink(filename);
 }
 
+#ifdef HAVE_XIPH_CODECS
+
+static void ogg_long_seek_test(const char *filename, int format)
+{
+    /* Long enough for the seek code to bisect the file instead of decoding it. */
+    static float data[SAMPLE_RATE * 30];
+    static const sf_count_t positions[] = {
+        SAMPLE_RATE * 20 + 17, SAMPLE_RATE * 3 + 1000, SAMPLE_RATE * 29, 100, SAMPLE_RATE * 15, SAMPLE_RATE * 15 + 20000,
+        SAMPLE_RATE * 10, SAMPLE_RATE * 30 - 10,
+    };
+
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    float seek_data[10];
+    unsigned k;
+
+    print_test_name(__func__, filename);
+
+    gen_windowed_sine_float(data, ARRAY_LEN(data), 0.95);
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    sfinfo.format = format;
+    sfinfo.channels = 1;
+    sfinfo.samplerate = SAMPLE_RATE;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    test_write_float_or_die(file, 0, data, ARRAY_LEN(data), __LINE__);
+    sf_close(file);
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+
+    /* Decoded data is the reference, seeking must land on exactly the same samples. */
+    test_read_float_or_die(file, 0, data, ARRAY_LEN(data), __LINE__);
+
+    for (k = 0; k < ARRAY_LEN(positions); k++)
+    {
+        test_seek_or_die(file, positions[k], SEEK_SET, positions[k], sfinfo.channels, __LINE__);
+        test_readf_float_or_die(file, 0, seek_data, ARRAY_LEN(seek_data), __LINE__);
+        compare_float_or_die(seek_data, data + positions[k], ARRAY_LEN(seek_data), __LINE__);
+    };
+
+    sf_close(file);
+
+    puts("ok");
+    unlink(filename);
+}
+
+/*
+** A quiet, low bitrate file fits a long stretch into its first audio page, so
+** a seek forward within that page finds no page to start from.
+*/
+static void ogg_first_page_seek_test(const char *filename, int format)
+{
+    static float data[SAMPLE_RATE * 2];
+    static const sf_count_t positions[] = {20000, 100, 30000};
+
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    float seek_data[10];
+    double quality = 0.0;
+    unsigned k;
+
+    print_test_name(__func__, filename);
+
+    gen_windowed_sine_float(data, ARRAY_LEN(data), 0.0001);
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    sfinfo.format = format;
+    sfinfo.channels = 1;
+    sfinfo.samplerate = SAMPLE_RATE;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    sf_command(file, SFC_SET_VBR_ENCODING_QUALITY, &quality, sizeof(quality));
+    test_write_float_or_die(file, 0, data, ARRAY_LEN(data), __LINE__);
+    sf_close(file);
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    test_read_float_or_die(file, 0, data, ARRAY_LEN(data), __LINE__);
+    sf_close(file);
+
+    /* Seek straight after opening, from frame 0. */
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+
+    for (k = 0; k < ARRAY_LEN(positions); k++)
+    {
+        test_seek_or_die(file, positions[k], SEEK_SET, positions[k], sfinfo.channels, __LINE__);
+        test_readf_float_or_die(file, 0, seek_data, ARRAY_LEN(seek_data), __LINE__);
+        compare_float_or_die(seek_data, data + positions[k], ARRAY_LEN(seek_data), __LINE__);
+    };
+
+    sf_close(file);
+
+    puts("ok");
+    unlink(filename);
+}
+
+static void ogg_page_index_test(const char *filename, int format)
+{
+    static float data[SAMPLE_RATE * 30];
+    static const sf_count_t positions[] = {
+        SAMPLE_RATE * 20 + 17, SAMPLE_RATE * 3 + 1000, SAMPLE_RATE * 29, 100, SAMPLE_RATE * 15 + 20000,
+    };
+
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    float seek_data[10];
+    unsigned char *blob;
+    size_t blob_size;
+    unsigned k;
+
+    print_test_name(__func__, filename);
+
+    gen_windowed_sine_float(data, ARRAY_LEN(data), 0.95);
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    sfinfo.format = format;
+    sfinfo.channels = 1;
+    sfinfo.samplerate = SAMPLE_RATE;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    test_write_float_or_die(file, 0, data, ARRAY_LEN(data), __LINE__);
+    sf_close(file);
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+
+    if (sf_command(file, SFC_OGG_GET_PAGE_INDEX, NULL, 0) != 0)
+    {
+        printf("\n\nLine %d : Page index present before it was built.\n\n", __LINE__);
+        exit(1);
+    };
+
+    /* Read some data first, building the index must not disturb decoding. */
+    test_readf_float_or_die(file, 0, seek_data, ARRAY_LEN(seek_data), __LINE__);
+
+    if (sf_command(file, SFC_OGG_BUILD_PAGE_INDEX, NULL, 0) != SF_TRUE)
+    {
+        printf("\n\nLine %d : SFC_OGG_BUILD_PAGE_INDEX failed.\n\n", __LINE__);
+        exit(1);
+    };
+
+    test_readf_float_or_die(file, 0, data, ARRAY_LEN(data) - ARRAY_LEN(seek_data), __LINE__);
+
+    blob_size = sf_command(file, SFC_OGG_GET_PAGE_INDEX, NULL, 0);
+    if (blob_size == 0)
+    {
+        printf("\n\nLine %d : Page index is empty.\n\n", __LINE__);
+        exit(1);
+    };
+
+    blob = (unsigned char *)malloc(blob_size);
+    if ((size_t)sf_command(file, SFC_OGG_GET_PAGE_INDEX, blob, (int)blob_size) != blob_size)
+    {
+        printf("\n\nLine %d : SFC_OGG_GET_PAGE_INDEX failed.\n\n", __LINE__);
+        exit(1);
+    };
+
+    sf_close(file);
+
+    /* Decoded data is the reference. */
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    test_read_float_or_die(file, 0, data, ARRAY_LEN(data), __LINE__);
+
+    /* A damaged blob must be rejected. */
+    blob[0] ^= 0xff;
+    if (sf_command(file, SFC_OGG_SET_PAGE_INDEX, blob, (int)blob_size) != SF_FALSE)
+    {
+        printf("\n\nLine %d : Damaged page index was accepted.\n\n", __LINE__);
+        exit(1);
+    };
+    blob[0] ^= 0xff;
+
+    if (sf_command(file, SFC_OGG_SET_PAGE_INDEX, blob, (int)blob_size - 1) != SF_FALSE)
+    {
+        printf("\n\nLine %d : Truncated page index was accepted.\n\n", __LINE__);
+        exit(1);
+    };
+
+    if (sf_command(file, SFC_OGG_SET_PAGE_INDEX, blob, (int)blob_size) != SF_TRUE)
+    {
+        printf("\n\nLine %d : SFC_OGG_SET_PAGE_INDEX failed.\n\n", __LINE__);
+        exit(1);
+    };
+
+    for (k = 0; k < ARRAY_LEN(positions); k++)
+    {
+        test_seek_or_die(file, positions[k], SEEK_SET, positions[k], sfinfo.channels, __LINE__);
+        test_readf_float_or_die(file, 0, seek_data, ARRAY_LEN(seek_data), __LINE__);
+        compare_float_or_die(seek_data, data + positions[k], ARRAY_LEN(seek_data), __LINE__);
+    };
+
+    sf_close(file);
+    free(blob);
+
+    puts("ok");
+    unlink(filename);
+}
+
+#endif
+
 int main(void)
 {
 #ifdef HAVE_XIPH_CODECS
@@ -336,6 +540,9 @@ int main(void)
 
         /*-ogg_stereo_seek_test ("pcm.wav", SF_FORMAT_WAV | SF_FORMAT_PCM_16) ;-*/
         ogg_stereo_seek_test("vorbis_seek.ogg", SF_FORMAT_OGG | SF_FORMAT_VORBIS);
+        ogg_long_seek_test("vorbis_long_seek.ogg", SF_FORMAT_OGG | SF_FORMAT_VORBIS);
+        ogg_first_page_seek_test("vorbis_first_page.ogg", SF_FORMAT_OGG | SF_FORMAT_VORBIS);
+        ogg_page_index_test("vorbis_page_index.ogg", SF_FORMAT_OGG | SF_FORMAT_VORBIS);
     }
 #else
     puts("    No Ogg/Vorbis tests because Ogg/Vorbis support was not compiled "
@@ -0,0 +1,265 @@
+/*
+** Copyright (C) 2026 agent <agent@local>
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "config.h"
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "sf_unistd.h"
+
+#include "sndfile2k/sndfile2k.h"
+
+#include "utils.h"
+
+#define FRAMES (10000)
+#define CHUNK_FRAMES (1500)
+#define SEEK_FRAME (1234)
+/* Runs on past the end of the codec block the seek lands in. */
+#define SEEK_READ_FRAMES (5000)
+#define EXTRA_FRAMES (100)
+
+static void planar_format_test(const char *filename, int format, int channels);
+template <typename T>
+static void planar_test(const char *filename, int channels);
+
+int main(void)
+{
+    planar_format_test("planar_mono.wav", SF_FORMAT_WAV | SF_FORMAT_PCM_16, 1);
+    planar_format_test("planar_pcm16.wav", SF_FORMAT_WAV | SF_FORMAT_PCM_16, 3);
+    planar_format_test("planar_pcm24.aiff", SF_FORMAT_AIFF | SF_FORMAT_PCM_24, 6);
+    /* More channels than fit a staging chunk's worth of frames evenly. */
+    planar_format_test("planar_float.wav", SF_FORMAT_WAV | SF_FORMAT_FLOAT, 40);
+    planar_format_test("planar_ulaw.wav", SF_FORMAT_WAV | SF_FORMAT_ULAW, 2);
+
+    /* Decoded straight into the channel buffers. */
+    planar_format_test("planar_alac16.caf", SF_FORMAT_CAF | SF_FORMAT_ALAC_16, 2);
+    planar_format_test("planar_alac24.caf", SF_FORMAT_CAF | SF_FORMAT_ALAC_24, 3);
+#ifdef HAVE_XIPH_CODECS
+    planar_format_test("planar_pcm16.flac", SF_FORMAT_FLAC | SF_FORMAT_PCM_16, 2);
+    planar_format_test("planar_pcm24.flac", SF_FORMAT_FLAC | SF_FORMAT_PCM_24, 5);
+#endif
+
+    return 0;
+}
+
+static sf_count_t readf(SNDFILE *file, short *ptr, sf_count_t frames)
+{
+    return sf_readf_short(file, ptr, frames);
+}
+
+static sf_count_t readf(SNDFILE *file, int *ptr, sf_count_t frames)
+{
+    return sf_readf_int(file, ptr, frames);
+}
+
+static sf_count_t readf(SNDFILE *file, float *ptr, sf_count_t frames)
+{
+    return sf_readf_float(file, ptr, frames);
+}
+
+static sf_count_t readf(SNDFILE *file, double *ptr, sf_count_t frames)
+{
+    return sf_readf_double(file, ptr, frames);
+}
+
+static sf_count_t readf_planar(SNDFILE *file, short *const *ptr, sf_count_t frames)
+{
+    return sf_readf_short_planar(file, ptr, frames);
+}
+
+static sf_count_t readf_planar(SNDFILE *file, int *const *ptr, sf_count_t frames)
+{
+    return sf_readf_int_planar(file, ptr, frames);
+}
+
+static sf_count_t readf_planar(SNDFILE *file, float *const *ptr, sf_count_t frames)
+{
+    return sf_readf_float_planar(file, ptr, frames);
+}
+
+static sf_count_t readf_planar(SNDFILE *file, double *const *ptr, sf_count_t frames)
+{
+    return sf_readf_double_planar(file, ptr, frames);
+}
+
+static sf_count_t writef_planar(SNDFILE *file, const short *const *ptr, sf_count_t frames)
+{
+    return sf_writef_short_planar(file, ptr, frames);
+}
+
+static sf_count_t writef_planar(SNDFILE *file, const int *const *ptr, sf_count_t frames)
+{
+    return sf_writef_int_planar(file, ptr, frames);
+}
+
+static sf_count_t writef_planar(SNDFILE *file, const float *const *ptr, sf_count_t frames)
+{
+    return sf_writef_float_planar(file, ptr, frames);
+}
+
+static sf_count_t writef_planar(SNDFILE *file, const double *const *ptr, sf_count_t frames)
+{
+    return sf_writef_double_planar(file, ptr, frames);
+}
+
+static void planar_format_test(const char *filename, int format, int channels)
+{
+    std::vector<short> data(FRAMES * channels);
+    SNDFILE *file;
+    SF_INFO sfinfo;
+
+    print_test_name(__func__, filename);
+
+    for (int k = 0; k < FRAMES * channels; k++)
+        data[k] = (short)((k * 37 + (k % channels) * 1000) % 30000 - 15000);
+
+    sf_info_clear(&sfinfo);
+    sfinfo.samplerate = 44100;
+    sfinfo.channels = channels;
+    sfinfo.format = format;
+
+    file = test_open_file_or_die(filename, SFM_WRITE, &sfinfo, __LINE__);
+    test_writef_short_or_die(file, 0, data.data(), FRAMES, __LINE__);
+    sf_close(file);
+
+    planar_test<short>(filename, channels);
+    planar_test<int>(filename, channels);
+    planar_test<float>(filename, channels);
+    planar_test<double>(filename, channels);
+
+    unlink(filename);
+    puts("ok");
+}
+
+/*
+** Planar reads must give the same samples as interleaved ones, in chunks
+** crossing codec blocks, after a seek and past the end of the file. Writing
+** the planar samples to a new file must give the interleaved ones back.
+*/
+template <typename T>
+static void planar_test(const char *filename, int channels)
+{
+    std::vector<T> ref(FRAMES * channels);
+    std::vector<std::vector<T>> planes(channels, std::vector<T>(FRAMES + EXTRA_FRAMES));
+    std::vector<T *> ptr(channels);
+    std::vector<const T *> cptr(channels);
+    SNDFILE *file;
+    SF_INFO sfinfo;
+    sf_count_t total = 0, count;
+
+    sf_info_clear(&sfinfo);
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+    exit_if_true(readf(file, ref.data(), FRAMES) != FRAMES, "\n\nLine %d : Interleaved read failed : %s\n", __LINE__,
+                 sf_strerror(file));
+    sf_close(file);
+
+    file = test_open_file_or_die(filename, SFM_READ, &sfinfo, __LINE__);
+
+    for (int ch = 0; ch < channels; ch++)
+        std::fill(planes[ch].begin(), planes[ch].end(), (T)1);
+
+    while (total < FRAMES)
+    {
+        for (int ch = 0; ch < channels; ch++)
+            ptr[ch] = planes[ch].data() + total;
+
+        count = std::min((sf_count_t)CHUNK_FRAMES, FRAMES - total);
+        exit_if_true(readf_planar(file, ptr.data(), count) != count,
+                     "\n\nLine %d : Planar read of %" PRId64 " frames at %" PRId64 " failed.\n", __LINE__, count, total);
+        total += count;
+    };
+
+    /* A read past the end zero fills the rest of the channel buffers. */
+    for (int ch = 0; ch < channels; ch++)
+        ptr[ch] = planes[ch].data() + total;
+    exit_if_true(readf_planar(file, ptr.data(), EXTRA_FRAMES) != 0, "\n\nLine %d : Planar read past end returned frames.\n",
+                 __LINE__);
+
+    for (int ch = 0; ch < channels; ch++)
+    {
+        for (sf_count_t k = 0; k < FRAMES; k++)
+            exit_if_true(planes[ch][k] != ref[k * channels + ch],
+                         "\n\nLine %d : Mismatch in channel %d at frame %" PRId64 ".\n", __LINE__, ch, k);
+        for (sf_count_t k = FRAMES; k < FRAMES + EXTRA_FRAMES; k++)
+            exit_if_true(planes[ch][k] != 0, "\n\nLine %d : Channel %d not zero filled at frame %" PRId64 ".\n", __LINE__,
+                         ch, k);
+    };
+
+    test_seek_or_die(file, SEEK_FRAME, SEEK_SET, SEEK_FRAME, channels, __LINE__);
+    for (int ch = 0; ch < channels; ch++)
+        ptr[ch] = planes[ch].data();
+    exit_if_true(readf_planar(file, ptr.data(), SEEK_READ_FRAMES) != SEEK_READ_FRAMES,
+                 "\n\nLine %d : Planar read after seek failed.\n", __LINE__);
+    exit_if_true(sf_seek(file, 0, SEEK_CUR) != SEEK_FRAME + SEEK_READ_FRAMES,
+                 "\n\nLine %d : Bad read position %" PRId64 ".\n", __LINE__, sf_seek(file, 0, SEEK_CUR));
+    for (int ch = 0; ch < channels; ch++)
+        for (sf_count_t k = 0; k < SEEK_READ_FRAMES; k++)
+            exit_if_true(planes[ch][k] != ref[(SEEK_FRAME + k) * channels + ch],
+                         "\n\nLine %d : Mismatch in channel %d at frame %" PRId64 " after seek.\n", __LINE__, ch,
+                         SEEK_FRAME + k);
+
+    sf_close(file);
+
+    /* Write back what was read, a chunk at a time, to a raw file of the same type. */
+    static const char *rawname = "planar_write.raw";
+    std::vector<T> check(FRAMES * channels);
+
+    for (int ch = 0; ch < channels; ch++)
+        for (sf_count_t k = 0; k < FRAMES; k++)
+            planes[ch][k] = ref[k * channels + ch];
+
+    sf_info_clear(&sfinfo);
+    sfinfo.samplerate = 44100;
+    sfinfo.channels = channels;
+    if (sizeof(T) == sizeof(short))
+        sfinfo.format = SF_FORMAT_RAW | SF_FORMAT_PCM_16;
+    else if (sizeof(T) == sizeof(double))
+        sfinfo.format = SF_FORMAT_RAW | SF_FORMAT_DOUBLE;
+    else if ((T)0.5 == 0)
+        sfinfo.format = SF_FORMAT_RAW | SF_FORMAT_PCM_32;
+    else
+        sfinfo.format = SF_FORMAT_RAW | SF_FORMAT_FLOAT;
+
+    file = test_open_file_or_die(rawname, SFM_WRITE, &sfinfo, __LINE__);
+    for (total = 0; total < FRAMES; total += count)
+    {
+        for (int ch = 0; ch < channels; ch++)
+            cptr[ch] = planes[ch].data() + total;
+
+        count = writef_planar(file, cptr.data(), std::min((sf_count_t)CHUNK_FRAMES, FRAMES - total));
+        exit_if_true(count <= 0, "\n\nLine %d : Planar write failed : %s\n", __LINE__, sf_strerror(file));
+    };
+    sf_close(file);
+
+    file = test_open_file_or_die(rawname, SFM_READ, &sfinfo, __LINE__);
+    exit_if_true(readf(file, check.data(), FRAMES) != FRAMES, "\n\nLine %d : Read back failed : %s\n", __LINE__,
+                 sf_strerror(file));
+    sf_close(file);
+
+    exit_if_true(check != ref, "\n\nLine %d : Planar write did not give back the interleaved samples.\n", __LINE__);
+
+    unlink(rawname);
+}
@@ -488,6 +488,10 @@ SNDFILE *test_open_file_or_die(const char *filename, SF_FILEMODE mode, SF_INFO *
     case SFM_RDWR:
         modestr = "SFM_RDWR";
         break;
+
+    case SFM_READ | SFM_MMAP:
+        modestr = "SFM_READ | SFM_MMAP";
+        break;
     default:
         printf("\n\nLine %d: Bad mode.\n", line_num);
         fflush(stdout);
@@ -34,6 +34,7 @@
 #include "ref_ptr.h"
 
 static void vio_test(const char *fname, int format);
+static void vio_buffered_test(const char *fname, int format);
 
 int main(void)
 {
@@ -42,6 +43,9 @@ int main(void)
     vio_test("vio_float.au", SF_FORMAT_AU | SF_FORMAT_FLOAT);
     vio_test("vio_pcm24.paf", SF_FORMAT_PAF | SF_FORMAT_PCM_24);
 
+    vio_buffered_test("vio_buffered.wav", SF_FORMAT_WAV | SF_FORMAT_PCM_16);
+    vio_buffered_test("vio_buffered.aiff", SF_FORMAT_AIFF | SF_FORMAT_PCM_24);
+
     return 0;
 } /* main */
 
@@ -50,6 +54,9 @@ int main(void)
 
 bool flush_done = false;
 
+/* Number of calls to MemoryStream::read() and MemoryStream::seek(). */
+int io_calls = 0;
+
 class MemoryStream: public SF_STREAM
 {
     unsigned long m_ref = 0;
@@ -83,6 +90,8 @@ public:
 
     sf_count_t seek(sf_count_t offset, int whence) override
     {
+        io_calls++;
+
         switch (whence)
         {
         case SEEK_SET:
@@ -109,6 +118,8 @@ public:
         **	This will brack badly for files over 2Gig in length, but
         **	is sufficient for testing.
         */
+        io_calls++;
+
         if (m_offset + count > m_length)
             count = m_length - m_offset;
 
@@ -262,3 +273,83 @@ static void vio_test(const char *fname, int format)
 
     puts("ok");
 } /* vio_test */
+
+static int vio_read_test(SF_STREAM *stream, int line)
+{
+    static short data[256];
+
+    SNDFILE *file;
+    SF_INFO sfinfo;
+
+    stream->seek(0, SEEK_SET);
+    io_calls = 0;
+
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    int error = sf_open_stream(stream, SFM_READ, &sfinfo, &file);
+    if (error != SF_ERR_NO_ERROR)
+    {
+        printf("\n\nLine %d : sf_open_stream failed with error : %s\n\n", line, sf_error_number(error));
+        exit(1);
+    };
+
+    for (int k = 0; k < 3; k++)
+    {
+        sf_read_short(file, data, ARRAY_LEN(data));
+        check_short_data(data, ARRAY_LEN(data), k, line);
+    };
+
+    sf_close(file);
+
+    return io_calls;
+} /* vio_read_test */
+
+static void vio_buffered_test(const char *fname, int format)
+{
+    static short data[256];
+
+    sf::ref_ptr<SF_STREAM> vio, buffered;
+    SNDFILE *file;
+    SF_INFO sfinfo;
+
+    print_test_name("buffered virtual i/o test", fname);
+
+    vio.copy(new MemoryStream());
+    if (sf_create_buffered_stream(vio.get(), 0, buffered.get_address_of()) != SF_ERR_NO_ERROR)
+    {
+        printf("\n\nLine %d : sf_create_buffered_stream failed.\n\n", __LINE__);
+        exit(1);
+    };
+
+    /* Write through the buffered stream too, it must pass writes on. */
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    sfinfo.format = format;
+    sfinfo.channels = 2;
+    sfinfo.samplerate = 44100;
+
+    int error = sf_open_stream(buffered.get(), SFM_WRITE, &sfinfo, &file);
+    if (error != SF_ERR_NO_ERROR)
+    {
+        printf("\n\nLine %d : sf_open_stream failed with error : %s\n\n", __LINE__, sf_error_number(error));
+        exit(1);
+    };
+
+    for (int k = 0; k < 3; k++)
+    {
+        gen_short_data(data, ARRAY_LEN(data), k);
+        sf_write_short(file, data, ARRAY_LEN(data));
+    };
+
+    sf_close(file);
+
+    int unbuffered_calls = vio_read_test(vio.get(), __LINE__);
+    int buffered_calls = vio_read_test(buffered.get(), __LINE__);
+
+    if (buffered_calls >= unbuffered_calls)
+    {
+        printf("\n\nLine %d : buffered stream made %d calls, unbuffered %d.\n\n", __LINE__, buffered_calls,
+               unbuffered_calls);
+        exit(1);
+    };
+
+    puts("ok");
+} /* vio_buffered_test */